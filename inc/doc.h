@@ -96,6 +96,7 @@
 #define DOC_MOD_TYPE_DEL            DOC_SEE("collection-api/mod_type/del")
 #define DOC_MOD_TYPE_MOD            DOC_SEE("collection-api/mod_type/mod")
 #define DOC_MOD_TYPE_HID            DOC_SEE("collection-api/mod_type/hid")
+#define DOC_MOD_TYPE_IDX            DOC_SEE("collection-api/mod_type/idx")
 #define DOC_MOD_TYPE_REL            DOC_SEE("collection-api/mod_type/rel")
 #define DOC_MOD_TYPE_REN            DOC_SEE("collection-api/mod_type/ren")
 #define DOC_MOD_TYPE_WPO            DOC_SEE("collection-api/mod_type/wpo")
@@ -127,7 +128,9 @@
 #define DOC_TRY                     DOC_SEE("collection-api/try")
 #define DOC_TYPE                    DOC_SEE("collection-api/type")
 #define DOC_TYPE_ASSERT             DOC_SEE("collection-api/type_assert")
+#define DOC_TYPE_BETWEEN            DOC_SEE("collection-api/type_between")
 #define DOC_TYPE_COUNT              DOC_SEE("collection-api/type_count")
+#define DOC_TYPE_FILTER             DOC_SEE("collection-api/type_filter")
 #define DOC_TYPE_INFO               DOC_SEE("collection-api/type_info")
 #define DOC_TYPES_INFO              DOC_SEE("collection-api/types_info")
 #define DOC_WSE                     DOC_SEE("collection-api/wse")
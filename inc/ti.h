@@ -115,6 +115,7 @@ struct ti_s
     cleri_grammar_t * langdef;
     cleri_grammar_t * compat;   /* TODO (COMPAT): For < v1.5 */
     size_t futures_count;       /* number of running futures */
+    size_t streams_count;       /* number of streamed responses */
     uint32_t rel_id;            /* relative node id */
     int flags;                  /* changed and read by multiple treads */
     struct timespec boottime;   /* keep the up-time */
@@ -4,9 +4,17 @@
 #ifndef TI_API_H_
 #define TI_API_H_
 
+/*
+ * Space reserved at the start of a buffer which is written using
+ * ti_api_write_chunk(); enough for the chunk size in hex followed by CRLF.
+ */
+#define TI_API_CHUNK_PREFIX 18
+
 #include <ex.h>
 #include <ti/api.t.h>
 #include <ti/req.t.h>
+#include <ti/write.h>
+#include <util/mpack.h>
 #include <uv.h>
 
 int ti_api_init(void);
@@ -15,6 +23,12 @@ ti_api_request_t * ti_api_acquire(ti_api_request_t * api_request);
 void ti_api_release(ti_api_request_t * api_request);
 int ti_api_close_with_response(ti_api_request_t * ar, void * data, size_t size);
 int ti_api_close_with_err(ti_api_request_t * api_request, ex_t * e);
+int ti_api_write_chunk(
+        ti_api_request_t * ar,
+        msgpack_sbuffer * buffer,
+        _Bool is_last,
+        ti_write_direct_cb cb,
+        void * arg);
 void ti_api_close(ti_api_request_t * api_request);
 
 static inline _Bool ti_api_is_closed(ti_api_request_t * ar)
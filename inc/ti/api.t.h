@@ -21,6 +21,7 @@ typedef enum
     TI_API_STATE_NONE,
     TI_API_STATE_CONTENT_TYPE,
     TI_API_STATE_AUTHORIZATION,
+    TI_API_STATE_STREAM,
 } ti_api_state_t;
 
 typedef enum
@@ -31,6 +32,8 @@ typedef enum
     TI_API_FLAG_JSON_BEAUTY     =1<<3,
     TI_API_FLAG_JSON_UTF8       =1<<4,
     TI_API_FLAG_HOME            =1<<5,
+    TI_API_FLAG_STREAM          =1<<6,  /* client accepts a chunked response */
+    TI_API_FLAG_CHUNKED         =1<<7,  /* chunked response is started */
 } ti_api_flags_t;
 
 #include <ex.h>
@@ -23,6 +23,17 @@ struct ti_cfg_s
     uint8_t zone;
     uint8_t shutdown_period;            /* Wait for X seconds before shutdown;
                                           (only used with multiple nodes) */
+    uint8_t store_threads;              /* number of threads for storing
+                                           (and pre-loading) collections */
+    uint8_t query_threads;              /* number of threads for testing
+                                           simple closures on large lists
+                                           and sets; 1 disables threads */
+    uint8_t store_compression;          /* zlib level for store and
+                                           archive files; 0 disables
+                                           compression */
+    uint8_t change_id_batch;            /* maximum number of new changes
+                                           sharing a single change id
+                                           request; 1 disables batching */
     size_t threshold_full_storage;      /* if the number of changes
                                            stored on disk is equal or greater
                                            than this threshold, then a full-
@@ -44,6 +55,12 @@ struct ti_cfg_s
     int ip_support;                    /* AF_UNSPEC / AF_INET / AF_INET6 */
     _Bool wait_for_modules;            /* wait for modules to load before
                                           listening to nodes and clients */
+    _Bool change_pipelines;            /* add the dependency to changes for
+                                          a collection so other nodes may
+                                          run them ahead of a gap */
+    _Bool lazy_load;                   /* load the properties of things in a
+                                          collection on first use instead of
+                                          at start-up */
     char * node_name;
     char * bind_client_addr;
     char * bind_node_addr;
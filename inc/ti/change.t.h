@@ -20,6 +20,9 @@ typedef enum
 typedef enum
 {
     TI_CHANGE_FLAG_SAVE      = 1<<0,    /* ti_save() must be triggered */
+    TI_CHANGE_FLAG_AHEAD     = 1<<1,    /* the change has run ahead of the
+                                           committed change id */
+    TI_CHANGE_FLAG_FAILED    = 1<<2,    /* running ahead has failed */
 } ti_change_flags_enum;
 
 typedef struct ti_change_s ti_change_t;
@@ -5,6 +5,7 @@
 #define TI_CHANGES_H_
 
 #include <ti/changes.t.h>
+#include <ti/collection.t.h>
 #include <ti/node.t.h>
 #include <ti/proto.t.h>
 #include <ti/query.t.h>
@@ -19,7 +20,12 @@ int ti_changes_on_change(ti_node_t * from_node, ti_pkg_t * pkg);
 int ti_changes_create_new_change(ti_query_t * query, ex_t * e);
 int ti_changes_add_change(ti_node_t * node, ti_cpkg_t * cpkg);
 ti_proto_enum_t ti_changes_accept_id(uint64_t change_id, uint8_t * n);
+ti_proto_enum_t ti_changes_accept_range(
+        uint64_t change_id,
+        uint64_t n_ids,
+        uint8_t * n);
 void ti_changes_set_next_missing_id(uint64_t * change_id);
+uint64_t ti_changes_dep_id(ti_collection_t * collection);
 void ti_changes_free_dropped(void);
 int ti_changes_resize_dropped(void);
 
@@ -30,7 +36,7 @@ static inline void ti_changes_keep_dropped(void)
 
 static inline _Bool ti_changes_in_queue(void)
 {
-    return changes_.queue->n != 0;
+    return changes_.queue->n != 0 || changes_.pending->n != 0;
 }
 
 static inline _Bool ti_changes_unkeep_dropped(void)
@@ -28,10 +28,20 @@ struct ti_changes_s
                                    change has only one reference which is
                                    hold by this queue. (order low->high) */
     uv_async_t * changeloop;
+    uv_timer_t * batch_timer;   /* flushes `pending` on the next loop */
+    vec_t * pending;            /* new changes (ti_change_t) waiting for a
+                                   change id when batching is enabled */
     vec_t * dropped;            /* ti_thing_t, dropped while running change */
     olist_t * skipped_ids;
     util_time_t wait_gap_time;
     uint64_t wait_ccid;
+    uint64_t barrier_id;        /* last change with a global or unknown
+                                   scope; changes to a collection depend at
+                                   least on this change */
+    uint64_t loop_ccid;         /* committed change id after the last run of
+                                   the change loop */
+    _Bool run_ahead;            /* the queue must be checked for changes
+                                   which can run ahead */
 };
 
 #endif /* TI_CHANGES_T_H_ */
@@ -4,6 +4,15 @@
 #ifndef TI_COLLECTION_T_H_
 #define TI_COLLECTION_T_H_
 
+typedef enum
+{
+    TI_COLLECTION_FLAG_UNLOADED =1<<0,  /* things are restored without their
+                                         * properties (`lazy_load`); the
+                                         * properties are loaded on first use
+                                         * by ti_store_load_collection().
+                                         */
+} ti_collection_flag_t;
+
 typedef struct ti_collection_s  ti_collection_t;
 
 #include <uv.h>
@@ -20,7 +29,14 @@ typedef struct ti_collection_s  ti_collection_t;
 struct ti_collection_s
 {
     uint32_t ref;
-    long:24;
+    uint8_t flags;          /* only written by the main thread */
+    _Bool dirty;            /* collection has changed since the last full
+                               store; only dirty collections are written by
+                               ti_store_store(), others are linked from the
+                               previous store */
+    _Bool gc_dirty;         /* collection has changed since the last garbage
+                               collection; unchanged collections are skipped
+                               by the garbage collector */
     uint8_t deep;
     uint64_t id;            /* collection Id (>= 2) */
     uint64_t next_free_id;
@@ -39,6 +55,8 @@ struct ti_collection_s
     vec_t * futures;        /* no reference, type: ti_future_t */
     vec_t * vtasks;         /* tasks, type: ti_vtask_t */
     guid_t guid;            /* derived from collection->id */
+    uint64_t change_id;     /* last change applied to this collection, not
+                               stored and therefore 0 after a restart */
 };
 
 #endif /* TI_COLLECTION_T_H_ */
@@ -31,6 +31,8 @@ ti_collection_t * ti_collections_create_collection(
         ex_t * e);
 ti_collection_t * ti_collections_get_by_strn(const char * str, size_t n);
 ti_collection_t * ti_collections_get_by_id(const uint64_t id);
+_Bool ti_collections_is_busy_strn(const char * str, size_t n);
+_Bool ti_collections_is_busy_id(const uint64_t id);
 ti_collection_t * ti_collections_get_by_val(ti_val_t * val, ex_t * e);
 ti_varr_t * ti_collections_info(ti_user_t * user);
 int ti_collections_check_empty(ex_t * e);
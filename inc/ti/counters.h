@@ -18,6 +18,7 @@ void ti_counters_destroy(void);
 void ti_counters_reset(void);
 double ti_counters_upd_commit_change(struct timespec * start);
 double ti_counters_upd_success_query(struct timespec * start);
+void ti_counters_upd_gc_pause(double pause);
 int ti_counters_to_pk(msgpack_packer * pk);
 ti_val_t * ti_counters_as_mpval(void);
 
@@ -59,6 +60,23 @@ struct ti_counters_s
                                        pushed to the end of the queue because
                                        a higher change id is already queued
                                     */
+    uint64_t change_id_batches;     /* number of change id requests for a
+                                       batch of changes
+                                    */
+    uint64_t change_id_batched;     /* number of changes which have requested
+                                       a change id as part of a batch
+                                    */
+    uint64_t largest_change_id_batch;   /* largest number of changes in a
+                                           single change id request
+                                        */
+    uint64_t changes_ahead;         /* changes which have run ahead of the
+                                       committed change id since the change
+                                       they depend on was already applied
+                                    */
+    uint64_t room_emits_suppressed; /* room emits not written to a node
+                                       since the node has no listeners for
+                                       the room
+                                    */
     uint64_t largest_result_size;   /* largest result size in bytes */
     uint64_t queries_from_cache;    /* number of queries which are loaded from
                                        cache.
@@ -87,6 +105,11 @@ struct ti_counters_s
                                        total_change_duration / changes_committed
                                         (in seconds)
                                     */
+    double largest_gc_pause;        /* longest time the garbage collector
+                                       has locked a collection (in seconds);
+                                       written by the garbage collector, use
+                                       ti_counters_upd_gc_pause()
+                                    */
 };
 
 #define ti_counters_garbage_collected() \
@@ -102,4 +125,11 @@ struct ti_counters_s
     (__atomic_add_fetch(&counters_.wasted_cache, 1, __ATOMIC_SEQ_CST))
 #define ti_counters_zero_wasted_cache() \
     (__atomic_store_n(&counters_.wasted_cache, 0, __ATOMIC_SEQ_CST))
+
+static inline double ti_counters_largest_gc_pause(void)
+{
+    double pause;
+    __atomic_load(&counters_.largest_gc_pause, &pause, __ATOMIC_SEQ_CST);
+    return pause;
+}
 #endif  /* TI_COUNTERS_H_ */
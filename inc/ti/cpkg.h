@@ -12,5 +12,6 @@
 ti_cpkg_t * ti_cpkg_create(ti_pkg_t * pkg, uint64_t change_id);
 ti_cpkg_t * ti_cpkg_initial(void);
 ti_cpkg_t * ti_cpkg_from_pkg(ti_pkg_t * pkg);
+int ti_cpkg_dep(ti_cpkg_t * cpkg, uint64_t * scope_id, uint64_t * dep_id);
 
 #endif  /* TI_CPKG_H_ */
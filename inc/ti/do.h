@@ -12,6 +12,14 @@
 typedef int (*ti_do_cb)(ti_query_t * query, cleri_node_t * nd, ex_t * e);
 
 int ti_do_expression(ti_query_t * query, cleri_node_t * nd, ex_t * e);
+int ti_do_expr_false(ti_query_t * query, cleri_node_t * nd, ex_t * e);
+int ti_do_expr_true(ti_query_t * query, cleri_node_t * nd, ex_t * e);
+int ti_do_expr_nil(ti_query_t * query, cleri_node_t * nd, ex_t * e);
+int ti_do_expr_float(ti_query_t * query, cleri_node_t * nd, ex_t * e);
+int ti_do_expr_int(ti_query_t * query, cleri_node_t * nd, ex_t * e);
+int ti_do_expr_string(ti_query_t * query, cleri_node_t * nd, ex_t * e);
+int ti_do_expr_var(ti_query_t * query, cleri_node_t * nd, ex_t * e);
+int ti_do_expr_function(ti_query_t * query, cleri_node_t * nd, ex_t * e);
 int ti_do_operation(ti_query_t * query, cleri_node_t * nd, ex_t * e);
 int ti_do_bit_sl(ti_query_t * query, cleri_node_t * nd, ex_t * e);
 int ti_do_bit_sr(ti_query_t * query, cleri_node_t * nd, ex_t * e);
@@ -45,7 +53,8 @@ static inline int ti_do_statement(
         cleri_node_t * nd,
         ex_t * e)
 {
-    /* Calls ti_do_expression(..) or one of the operations(..) */
+    /* Calls ti_do_expression(..), ti_do_expr_xxx(..) or one of the
+     * operations(..) */
     return ((ti_do_cb) nd->children->data)(query, nd->children, e);
 }
 
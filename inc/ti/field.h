@@ -10,6 +10,7 @@
 #include <ti/name.t.h>
 #include <ti/raw.t.h>
 #include <ti/thing.t.h>
+#include <ti/type.h>
 #include <ti/val.t.h>
 #include <ti/spec.t.h>
 #include <ti/query.t.h>
@@ -67,9 +68,44 @@ int ti_field_vset_pre_assign(
         ti_thing_t * parent,
         ex_t * e,
         _Bool do_type_check);
+_Bool ti_field_is_indexable(ti_field_t * field);
+_Bool ti_field_index_accepts(ti_field_t * field, ti_val_t * val);
+int ti_field_index_create(ti_field_t * field);
+void ti_field_index_destroy(ti_field_t * field);
+void ti_field_index_add(
+        ti_field_t * field,
+        ti_thing_t * thing,
+        ti_val_t * val);
+void ti_field_index_del(
+        ti_field_t * field,
+        ti_thing_t * thing,
+        ti_val_t * val);
+vec_t * ti_field_index_find(
+        ti_field_t * field,
+        ti_val_t * min,
+        ti_val_t * max);
 
 static inline ti_field_t * ti_field_by_name(ti_type_t * type, ti_name_t * name)
 {
+    if (ti_type_use_lookup(type))
+    {
+        ti_type_lookup_t * lookup = type->lookup;
+        uint32_t slot, i = ti_type_lookup_hash(name);
+        ti_field_t * field;
+
+        while ((slot = lookup->slots[i++ & lookup->mask])
+                != TI_TYPE_LOOKUP_EMPTY)
+        {
+            if (slot & TI_TYPE_LOOKUP_METHOD)
+                continue;
+
+            field = VEC_get(type->fields, slot);
+            if (field->name == name)
+                return field;
+        }
+        return NULL;
+    }
+
     for (vec_each(type->fields, ti_field_t, field))
         if (field->name == name)
             return field;
@@ -103,5 +139,21 @@ static inline int ti_field_ret_flags(ti_field_t * field)
    return field->flags & TI_FIELD_FLAG_NO_IDS;
 }
 
+/*
+ * Must be called before the value of a field is replaced with `val`.
+ */
+static inline void ti_field_index_replace(
+        ti_field_t * field,
+        ti_thing_t * thing,
+        ti_val_t * prev,
+        ti_val_t * val)
+{
+    if (field->index && thing->id)
+    {
+        ti_field_index_del(field, thing, prev);
+        ti_field_index_add(field, thing, val);
+    }
+}
+
 
 #endif  /* TI_FIELD_H_ */
@@ -14,6 +14,7 @@ typedef struct ti_field_s ti_field_t;
 #include <ti/raw.t.h>
 #include <ti/type.t.h>
 #include <ti/val.t.h>
+#include <util/imap.h>
 
 typedef ti_val_t *  (*ti_field_dval_cb) (ti_field_t *);
 
@@ -51,6 +52,10 @@ struct ti_field_s
     ti_field_dval_cb dval_cb;
     ti_condition_via_t condition;
     int flags;
+    _Bool is_indexed;           /* index is declared using `mod_type` */
+    imap_t * index;             /* index on the value of this field; created
+                                   on first use when `is_indexed` is set and
+                                   maintained from then on (may be NULL) */
 };
 
 #endif  /* TI_FIELD_T_H_ */
@@ -9,7 +9,7 @@
 #include <ti/val.t.h>
 
 
-#define TI_FLAGS_QUERY_MASK 0x1f
+#define TI_FLAGS_QUERY_MASK 0x5f
 
 /* flags must fit with `TI_QUERY_FLAG` defined in query.t.h */
 enum
@@ -44,6 +44,7 @@
 #include <ti/names.h>
 #include <ti/nil.h>
 #include <ti/opr.h>
+#include <ti/pred.h>
 #include <ti/procedures.h>
 #include <ti/prop.h>
 #include <ti/qbind.h>
@@ -62,6 +62,16 @@ static int do__f_every(ti_query_t * query, cleri_node_t * nd, ex_t * e)
     {
         int64_t idx  = 0;
         vec_t * vec = VARR(iterval);
+        uint8_t * res = ti_pred_varr(closure, query, vec);
+
+        if (res)
+        {
+            for (uint32_t i = 0; i < vec->n; ++i)
+                if (!(every = res[i]))
+                    break;
+            free(res);
+            break;
+        }
 
         for (vec_each(vec, ti_val_t, v), ++idx)
         {
@@ -86,12 +96,27 @@ static int do__f_every(ti_query_t * query, cleri_node_t * nd, ex_t * e)
     }
     case TI_VAL_SET:
     {
+        int rc;
+        vec_t * vec;
+        uint8_t * res;
         every__walk_t w = {
                 .e = e,
                 .closure = closure,
                 .query = query,
         };
-        int rc = ti_vset_walk(
+
+        res = ti_pred_vset(closure, query, (ti_vset_t *) iterval, &vec);
+        if (res)
+        {
+            for (uint32_t i = 0; i < vec->n; ++i)
+                if (!(every = res[i]))
+                    break;
+            free(res);
+            free(vec);
+            break;
+        }
+
+        rc = ti_vset_walk(
                 (ti_vset_t *) iterval,
                 query,
                 closure,
@@ -151,12 +151,30 @@ static int do__f_filter(ti_query_t * query, cleri_node_t * nd, ex_t * e)
     case TI_VAL_ARR:
     {
         int64_t idx = 0;
+        uint8_t * res;
         ti_varr_t * varr = ti_varr_create(VARR(iterval)->n);
         if (!varr)
             goto fail2;
 
         retval = (ti_val_t *) varr;
 
+        res = ti_pred_varr(closure, query, VARR(iterval));
+        if (res)
+        {
+            for (vec_each(VARR(iterval), ti_val_t, v), ++idx)
+            {
+                if (res[idx])
+                {
+                    ti_incref(v);
+                    (void) ti_val_varr_append(varr, &v, e);
+                    assert(e->nr == 0);  /* the above should always succeed */
+                }
+            }
+            free(res);
+            (void) vec_shrink(&varr->vec);
+            break;
+        }
+
         for (vec_each(VARR(iterval), ti_val_t, v), ++idx)
         {
             if (ti_closure_vars_val_idx(closure, v, idx) ||
@@ -179,6 +197,8 @@ static int do__f_filter(ti_query_t * query, cleri_node_t * nd, ex_t * e)
     }
     case TI_VAL_SET:
     {
+        vec_t * vec;
+        uint8_t * res;
         filter__walk_set_t w = {
                 .e = e,
                 .closure = closure,
@@ -191,6 +211,26 @@ static int do__f_filter(ti_query_t * query, cleri_node_t * nd, ex_t * e)
 
         retval = (ti_val_t *) w.vset;
 
+        res = ti_pred_vset(closure, query, (ti_vset_t *) iterval, &vec);
+        if (res)
+        {
+            uint32_t idx = 0;
+            int rc = 0;
+            for (vec_each(vec, ti_thing_t, t), ++idx)
+            {
+                if (!res[idx])
+                    continue;
+                if ((rc = ti_vset_add(w.vset, t)))
+                    break;
+                ti_incref(t);
+            }
+            free(res);
+            free(vec);
+            if (rc)
+                goto fail2;
+            break;
+        }
+
         if (ti_vset_walk(
                 (ti_vset_t *) iterval,
                 query,
@@ -63,6 +63,25 @@ static int do__f_find(ti_query_t * query, cleri_node_t * nd, ex_t * e)
     switch (iterval->tp)
     {
     case TI_VAL_ARR:
+    {
+        uint8_t * res = ti_pred_varr(closure, query, VARR(iterval));
+        if (res)
+        {
+            for (vec_each(VARR(iterval), ti_val_t, v), ++idx)
+            {
+                if (res[idx])
+                {
+                    query->rval = v;
+                    ti_incref(v);
+                    break;
+                }
+            }
+            free(res);
+            if (query->rval)
+                goto done;
+            break;
+        }
+
         for (vec_each(VARR(iterval), ti_val_t, v), ++idx)
         {
             _Bool found;
@@ -89,15 +108,37 @@ static int do__f_find(ti_query_t * query, cleri_node_t * nd, ex_t * e)
             query->rval = NULL;
         }
         break;
+    }
     case TI_VAL_SET:
     {
         int rc;
+        vec_t * vec;
+        uint8_t * res;
         find__walk_t w = {
                 .e = e,
                 .closure = closure,
                 .query = query,
         };
 
+        res = ti_pred_vset(closure, query, (ti_vset_t *) iterval, &vec);
+        if (res)
+        {
+            for (vec_each(vec, ti_thing_t, t), ++idx)
+            {
+                if (res[idx])
+                {
+                    query->rval = (ti_val_t *) t;
+                    ti_incref(t);
+                    break;
+                }
+            }
+            free(res);
+            free(vec);
+            if (query->rval)
+                goto done;
+            break;
+        }
+
         rc = ti_vset_walk(
                 (ti_vset_t *) iterval,
                 query,
@@ -37,9 +37,9 @@ static int json_dump__walk_cb(
 static int do__f_json_dump(ti_query_t * query, cleri_node_t * nd, ex_t * e)
 {
     const int nargs = fn_get_nargs(nd);
-    msgpack_sbuffer buffer;
-    yajl_gen_status stat;
+    mpjson_writer_t writer;
     ti_raw_t * raw;
+    char * data;
     ti_val_t * val;
     size_t total_n;
     ti_vp_t vp = {
@@ -73,38 +73,32 @@ static int do__f_json_dump(ti_query_t * query, cleri_node_t * nd, ex_t * e)
         query->rval = NULL;
     }
 
-    if (mp_sbuffer_alloc_init(&buffer, ti_val_alloc_size(val), 0))
+    if (mpjson_writer_init(
+            &writer,
+            &vp.pk,
+            ti_val_alloc_size(val) + sizeof(ti_raw_t),
+            sizeof(ti_raw_t),
+            options.json_flags))
     {
         ex_set_mem(e);
         goto fail0;
     }
 
-    msgpack_packer_init(&vp.pk, &buffer, msgpack_sbuffer_write);
-
-    if (ti_val_to_client_pk(val, &vp, options.deep, options.flags))
+    if (ti_val_to_client_pk(val, &vp, options.deep, options.flags) ||
+        mpjson_writer_done(&writer))
     {
-        ex_set_mem(e);
+        mpjson_writer_set_err(&writer, e);
         goto fail1;
     }
 
-    stat = mpjson_mp_to_json(
-                buffer.data,
-                buffer.size,
-                (unsigned char **) &raw,
-                &total_n,
-                sizeof(ti_raw_t),
-                options.json_flags);
-    if (stat)
-    {
-        mpjson__set_err(e, stat);
-        goto fail1;
-    }
+    take_buffer(&writer.buffer, &data, &total_n);
 
+    raw = (ti_raw_t *) data;
     ti_raw_init(raw, TI_VAL_STR, total_n);
     query->rval = (ti_val_t *) raw;
 
 fail1:
-    msgpack_sbuffer_destroy(&buffer);
+    mpjson_writer_destroy(&writer);
 fail0:
     ti_val_unsafe_drop(val);
     return e->nr;
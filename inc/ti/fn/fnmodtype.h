@@ -326,13 +326,9 @@ static imap_t * modtype__collect_things(ti_query_t * query, ti_type_t * type)
             query->collection,
             (imap_cb) modtype__collect_cb,
             &collect) ||
-        imap_walk(
-                query->collection->things,
+        ti_type_walk_instances(
+                type,
                 (imap_cb) modtype__collect_cb,
-                &collect) ||
-        ti_gc_walk(
-                query->collection->gc,
-                (queue_cb) modtype__collect_cb,
                 &collect))
     {
         imap_destroy(collect.imap, (imap_destroy_cb) ti_val_unsafe_drop);
@@ -810,7 +806,12 @@ static int type__mod_using_callback(
     imap_after = modtype__collect_things(query, field->type);
     if (imap_after)
     {
-        imap_difference_inplace(imap_after, imap);
+        if (imap_difference_inplace(imap_after, imap))
+        {
+            imap_destroy(imap_after, (imap_destroy_cb) ti_val_unsafe_drop);
+            ex_set_mem(e);
+            goto panic;
+        }
 
         (void) imap_walk(
                 imap_after,
@@ -1122,13 +1123,9 @@ static int modtype__has_lock(ti_query_t * query, ti_type_t * type, ex_t * e)
         goto locked;
     }
 
-    if (imap_walk(
-            query->collection->things,
+    if (ti_type_walk_instances(
+            type,
             (imap_cb) modtype__is_locked_cb,
-            type) ||
-        ti_gc_walk(
-            query->collection->gc,
-            (queue_cb) modtype__is_locked_cb,
             type))
         goto locked;
 
@@ -1514,6 +1511,74 @@ static void type__hid(
         ex_set_mem(e);
 }
 
+static void type__idx(
+        ti_query_t * query,
+        ti_type_t * type,
+        ti_name_t * name,
+        cleri_node_t * nd,
+        ex_t * e)
+{
+    static const char * fnname = "mod_type` with task `idx";
+    const int nargs = fn_get_nargs(nd);
+    ti_field_t * field = ti_field_by_name(type, name);
+    _Bool is_indexed;
+    ti_task_t * task;
+
+    if (fn_nargs(fnname, DOC_MOD_TYPE_IDX, 4, nargs, e))
+        return;
+
+    if (!field)
+    {
+        ex_set(e, EX_LOOKUP_ERROR,
+                "type `%s` has no property `%s`",
+                type->name, name->str);
+        return;
+    }
+
+    if (!ti_field_is_indexable(field))
+    {
+        ex_set(e, EX_OPERATION,
+                "cannot index property `%s` on type `%s`; "
+                "only `str`, `int`, `float` and `datetime` (or related) "
+                "definitions can be indexed"DOC_MOD_TYPE_IDX,
+                name->str, type->name);
+        return;
+    }
+
+    if (ti_do_statement(
+            query,
+            nd->children->next->next->next->next->next->next,
+            e) ||
+        fn_arg_bool(fnname, DOC_MOD_TYPE_IDX, 4, query->rval, e))
+        return;
+
+    is_indexed = ti_val_as_bool(query->rval);
+
+    ti_val_unsafe_drop(query->rval);
+    query->rval = NULL;
+
+    if (is_indexed == field->is_indexed)
+        return;  /* nothing to do */
+
+    task = ti_task_get_task(query->change, query->collection->root);
+    if (!task)
+    {
+        ex_set_mem(e);
+        return;
+    }
+
+    /* the index itself is created on first use */
+    field->is_indexed = is_indexed;
+    if (!is_indexed)
+        ti_field_index_destroy(field);
+
+    /* update modified time-stamp */
+    type->modified_at = util_now_usec();
+
+    if (ti_task_add_mod_type_idx(task, field))
+        ex_set_mem(e);
+}
+
 static int do__f_mod_type(ti_query_t * query, cleri_node_t * nd, ex_t * e)
 {
     ti_type_t * type;
@@ -1606,6 +1671,12 @@ static int do__f_mod_type(ti_query_t * query, cleri_node_t * nd, ex_t * e)
         goto done;
     }
 
+    if (ti_raw_eq_strn(rmod, "idx", 3))
+    {
+        type__idx(query, type, name, nd, e);
+        goto done;
+    }
+
     if (ti_raw_eq_strn(rmod, "rel", 3))
     {
         type__rel(query, type, name, nd, e);
@@ -1614,12 +1685,16 @@ static int do__f_mod_type(ti_query_t * query, cleri_node_t * nd, ex_t * e)
 
     ex_set(e, EX_VALUE_ERROR,
             "function `mod_type` expects argument 2 to be "
-            "`all`, `add`, `del`, `hid`, `mod`, `rel`, `ren` or `wpo` "
-            "but got `%.*s` instead"
+            "`all`, `add`, `del`, `hid`, `idx`, `mod`, `rel`, `ren` or "
+            "`wpo` but got `%.*s` instead"
             DOC_MOD_TYPE,
             rmod->n, (const char *) rmod->data);
 
 done:
+    /* values may have been changed without updating the indexes */
+    if (!ti_raw_eq_strn(rmod, "idx", 3))
+        ti_type_indexes_clear(type);
+
     if (e->nr == 0)
     {
         ti_type_map_cleanup(type);
@@ -1,5 +1,6 @@
 #define _GNU_SOURCE
 #include <ti/fn/fn.h>
+#include <util/argsort.h>
 
 typedef struct
 {
@@ -7,6 +8,7 @@ typedef struct
     ti_closure_t * closure;
     ex_t * e;
     vec_sort_r_cb cb;
+    _Bool reverse;
 } closure_cmp_t;
 
 static int ti_closure_cmp(ti_val_t * va, ti_val_t * vb, closure_cmp_t * cc)
@@ -49,45 +51,183 @@ static int ti_closure_cmp(ti_val_t * va, ti_val_t * vb, closure_cmp_t * cc)
     return i < INT_MIN ? INT_MIN : i > INT_MAX ? INT_MAX : i;
 }
 
-static int ti_closure_pick(ti_val_t * va, ti_val_t * vb, closure_cmp_t * cc)
+typedef struct
 {
-    int i;
-    ti_prop_t * p;
+    ti_val_t * key;
+    ti_val_t * val;
+} sort__kv_t;
 
-    if (cc->e->nr)
-        return 0;
+static int sort__kv_cmp(sort__kv_t * a, sort__kv_t * b, closure_cmp_t * cc)
+{
+    return cc->e->nr ? 0 : cc->cb(a->key, b->key, cc->e);
+}
 
-    ti_incref(va);
-    p = VEC_get(cc->closure->vars, 0);
-    ti_val_unsafe_drop(p->val);
-    p->val = va;
+static inline ti_val_t * sort__key(vec_t * vec, size_t i, _Bool is_kv)
+{
+    return is_kv ? ((sort__kv_t *) VEC_get(vec, i))->key : VEC_get(vec, i);
+}
 
-    if (ti_closure_do_statement(cc->closure, cc->query, cc->e))
-        return 0;
+/*
+ * Sort on a packed copy of the keys when all keys are integer values or all
+ * keys are float values. The keys are sorted using a radix sort, without a
+ * compare call-back for each pair of values. When `is_kv` is set, `vec`
+ * contains `sort__kv_t` pairs, otherwise the values are the keys.
+ *
+ * Only the sort uses a packed copy; lists always store boxed values, there is
+ * no packed list representation.
+ *
+ * Returns `false` if the keys are not packed, the caller must then fall back
+ * to a compare sort.
+ */
+static _Bool sort__packed(vec_t * vec, _Bool is_kv, _Bool reverse)
+{
+    size_t i, n = vec->n;
+    uint64_t * keys = NULL;
+    uint32_t * idx = NULL;
+    void ** data = NULL;
+    uint8_t tp;
+
+    if (n < 2)
+        return false;
+
+    tp = sort__key(vec, 0, is_kv)->tp;
+    if (tp != TI_VAL_INT && tp != TI_VAL_FLOAT)
+        return false;
+
+    keys = malloc(n * sizeof(uint64_t));
+    idx = malloc(n * sizeof(uint32_t));
+    data = malloc(n * sizeof(void *));
+    if (!keys || !idx || !data)
+        goto fail;
+
+    for (i = 0; i < n; ++i)
+    {
+        ti_val_t * key = sort__key(vec, i, is_kv);
+        if (key->tp != tp)
+            goto fail;
+
+        keys[i] = tp == TI_VAL_INT
+                ? argsort_key_i64(VINT(key))
+                : argsort_key_f64(VFLOAT(key));
+        if (reverse)
+            keys[i] = ~keys[i];
+    }
 
-    va = cc->query->rval;
-    cc->query->rval = NULL;
+    if (argsort_u64(keys, idx, n))
+        goto fail;
 
-    ti_incref(vb);
-    p = VEC_get(cc->closure->vars, 0);
-    ti_val_unsafe_drop(p->val);
-    p->val = vb;
+    memcpy(data, vec->data, n * sizeof(void *));
+    for (i = 0; i < n; ++i)
+        vec->data[i] = data[idx[i]];
 
-    if (ti_closure_do_statement(cc->closure, cc->query, cc->e))
+    free(keys);
+    free(idx);
+    free(data);
+    return true;
+
+fail:
+    free(keys);
+    free(idx);
+    free(data);
+    return false;
+}
+
+/*
+ * Sort the first `limit` values of `vec`, or all values when `limit` is
+ * equal or greater than the number of values.
+ */
+static inline void sort__vec(
+        vec_t * vec,
+        size_t limit,
+        vec_sort_r_cb cb,
+        void * arg)
+{
+    if (limit < vec->n)
+        vec_partial_sort_r(vec, (uint32_t) limit, cb, arg);
+    else
+        vec_sort_r(vec, cb, arg);
+}
+
+/*
+ * Sort using a closure which returns a key for a given value. The key is
+ * computed only once for each value, the values are sorted on the keys and
+ * reordered afterwards.
+ */
+static int sort__pick(vec_t * vec, size_t limit, closure_cmp_t * cc)
+{
+    size_t i, n = vec->n;
+    sort__kv_t * kvs = malloc(n * sizeof(sort__kv_t));
+    vec_t * tmp = vec_new(n);
+
+    if (!kvs || !tmp)
     {
-        ti_val_unsafe_drop(va);
-        return 0;
+        ex_set_mem(cc->e);
+        goto done;
     }
 
-    vb = cc->query->rval;
-    cc->query->rval = NULL;
+    for (i = 0; i < n; ++i)
+    {
+        sort__kv_t * kv = kvs + i;
 
-    i = cc->cb(va, vb, cc->e);
+        if (ti_closure_vars_val_idx(cc->closure, VEC_get(vec, i), 0))
+        {
+            ex_set_mem(cc->e);
+            break;
+        }
 
-    ti_val_unsafe_drop(va);
-    ti_val_unsafe_drop(vb);
+        if (ti_closure_do_statement(cc->closure, cc->query, cc->e))
+            break;
 
-    return i;
+        kv->key = cc->query->rval;
+        kv->val = VEC_get(vec, i);
+        cc->query->rval = NULL;
+        VEC_push(tmp, kv);
+    }
+
+    if (!cc->e->nr && !sort__packed(tmp, true, cc->reverse))
+        sort__vec(tmp, limit, (vec_sort_r_cb) sort__kv_cmp, cc);
+
+    if (!cc->e->nr)
+        for (i = 0; i < n; ++i)
+            vec->data[i] = ((sort__kv_t *) VEC_get(tmp, i))->val;
+
+    for (vec_each(tmp, sort__kv_t, kv))
+        ti_val_unsafe_drop(kv->key);
+
+done:
+    free(tmp);
+    free(kvs);
+    return cc->e->nr;
+}
+
+/*
+ * Read the `limit` argument from `query->rval`.
+ */
+static int sort__limit(
+        ti_query_t * query,
+        int argn,
+        size_t * limit,
+        ex_t * e)
+{
+    int64_t i;
+
+    if (fn_arg_int("sort", DOC_LIST_SORT, argn, query->rval, e))
+        return e->nr;
+
+    i = VINT(query->rval);
+    if (i < 0)
+    {
+        ex_set(e, EX_VALUE_ERROR,
+            "function `sort` expects argument %d to be a "
+            "positive integer value"DOC_LIST_SORT, argn);
+        return e->nr;
+    }
+
+    *limit = (size_t) i;
+
+    ti_val_unsafe_drop(query->rval);
+    query->rval = NULL;
+    return 0;
 }
 
 static int do__f_sort(ti_query_t * query, cleri_node_t * nd, ex_t * e)
@@ -96,11 +236,12 @@ static int do__f_sort(ti_query_t * query, cleri_node_t * nd, ex_t * e)
     ti_varr_t * varr;
     ti_closure_t * closure;
     _Bool reverse = false;
+    size_t limit = SIZE_MAX;
 
     if (!ti_val_is_array(query->rval))
         return fn_call_try("sort", query, nd, e);
 
-    if (fn_nargs_max("sort", DOC_LIST_SORT, 2, nargs, e))
+    if (fn_nargs_max("sort", DOC_LIST_SORT, 3, nargs, e))
         return e->nr;
 
     if (vec_is_sorting())
@@ -120,14 +261,12 @@ static int do__f_sort(ti_query_t * query, cleri_node_t * nd, ex_t * e)
         goto fail0;
     }
 
-    if (varr->vec->n <= 1)
-        goto done;  /* nothing to sort */
-
     /* varr has only one reference and could be a copy, or if this was the
      * only reference it is just the old one */
     if (nargs == 0)
     {
-        vec_sort_r(varr->vec, (vec_sort_r_cb) ti_opr_compare, e);
+        if (!sort__packed(varr->vec, false, false))
+            vec_sort_r(varr->vec, (vec_sort_r_cb) ti_opr_compare, e);
         if (e->nr)
             goto fail0;
         goto done;
@@ -136,20 +275,41 @@ static int do__f_sort(ti_query_t * query, cleri_node_t * nd, ex_t * e)
     if (ti_do_statement(query, nd->children, e))
         goto fail0;
 
-    if (nargs == 1 && ti_val_is_bool(query->rval))
+    if (nargs == 1 && ti_val_is_int(query->rval))
+    {
+        if (sort__limit(query, 1, &limit, e))
+            goto fail0;
+
+        if (!sort__packed(varr->vec, false, false))
+            sort__vec(varr->vec, limit, (vec_sort_r_cb) ti_opr_compare, e);
+
+        if (e->nr)
+            goto fail0;
+
+        goto done;
+    }
+
+    if (nargs <= 2 && ti_val_is_bool(query->rval))
     {
         reverse = VBOOL(query->rval);
 
         ti_val_unsafe_drop(query->rval);
         query->rval = NULL;
 
-        vec_sort_r(
-                varr->vec,
-                (vec_sort_r_cb) (
-                        reverse
-                        ? ti_opr_compare_desc
-                        : ti_opr_compare
-                ), e);
+        if (nargs == 2 && (
+                ti_do_statement(query, nd->children->next->next, e) ||
+                sort__limit(query, 2, &limit, e)))
+            goto fail0;
+
+        if (!sort__packed(varr->vec, false, reverse))
+            sort__vec(
+                    varr->vec,
+                    limit,
+                    (vec_sort_r_cb) (
+                            reverse
+                            ? ti_opr_compare_desc
+                            : ti_opr_compare
+                    ), e);
 
         if (e->nr)
             goto fail0;
@@ -171,27 +331,47 @@ static int do__f_sort(ti_query_t * query, cleri_node_t * nd, ex_t * e)
         goto fail1;
     }
 
-    if (nargs == 2)
+    if (nargs >= 2)
     {
-        if (ti_do_statement(query, nd->children->next->next, e) ||
-            fn_arg_bool("sort", DOC_LIST_SORT, 2, query->rval, e))
-            goto fail1;
-
-        reverse = VBOOL(query->rval);
+        cleri_node_t * child = nd->children->next->next;
 
-        ti_val_unsafe_drop(query->rval);
-        query->rval = NULL;
+        if (ti_do_statement(query, child, e))
+            goto fail1;
 
-        if (closure->vars->n == 2)
+        if (nargs == 2 && ti_val_is_int(query->rval))
         {
-            ex_set(e, EX_NUM_ARGUMENTS,
-                "cannot specify an order with a closure which takes two "
-                "arguments; in this case the order should be specified within "
-                "the closure"DOC_LIST_SORT);
-            goto fail1;
+            if (sort__limit(query, 2, &limit, e))
+                goto fail1;
+        }
+        else
+        {
+            if (fn_arg_bool("sort", DOC_LIST_SORT, 2, query->rval, e))
+                goto fail1;
+
+            reverse = VBOOL(query->rval);
+
+            ti_val_unsafe_drop(query->rval);
+            query->rval = NULL;
+
+            if (closure->vars->n == 2)
+            {
+                ex_set(e, EX_NUM_ARGUMENTS,
+                    "cannot specify an order with a closure which takes two "
+                    "arguments; in this case the order should be specified "
+                    "within the closure"DOC_LIST_SORT);
+                goto fail1;
+            }
+
+            if (nargs == 3 && (
+                    ti_do_statement(query, child->next->next, e) ||
+                    sort__limit(query, 3, &limit, e)))
+                goto fail1;
         }
     }
 
+    if (varr->vec->n <= 1)
+        goto closure_done;  /* nothing to sort */
+
     if (    ti_closure_try_wse(closure, query, e) ||
             ti_closure_inc(closure, query, e))
         goto fail1;
@@ -205,24 +385,27 @@ static int do__f_sort(ti_query_t * query, cleri_node_t * nd, ex_t * e)
                     ? ti_opr_compare_desc
                     : ti_opr_compare
             ),
+            .reverse = reverse,
     };
-    vec_sort_r(
-            varr->vec,
-            (vec_sort_r_cb) (
-                    closure->vars->n == 1
-                    ? ti_closure_pick
-                    : ti_closure_cmp
-            ),
-            &cc);
+
+    if (closure->vars->n == 1)
+        (void) sort__pick(varr->vec, limit, &cc);
+    else
+        sort__vec(varr->vec, limit, (vec_sort_r_cb) ti_closure_cmp, &cc);
 
     ti_closure_dec(closure, query);
 
     if (e->nr)
         goto fail1;
 
+closure_done:
     ti_val_unsafe_drop((ti_val_t *) closure);
 
 done:
+    /* with a limit, only the first `limit` values are returned */
+    while (varr->vec->n > limit)
+        ti_val_unsafe_drop(vec_pop(varr->vec));
+
     query->rval = (ti_val_t *) varr;
     return e->nr;
 
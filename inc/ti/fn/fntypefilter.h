@@ -0,0 +1,90 @@
+#include <ti/fn/fn.h>
+
+static int do__f_type_filter(ti_query_t * query, cleri_node_t * nd, ex_t * e)
+{
+    const int nargs = fn_get_nargs(nd);
+    cleri_node_t * child = nd->children;
+    ti_raw_t * rtype, * rname;
+    ti_type_t * type;
+    ti_field_t * field;
+    vec_t * vec;
+
+    if (fn_not_collection_scope("type_filter", query, e) ||
+        fn_nargs("type_filter", DOC_TYPE_FILTER, 3, nargs, e) ||
+        ti_do_statement(query, child, e) ||
+        fn_arg_str("type_filter", DOC_TYPE_FILTER, 1, query->rval, e))
+        return e->nr;
+
+    rtype = (ti_raw_t *) query->rval;
+    query->rval = NULL;
+
+    if (ti_do_statement(query, (child = child->next->next), e) ||
+        fn_arg_str("type_filter", DOC_TYPE_FILTER, 2, query->rval, e))
+        goto fail0;
+
+    rname = (ti_raw_t *) query->rval;
+    query->rval = NULL;
+
+    if (ti_do_statement(query, (child = child->next->next), e))
+        goto fail1;
+
+    type = ti_types_by_raw(query->collection->types, rtype);
+    if (!type)
+    {
+        (void) ti_raw_err_not_found(rtype, "type", e);
+        goto fail1;
+    }
+
+    field = ti_field_by_strn_e(
+            type,
+            (const char *) rname->data,
+            rname->n,
+            e);
+    if (!field)
+        goto fail1;
+
+    if (!ti_field_is_indexable(field))
+    {
+        ex_set(e, EX_TYPE_ERROR,
+                "function `type_filter` cannot search property `%s` on "
+                "type `%s`; only `str`, `int`, `float` and `datetime` "
+                "(or related) definitions are supported"DOC_TYPE_FILTER,
+                field->name->str, type->name);
+        goto fail1;
+    }
+
+    if (!ti_field_index_accepts(field, query->rval))
+    {
+        ex_set(e, EX_TYPE_ERROR,
+                "function `type_filter` cannot compare property `%s` "
+                "with definition `%.*s` to type `%s`"DOC_TYPE_FILTER,
+                field->name->str,
+                field->spec_raw->n, (const char *) field->spec_raw->data,
+                ti_val_str(query->rval));
+        goto fail1;
+    }
+
+    vec = ti_field_index_find(field, query->rval, query->rval);
+    if (!vec)
+    {
+        ex_set_mem(e);
+        goto fail1;
+    }
+
+    for (vec_each(vec, ti_thing_t, thing))
+        ti_incref(thing);
+
+    ti_val_unsafe_drop(query->rval);
+    query->rval = (ti_val_t *) ti_varr_from_vec_unsafe(vec);
+    if (!query->rval)
+    {
+        vec_destroy(vec, (vec_destroy_cb) ti_val_unsafe_drop);
+        ex_set_mem(e);
+    }
+
+fail1:
+    ti_val_unsafe_drop((ti_val_t *) rname);
+fail0:
+    ti_val_unsafe_drop((ti_val_t *) rtype);
+    return e->nr;
+}
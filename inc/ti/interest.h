@@ -0,0 +1,28 @@
+/*
+ * ti/interest.h
+ *
+ * Bloom filter with the rooms for which a node has listeners. Each node
+ * advertises this filter so room emits are only forwarded to nodes which
+ * might have listeners for the room.
+ */
+#ifndef TI_INTEREST_H_
+#define TI_INTEREST_H_
+
+#define TI_INTEREST_BITS 16384
+#define TI_INTEREST_SZ (TI_INTEREST_BITS / 8)
+
+#include <inttypes.h>
+#include <ti/node.t.h>
+#include <ti/pkg.t.h>
+#include <ti/room.t.h>
+
+void ti_interest_add(ti_room_t * room);
+void ti_interest_changed(void);
+void ti_interest_update(void);
+void ti_interest_on_pkg(ti_node_t * node, ti_pkg_t * pkg);
+_Bool ti_interest_test(
+        ti_node_t * node,
+        uint64_t collection_id,
+        uint64_t room_id);
+
+#endif  /* TI_INTEREST_H_ */
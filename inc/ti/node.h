@@ -24,6 +24,7 @@ void ti_node_connect(ti_node_t * node);
 int ti_node_info_to_pk(ti_node_t * node, msgpack_packer * pk);
 ti_val_t * ti_node_as_mpval(ti_node_t * node);
 int ti_node_status_from_unp(ti_node_t * node, mp_unp_t * up);
+int ti_node_write_caps(ti_node_t * node, _Bool reply);
 
 static inline int ti_node_status_to_pk(ti_node_t * node, msgpack_packer * pk)
 {
@@ -39,4 +40,9 @@ static inline int ti_node_status_to_pk(ti_node_t * node, msgpack_packer * pk)
     );
 }
 
+static inline _Bool ti_node_has_cap(ti_node_t * node, ti_node_cap_t cap)
+{
+    return node && (node->caps & cap);
+}
+
 #endif /* TI_NODE_H_ */
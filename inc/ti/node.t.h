@@ -66,6 +66,26 @@ typedef enum
     TI_NODE_STAT_READY          =1<<7,
 } ti_node_status_t;
 
+/*
+ * Capabilities are exchanged using a NODE_CAPS package once a connection
+ * between two nodes is made; older nodes do not send capabilities and
+ * therefore have none.
+ */
+typedef enum
+{
+    TI_NODE_CAP_SYNC_Z          =1<<0,  /* accepts compressed sync parts */
+    TI_NODE_CAP_ROOM_INTEREST   =1<<1,  /* accepts the room interest filter */
+    TI_NODE_CAP_SYNC_NAMES      =1<<2,  /* accepts collection names files */
+} ti_node_cap_t;
+
+#define TI_NODE_CAPS ( \
+        TI_NODE_CAP_SYNC_Z| \
+        TI_NODE_CAP_ROOM_INTEREST| \
+        TI_NODE_CAP_SYNC_NAMES)
+
+/* first version which handles the NODE_CAPS package */
+#define TI_NODE_CAPS_VERSION "1.6.1"
+
 /*
  * Size TI_NODE_INFO_PK_SZ for node status info.
  *  {
@@ -104,6 +124,10 @@ struct ti_node_s
     uint64_t scid;                 /* last stored change id on disk */
     uint64_t next_free_id;
     ti_stream_t * stream;           /* borrowed reference */
+    uint8_t * interest;             /* room interest filter or NULL */
+    uint32_t interest_version;      /* version of the filter sent to node */
+    uint8_t caps;                   /* capabilities, see ti_node_cap_t */
+    int:24;
 
     /*
      * TODO: add warning flags, like:
@@ -30,6 +30,10 @@ _Bool ti_nodes_has_quorum(void);
 ti_node_t * ti_nodes_not_ready(void);
 _Bool ti_nodes_offline_found(void);
 void ti_nodes_write_rpkg(ti_rpkg_t * rpkg);
+void ti_nodes_write_room_rpkg(
+        ti_rpkg_t * rpkg,
+        uint64_t collection_id,
+        uint64_t room_id);
 int ti_nodes_to_pk(msgpack_packer * pk);
 int ti_nodes_from_up(mp_unp_t * up);
 ti_nodes_ignore_t ti_nodes_ignore_sync(uint8_t retry_offline);
@@ -46,7 +46,8 @@ static int opr__or(ti_val_t * a, ti_val_t ** b, ex_t * e, _Bool inplace)
 
         if (unrestricted && (inplace || a->ref == 1) && (*b)->ref == 1)
         {
-            imap_union_move(VSET(a), VSET(*b));
+            if (imap_union_move(VSET(a), VSET(*b)))
+                goto alloc_err;
             ti_val_unsafe_drop(*b);
             ti_incref(a);
             *b = a;
@@ -71,7 +71,8 @@ static int opr__sub(ti_val_t * a, ti_val_t ** b, ex_t * e, _Bool inplace)
 
         if (unrestricted && (inplace || a->ref == 1))
         {
-            imap_difference_inplace(VSET(a), VSET(*b));
+            if (imap_difference_inplace(VSET(a), VSET(*b)))
+                goto alloc_err;
             ti_val_unsafe_drop(*b);
             ti_incref(a);
             *b = a;
@@ -47,10 +47,11 @@ static int opr__xor(ti_val_t * a, ti_val_t ** b, ex_t * e, _Bool inplace)
 
         if (unrestricted && (inplace || a->ref == 1) && (*b)->ref == 1)
         {
-            imap_symmdiff_move(
+            if (imap_symmdiff_move(
                     VSET(a),
                     VSET(*b),
-                    (imap_destroy_cb) ti_val_unsafe_gc_drop);
+                    (imap_destroy_cb) ti_val_unsafe_gc_drop))
+                goto alloc_err;
             ti_val_unsafe_drop(*b);
             ti_incref(a);
             *b = a;
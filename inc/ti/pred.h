@@ -0,0 +1,65 @@
+/*
+ * ti/pred.h
+ */
+#ifndef TI_PRED_H_
+#define TI_PRED_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <ti.h>
+#include <ti/closure.t.h>
+#include <ti/query.t.h>
+#include <ti/vset.h>
+#include <tiinc.h>
+#include <util/imap.h>
+#include <util/vec.h>
+
+int ti_pred_init(void);
+void ti_pred_destroy(void);
+_Bool ti_pred_has_threads(void);
+uint8_t * ti_pred_run(ti_closure_t * closure, ti_query_t * query, vec_t * vec);
+
+static inline _Bool ti_pred_enabled(size_t n)
+{
+    return n >= TI_QUERY_THREADS_MIN_ITEMS && ti_pred_has_threads();
+}
+
+/*
+ * Returns the outcome of `closure` (0 or 1) for each value in the list, or
+ * NULL if the closure must be called for each value instead. The return
+ * value must be freed by the caller.
+ */
+static inline uint8_t * ti_pred_varr(
+        ti_closure_t * closure,
+        ti_query_t * query,
+        vec_t * vec)
+{
+    return ti_pred_enabled(vec->n) ? ti_pred_run(closure, query, vec) : NULL;
+}
+
+/*
+ * Same as ti_pred_varr(..) but for a set. When successful, `vec` is set to
+ * the things in the set (without references) in the order of the results;
+ * both `vec` and the return value must be freed by the caller.
+ */
+static inline uint8_t * ti_pred_vset(
+        ti_closure_t * closure,
+        ti_query_t * query,
+        ti_vset_t * vset,
+        vec_t ** vec)
+{
+    uint8_t * res;
+
+    if (!ti_pred_enabled(vset->imap->n) || !(*vec = imap_vec(vset->imap)))
+        return NULL;
+
+    res = ti_pred_run(closure, query, *vec);
+    if (!res)
+    {
+        free(*vec);
+        *vec = NULL;
+    }
+    return res;
+}
+
+#endif  /* TI_PRED_H_ */
@@ -6,6 +6,7 @@
 
 #include <ti/prop.t.h>
 #include <ti/name.t.h>
+#include <ti/slab.h>
 #include <ti/val.t.h>
 
 ti_prop_t * ti_prop_create(ti_name_t * name, ti_val_t * val);
@@ -14,4 +15,12 @@ void ti_prop_destroy(ti_prop_t * prop);
 void ti_prop_unassign_destroy(ti_prop_t * prop);
 void ti_prop_unsafe_vdestroy(ti_prop_t * prop);
 
+TI_SLAB_ASSERT(ti_prop_t, 16);
+
+/* only frees the prop, the name and value are not touched */
+static inline void ti_prop_free(ti_prop_t * prop)
+{
+    ti_slab_free(prop, sizeof(ti_prop_t));
+}
+
 #endif /* TI_PROP_H_ */
@@ -30,6 +30,9 @@ typedef enum
     TI_PROTO_CLIENT_RES_OK      =17,    /* empty */
     TI_PROTO_CLIENT_RES_DATA    =18,    /* ... */
     TI_PROTO_CLIENT_RES_ERROR   =19,    /* {error_msg:..., error_code: x}   */
+    TI_PROTO_CLIENT_RES_DATA_PART=20,   /* ...part of the data; more parts
+                                           follow and the last part is sent
+                                           as RES_DATA (or RES_ERROR) */
 
     /*
      * 0x0010xxxx  32..63 client requests
@@ -46,6 +49,10 @@ typedef enum
     TI_PROTO_CLIENT_REQ_LEAVE   =39,    /* [scope, ...room id's]}           */
     TI_PROTO_CLIENT_REQ_EMIT    =40,    /* [scope, room_id, event, ...args] */
 
+    /* same as QUERY and RUN but the response might be split in parts */
+    TI_PROTO_CLIENT_REQ_QUERY_STREAM=41,
+    TI_PROTO_CLIENT_REQ_RUN_STREAM  =42,
+
     /*
      * 64..127 modules range
      */
@@ -71,6 +78,8 @@ typedef enum
     TI_PROTO_NODE_ROOM_EMIT         =136,   /* {id:.., args: [..]} */
     TI_PROTO_NODE_FWD_WARN          =137,
     TI_PROTO_NODE_FWD_TASK          =138,   /* [scope_id, task_id] */
+    TI_PROTO_NODE_ROOM_INTEREST     =139,   /* [replace, bin/[pos..]] */
+    TI_PROTO_NODE_CAPS              =140,   /* [caps, reply] */
     /*
      * 160..191 node requests
      */
@@ -80,7 +89,7 @@ typedef enum
     TI_PROTO_NODE_REQ_RUN       =161,   /* [user_id, [original]] */
 
     TI_PROTO_NODE_REQ_CONNECT   =168,   /* [...] */
-    TI_PROTO_NODE_REQ_CHANGE_ID =169,   /* change id */
+    TI_PROTO_NODE_REQ_CHANGE_ID =169,   /* change id or [first_id, n] */
     TI_PROTO_NODE_REQ_AWAY      =170,   /* empty */
     TI_PROTO_NODE_REQ_SETUP     =171,   /* empty */
     TI_PROTO_NODE_REQ_SYNC      =172,   /* change_id */
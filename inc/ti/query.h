@@ -16,6 +16,8 @@
 #include <ti/type.t.h>
 #include <ti/user.t.h>
 #include <ti/vup.t.h>
+#include <string.h>
+#include <util/vec.h>
 
 extern ti_query_done_cb ti_query_done_map[];
 extern ti_query_run_cb ti_query_run_map[];
@@ -61,6 +63,61 @@ int ti_query_task_context(ti_query_t * query, ti_vtask_t * vtask, ex_t * e);
 _Bool ti_query_thing_can_change_spec(ti_query_t * query, ti_thing_t * thing);
 void ti_query_warn_log(ti_query_t * query, const char * msg);
 
+static inline ti_query_var_slot_t * ti_query_var_slot(
+        ti_query_t * query,
+        ti_name_t * name)
+{
+    return &query->var_slots[
+        ((uintptr_t) name >> 4) & (TI_QUERY_VAR_SLOTS - 1)];
+}
+
+/*
+ * Must be called after a variable is pushed on the stack.
+ */
+static inline void ti_query_var_pushed(ti_query_t * query)
+{
+    uint32_t idx = query->vars->n - 1;
+    ti_prop_t * prop = VEC_get(query->vars, idx);
+    ti_query_var_slot_t * slot = ti_query_var_slot(query, prop->name);
+    slot->name = prop->name;
+    slot->idx = idx;
+}
+
+/*
+ * Must be called when variables on the stack are moved.
+ */
+static inline void ti_query_var_slots_reset(ti_query_t * query)
+{
+    memset(query->var_slots, 0, sizeof(query->var_slots));
+}
+
+/*
+ * Returns the position of a variable with the given name in the stack or -1
+ * if the variable is not found.
+ */
+static inline int64_t ti_query_var_idx(ti_query_t * query, ti_name_t * name)
+{
+    ti_query_var_slot_t * slot = ti_query_var_slot(query, name);
+    uint32_t idx = slot->idx;
+
+    if (slot->name == name &&
+        idx < query->vars->n &&
+        ((ti_prop_t *) VEC_get(query->vars, idx))->name == name)
+        return idx;
+
+    idx = query->vars->n;
+    while (idx--)
+    {
+        if (((ti_prop_t *) VEC_get(query->vars, idx))->name == name)
+        {
+            slot->name = name;
+            slot->idx = idx;
+            return idx;
+        }
+    }
+    return -1;
+}
+
 static inline _Bool ti_query_wse(ti_query_t * query)
 {
     return query->qbind.flags & TI_QBIND_FLAG_WSE;
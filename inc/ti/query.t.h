@@ -5,6 +5,7 @@
 #define TI_QUERY_T_H_
 
 typedef struct ti_query_s ti_query_t;
+typedef struct ti_query_var_slot_s ti_query_var_slot_t;
 typedef int (*ti_query_vars_walk_cb)(void * data, void * arg);
 
 #include <cleri/cleri.h>
@@ -14,6 +15,7 @@ typedef int (*ti_query_vars_walk_cb)(void * data, void * arg);
 #include <ti/change.t.h>
 #include <ti/flags.h>
 #include <ti/future.t.h>
+#include <ti/name.t.h>
 #include <ti/qbind.t.h>
 #include <ti/stream.t.h>
 #include <ti/vtask.t.h>
@@ -37,6 +39,8 @@ enum
     TI_QUERY_FLAG_TASK_CHANGES      =1<<4,  /* mark when this query has handled
                                                all required task changes */
     TI_QUERY_FLAG_RETURN_NO_IDS     =TI_FLAGS_NO_IDS,  /* return no id's */
+    TI_QUERY_FLAG_STREAM            =1<<6,  /* the response may be written
+                                               in parts */
 };
 
 typedef enum
@@ -56,6 +60,21 @@ typedef int (*ti_query_unpack_cb) (
         ex_t *);
 
 typedef void (*ti_query_done_cb) (ti_query_t *, ex_t *);
+
+/* number of variable slots, must be a power of 2 */
+#define TI_QUERY_VAR_SLOTS 16
+
+/*
+ * Remembers the position of a variable in the `query->vars` stack. A slot is
+ * updated each time a variable is pushed on the stack and is only used when
+ * the variable at the position still has the same name. This is safe as the
+ * last pushed variable is always the one which must be used.
+ */
+struct ti_query_var_slot_s
+{
+    ti_name_t * name;           /* weak reference */
+    uint32_t idx;               /* position in query->vars */
+};
 typedef void (*ti_query_run_cb) (ti_query_t *);
 
 typedef union
@@ -98,6 +117,7 @@ struct ti_query_s
                                 */
     link_t futures;             /* place to store futures */
     util_time_t time;           /* time query duration */
+    ti_query_var_slot_t var_slots[TI_QUERY_VAR_SLOTS];
 };
 
 #endif /* TI_QUERY_T_H_ */
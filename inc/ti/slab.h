@@ -0,0 +1,68 @@
+/*
+ * ti/slab.h
+ *
+ * Size classes for small value objects like integers, floats, properties
+ * and things. The slab allocator is only used when ThingsDB is build with
+ * the `THINGSDB_SLAB` option, otherwise malloc() and free() are used.
+ */
+#ifndef TI_SLAB_H_
+#define TI_SLAB_H_
+
+#include <stdlib.h>
+#include <util/mpack.h>
+#include <util/slab.h>
+
+enum
+{
+    TI_SLAB_16,
+    TI_SLAB_32,
+    TI_SLAB_48,
+    TI_SLAB_N,
+};
+
+/* the size is known at compile time so the class resolves to a constant */
+#define TI_SLAB_CLASS(__sz) \
+    ((__sz) <= 16 ? TI_SLAB_16 : (__sz) <= 32 ? TI_SLAB_32 : TI_SLAB_48)
+
+/*
+ * Each type allocated from the slab asserts the class it expects; a type
+ * which grows would otherwise silently move to a larger class, or overflow
+ * the largest class.
+ */
+#define TI_SLAB_ASSERT(__tp, __sz) \
+    _Static_assert(sizeof(__tp) <= (__sz) && (__sz) <= 48, \
+        "`" #__tp "` does not fit in the " #__sz " byte slab class")
+
+void ti_slab_destroy(void);
+int ti_slab_to_pk(msgpack_packer * pk);
+
+#ifdef TI_WITH_SLAB
+
+extern slab_t ti_slabs[TI_SLAB_N];
+
+static inline void * ti_slab_alloc(size_t sz)
+{
+    return slab_alloc(&ti_slabs[TI_SLAB_CLASS(sz)]);
+}
+
+static inline void ti_slab_free(void * data, size_t sz)
+{
+    slab_free(&ti_slabs[TI_SLAB_CLASS(sz)], data);
+}
+
+#else
+
+static inline void * ti_slab_alloc(size_t sz)
+{
+    return malloc(sz);
+}
+
+static inline void ti_slab_free(void * data, size_t sz)
+{
+    (void) sz;
+    free(data);
+}
+
+#endif  /* TI_WITH_SLAB */
+
+#endif  /* TI_SLAB_H_ */
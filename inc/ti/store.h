@@ -7,6 +7,8 @@
 typedef struct ti_store_s ti_store_t;
 
 #include <inttypes.h>
+#include <ti/collection.t.h>
+#include <util/imap.h>
 #include <util/vec.h>
 
 int ti_store_create(void);
@@ -14,6 +16,9 @@ int ti_store_init(void);
 void ti_store_destroy(void);
 int ti_store_store(void);
 int ti_store_restore(void);
+int ti_store_load_collection(ti_collection_t * collection);
+int ti_store_load_start(void);
+void ti_store_load_stop(void);
 
 struct ti_store_s
 {
@@ -31,6 +36,10 @@ struct ti_store_s
     char * modules_fn;
     size_t fn_offset;
     vec_t * collection_ids;             /* stored collection id's, uint64_t */
+    imap_t * namesmap;                  /* names for unloaded collections,
+                                           NULL when all are loaded */
+    _Bool foreign_names;                /* the names in the store are
+                                           written by another process */
     uint64_t last_stored_change_id;     /* last change Id in full database store */
 };
 
@@ -46,6 +46,9 @@ char * ti_store_collection_gcprops_fn(
 char * ti_store_collection_gcthings_fn(
         const char * path,
         uint64_t collection_id);
+char * ti_store_collection_names_fn(
+        const char * path,
+        uint64_t collection_id);
 
 struct ti_store_collection_s
 {
@@ -10,6 +10,7 @@
 #include <ti/rpkg.t.h>
 #include <ti/stream.t.h>
 #include <ti/user.t.h>
+#include <ti/write.h>
 #include <uv.h>
 
 ti_stream_t * ti_stream_create(ti_stream_enum tp, ti_stream_pkg_cb cb);
@@ -24,6 +25,11 @@ const char * ti_stream_name(ti_stream_t * stream);
 void ti_stream_on_response(ti_stream_t * stream, ti_pkg_t * pkg);
 int ti_stream_write_pkg(ti_stream_t * stream, ti_pkg_t * pkg);
 int ti_stream_write_rpkg(ti_stream_t * stream, ti_rpkg_t * rpkg);
+int ti_stream_write_pkg_direct(
+        ti_stream_t * stream,
+        ti_pkg_t * pkg,
+        ti_write_direct_cb cb,
+        void * arg);
 size_t ti_stream_client_connections(void);
 
 static inline _Bool ti_stream_is_closed(ti_stream_t * stream)
@@ -31,6 +37,17 @@ static inline _Bool ti_stream_is_closed(ti_stream_t * stream)
     return !stream || (stream->flags & TI_STREAM_FLAG_CLOSED);
 }
 
+/*
+ * Returns the number of bytes which are queued but not yet written; this is
+ * always 0 for WebSocket streams.
+ */
+static inline size_t ti_stream_queued(ti_stream_t * stream)
+{
+    return (stream->tp == TI_STREAM_WS_IN_CLIENT || !stream->with.uvstream)
+            ? 0
+            : stream->with.uvstream->write_queue_size;
+}
+
 static inline _Bool ti_stream_is_client(ti_stream_t * stream)
 {
     return stream && (
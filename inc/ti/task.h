@@ -113,6 +113,7 @@ int ti_task_add_mod_type_ren(
         ti_name_t * newname);
 int ti_task_add_mod_type_wpo(ti_task_t * task, ti_type_t * type);
 int ti_task_add_mod_type_hid(ti_task_t * task, ti_type_t * type);
+int ti_task_add_mod_type_idx(ti_task_t * task, ti_field_t * field);
 int ti_task_add_del_node(ti_task_t * task, uint32_t node_id);
 int ti_task_add_set_remove(ti_task_t * task, ti_raw_t * key, vec_t * removed);
 int ti_task_add_rename_collection(
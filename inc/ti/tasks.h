@@ -5,7 +5,9 @@
 #define TI_TASKS_H_
 
 typedef struct ti_tasks_s ti_tasks_t;
+typedef struct ti_tasks_sched_s ti_tasks_sched_t;
 
+#include <ti/collection.t.h>
 #include <ti/vtask.t.h>
 #include <ti/user.t.h>
 #include <ti/varr.t.h>
@@ -15,20 +17,42 @@ typedef struct ti_tasks_s ti_tasks_t;
 int ti_tasks_create(void);
 int ti_tasks_start(void);
 void ti_tasks_stop(void);
-int ti_tasks_append(vec_t ** vtasks, ti_vtask_t * vtask);
+int ti_tasks_append(
+        vec_t ** vtasks,
+        ti_vtask_t * vtask,
+        ti_collection_t * collection);
 void ti_tasks_clear_dropped(vec_t ** vtasks);
+void ti_tasks_del_collection(ti_collection_t * collection);
 void ti_tasks_del_user(ti_user_t * user);
 void ti_tasks_clear_all(void);
 ti_varr_t * ti_tasks_list(vec_t * tasks);
 vec_t * ti_tasks_from_scope_id(uint64_t scope_id);
-void ti_tasks_reset_lowest_run_at(void);
-void ti_tasks_vtask_finish(ti_vtask_t * vtask);
+void ti_tasks_reschedule(void);
+void ti_tasks_vtask_finish(ti_vtask_t * vtask, ti_collection_t * collection);
+
+/*
+ * Scheduled tasks are kept in a binary min-heap ordered by `at`. Entries
+ * are not removed when a task is cancelled, deleted or re-scheduled; instead
+ * an entry is validated when it is due and skipped when the `run_at` value
+ * of the task no longer matches the entry.
+ */
+struct ti_tasks_sched_s
+{
+    uint64_t at;                /* time to handle the entry */
+    uint64_t run_at;            /* run_at value when scheduled */
+    uint64_t scope_id;          /* collection Id or TI_SCOPE_THINGSDB */
+    ti_vtask_t * vtask;         /* with reference */
+};
 
 struct ti_tasks_s
 {
     _Bool is_stopping;
     _Bool is_started;
-    uint64_t lowest_run_at;     /* earliest known run_at value */
+    _Bool do_reschedule;        /* rebuild the heap on the next callback */
+    uint32_t sched_n;           /* number of entries in the heap */
+    uint32_t sched_sz;          /* allocated size of the heap */
+    uint64_t timer_at;          /* time the timer is set for, or 0 */
+    ti_tasks_sched_t * sched;   /* heap with tasks owned by this node */
     vec_t * vtasks;             /* ti_vtask_t */
     uv_timer_t * timer;
 };
@@ -8,6 +8,7 @@ typedef struct ti_token_s ti_token_t;
 typedef char ti_token_key_t[22];    /* token using 22 base64 characters */
 
 #include <stdint.h>
+#include <ti/user.t.h>
 
 struct ti_token_s
 {
@@ -15,6 +16,7 @@ struct ti_token_s
     uint64_t expire_ts;         /* 0 if not set (UNIX time in seconds) */
     uint64_t created_at;        /* UNIX time in seconds */
     char * description;         /* may be empty */
+    ti_user_t * user;           /* borrowed, NULL if not added to a user */
 };
 
 #endif /* TI_TOKEN_T_H_ */
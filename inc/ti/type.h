@@ -6,6 +6,7 @@
 
 #include <ex.h>
 #include <inttypes.h>
+#include <stdlib.h>
 #include <ti/change.t.h>
 #include <ti/closure.t.h>
 #include <ti/method.t.h>
@@ -17,6 +18,11 @@
 #include <util/mpack.h>
 #include <util/vec.h>
 
+/* use a lookup table when a type has at least this many fields/methods */
+#define TI_TYPE_LOOKUP_MIN 8
+#define TI_TYPE_LOOKUP_EMPTY UINT32_MAX
+#define TI_TYPE_LOOKUP_METHOD 0x80000000U
+
 ti_type_t * ti_type_create(
         ti_types_t * types,
         uint16_t type_id,
@@ -29,6 +35,12 @@ void ti_type_drop(ti_type_t * type);
 void ti_type_del(ti_type_t * type, vec_t * vars);
 void ti_type_destroy(ti_type_t * type);
 void ti_type_map_cleanup(ti_type_t * type);
+int ti_type_lookup_create(ti_type_t * type);
+int ti_type_instances_create(ti_type_t * type);
+int ti_type_walk_instances(ti_type_t * type, imap_cb cb, void * arg);
+void ti_type_indexes_add(ti_type_t * type, ti_thing_t * thing);
+void ti_type_indexes_del(ti_type_t * type, ti_thing_t * thing);
+void ti_type_indexes_clear(ti_type_t * type);
 size_t ti_type_fields_approx_pack_sz(ti_type_t * type);
 int ti_type_init_from_thing(ti_type_t * type, ti_thing_t * thing, ex_t * e);
 int ti_type_init_from_unp(
@@ -69,6 +81,27 @@ int ti_type_required_by_non_wpo(ti_type_t * type, ex_t * e);
 int ti_type_uses_wpo(ti_type_t * type, ex_t * e);
 int ti_type_rename(ti_type_t * type, ti_raw_t * nname);
 
+/*
+ * Adds a thing to the instance index, if the index is in use. The thing must
+ * have an id. When out of memory, the index is removed and will be re-created
+ * on next use.
+ */
+static inline void ti_type_instances_add(ti_type_t * type, ti_thing_t * thing)
+{
+    if (type->instances &&
+        imap_add(type->instances, thing->id, thing) == IMAP_ERR_ALLOC)
+    {
+        imap_destroy(type->instances, NULL);
+        type->instances = NULL;
+    }
+}
+
+static inline void ti_type_instances_del(ti_type_t * type, ti_thing_t * thing)
+{
+    if (type->instances)
+        (void) imap_pop(type->instances, thing->id);
+}
+
 static inline int ti_type_use(ti_type_t * type, ex_t * e)
 {
     if (type->flags & TI_TYPE_FLAG_LOCK)
@@ -182,10 +215,62 @@ static inline int ti_type_wrap_only_e(ti_type_t * type, ex_t * e)
     return e->nr;
 }
 
+/*
+ * Names are unique so the pointer address can be used as hash.
+ */
+static inline uint32_t ti_type_lookup_hash(ti_name_t * name)
+{
+    uint64_t p = (uintptr_t) name;
+    return (uint32_t) ((p >> 3) * 0x9e3779b97f4a7c15ULL >> 32);
+}
+
+/*
+ * Must be called after a field or method is added, removed or renamed.
+ */
+static inline void ti_type_lookup_clear(ti_type_t * type)
+{
+    free(type->lookup);
+    type->lookup = NULL;
+}
+
+/*
+ * Returns `true` when the lookup table should be used for finding a field or
+ * method. The table is created when it does not exist, and if creating the
+ * table fails, a linear search will be used instead.
+ */
+static inline _Bool ti_type_use_lookup(ti_type_t * type)
+{
+    return (
+        type->fields->n + type->methods->n >= TI_TYPE_LOOKUP_MIN &&
+        (type->lookup || ti_type_lookup_create(type) == 0)
+    );
+}
+
 static inline ti_method_t * ti_type_get_method(
         ti_type_t * type,
         ti_name_t * name)
 {
+    if (ti_type_use_lookup(type))
+    {
+        ti_type_lookup_t * lookup = type->lookup;
+        uint32_t slot, i = ti_type_lookup_hash(name);
+        ti_method_t * method;
+
+        while ((slot = lookup->slots[i++ & lookup->mask])
+                != TI_TYPE_LOOKUP_EMPTY)
+        {
+            if (slot & TI_TYPE_LOOKUP_METHOD)
+            {
+                method = VEC_get(
+                        type->methods,
+                        slot & ~TI_TYPE_LOOKUP_METHOD);
+                if (method->name == name)
+                    return method;
+            }
+        }
+        return NULL;
+    }
+
     for (vec_each(type->methods, ti_method_t, method))
         if (method->name == name)
             return method;
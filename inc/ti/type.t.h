@@ -9,9 +9,12 @@ enum
     TI_TYPE_FLAG_LOCK       =1<<0,
     TI_TYPE_FLAG_WRAP_ONLY  =1<<1,
     TI_TYPE_FLAG_HIDE_ID    =1<<2,
+    TI_TYPE_FLAG_INDEXED    =1<<3,  /* runtime only, at least one field has
+                                       an index in use */
 };
 
 typedef struct ti_type_s ti_type_t;
+typedef struct ti_type_lookup_s ti_type_lookup_t;
 
 #include <inttypes.h>
 #include <ti/raw.t.h>
@@ -47,6 +50,21 @@ struct ti_type_s
     vec_t * fields;         /* ti_field_t */
     vec_t * methods;        /* ti_method_t */
     imap_t * t_mappings;    /* from_type_id / vec_t * with ti_field_t */
+    ti_type_lookup_t * lookup;  /* hash table for finding fields and methods
+                                   by name; created on first use and cleared
+                                   when fields or methods are added, removed
+                                   or renamed (may be NULL) */
+    imap_t * instances;     /* ti_thing_t with an id, by thing id; created
+                               on first use by type scoped operations and
+                               maintained from then on (may be NULL) */
+};
+
+struct ti_type_lookup_s
+{
+    uint32_t mask;          /* number of slots - 1 (number is a power of 2) */
+    uint32_t slots[];       /* field index, method index with the
+                               TI_TYPE_LOOKUP_METHOD bit set, or
+                               TI_TYPE_LOOKUP_EMPTY */
 };
 
 #endif  /* TI_TYPE_T_H_ */
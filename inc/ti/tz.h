@@ -5,6 +5,8 @@
 #define TI_TZ_H_
 
 #include <stddef.h>
+#include <time.h>
+#include <ti/tzinfo.h>
 #include <ti/val.t.h>
 typedef struct ti_tz_s ti_tz_t;
 
@@ -15,12 +17,13 @@ struct ti_tz_s
     char * name;    /* null terminated string */
     size_t n;       /* size excluding null terminator */
     size_t index;   /* index number */
+    ti_tzinfo_t * info;     /* zone info, NULL if not (yet) loaded */
+    _Bool is_loaded;        /* set when loading the zone info is done */
 };
 
 void ti_tz_init(void);
-void ti_tz_set_utc(void);
-void ti_tz_set(ti_tz_t * tz);
-void ti_tz_set_offset(int16_t offset);
+int ti_tz_localtime(ti_tz_t * tz, time_t ts, struct tm * tm);
+time_t ti_tz_mktime(ti_tz_t * tz, struct tm * tm);
 ti_tz_t * ti_tz_utc(void);
 ti_tz_t * ti_tz_from_index(size_t tz_index);
 ti_tz_t * ti_tz_from_strn(register const char * s, register size_t n);
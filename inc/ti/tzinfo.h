@@ -0,0 +1,23 @@
+/*
+ * ti/tzinfo.h
+ *
+ * Time zone rules, read from a compiled zoneinfo (TZif) file. This allows
+ * converting between UTC and local time without changing the process wide
+ * `TZ` environment variable.
+ */
+#ifndef TI_TZINFO_H_
+#define TI_TZINFO_H_
+
+#define TI_TZINFO_PATH "/usr/share/zoneinfo"
+
+#include <inttypes.h>
+#include <time.h>
+
+typedef struct ti_tzinfo_s ti_tzinfo_t;
+
+ti_tzinfo_t * ti_tzinfo_load(const char * name);
+void ti_tzinfo_destroy(ti_tzinfo_t * info);
+int ti_tzinfo_localtime(ti_tzinfo_t * info, int64_t ts, struct tm * tm);
+int ti_tzinfo_mktime(ti_tzinfo_t * info, struct tm * tm, int64_t * ts);
+
+#endif  /* TI_TZINFO_H_ */
@@ -20,7 +20,7 @@ ti_user_t* ti_user_create(
         const char * encrpass,
         uint64_t created_at);
 void ti_user_drop(ti_user_t * user);
-static inline int ti_user_add_token(ti_user_t * user, ti_token_t * token);
+int ti_user_add_token(ti_user_t * user, ti_token_t * token);
 void ti_user_del_expired(ti_user_t * user, uint64_t after_ts);
 _Bool ti_user_name_check(const char * name, size_t n, ex_t * e);
 _Bool ti_user_pass_check(const char * passstr, ex_t * e);
@@ -30,9 +30,4 @@ int ti_user_info_to_pk(ti_user_t * user, msgpack_packer * pk);
 ti_val_t * ti_user_as_mpval(ti_user_t * user);
 ti_token_t * ti_user_pop_token_by_key(ti_user_t * user, ti_token_key_t * key);
 
-static inline int ti_user_add_token(ti_user_t * user, ti_token_t * token)
-{
-    return vec_push(&user->tokens, token);
-}
-
 #endif /* TI_USER_H_ */
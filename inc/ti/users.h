@@ -7,6 +7,7 @@
 #include <ex.h>
 #include <stdint.h>
 #include <ti/raw.h>
+#include <ti/token.t.h>
 #include <ti/user.h>
 #include <ti/val.h>
 #include <util/mpack.h>
@@ -38,5 +39,8 @@ ti_varr_t * ti_users_info(void);
 void ti_users_del_expired(uint64_t after_ts);
 _Bool ti_users_has_token(ti_token_key_t * key);
 ti_token_t * ti_users_pop_token_by_key(ti_token_key_t * key);
+int ti_users_index_token(ti_token_t * token);
+void ti_users_unindex_token(ti_token_t * token);
+void ti_users_clear_basic_cache(void);
 
 #endif /* TI_USERS_H_ */
@@ -273,7 +273,7 @@ static ti_val_type_t ti_val_type_props[22] = {
     },
     /* TI_VAL_INT */
     {
-        .destroy = (ti_val_destroy_cb) free,
+        .destroy = (ti_val_destroy_cb) ti_vint_free,
         .to_str = ti_val_int_to_str,
         .to_arr_cb = val__to_arr_cb,
         .to_client_pk = val__int_to_client_pk,
@@ -283,7 +283,7 @@ static ti_val_type_t ti_val_type_props[22] = {
     },
     /* TI_VAL_FLOAT */
     {
-        .destroy = (ti_val_destroy_cb) free,
+        .destroy = (ti_val_destroy_cb) ti_vfloat_free,
         .to_str = ti_val_float_to_str,
         .to_arr_cb = val__to_arr_cb,
         .to_client_pk = val__float_to_client_pk,
@@ -6,6 +6,9 @@
 
 typedef struct ti_vfloat_s ti_vfloat_t;
 
+#include <inttypes.h>
+#include <ti/slab.h>
+
 #define VFLOAT(__x) ((ti_vfloat_t *) (__x))->float_
 
 ti_vfloat_t * ti_vfloat_create(double d);
@@ -20,9 +23,11 @@ struct ti_vfloat_s
     double float_;
 };
 
+TI_SLAB_ASSERT(ti_vfloat_t, 16);
+
 static inline void ti_vfloat_free(ti_vfloat_t * vfloat)
 {
-    free(vfloat);
+    ti_slab_free(vfloat, sizeof(ti_vfloat_t));
 }
 
 #endif  /* TI_VFLOAT_H_ */
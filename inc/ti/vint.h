@@ -6,6 +6,7 @@
 
 #include <stdlib.h>
 #include <inttypes.h>
+#include <ti/slab.h>
 
 typedef struct ti_vint_s ti_vint_t;
 
@@ -24,9 +25,11 @@ struct ti_vint_s
     int64_t int_;
 };
 
+TI_SLAB_ASSERT(ti_vint_t, 16);
+
 static inline void ti_vint_free(ti_vint_t * vint)
 {
-    free(vint);
+    ti_slab_free(vint, sizeof(ti_vint_t));
 }
 
 #endif  /* TI_VINT_H_ */
@@ -5,6 +5,7 @@
 #define TI_WRITE_H_
 
 typedef struct ti_write_s ti_write_t;
+typedef void (*ti_write_direct_cb)(void * arg, int status);
 
 #include <uv.h>
 #include <ti/stream.h>
@@ -19,6 +20,13 @@ int ti_write(
         void * data,
         ti_write_cb cb);
 void ti_write_destroy(ti_write_t * req);
+int ti_write_direct(
+        uv_stream_t * uvstream,
+        char * data,
+        size_t n,
+        void * buf,
+        ti_write_direct_cb cb,
+        void * arg);
 
 struct ti_write_s
 {
@@ -28,6 +28,15 @@
 /* Cached query expiration time in seconds */
 #define TI_DEFAULT_CACHE_EXPIRATION_TIME 900UL
 
+/* Number of threads used to store and load collections */
+#define TI_DEFAULT_STORE_THREADS 4
+
+/* Number of threads used to test simple closures; 1 disables threading */
+#define TI_DEFAULT_QUERY_THREADS 1
+
+/* Minimal size of a list or set before query threads are used */
+#define TI_QUERY_THREADS_MIN_ITEMS 8192
+
 #define TI_COLLECTION_ID "`collection:%"PRIu64"`"
 #define TI_CHANGE_ID "`change:%"PRIu64"`"
 #define TI_NODE_ID "`node:%"PRIu32"`"
@@ -0,0 +1,36 @@
+/*
+ * argsort.h
+ */
+#ifndef ARGSORT_H_
+#define ARGSORT_H_
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <string.h>
+
+#define ARGSORT__SIGN 0x8000000000000000ULL
+
+int argsort_u64(uint64_t * keys, uint32_t * idx, size_t n);
+
+/*
+ * Returns a key which sorts unsigned in the same order as the signed integer.
+ */
+static inline uint64_t argsort_key_i64(int64_t i)
+{
+    return (uint64_t) i ^ ARGSORT__SIGN;
+}
+
+/*
+ * Returns a key which sorts unsigned in the same order as the double; -0.0
+ * and 0.0 share the same key. NaN values are sorted after infinity.
+ */
+static inline uint64_t argsort_key_f64(double d)
+{
+    uint64_t u;
+    if (d == 0.0)
+        d = 0.0;
+    memcpy(&u, &d, sizeof(uint64_t));
+    return (u & ARGSORT__SIGN) ? ~u : u | ARGSORT__SIGN;
+}
+
+#endif  /* ARGSORT_H_ */
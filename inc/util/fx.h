@@ -7,6 +7,7 @@
 #include <stddef.h>
 #include <sys/types.h>
 #include <limits.h>
+#include <stdbool.h>
 #include <string.h>
 
 #ifndef PATH_MAX
@@ -20,6 +21,7 @@
 typedef struct fx_mmap_s fx_mmap_t;
 
 int fx_write(const char * fn, const void * data, size_t n);
+int fx_copy(const char * src, const char * dst);
 unsigned char * fx_read(const char * fn, ssize_t * size);
 _Bool fx_file_exist(const char * fn);
 _Bool fx_is_executable(const char * fn);
@@ -44,6 +46,7 @@ struct fx_mmap_s
     size_t n;
     const char * fn;
     int _fd;
+    _Bool _is_alloc;                /* data is decompressed in memory */
 };
 
 static inline char * fx_path_join(const char * s1, const char * s2)
@@ -55,6 +58,7 @@ static inline void fx_mmap_init(fx_mmap_t * x, const char * fn)
 {
     x->fn = fn;
     x->data = NULL;
+    x->_is_alloc = false;
 }
 
 #endif /* FX_H_ */
@@ -0,0 +1,51 @@
+/*
+ * util/fz.h
+ *
+ * Block compressed files. A compressed file starts with a header which is
+ * followed by blocks, each compressed (zlib) independently:
+ *
+ *   header:    "TIZ" <version:u8> <size:u64>
+ *   block:     <compressed size:u32> <size:u32> <data>
+ *
+ * All integer values are written little endian. Files without the header
+ * are not compressed; readers accept both. A single block may also be used
+ * on its own, for example to compress a part of a file.
+ */
+#ifndef FZ_H_
+#define FZ_H_
+
+#define FZ_VERSION 1
+#define FZ_HEADER_SZ 12
+#define FZ_BLOCK_HEADER_SZ 8
+#define FZ_BLOCK_SZ 262144
+
+#include <stddef.h>
+#include <stdio.h>
+
+typedef struct fz_s fz_t;
+
+fz_t * fz_open(const char * fn, int level);
+int fz_write(void * data, const char * buf, size_t len);
+int fz_close(fz_t * fz);
+_Bool fz_is_compressed(const void * data, size_t n);
+void * fz_decompress(const void * data, size_t n, size_t * size);
+size_t fz_block_bound(size_t n);
+size_t fz_block_compress(
+        unsigned char * dst,
+        const void * src,
+        size_t n,
+        int level);
+size_t fz_block_size(const void * data, size_t n);
+int fz_block_decompress(unsigned char * dst, const void * data, size_t n);
+
+struct fz_s
+{
+    FILE * f;
+    int level;                  /* compression level, 0 for a raw file */
+    size_t n;                   /* number of bytes in the current block */
+    size_t size;                /* total number of bytes written */
+    unsigned char * block;
+    unsigned char * zbuf;
+};
+
+#endif  /* FZ_H_ */
@@ -16,7 +16,7 @@ typedef struct imap_s imap_t;
 
 typedef int (*imap_cb)(void * data, void * arg);
 typedef void (*imap_destroy_cb)(void * data);
-typedef void (*imap_update_cb)(
+typedef int (*imap_update_cb)(
         imap_t * dest,
         imap_t * imap,
         imap_destroy_cb decref_cb);
@@ -34,6 +34,7 @@ void * imap_get(imap_t * imap, uint64_t id);
 void * imap_pop(imap_t * imap, uint64_t id);
 void * imap_one(imap_t * imap);
 int imap_walk(imap_t * imap, imap_cb cb, void * arg);
+int imap_walk_from(imap_t * imap, uint64_t id, imap_cb cb, void * arg);
 int imap_walk_cp(
         imap_t * imap,
         imap_cb cb,
@@ -48,34 +49,40 @@ vec_t * imap_vec_ref(imap_t * imap);
 uint64_t imap_unused_id(imap_t * imap, uint64_t max);
 
 /* union `|` */
-void imap_union_move(imap_t * dest, imap_t * imap);
+int imap_union_move(imap_t * dest, imap_t * imap);
 int imap_union_make(imap_t * dest, imap_t * a, imap_t * b);
 
 /* difference `-` */
-void imap_difference_inplace(imap_t * dest, imap_t * imap);
+int imap_difference_inplace(imap_t * dest, imap_t * imap);
 int imap_difference_make(imap_t * dest, imap_t * a, imap_t * b);
 
 /* intersection `&` */
-void imap_intersection_inplace(imap_t * dest, imap_t * imap, imap_destroy_cb cb);
+int imap_intersection_inplace(
+        imap_t * dest,
+        imap_t * imap,
+        imap_destroy_cb cb);
 int imap_intersection_make(imap_t * dest, imap_t * a, imap_t * b);
 
 /* symmetric difference `^` */
-void imap_symmdiff_move(imap_t * dest, imap_t * imap, imap_destroy_cb cb);
+int imap_symmdiff_move(imap_t * dest, imap_t * imap, imap_destroy_cb cb);
 int imap_symmdiff_make(imap_t * dest, imap_t * a, imap_t * b);
 
+/*
+ * Each node covers 6 bits of an id; The `bits` tell which child nodes (or
+ * items for the lowest level) exist while `items` only holds the existing
+ * ones, ordered by id. The root is at level `height - 1`.
+ */
 struct imap_node_s
 {
-    uint32_t sz;
-    uint8_t key;
-    long:24;
-    void * data;
-    imap_node_t * nodes;
+    uint64_t bits;
+    void * items[];
 };
 
 struct imap_s
 {
     size_t n;
-    imap_node_t nodes[];
+    uint32_t height;
+    imap_node_t * root;
 };
 
 static inline _Bool imap_eq(imap_t * a, imap_t * b)
@@ -30,115 +30,51 @@ typedef struct
     uint32_t count[YAJL_MAX_DEPTH];
 } mpjson_convert_t;
 
-static yajl_gen_status mp__to_json(yajl_gen g, mp_unp_t * up)
-{
-    mp_obj_t obj;
-    switch (mp_next(up, &obj))
-    {
-    case MP_NEVER_USED:
-        return yajl_gen_in_error_state;
-    case MP_INCOMPLETE:
-        return yajl_gen_in_error_state;
-    case MP_ERR:
-        return yajl_gen_in_error_state;
-    case MP_END:
-        return yajl_gen_status_ok;
-    case MP_I64:
-        return yajl_gen_integer(g, obj.via.i64);
-    case MP_U64:
-        if (obj.via.u64 > INT64_MAX)
-        {
-            char buf[21];
-            int len = sprintf(buf, "%"PRIu64, obj.via.u64);
-            return len > 0
-                    ? yajl_gen_number(g, buf, (size_t) len)
-                    : yajl_gen_in_error_state;
-        }
-        return yajl_gen_integer(g, (int64_t) obj.via.u64);
-    case MP_F64:
-        return yajl_gen_double(g, obj.via.f64);
-    case MP_BIN:
-        return yajl_gen_invalid_string;
-    case MP_STR:
-        return yajl_gen_string(
-                g, (unsigned char *) obj.via.str.data, obj.via.str.n);
-    case MP_BOOL:
-        return yajl_gen_bool(g, obj.via.bool_);
-    case MP_NIL:
-        return yajl_gen_null(g);
-    case MP_ARR:
-    {
-        size_t i = obj.via.sz;
-        yajl_gen_status stat;
-        if ((stat = yajl_gen_array_open(g)) != yajl_gen_status_ok)
-            return stat;
+/*
+ * JSON writer which can be used as the target of a `msgpack_packer`; each
+ * packed value is written as JSON to `buffer` right away, so there is no need
+ * for an intermediate MessagePack buffer.
+ *
+ * When `flush_cb` is set, it is called after a write once the buffer
+ * contains at least `flush_sz` bytes. The callback must take the data and
+ * re-initialize the buffer.
+ */
+typedef struct mpjson_writer_s mpjson_writer_t;
 
-        while (i--)
-            if ((stat = mp__to_json(g, up)) != yajl_gen_status_ok)
-                return stat;
+typedef int (*mpjson_flush_cb)(mpjson_writer_t * w, void * arg);
 
-        return yajl_gen_array_close(g);
-    }
-    case MP_MAP:
-    {
-        size_t i = obj.via.sz;
-        yajl_gen_status stat;
-        if ((stat = yajl_gen_map_open(g)) != yajl_gen_status_ok)
-            return stat;
-
-        while (i--)
-        {
-            if ((stat = mp__to_json(g, up)) != yajl_gen_status_ok ||
-                (stat = mp__to_json(g, up)) != yajl_gen_status_ok)
-                return stat;
-        }
-
-        return yajl_gen_map_close(g);
-    }
-    case MP_EXT:
-        return yajl_gen_in_error_state;
-    }
-    return yajl_gen_in_error_state;
-}
-
-static yajl_gen_status __attribute__((unused))mpjson_mp_to_json(
-        const void * src,
-        size_t src_n,
-        unsigned char ** dst,
-        size_t * dst_n,
-        size_t offset,
-        int flags)
+struct mpjson_writer_s
 {
-    mp_unp_t up;
+    msgpack_sbuffer buffer;     /* must be the first member; the packer data
+                                 * is used as a `msgpack_sbuffer` to check
+                                 * the result size */
     yajl_gen g;
     yajl_gen_status stat;
+    _Bool is_oom;
+    _Bool is_complete;
+    uint8_t hdr_n;              /* bytes received for a partial header */
+    uint8_t hdr_sz;             /* size of the partial header */
+    unsigned char hdr[9];
+    unsigned char * str;        /* string data, split over writes */
+    size_t str_n;
+    size_t str_sz;
+    size_t deep;
+    size_t n[YAJL_MAX_DEPTH];   /* number of values left in a map or array */
+    _Bool is_map[YAJL_MAX_DEPTH];
+    mpjson_flush_cb flush_cb;
+    void * flush_arg;
+    size_t flush_sz;
+};
 
-    mp_unp_init(&up, src, src_n);
-
-    g = yajl_gen_alloc(NULL);
-    if (!g)
-        return yajl_gen_in_error_state;
-
-    yajl_gen_config(g, yajl_gen_beautify, flags & MPJSON_FLAG_BEAUTIFY);
-    yajl_gen_config(g, yajl_gen_validate_utf8, flags & MPJSON_FLAG_VALIDATE_UTF8);
-
-    if ((stat = mp__to_json(g, &up)) == yajl_gen_status_ok)
-    {
-        const unsigned char * tmp;
-        if ((stat = yajl_gen_get_buf(g, &tmp, dst_n)) == yajl_gen_status_ok)
-        {
-            *dst_n += offset;
-            *dst = malloc(*dst_n);
-            if (*dst)
-                memcpy(*dst + offset, tmp, *dst_n - offset);
-            else
-                stat = yajl_gen_in_error_state;
-        }
-    }
-
-    yajl_gen_free(g);
-    return stat;
-}
+int mpjson_writer_init(
+        mpjson_writer_t * w,
+        msgpack_packer * pk,
+        size_t alloc,
+        size_t offset,
+        int flags);
+int mpjson_writer_done(mpjson_writer_t * w);
+void mpjson_writer_destroy(mpjson_writer_t * w);
+void mpjson_writer_set_err(mpjson_writer_t * w, ex_t * e);
 
 static void __attribute__((unused))mpjson__set_err(ex_t * e, yajl_gen_status stat)
 {
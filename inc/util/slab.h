@@ -0,0 +1,37 @@
+/*
+ * slab.h
+ */
+#ifndef SLAB_H_
+#define SLAB_H_
+
+typedef struct slab_s slab_t;
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+#define SLAB_INIT(__sz) {.lock = ATOMIC_FLAG_INIT, .sz = (__sz)}
+
+void slab_init(slab_t * slab, size_t sz);
+void slab_destroy(slab_t * slab);
+void * slab_alloc(slab_t * slab);
+void slab_free(slab_t * slab, void * data);
+
+/*
+ * Slab for objects of a fixed size. Memory is allocated in chunks and freed
+ * objects are kept on a free list for re-use; chunks are only released when
+ * the slab is destroyed. A slab may be used from multiple threads.
+ */
+struct slab_s
+{
+    atomic_flag lock;
+    size_t sz;              /* object size, a multiple of the pointer size */
+    size_t n_total;         /* number of objects in all chunks */
+    size_t n_used;          /* number of objects in use */
+    size_t n_chunks;        /* number of allocated chunks */
+    void * free_list;       /* freed objects */
+    void * chunks;          /* linked list with allocated chunks */
+    char * next;            /* next unused object in the last chunk */
+    char * end;             /* end of the last chunk */
+};
+
+#endif  /* SLAB_H_ */
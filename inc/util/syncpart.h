@@ -11,7 +11,16 @@
 #define SYNCPART_SIZE 131072UL
 #endif
 
-int syncpart_to_pk(msgpack_packer * pk, const char * fn, off_t offset);
+#ifndef SYNCPART_LEVEL
+#define SYNCPART_LEVEL 1
+#endif
+
+int syncpart_to_pk(
+        msgpack_packer * pk,
+        const char * fn,
+        off_t offset,
+        int level,
+        _Bool * is_compressed);
 
 int syncpart_write(
         const char * fn,
@@ -20,4 +29,9 @@ int syncpart_write(
         off_t offset,
         ex_t * e);
 
+unsigned char * syncpart_decompress(
+        const unsigned char * data,
+        size_t * size,
+        ex_t * e);
+
 #endif  /* SYNCPART_H_ */
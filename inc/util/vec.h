@@ -42,6 +42,11 @@ int vec_shrink(vec_t ** vaddr);
 int vec_may_shrink(vec_t ** vaddr);
 static inline void vec_sort(vec_t * vec, vec_sort_cb compare);
 void vec_sort_r(vec_t * vec, vec_sort_r_cb compare, void * arg);
+void vec_partial_sort_r(
+        vec_t * vec,
+        uint32_t k,
+        vec_sort_r_cb compare,
+        void * arg);
 _Bool vec_is_sorting(void);
 
 static inline void * VEC_get(const vec_t * vec, uint32_t i);
@@ -0,0 +1,86 @@
+#!/usr/bin/env python
+"""Write throughput benchmark on a multi-node cluster.
+
+Usage:
+    python bench_changes.py [nodes] [change_id_batch] [writers] [writes]
+
+Each writer is a client connected to one of the nodes (round-robin) which
+performs `writes` sequential changes. Run once with `change_id_batch=1` and
+once with a larger value to compare the throughput with and without change
+id batching.
+"""
+import asyncio
+import sys
+import time
+from lib import run_test
+from lib import default_test_setup
+from lib.testbase import TestBase
+from lib.client import get_client
+
+NUM_NODES = int(sys.argv[1]) if len(sys.argv) > 1 else 3
+CHANGE_ID_BATCH = int(sys.argv[2]) if len(sys.argv) > 2 else 32
+NUM_WRITERS = int(sys.argv[3]) if len(sys.argv) > 3 else 64
+NUM_WRITES = int(sys.argv[4]) if len(sys.argv) > 4 else 500
+
+
+class BenchChanges(TestBase):
+
+    title = 'Benchmark write throughput'
+
+    async def _writer(self, client, n):
+        for i in range(NUM_WRITES):
+            await client.query(f'.w{n} = {i};')
+
+    @default_test_setup(
+            num_nodes=NUM_NODES,
+            seed=1,
+            threshold_full_storage=1_000_000,
+            change_id_batch=CHANGE_ID_BATCH)
+    async def run(self):
+
+        await self.node0.init_and_run()
+
+        client0 = await get_client(self.node0)
+        client0.set_default_scope('//stuff')
+
+        for node in self.nodes[1:]:
+            await node.join_until_ready(client0)
+
+        clients = [client0]
+        for node in self.nodes[1:]:
+            client = await get_client(node)
+            client.set_default_scope('//stuff')
+            clients.append(client)
+
+        # one change to make sure all nodes are in sync
+        await client0.query('.init = true;')
+        await asyncio.sleep(0.5)
+
+        start = time.time()
+        await asyncio.gather(*(
+            self._writer(clients[n % NUM_NODES], n)
+            for n in range(NUM_WRITERS)))
+        duration = time.time() - start
+
+        total = NUM_WRITERS * NUM_WRITES
+        print(
+            f'\n{NUM_NODES} nodes, change_id_batch={CHANGE_ID_BATCH}, '
+            f'{NUM_WRITERS} writers: {total} changes in {duration:.3f}s '
+            f'({total / duration:.0f} changes/s)')
+
+        for n, client in enumerate(clients):
+            counters = await client.query('counters();', scope='@node')
+            print(
+                f'node{n}: '
+                f'batches={counters["change_id_batches"]} '
+                f'batched={counters["change_id_batched"]} '
+                f'largest={counters["largest_change_id_batch"]} '
+                f'quorum_lost={counters["quorum_lost"]}')
+
+        for client in clients:
+            client.close()
+            await client.wait_closed()
+
+
+if __name__ == '__main__':
+    run_test(BenchChanges())
@@ -0,0 +1,71 @@
+#!/usr/bin/env python
+"""Date/time conversion benchmark across several time zones.
+
+Usage:
+    python bench_datetime.py [count]
+
+Each benchmark converts `count` date/time values within a single query; the
+time zone is picked round-robin from `ZONES`.
+"""
+import time
+import sys
+from lib import run_test
+from lib import default_test_setup
+from lib.testbase import TestBase
+from lib.client import get_client
+
+COUNT = int(sys.argv[1]) if len(sys.argv) > 1 else 1_000_000
+ZONES = (
+    'Europe/Amsterdam',
+    'America/New_York',
+    'Asia/Kolkata',
+    'Australia/Sydney',
+    'America/Sao_Paulo',
+)
+
+BENCHMARKS = (
+    ('to', 'dt.to(z);'),
+    ('format', 'dt.to(z).format("%Y-%m-%d %H:%M:%S %Z");'),
+    ('week', 'dt.to(z).week();'),
+    ('yday', 'dt.to(z).yday();'),
+    ('move', 'dt.to(z).move("days", 1);'),
+)
+
+
+class BenchDatetime(TestBase):
+
+    title = 'Benchmark date/time conversion'
+
+    @default_test_setup(num_nodes=1, seed=1)
+    async def run(self):
+
+        await self.node0.init_and_run()
+
+        client = await get_client(self.node0)
+        client.set_default_scope('//stuff')
+
+        zones = ', '.join(f'"{zone}"' for zone in ZONES)
+
+        print(f'\n{COUNT} date/time values across {len(ZONES)} time zones')
+
+        for name, code in BENCHMARKS:
+            start = time.time()
+            await client.query(f'''
+                zones = [{zones}];
+                range({COUNT}).each(|i| {{
+                    dt = datetime(i * 3593);
+                    z = zones[i % {len(ZONES)}];
+                    {code}
+                }});
+            ''')
+            duration = time.time() - start
+            print(
+                f'{name:>8}: {duration:.3f}s '
+                f'({duration / COUNT * 1e9:.0f}ns per value)')
+
+        client.close()
+        await client.wait_closed()
+
+
+if __name__ == '__main__':
+    run_test(BenchDatetime())
@@ -0,0 +1,87 @@
+#!/usr/bin/env python
+"""Direct expression handler benchmark.
+
+Usage:
+    python bench_procedure.py [iterations]
+
+Runs a few typical procedures and a loop within a single query. Values,
+variables and function calls in these procedures are bound to a direct
+handler instead of the generic expression handler. Compare the results with
+a build without the direct handlers to see the effect; both builds walk the
+same parse tree since queries are not compiled to another form.
+"""
+import time
+import sys
+from lib import run_test
+from lib import default_test_setup
+from lib.testbase import TestBase
+from lib.client import get_client
+
+ITERATIONS = int(sys.argv[1]) if len(sys.argv) > 1 else 10_000
+LOOP_SIZE = 1_000_000
+
+PROCEDURES = {
+    'get_value': '|key| .values.get(key, nil)',
+    'add_value': '|key, value| {.values[key] = value; true}',
+    'calc': '|a, b| {c = a * b + 1; c > 100 ? c - 100 : c}',
+    'filter_list': '|limit| .list.filter(|x| x < limit).len()',
+}
+
+CALLS = {
+    'get_value': ('a',),
+    'add_value': ('c', 3),
+    'calc': (7, 21),
+    'filter_list': (50,),
+}
+
+
+class BenchProcedure(TestBase):
+
+    title = 'Benchmark direct expression handlers'
+
+    @default_test_setup(num_nodes=1, seed=1)
+    async def run(self):
+
+        await self.node0.init_and_run()
+
+        client = await get_client(self.node0)
+        client.set_default_scope('//stuff')
+
+        await client.query('''
+            .values = {a: 1, b: 2};
+            .list = range(100);
+        ''')
+
+        for name, code in PROCEDURES.items():
+            await client.query(f'new_procedure("{name}", {code});')
+
+        print(f'\n{ITERATIONS} calls per procedure')
+
+        for name, args in CALLS.items():
+            start = time.time()
+            for _ in range(ITERATIONS):
+                await client.run(name, *args)
+            duration = time.time() - start
+            print(
+                f'{name:>12}: {duration:.3f}s '
+                f'({duration / ITERATIONS * 1e6:.1f}us per call)')
+
+        start = time.time()
+        await client.query(f'''
+            n = 0;
+            for (x in range({LOOP_SIZE})) {{
+                n += x > 10 ? 1 : 0;
+            }};
+            n;
+        ''')
+        duration = time.time() - start
+        print(
+            f'{"for loop":>12}: {duration:.3f}s '
+            f'({duration / LOOP_SIZE * 1e9:.1f}ns per iteration)')
+
+        client.close()
+        await client.wait_closed()
+
+
+if __name__ == '__main__':
+    run_test(BenchProcedure())
@@ -0,0 +1,86 @@
+#!/usr/bin/env python
+"""Benchmark filter(..), find(..), some(..) and every(..) on a large list.
+
+Usage:
+    python bench_query_threads.py [count]
+
+The node is restarted using a different `query_threads` value for each run
+and the duration of each benchmark is reported, together with the speedup
+compared to a single thread.
+"""
+import asyncio
+import sys
+import time
+from lib import run_test
+from lib import default_test_setup
+from lib.testbase import TestBase
+from lib.client import get_client
+
+COUNT = int(sys.argv[1]) if len(sys.argv) > 1 else 2_000_000
+QUERY_THREADS = (1, 2, 4, 8)
+REPEAT = 5
+
+BENCHMARKS = (
+    ('filter', '.items.filter(|x| x.age > 18 && x.score < 2.5).len();'),
+    ('find', '.items.find(|x| x.age == 1000);'),
+    ('some', '.items.some(|x| x.name == "");'),
+    ('every', '.items.every(|x| x.age >= 0);'),
+    ('set', '.set.filter(|x| x.age < 10).len();'),
+)
+
+
+class BenchQueryThreads(TestBase):
+
+    title = 'Benchmark query threads'
+
+    async def _restart(self, query_threads):
+        await self.node0.shutdown(timeout=600)
+        self.node0.query_threads = query_threads
+        self.node0.write_config()
+        self.node0.start()
+        await self.node0.expect(
+            'start listening for node connections', timeout=600)
+
+    @default_test_setup(num_nodes=1, seed=1)
+    async def run(self):
+
+        await self.node0.init_and_run()
+
+        client = await get_client(self.node0)
+        await client.query(r'''
+            .items = range(n).map(|i| {
+                name: `item {i}`,
+                age: i % 100,
+                score: (i % 7) / 2,
+            });
+            .set = set(.items);
+        ''', n=COUNT, scope='//stuff')
+        client.close()
+        await client.wait_closed()
+
+        print(f'\n{COUNT} items')
+
+        base = {}
+        for query_threads in QUERY_THREADS:
+            await self._restart(query_threads)
+            client = await get_client(self.node0)
+            client.set_default_scope('//stuff')
+
+            for name, code in BENCHMARKS:
+                start = time.time()
+                for _ in range(REPEAT):
+                    await client.query(code)
+                duration = (time.time() - start) / REPEAT
+                speedup = base.setdefault(name, duration) / duration
+                print(
+                    f'query_threads={query_threads} {name:>8}: '
+                    f'{duration:.3f}s ({speedup:.2f}x)')
+
+            client.close()
+            await client.wait_closed()
+
+        await asyncio.sleep(0.5)
+
+
+if __name__ == '__main__':
+    run_test(BenchQueryThreads())
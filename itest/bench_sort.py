@@ -0,0 +1,64 @@
+#!/usr/bin/env python
+"""List sort benchmark.
+
+Usage:
+    python bench_sort.py [count]
+
+Each benchmark sorts a list with `count` items within a single query. The
+`range` benchmark only builds the list and can be used as a baseline.
+"""
+import time
+import sys
+from lib import run_test
+from lib import default_test_setup
+from lib.testbase import TestBase
+from lib.client import get_client
+
+COUNT = int(sys.argv[1]) if len(sys.argv) > 1 else 1_000_000
+
+BENCHMARKS = (
+    ('range', 'nums.len();'),
+    ('plain', 'nums.sort().len();'),
+    ('floats', 'floats.sort(true).len();'),
+    ('key', 'items.sort(|x| x.name).len();'),
+    ('compare', 'nums.sort(|a, b| a < b ? -1 : a > b ? 1 : 0).len();'),
+    ('top-10', 'items.sort(|x| x.score, true, 10).len();'),
+    ('top-1000', 'items.sort(|x| x.score, true, 1000).len();'),
+)
+
+
+class BenchSort(TestBase):
+
+    title = 'Benchmark sorting lists'
+
+    @default_test_setup(num_nodes=1, seed=1)
+    async def run(self):
+
+        await self.node0.init_and_run()
+
+        client = await get_client(self.node0)
+        client.set_default_scope('//stuff')
+
+        print(f'\n{COUNT} items per list')
+
+        for name, code in BENCHMARKS:
+            start = time.time()
+            n = await client.query(f'''
+                nums = range({COUNT}).map(|i| i * 7919 % {COUNT});
+                floats = nums.map(|i| i / 7.0);
+                items = nums.map(|i| {{
+                    name: str(i),
+                    score: i % 1000,
+                }});
+                {code}
+            ''')
+            duration = time.time() - start
+            assert n in (COUNT, 10, 1000), n
+            print(f'{name:>10}: {duration:.3f}s')
+
+        client.close()
+        await client.wait_closed()
+
+
+if __name__ == '__main__':
+    run_test(BenchSort())
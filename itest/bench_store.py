@@ -0,0 +1,78 @@
+#!/usr/bin/env python
+"""Startup and full store benchmark over a synthetic multi-collection store.
+
+Usage:
+    python bench_store.py [collections] [things-per-collection]
+
+The store is created once; the node is then restarted using a different
+`store_threads` value for each run and the time it takes before the node
+starts listening is reported.
+"""
+import asyncio
+import sys
+import time
+from lib import run_test
+from lib import default_test_setup
+from lib.testbase import TestBase
+from lib.client import get_client
+
+NUM_COLLECTIONS = int(sys.argv[1]) if len(sys.argv) > 1 else 100
+NUM_THINGS = int(sys.argv[2]) if len(sys.argv) > 2 else 20_000
+STORE_THREADS = (1, 2, 4, 8)
+
+
+class BenchStore(TestBase):
+
+    title = 'Benchmark store and load'
+
+    async def _restart(self, store_threads):
+        await self.node0.shutdown(timeout=600)
+        self.node0.store_threads = store_threads
+        self.node0.write_config()
+        start = time.time()
+        self.node0.start()
+        await self.node0.expect(
+            'start listening for node connections', timeout=600)
+        return time.time() - start
+
+    @default_test_setup(num_nodes=1, seed=1, threshold_full_storage=0)
+    async def run(self):
+
+        await self.node0.init_and_run()
+
+        client = await get_client(self.node0)
+
+        for i in range(NUM_COLLECTIONS):
+            name = f'bench{i}'
+            await client.query(f'new_collection("{name}");')
+            await client.query(r'''
+                .items = range(n).map(|i| {
+                    name: `item {i}`,
+                    value: i * 1.5,
+                    tags: ['a', 'b', 'c'],
+                });
+            ''', n=NUM_THINGS, scope=f'@:{name}')
+
+        client.close()
+        await client.wait_closed()
+
+        print(
+            f'\n{NUM_COLLECTIONS} collections with '
+            f'{NUM_THINGS} things each')
+
+        for store_threads in STORE_THREADS:
+            # the first restart writes the full store using `store_threads`
+            await self._restart(store_threads)
+            client = await get_client(self.node0)
+            await client.query(r'.store_bench = true;', scope='@:bench0')
+            client.close()
+            await client.wait_closed()
+
+            duration = await self._restart(store_threads)
+            print(f'store_threads={store_threads}: start in {duration:.3f}s')
+
+        await asyncio.sleep(0.5)
+
+
+if __name__ == '__main__':
+    run_test(BenchStore())
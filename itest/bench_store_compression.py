@@ -0,0 +1,114 @@
+#!/usr/bin/env python
+"""Store and archive compression benchmark.
+
+Usage:
+    python bench_store_compression.py [collections] [things-per-collection]
+
+The store is created once; the node is then restarted using a different
+`store_compression` level for each run. For each level the time to write the
+full store (shutdown), the time to load the store (startup) and the size of
+the store directory are reported.
+"""
+import asyncio
+import os
+import sys
+import time
+from lib import run_test
+from lib import default_test_setup
+from lib.testbase import TestBase
+from lib.client import get_client
+
+NUM_COLLECTIONS = int(sys.argv[1]) if len(sys.argv) > 1 else 20
+NUM_THINGS = int(sys.argv[2]) if len(sys.argv) > 2 else 50_000
+LEVELS = (0, 1, 3, 6, 9)
+
+
+def dir_size(path):
+    return sum(
+        os.path.getsize(os.path.join(root, fn))
+        for root, _, files in os.walk(path)
+        for fn in files)
+
+
+class BenchStoreCompression(TestBase):
+
+    title = 'Benchmark store compression'
+
+    async def _touch(self):
+        # unchanged collections are linked, so change each collection
+        client = await get_client(self.node0)
+        for i in range(NUM_COLLECTIONS):
+            await client.query(r'.store_bench = now();', scope=f'@:bench{i}')
+        client.close()
+        await client.wait_closed()
+
+    async def _shutdown(self):
+        start = time.time()
+        await self.node0.shutdown(timeout=600)
+        return time.time() - start
+
+    async def _start(self):
+        start = time.time()
+        self.node0.start()
+        await self.node0.expect(
+            'start listening for node connections', timeout=600)
+        return time.time() - start
+
+    async def _check(self):
+        client = await get_client(self.node0)
+        for i in range(NUM_COLLECTIONS):
+            n = await client.query('.items.len();', scope=f'@:bench{i}')
+            self.assertEqual(n, NUM_THINGS)
+        client.close()
+        await client.wait_closed()
+
+    @default_test_setup(num_nodes=1, seed=1, threshold_full_storage=0)
+    async def run(self):
+
+        await self.node0.init_and_run()
+
+        client = await get_client(self.node0)
+
+        for i in range(NUM_COLLECTIONS):
+            name = f'bench{i}'
+            await client.query(f'new_collection("{name}");')
+            await client.query(r'''
+                .items = range(n).map(|i| {
+                    name: `item {i}`,
+                    value: i * 1.5,
+                    tags: ['a', 'b', 'c'],
+                });
+            ''', n=NUM_THINGS, scope=f'@:{name}')
+
+        client.close()
+        await client.wait_closed()
+
+        print(
+            f'\n{NUM_COLLECTIONS} collections with '
+            f'{NUM_THINGS} things each')
+
+        store_path = os.path.join(self.node0.storage_path, 'store')
+
+        for level in LEVELS:
+            self.node0.store_compression = level
+            await self._shutdown()
+            self.node0.write_config()
+            await self._start()
+
+            await self._touch()
+            write = await self._shutdown()
+            size = dir_size(store_path)
+            load = await self._start()
+            await self._check()
+
+            print(
+                f'store_compression={level}: '
+                f'write {write:.3f}s, '
+                f'load {load:.3f}s, '
+                f'size {size / 1024 / 1024:.1f}MiB')
+
+        await asyncio.sleep(0.5)
+
+
+if __name__ == '__main__':
+    run_test(BenchStoreCompression())
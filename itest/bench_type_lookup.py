@@ -0,0 +1,56 @@
+#!/usr/bin/env python
+"""Property access benchmark for types with a growing number of fields.
+
+Usage:
+    python bench_type_lookup.py [iterations]
+
+For each field count a type is created and the last field (the worst case
+for a linear search) is read `iterations` times within a single query.
+"""
+import time
+import sys
+from lib import run_test
+from lib import default_test_setup
+from lib.testbase import TestBase
+from lib.client import get_client
+
+ITERATIONS = int(sys.argv[1]) if len(sys.argv) > 1 else 1_000_000
+FIELD_COUNTS = (1, 4, 8, 16, 40, 80)
+
+
+class BenchTypeLookup(TestBase):
+
+    title = 'Benchmark type field lookup'
+
+    @default_test_setup(num_nodes=1, seed=1)
+    async def run(self):
+
+        await self.node0.init_and_run()
+
+        client = await get_client(self.node0)
+        client.set_default_scope('//stuff')
+
+        print(f'\n{ITERATIONS} property reads per type')
+
+        for n in FIELD_COUNTS:
+            name = f'T{n}'
+            fields = ', '.join(f'f{i}: "int"' for i in range(n))
+            await client.query(f'set_type("{name}", {{{fields}}});')
+
+            last = f'f{n - 1}'
+            start = time.time()
+            await client.query(f'''
+                t = {name}{{}};
+                range({ITERATIONS}).each(|| t.{last});
+            ''')
+            duration = time.time() - start
+            print(
+                f'{n:3} fields: {duration:.3f}s '
+                f'({duration / ITERATIONS * 1e9:.1f}ns per access)')
+
+        client.close()
+        await client.wait_closed()
+
+
+if __name__ == '__main__':
+    run_test(BenchTypeLookup())
@@ -76,6 +76,12 @@ class Node:
         self.ip_support = options.pop('ip_support', 'ALL')
         self.pipe_client_name = options.pop('pipe_client_name', None)
         self.threshold_full_storage = options.pop('threshold_full_storage', 10)
+        self.store_threads = options.pop('store_threads', None)
+        self.query_threads = options.pop('query_threads', None)
+        self.store_compression = options.pop('store_compression', None)
+        self.change_id_batch = options.pop('change_id_batch', None)
+        self.change_pipelines = options.pop('change_pipelines', None)
+        self.lazy_load = options.pop('lazy_load', None)
         self.gcloud_key_file = options.pop('gcloud_key_file', None)
 
         self.storage_path = os.path.join(THINGSDB_TESTDIR, f'tdb{n}')
@@ -180,6 +186,27 @@ class Node:
 
         config.set('thingsdb', 'ip_support', self.ip_support)
 
+        if self.store_threads is not None:
+            config.set('thingsdb', 'store_threads', self.store_threads)
+
+        if self.query_threads is not None:
+            config.set('thingsdb', 'query_threads', self.query_threads)
+
+        if self.store_compression is not None:
+            config.set(
+                'thingsdb',
+                'store_compression',
+                self.store_compression)
+
+        if self.change_id_batch is not None:
+            config.set('thingsdb', 'change_id_batch', self.change_id_batch)
+
+        if self.change_pipelines is not None:
+            config.set('thingsdb', 'change_pipelines', self.change_pipelines)
+
+        if self.lazy_load is not None:
+            config.set('thingsdb', 'lazy_load', self.lazy_load)
+
         if self.pipe_client_name is not None:
             config.set('thingsdb', 'pipe_client_name',  self.pipe_client_name)
 
@@ -5,6 +5,7 @@ from lib import run_test, vars
 from test_advanced import TestAdvanced
 from test_arguments import TestArguments
 from test_backup import TestBackup
+from test_change_pipelines import TestChangePipelines
 from test_changes import TestChanges
 from test_collection_functions import TestCollectionFunctions
 from test_datetime import TestDatetime
@@ -16,6 +17,7 @@ from test_gc import TestGC
 from test_http_api import TestHTTPAPI
 from test_import import TestImport
 from test_index_slice import TestIndexSlice
+from test_lazy_load import TestLazyLoad
 from test_math import TestMath
 from test_modules import TestModules
 from test_multi_node import TestMultiNode
@@ -64,6 +66,7 @@ if __name__ == '__main__':
     run_test(TestAdvanced())
     run_test(TestArguments())
     run_test(TestBackup())
+    run_test(TestChangePipelines())
     run_test(TestChanges())
     run_test(TestCollectionFunctions())
     run_test(TestDatetime())
@@ -76,6 +79,7 @@ if __name__ == '__main__':
     run_test(TestHTTPAPI())
     run_test(TestImport())
     run_test(TestIndexSlice())
+    run_test(TestLazyLoad())
     run_test(TestMath())
     if args.doc_modules is True:
         run_test(TestModules())
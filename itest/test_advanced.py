@@ -1155,6 +1155,23 @@ class TestAdvanced(TestBase):
         ''')
         self.assertEqual(res, 1)
 
+        # the instance index must follow removed and converted things
+        res = await client.query(r'''
+            .del('x');
+            .a.pop();
+            .y.other = nil;
+            type_count('X');
+        ''')
+        self.assertEqual(res, 2)
+
+        res = await client.query(r'''
+            .z = {other: nil};
+            .z.to_type('X');
+            .y.to_thing();
+            type_count('X');
+        ''')
+        self.assertEqual(res, 2)
+
     async def test_mod_to_any(self, client):
         res = await client.query('''
             set_type('X', {
@@ -0,0 +1,101 @@
+#!/usr/bin/env python
+import asyncio
+from lib import run_test
+from lib import default_test_setup
+from lib.testbase import TestBase
+from lib.client import get_client
+
+NUM_CHANGES = 5
+ATTEMPTS = 5
+
+
+class TestChangePipelines(TestBase):
+
+    title = 'Test changes which run ahead of a gap for another collection'
+
+    @default_test_setup(
+            num_nodes=3,
+            seed=1,
+            threshold_full_storage=1000000,
+            change_pipelines=1)
+    async def run(self):
+
+        await self.node0.init_and_run()
+
+        client0 = await get_client(self.node0)
+        client0.set_default_scope('//stuff')
+
+        await client0.query(r'''
+            new_collection('other');
+        ''', scope='@t')
+
+        await client0.query('.log = [];')
+        await client0.query('.log = [];', scope='//other')
+
+        await self.node1.join_until_ready(client0)
+        await self.node2.join_until_ready(client0)
+
+        client1 = await get_client(self.node1)
+        client1.set_default_scope('//other')
+
+        client2 = await get_client(self.node2)
+        client2.set_default_scope('//other')
+
+        ahead = await self.changes_ahead(client2)
+
+        for attempt in range(ATTEMPTS):
+            await self.wait_nodes_ready(client0, success_count=2)
+            await self.create_gap(client0, client1, client2, attempt)
+            if await self.changes_ahead(client2) > ahead:
+                break
+
+        self.assertGreater(await self.changes_ahead(client2), ahead)
+
+        await self.wait_nodes_ready(client0, success_count=2)
+
+        n = attempt + 1
+        expect_stuff = [f'{s}{i}' for i in range(n) for s in ('a', 'b')]
+        expect_other = list(range(n * NUM_CHANGES))
+
+        for client in (client0, client1, client2):
+            res = await client.query('.log;', scope='//stuff')
+            self.assertEqual(res, expect_stuff)
+            res = await client.query('.log;', scope='//other')
+            self.assertEqual(res, expect_other)
+
+        for client in (client0, client1, client2):
+            client.close()
+            await client.wait_closed()
+
+    async def changes_ahead(self, client):
+        counters = await client.query('counters();', scope='@n')
+        return counters['changes_ahead']
+
+    async def create_gap(self, client0, client1, client2, attempt):
+        # Keep node2 busy so it reads the large change from node0 in parts,
+        # while the small changes from node1 are read at once. Node2 then
+        # waits for the change from node0 (a gap) when the changes from node1
+        # are received; these depend only on collection `other`.
+        busy = asyncio.ensure_future(client2.query(r'''
+            range(3000).map(|_| range(3000).reduce(|a, b| a + b, 0)).len();
+        ''', timeout=60))
+
+        await asyncio.sleep(0.2)
+
+        await client0.query(f'''
+            .log.push('a{attempt}');
+            .big = range(2000000);
+            nil;
+        ''')
+
+        for i in range(NUM_CHANGES):
+            await client1.query(f'.log.push({attempt * NUM_CHANGES + i});')
+
+        # depends on the change from node0 and must wait for the gap
+        await client1.query(f".log.push('b{attempt}');", scope='//stuff')
+
+        await busy
+
+
+if __name__ == '__main__':
+    run_test(TestChangePipelines())
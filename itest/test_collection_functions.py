@@ -25,7 +25,11 @@ class TestCollectionFunctions(TestBase):
 
     title = 'Test collection scope functions'
 
-    @default_test_setup(num_nodes=2, seed=1, threshold_full_storage=50000)
+    @default_test_setup(
+        num_nodes=2,
+        seed=1,
+        threshold_full_storage=50000,
+        query_threads=4)
     async def run(self):
 
         await self.node0.init_and_run()
@@ -3998,8 +4002,8 @@ class TestCollectionFunctions(TestBase):
 
         with self.assertRaisesRegex(
                 NumArgumentsError,
-                'function `sort` takes at most 2 arguments but 3 were given'):
-            await client.query('[2, 0, 1, 3].sort(|a, b|1, nil, nil);')
+                'function `sort` takes at most 3 arguments but 4 were given'):
+            await client.query('[2, 0, 1, 3].sort(|a, b|1, nil, nil, nil);')
 
         with self.assertRaisesRegex(
                 OperationError,
@@ -4049,6 +4053,171 @@ class TestCollectionFunctions(TestBase):
             [42, 2013, 6].sort(|a, b| a > b ? -1 : a < b ? 1 : 0);
         '''), [2013, 42, 6])
 
+        with self.assertRaisesRegex(
+                TypeError,
+                'function `sort` expects argument 2 to be of type `int` '
+                'but got type `nil` instead'):
+            await client.query('[2, 0, 1, 3].sort(true, nil);')
+
+        with self.assertRaisesRegex(
+                TypeError,
+                'function `sort` expects argument 2 to be of type `bool` '
+                'but got type `nil` instead'):
+            await client.query('[2, 0, 1, 3].sort(|x| x, nil, 2);')
+
+        with self.assertRaisesRegex(
+                ValueError,
+                'function `sort` expects argument 1 to be a '
+                'positive integer value'):
+            await client.query('[2, 0, 1, 3].sort(-1);')
+
+        with self.assertRaisesRegex(
+                TypeError,
+                'expecting a return value of type `int` but '
+                'got type `bool` instead'):
+            await client.query('["a", "b", "c"].sort(|a, b| true, 1);')
+
+        self.assertEqual(await client.query(r'''
+            [2, 0, 1, 3].sort(2);
+        '''), [0, 1])
+
+        self.assertEqual(await client.query(r'''
+            [2, 0, 1, 3].sort(true, 3);
+        '''), [3, 2, 1])
+
+        self.assertEqual(await client.query(r'''
+            [2, 0, 1, 3].sort(0);
+        '''), [])
+
+        self.assertEqual(await client.query(r'''
+            [2, 0, 1, 3].sort(10);
+        '''), [0, 1, 2, 3])
+
+        self.assertEqual(await client.query(r'''
+            ["Iris", "Anne", "cato"].sort(|n| n.lower(), 2);
+        '''), ["Anne", "cato"])
+
+        self.assertEqual(await client.query(r'''
+            ["Iris", "Anne", "cato"].sort(|n| n.lower(), true, 1);
+        '''), ["Iris"])
+
+        self.assertEqual(await client.query(r'''
+            [42, 2013, 6].sort(|a, b| a > b ? -1 : a < b ? 1 : 0, 2);
+        '''), [2013, 42])
+
+        self.assertEqual(await client.query(r'''
+            range(100).map(|i| i * 37 % 100).sort(|x| -x, 5);
+        '''), [99, 98, 97, 96, 95])
+
+        # the key closure may use sort() since it runs before sorting
+        self.assertEqual(await client.query(r'''
+            [[3, 1], [2], [0, 5]].sort(|x| x.sort()[0]);
+        '''), [[0, 5], [3, 1], [2]])
+
+    async def test_sort_numbers(self, client):
+        # lists with only integers or only floats are sorted on packed keys
+        values = [(i * 7919) % 1000 - 500 for i in range(1000)]
+        values[10] = -2**63
+        values[20] = 2**63 - 1
+
+        res = await client.query('values.sort();', values=values)
+        self.assertEqual(res, sorted(values))
+
+        res = await client.query('values.sort(true);', values=values)
+        self.assertEqual(res, sorted(values, reverse=True))
+
+        res = await client.query('values.sort(true, 3);', values=values)
+        self.assertEqual(res, sorted(values, reverse=True)[:3])
+
+        floats = [v / 8 for v in values[21:]] + [-0.0, 1e300, -1e300]
+        res = await client.query('floats.sort();', floats=floats)
+        self.assertEqual(res, sorted(floats))
+
+        res = await client.query('floats.sort(true);', floats=floats)
+        self.assertEqual(res, sorted(floats, reverse=True))
+
+        # a stable sort on the key, equal keys keep their order
+        res = await client.query(r"""//ti
+            range(200).sort(|i| i % 3).slice(0, 5);
+        """)
+        self.assertEqual(res, [0, 3, 6, 9, 12])
+
+        res = await client.query(r"""//ti
+            range(200).sort(|i| (i % 4) / 2.0, true).slice(0, 4);
+        """)
+        self.assertEqual(res, [3, 7, 11, 15])
+
+        # mixed numbers use the generic compare
+        self.assertEqual(
+            await client.query('[3, 1.5, -2, 0.25, 2].sort();'),
+            [-2, 0.25, 1.5, 2, 3])
+
+    async def test_query_threads(self, client):
+        # large lists and sets are tested on multiple threads when the
+        # closure only compares values; the results must be equal to
+        # calling the closure which is done when using `bool(..)`
+        await client.query(r"""//ti
+            .qt_items = range(20000).map(|i| {
+                name: (i % 5) ? `item {i}` : '',
+                age: i % 100,
+                score: (i % 7) / 2,
+            });
+            .qt_set = set(.qt_items);
+        """)
+
+        for code in (
+                'x.age > 18 && x.name != ""',
+                'x.age <= 3 || x.score == 2.5',
+                '!!x.name && (x.age >= 40 || x.age < 2)',
+                'x.age == min',
+                'x.name',
+                '-1 < x.score && x.age != nil'):
+            res = await client.query(f"""//ti
+                min = 42;
+                li = .qt_items;
+                se = .qt_set;
+                [
+                    li.filter(|x| {code}) == li.filter(|x| bool({code})),
+                    se.filter(|x| {code}) == se.filter(|x| bool({code})),
+                    li.find(|x| {code}) == li.find(|x| bool({code})),
+                    se.find(|x| {code}) == se.find(|x| bool({code})),
+                    li.some(|x| {code}) == li.some(|x| bool({code})),
+                    se.some(|x| {code}) == se.some(|x| bool({code})),
+                    li.every(|x| {code}) == li.every(|x| bool({code})),
+                    se.every(|x| {code}) == se.every(|x| bool({code})),
+                ];
+            """)
+            self.assertEqual(res, [True] * 8, code)
+
+        res = await client.query(r"""//ti
+            [
+                range(20000).filter(|x| x >= 19998),
+                range(20000).find(|x| x > 12345),
+                range(20000).some(|x| x < 0),
+                range(20000).every(|x| x >= 0),
+            ];
+        """)
+        self.assertEqual(res, [[19998, 19999], 12346, False, True])
+
+        # errors are equal to the single threaded code path
+        with self.assertRaisesRegex(
+                LookupError,
+                r'has no property `age`'):
+            await client.query(r"""//ti
+                items = .qt_items.map(|x| x);
+                items.push({});
+                items.filter(|x| x.age > 1);
+            """)
+
+        with self.assertRaisesRegex(
+                TypeError,
+                r'`>` not supported between `str` and `int`'):
+            await client.query(r"""//ti
+                .qt_items.filter(|x| x.name > 1);
+            """)
+
+        await client.query('.del("qt_items"); .del("qt_set");')
+
     async def test_splice(self, client):
         await client.query('.li = [];')
         self.assertEqual(await client.query('.li.splice(0, 0, "a")'), [])
@@ -283,6 +283,138 @@ class TestHTTPAPI(TestBase):
         self.assertEqual(x.status_code, 400)
         self.assertRegex(x.text, r'invalid API request.*')
 
+    async def test_json_result(self, api0, api1, token):
+        code = """//ti
+            set_type('_Item', {name: 'str', n: 'int'});
+            .items = range(20_000).map(|i| {
+                name: `item-{i} "quoted"\n`,
+                n: i,
+                f: i / 3,
+                big: 9223372036854775807,
+                nested: [nil, true, {}, [], [[i]]],
+            });
+        """
+        get_items = "[.items, .items.map(|t| t.wrap('_Item'))];"
+        x = requests.post(
+            f'{api0}//stuff',
+            data=msgpack.dumps({'type': 'query', 'code': code + get_items}),
+            auth=('admin', 'pass'),
+            headers={'Content-Type': 'application/msgpack'}
+        )
+        self.assertEqual(x.status_code, 200)
+        expected = msgpack.unpackb(x.content, raw=False)
+
+        x = requests.post(
+            f'{api0}//stuff',
+            json={'type': 'query', 'code': get_items},
+            auth=('admin', 'pass'),
+        )
+        self.assertEqual(x.status_code, 200)
+        self.assertGreater(len(x.content), 1_000_000)
+        self.assertEqual(x.json(), expected)
+
+        x = requests.post(
+            f'{api0}//stuff',
+            json={'type': 'query', 'code': '[1, 2, bytes("abc")];'},
+            auth=('admin', 'pass'),
+        )
+        self.assertEqual(x.status_code, 422)
+        self.assertEqual(
+            x.text,
+            'type `bytes` is not JSON serializable (-61)\r\n')
+
+        x = requests.post(
+            f'{api0}//stuff',
+            json={'type': 'query', 'code': '.del("items"); nil;'},
+            auth=('admin', 'pass'),
+        )
+        self.assertEqual(x.status_code, 200)
+        self.assertIsNone(x.json())
+
+    async def test_stream_result(self, api0, api1, token):
+        code = """//ti
+            .items = range(50_000).map(|i| {
+                name: `item-{i}`,
+                n: i,
+                nested: [nil, true, {}, [[i]]],
+            });
+        """
+        x = requests.post(
+            f'{api0}//stuff',
+            data=msgpack.dumps({'type': 'query', 'code': code + '.items;'}),
+            auth=('admin', 'pass'),
+            headers={'Content-Type': 'application/msgpack'}
+        )
+        self.assertEqual(x.status_code, 200)
+        self.assertNotIn('Transfer-Encoding', x.headers)
+        expected = msgpack.unpackb(x.content, raw=False)
+
+        x = requests.post(
+            f'{api0}//stuff',
+            data=msgpack.dumps({'type': 'query', 'code': '.items;'}),
+            auth=('admin', 'pass'),
+            headers={
+                'Content-Type': 'application/msgpack',
+                'X-Stream': 'true',
+            }
+        )
+        self.assertEqual(x.status_code, 200)
+        self.assertEqual(x.headers['Transfer-Encoding'], 'chunked')
+        self.assertEqual(msgpack.unpackb(x.content, raw=False), expected)
+
+        x = requests.post(
+            f'{api0}//stuff',
+            json={'type': 'query', 'code': '.items;'},
+            auth=('admin', 'pass'),
+            headers={'X-Stream': 'true'}
+        )
+        self.assertEqual(x.status_code, 200)
+        self.assertEqual(x.headers['Transfer-Encoding'], 'chunked')
+        self.assertEqual(x.json(), expected)
+
+        # small results are written as a normal response
+        x = requests.post(
+            f'{api0}//stuff',
+            json={'type': 'query', 'code': '.items.len();'},
+            auth=('admin', 'pass'),
+            headers={'X-Stream': 'true'}
+        )
+        self.assertEqual(x.status_code, 200)
+        self.assertNotIn('Transfer-Encoding', x.headers)
+        self.assertEqual(x.json(), 50_000)
+
+        # other queries run while the response is written; a list which is
+        # changed in the mean time is written as it was
+        x = requests.post(
+            f'{api0}//stuff',
+            data=msgpack.dumps({'type': 'query', 'code': '.items;'}),
+            auth=('admin', 'pass'),
+            headers={
+                'Content-Type': 'application/msgpack',
+                'X-Stream': 'true',
+            },
+            stream=True,
+        )
+        self.assertEqual(x.status_code, 200)
+        y = requests.post(
+            f'{api0}//stuff',
+            json={
+                'type': 'query',
+                'code': '.items.splice(0, 50_000); .items.len();',
+            },
+            auth=('admin', 'pass'),
+        )
+        self.assertEqual(y.status_code, 200)
+        self.assertEqual(y.json(), 0)
+        self.assertEqual(msgpack.unpackb(x.content, raw=False), expected)
+
+        x = requests.post(
+            f'{api0}//stuff',
+            json={'type': 'query', 'code': '.del("items"); nil;'},
+            auth=('admin', 'pass'),
+        )
+        self.assertEqual(x.status_code, 200)
+
     async def test_token_auth(self, api0, api1, token):
         data = {'type': 'query', 'code': '42'}
         x = requests.post(
@@ -311,6 +443,61 @@ class TestHTTPAPI(TestBase):
         self.assertEqual(x.status_code, 200)
         self.assertEqual(msgpack.unpackb(x.content, raw=False), 42)
 
+    async def test_auth_changes(self, api0, api1, token):
+        data = {'type': 'query', 'code': '42'}
+
+        def query(auth=None, headers=None):
+            return requests.post(
+                f'{api0}/t',
+                json=data,
+                auth=auth,
+                headers=headers)
+
+        x = requests.post(
+            f'{api0}/t',
+            json={'type': 'query', 'code': """//ti
+                new_user("basic");
+                set_password("basic", "pass1");
+                grant("@t", "basic", QUERY);
+                new_token("basic");
+            """},
+            auth=('admin', 'pass'))
+        self.assertEqual(x.status_code, 200)
+        basic_token = x.json()
+
+        for _ in range(2):  # second request is using the cache
+            self.assertEqual(query(auth=('basic', 'pass1')).status_code, 200)
+
+        self.assertEqual(query(auth=('basic', 'pass2')).status_code, 401)
+
+        x = requests.post(
+            f'{api0}/t',
+            json={'type': 'query', 'code': 'set_password("basic", "pass2");'},
+            auth=('admin', 'pass'))
+        self.assertEqual(x.status_code, 200)
+
+        self.assertEqual(query(auth=('basic', 'pass1')).status_code, 401)
+        self.assertEqual(query(auth=('basic', 'pass2')).status_code, 200)
+
+        headers = {'Authorization': f'TOKEN {basic_token}'}
+        self.assertEqual(query(headers=headers).status_code, 200)
+
+        x = requests.post(
+            f'{api0}/t',
+            json={'type': 'query', 'code': f'del_token("{basic_token}");'},
+            auth=('admin', 'pass'))
+        self.assertEqual(x.status_code, 200)
+
+        self.assertEqual(query(headers=headers).status_code, 401)
+
+        x = requests.post(
+            f'{api0}/t',
+            json={'type': 'query', 'code': 'del_user("basic");'},
+            auth=('admin', 'pass'))
+        self.assertEqual(x.status_code, 200)
+
+        self.assertEqual(query(auth=('basic', 'pass2')).status_code, 401)
+
     async def test_long_request(self, api0, api1, token):
         code = r''' "just another simple test string!!!"; ''' * 3000
         data = {'type': 'query', 'code': code}
@@ -0,0 +1,91 @@
+#!/usr/bin/env python
+import asyncio
+from lib import run_test
+from lib import default_test_setup
+from lib.testbase import TestBase
+from lib.client import get_client
+
+
+class TestLazyLoad(TestBase):
+
+    title = 'Test loading collections on first use'
+
+    @default_test_setup(
+            num_nodes=1,
+            seed=1,
+            threshold_full_storage=10,
+            lazy_load=1)
+    async def run(self):
+
+        await self.node0.init_and_run()
+
+        client = await get_client(self.node0)
+
+        await client.query(r'''
+            new_collection('other');
+        ''', scope='@t')
+
+        await client.query(r'''
+            new_type('Person');
+            set_type('Person', {name: 'str', friend: 'Person?'});
+            .iris = Person{name: 'Iris'};
+            .cato = Person{name: 'Cato', friend: .iris};
+            .iris.friend = .cato;
+            .list = range(100).map(|i| {i: i, me: nil});
+            .list.each(|x| x.me = x);
+            .b = {name: 'b'};
+            .b.me = .b;
+            .del('b');
+        ''', scope='//stuff')
+
+        await client.query(r'''
+            .x = {answer: 42};
+            .arr = [.x, .x];
+        ''', scope='//other')
+
+        await self.node0.shutdown()
+        await self.node0.run()
+
+        await asyncio.sleep(2)
+
+        res = await client.query(r'''
+            [
+                .iris.friend.name,
+                .cato.friend.friend.name,
+                .list.len(),
+                .list.every(|x, i| x.i == i && x.me == x),
+            ];
+        ''', scope='//stuff')
+        self.assertEqual(res, ['Cato', 'Cato', 100, True])
+
+        # trigger a full store, the `other` collection is linked when not loaded
+        for i in range(20):
+            await client.query(f'.counter = {i};', scope='//stuff')
+
+        await asyncio.sleep(4)
+
+        await self.node0.shutdown()
+        await self.node0.run()
+
+        await asyncio.sleep(2)
+
+        res = await client.query(r'''
+            [.arr[0].answer, .arr[0] == .arr[1], .x == .arr[1]];
+        ''', scope='//other')
+        self.assertEqual(res, [42, True, True])
+
+        res = await client.query(r'''
+            [.counter, .iris.friend.name];
+        ''', scope='//stuff')
+        self.assertEqual(res, [19, 'Cato'])
+
+        await client.query(r'''
+            del_collection('other');
+        ''', scope='@t')
+
+        client.close()
+        await client.wait_closed()
+
+
+if __name__ == '__main__':
+    run_test(TestLazyLoad())
@@ -42,10 +42,13 @@ class TestNodeFunctions(TestBase):
 
         counters = await client.query('counters();')
 
-        self.assertEqual(len(counters), 20)
+        self.assertEqual(len(counters), 26)
 
         self.assertIn("average_change_duration", counters)
         self.assertIn("average_query_duration", counters)
+        self.assertIn("change_id_batched", counters)
+        self.assertIn("change_id_batches", counters)
+        self.assertIn("changes_ahead", counters)
         self.assertIn("changes_committed", counters)
         self.assertIn("changes_failed", counters)
         self.assertIn("changes_killed", counters)
@@ -53,6 +56,8 @@ class TestNodeFunctions(TestBase):
         self.assertIn("changes_unaligned", counters)
         self.assertIn("changes_with_gap", counters)
         self.assertIn("garbage_collected", counters)
+        self.assertIn("largest_change_id_batch", counters)
+        self.assertIn("largest_gc_pause", counters)
         self.assertIn("largest_result_size", counters)
         self.assertIn("longest_change_duration", counters)
         self.assertIn("longest_query_duration", counters)
@@ -60,6 +65,7 @@ class TestNodeFunctions(TestBase):
         self.assertIn("queries_success", counters)
         self.assertIn("queries_with_error", counters)
         self.assertIn("quorum_lost", counters)
+        self.assertIn("room_emits_suppressed", counters)
         self.assertIn("started_at", counters)
         self.assertIn("tasks_success", counters)
         self.assertIn("tasks_with_error", counters)
@@ -67,6 +73,10 @@ class TestNodeFunctions(TestBase):
 
         self.assertTrue(isinstance(counters["average_change_duration"], float))
         self.assertTrue(isinstance(counters["average_query_duration"], float))
+        self.assertTrue(isinstance(counters["largest_gc_pause"], float))
+        self.assertTrue(isinstance(counters["change_id_batched"], int))
+        self.assertTrue(isinstance(counters["change_id_batches"], int))
+        self.assertTrue(isinstance(counters["changes_ahead"], int))
         self.assertTrue(isinstance(counters["changes_committed"], int))
         self.assertTrue(isinstance(counters["changes_failed"], int))
         self.assertTrue(isinstance(counters["changes_killed"], int))
@@ -74,6 +84,8 @@ class TestNodeFunctions(TestBase):
         self.assertTrue(isinstance(counters["changes_unaligned"], int))
         self.assertTrue(isinstance(counters["changes_with_gap"], int))
         self.assertTrue(isinstance(counters["garbage_collected"], int))
+        self.assertTrue(
+            isinstance(counters["largest_change_id_batch"], int))
         self.assertTrue(isinstance(counters["largest_result_size"], int))
         self.assertTrue(isinstance(counters["longest_change_duration"], float))
         self.assertTrue(isinstance(counters["longest_query_duration"], float))
@@ -81,6 +93,7 @@ class TestNodeFunctions(TestBase):
         self.assertTrue(isinstance(counters["queries_success"], int))
         self.assertTrue(isinstance(counters["queries_with_error"], int))
         self.assertTrue(isinstance(counters["quorum_lost"], int))
+        self.assertTrue(isinstance(counters["room_emits_suppressed"], int))
         self.assertTrue(isinstance(counters["started_at"], int))
         self.assertTrue(isinstance(counters["tasks_success"], int))
         self.assertTrue(isinstance(counters["tasks_with_error"], int))
@@ -94,7 +107,7 @@ class TestNodeFunctions(TestBase):
 
         node = await client.query('node_info();')
 
-        self.assertEqual(len(node), 41)
+        self.assertEqual(len(node), 42)
 
         self.assertIn("node_id", node)
         self.assertIn("version", node)
@@ -137,6 +150,7 @@ class TestNodeFunctions(TestBase):
         self.assertIn('modules_path', node)
         self.assertIn('architecture', node)
         self.assertIn('platform', node)
+        self.assertIn('slab', node)
 
         self.assertTrue(isinstance(node["node_id"], int))
         self.assertTrue(isinstance(node["version"], str))
@@ -179,6 +193,7 @@ class TestNodeFunctions(TestBase):
         self.assertTrue(isinstance(node["modules_path"], str))
         self.assertTrue(isinstance(node["architecture"], str))
         self.assertTrue(isinstance(node["platform"], str))
+        self.assertTrue(node["slab"] is None or isinstance(node["slab"], list))
 
     async def test_nodes_info(self, client):
         with self.assertRaisesRegex(
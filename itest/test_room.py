@@ -189,6 +189,26 @@ class TestRoom(TestBase):
         ids = [id for id in res if id is not None]
         self.assertEqual(len(ids), 3)
 
+    async def test_room_interest(self, cl0, cl1, cl2):
+        await cl0.query('.iroom = room();')
+        actions = []
+        room = TRoom(actions, '.iroom.id();')
+        await room.join(cl0)
+
+        # wait for the connect loop to share the room interest
+        await asyncio.sleep(2.5)
+
+        counters = await cl1.query('counters();', scope='@node')
+        suppressed = counters['room_emits_suppressed']
+
+        await cl1.query('.iroom.emit("msg", "interest");')
+        await asyncio.sleep(0.5)
+
+        # only node0 has a listener, the emit to node2 must be suppressed
+        counters = await cl1.query('counters();', scope='@node')
+        self.assertGreater(counters['room_emits_suppressed'], suppressed)
+        self.assertEqual(actions, ['on_init', 'on_join', 'interest'])
+
     async def test_object_to_room(self, cl0, cl1, cl2):
         await cl0.query(r"""//ti
             .oroom = room();
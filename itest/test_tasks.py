@@ -193,6 +193,33 @@ class TestTasks(TestBase):
         self.assertEqual(await client.query('tasks();', scope='/t'), [])
         self.assertEqual(await client.query('tasks();', scope='//stuff'), [])
 
+    async def test_drop_collection(self, client):
+        await client.query(r'''
+            new_collection('dropme');
+        ''', scope='/t')
+
+        await client.query(r'''
+            .x = {name: 'x'};
+            x = .x;
+            task(datetime().move('seconds', 2), |t, x| x.name = t.id(), [x]);
+            task(datetime().move('seconds', 60), |_, x| x, [.x]);
+            task(datetime().move('days', 1), || nil);
+        ''', scope='//dropme')
+
+        await client.query(r'''
+            del_collection('dropme');
+        ''', scope='/t')
+
+        await asyncio.sleep(num_nodes*3)
+
+        # the node must still be able to run tasks
+        await client.query(r'''
+            .dropped = 0;
+            task(datetime(), || .dropped = 1);
+        ''')
+        await asyncio.sleep(num_nodes*3)
+        self.assertEqual(await client.query('.dropped;'), 1)
+
     async def test_again_in(self, client):
         await client.query("""//ti
             s = datetime();
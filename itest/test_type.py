@@ -537,8 +537,8 @@ class TestType(TestBase):
         with self.assertRaisesRegex(
                 ValueError,
                 r'function `mod_type` expects argument 2 to be '
-                r'`all`, `add`, `del`, `hid`, `mod`, `rel`, `ren` or `wpo` '
-                r'but got `x` instead'):
+                r'`all`, `add`, `del`, `hid`, `idx`, `mod`, `rel`, `ren` or '
+                r'`wpo` but got `x` instead'):
             await client.query(r'mod_type("Person", "x", "x");')
 
         # section ADD
@@ -2284,5 +2284,135 @@ class TestType(TestBase):
             """)
 
 
+    async def test_mod_type_idx(self, client0):
+        await client0.query(r"""//ti
+            set_type('U', {
+                email: 'str',
+                age: 'int?',
+                score: 'float',
+                seen: 'datetime',
+                tags: '[str]',
+            });
+            .users = range(100).map(|i| U{
+                email: `user{i % 10}@example.com`,
+                age: (i < 90) ? i : nil,
+                score: i / 4.0,
+                seen: datetime(i * 3600),
+            });
+            mod_type('U', 'idx', 'email', true);
+            mod_type('U', 'idx', 'age', true);
+        """)
+
+        with self.assertRaisesRegex(
+                NumArgumentsError,
+                r'function `mod_type` with task `idx` takes 4 arguments '
+                r'but 3 were given'):
+            await client0.query(r'mod_type("U", "idx", "email");')
+
+        with self.assertRaisesRegex(
+                LookupError,
+                r'type `U` has no property `x`'):
+            await client0.query(r'mod_type("U", "idx", "x", true);')
+
+        with self.assertRaisesRegex(
+                OperationError,
+                r'cannot index property `tags` on type `U`'):
+            await client0.query(r'mod_type("U", "idx", "tags", true);')
+
+        with self.assertRaisesRegex(
+                TypeError,
+                r'function `type_filter` cannot compare property `age` '
+                r'with definition `int\?` to type `str`'):
+            await client0.query(r'type_filter("U", "age", "1");')
+
+        with self.assertRaisesRegex(
+                TypeError,
+                r'function `type_between` cannot search property `tags` '
+                r'on type `U`'):
+            await client0.query(r'type_between("U", "tags", nil, nil);')
+
+        client1 = await get_client(self.node1)
+        client1.set_default_scope('//stuff')
+
+        await self.wait_nodes_ready(client0)
+
+        for client in (client0, client1):
+            res = await client.query(r"""//ti
+                type_filter('U', 'email', 'user3@example.com').map(|u| u.age);
+            """)
+            self.assertEqual(res, [3, 13, 23, 33, 43, 53, 63, 73, 83, None])
+
+            res = await client.query(r"""//ti
+                type_between('U', 'age', 10, 14).map(|u| u.age);
+            """)
+            self.assertEqual(res, [10, 11, 12, 13, 14])
+
+            res = await client.query(r"""//ti
+                type_between('U', 'age', 87, nil).map(|u| u.age);
+            """)
+            self.assertEqual(res, [87, 88, 89])
+
+            # not indexed, all instances are scanned
+            res = await client.query(r"""//ti
+                type_between('U', 'score', 2, 2.5).map(|u| u.score);
+            """)
+            self.assertEqual(res, [2.0, 2.25, 2.5])
+
+            res = await client.query(r"""//ti
+                type_between('U', 'seen', nil, datetime(3600)).len();
+            """)
+            self.assertEqual(res, 2)
+
+        # the index must follow changes
+        await client0.query(r"""//ti
+            .users[3].email = 'changed@example.com';
+            .users[13].age = nil;
+            .users[23].age += 100;
+            .users.push(U{email: 'user3@example.com', age: 5});
+            .users.splice(33, 1);
+        """)
+
+        await self.wait_nodes_ready(client0)
+
+        for client in (client0, client1):
+            res = await client.query(r"""//ti
+                type_filter('U', 'email', 'user3@example.com').map(|u| u.age);
+            """)
+            self.assertEqual(
+                res, [None, 123, 43, 53, 63, 73, 83, None, 5])
+
+            res = await client.query(r"""//ti
+                type_filter('U', 'email', 'changed@example.com').len();
+            """)
+            self.assertEqual(res, 1)
+
+            res = await client.query(r"""//ti
+                type_between('U', 'age', 120, 130).map(|u| u.email);
+            """)
+            self.assertEqual(res, ['user3@example.com'])
+
+        # changing the definition keeps the index when possible
+        await client0.query(r"""//ti
+            mod_type('U', 'mod', 'age', 'float?', |u|
+                (is_nil(u.age)) ? nil : float(u.age));
+            mod_type('U', 'idx', 'email', false);
+        """)
+
+        await self.wait_nodes_ready(client0)
+
+        for client in (client0, client1):
+            res = await client.query(r"""//ti
+                type_between('U', 'age', 4.5, 6).map(|u| u.age);
+            """)
+            self.assertEqual(res, [5.0, 6.0, 5.0])
+
+            res = await client.query(r"""//ti
+                type_filter('U', 'email', 'changed@example.com').len();
+            """)
+            self.assertEqual(res, 1)
+
+        client1.close()
+        await client1.wait_closed()
+
 if __name__ == '__main__':
     run_test(TestType())
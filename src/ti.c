@@ -17,6 +17,7 @@
 #include <ti/field.h>
 #include <ti/modules.h>
 #include <ti/names.h>
+#include <ti/pred.h>
 #include <ti/proc.h>
 #include <ti/procedure.h>
 #include <ti/proto.h>
@@ -25,6 +26,7 @@
 #include <ti/regex.h>
 #include <ti/room.h>
 #include <ti/signals.h>
+#include <ti/slab.h>
 #include <ti/store.h>
 #include <ti/sync.h>
 #include <ti/things.h>
@@ -149,6 +151,7 @@ void ti_destroy(void)
     ti__stop();
 
     ti_qcache_destroy();
+    ti_pred_destroy();
     ti_build_destroy();
     ti_archive_destroy();
     ti_args_destroy();
@@ -198,6 +201,9 @@ void ti_destroy(void)
     if (ti.compat)
         cleri_grammar_free(ti.compat);
 
+    /* must be last as values may be destroyed by the code above */
+    ti_slab_destroy();
+
     memset(&ti, 0, sizeof(ti_t));
 }
 
@@ -241,6 +247,7 @@ int ti_init(void)
         ti.cfg->query_duration_warn = ti.cfg->query_duration_error;
 
     if (ti_qcache_create() ||
+        ti_pred_init() ||
         ti_do_init() ||
         ti_val_init_common() ||
         ti_thing_init_gc())
@@ -575,6 +582,9 @@ static void ti__delayed_start_cb(uv_timer_t * UNUSED(timer))
         if (ti_tasks_start())
             goto failed;
 
+        if (ti_store_load_start())
+            log_error("failed to start loading collections in the background");
+
         if (ti_away_start())
             goto failed;
 
@@ -741,6 +751,7 @@ void ti_offline(void)
          */
         ti_modules_stop_and_destroy();
         ti_tasks_stop();
+        ti_store_load_stop();
     }
 }
 
@@ -955,7 +966,7 @@ int ti_this_node_to_pk(msgpack_packer * pk)
     const char * architecture = osarch_get_arch();
 
     return (
-        msgpack_pack_map(pk, 41) ||
+        msgpack_pack_map(pk, 42) ||
         /* 1 */
         mp_pack_str(pk, "node_id") ||
         msgpack_pack_uint32(pk, ti.node->id) ||
@@ -1082,9 +1093,12 @@ int ti_this_node_to_pk(msgpack_packer * pk)
         /* 40 */
         mp_pack_str(pk, "next_free_id") ||
         msgpack_pack_uint64(pk, ti.node->next_free_id) ||
-        /* 4 */
+        /* 41 */
         mp_pack_str(pk, "libwebsockets_version") ||
-        mp_pack_str(pk, lws_get_library_version())
+        mp_pack_str(pk, lws_get_library_version()) ||
+        /* 42 */
+        mp_pack_str(pk, "slab") ||
+        ti_slab_to_pk(pk)
     );
 }
 
@@ -1241,4 +1255,5 @@ static void ti__stop(void)
     ti_changes_stop();
     ti_sync_stop();
     ti_tasks_stop();  /* extra stop may be required */
+    ti_store_load_stop();
 }
@@ -14,6 +14,7 @@
 #include <ti/query.inline.h>
 #include <ti/req.h>
 #include <ti/scope.h>
+#include <ti/write.h>
 #include <util/logger.h>
 #include <util/mpjson.h>
 
@@ -266,6 +267,8 @@ static int api__header_field_cb(http_parser * parser, const char * at, size_t n)
             ? TI_API_STATE_CONTENT_TYPE
             : API__ICMP_WITH(at, n, "authorization")
             ? TI_API_STATE_AUTHORIZATION
+            : API__ICMP_WITH(at, n, "x-stream")
+            ? TI_API_STATE_STREAM
             : TI_API_STATE_NONE;
 
     return 0;
@@ -334,6 +337,12 @@ static int api__header_value_cb(http_parser * parser, const char * at, size_t n)
 
         log_debug("invalid authorization type: %.*s", n, at);
         break;
+
+    case TI_API_STATE_STREAM:
+        if ((API__ICMP_WITH(at, n, "true")) ||
+            (API__ICMP_WITH(at, n, "1")))
+            ar->flags |= TI_API_FLAG_STREAM;
+        break;
     }
     return 0;
 }
@@ -438,29 +447,122 @@ static int api__close_resp(
     return 0;
 }
 
+/*
+ * The data must be encoded using the content type of the request and will
+ * be freed when the response is written.
+ */
 int ti_api_close_with_response(ti_api_request_t * ar, void * data, size_t size)
 {
-    if (ar->content_type == TI_API_CT_JSON)
+    return api__close_resp(ar, data, size, api__write_free_cb);
+}
+
+/*
+ * Write the data in `buffer` as a part of a response using chunked transfer
+ * encoding. The buffer must start with `TI_API_CHUNK_PREFIX` reserved bytes;
+ * on success the data is taken from the buffer.
+ *
+ * When `is_last` is `true`, the response is completed. If no other parts are
+ * written, a normal response is written instead. Otherwise the part is written
+ * using ti_write_direct(), which also explains the return value and when `cb`
+ * is called.
+ */
+int ti_api_write_chunk(
+        ti_api_request_t * ar,
+        msgpack_sbuffer * buffer,
+        _Bool is_last,
+        ti_write_direct_cb cb,
+        void * arg)
+{
+    int rc;
+
+    char * data;
+    size_t offset = TI_API_CHUNK_PREFIX;
+    size_t n = buffer->size - offset;
+
+    if (is_last && (~ar->flags & TI_API_FLAG_CHUNKED))
     {
-        size_t tmp_sz;
-        unsigned char * tmp;
-        yajl_gen_status stat = mpjson_mp_to_json(
-                data,
-                size,
-                &tmp,
-                &tmp_sz,
-                0,
-                ar->flags);
-        free(data);
-        if (stat)
+        data = buffer->data;
+        memmove(data, data + offset, n);
+        memset(buffer, 0, sizeof(msgpack_sbuffer));
+        return ti_api_close_with_response(ar, data, n);
+    }
+
+    if (~ar->flags & TI_API_FLAG_CHUNKED)
+    {
+        int header_size;
+        char * header = malloc(API__HEADER_MAX_SZ);
+        if (!header)
+            return -1;
+
+        header_size = sprintf(
+            header,
+            "HTTP/1.1 %s\r\n" \
+            "Content-Type: %s\r\n" \
+            "Transfer-Encoding: chunked\r\n" \
+            "\r\n",
+            api__html_header[E200_OK],
+            api__content_type[ar->content_type]);
+
+        if (ti_write_direct(
+                &ar->uvstream,
+                header,
+                header_size,
+                header,
+                NULL,
+                NULL) < 0)
         {
-            mpjson__set_err(&ar->e, stat);
-            return ti_api_close_with_err(ar, &ar->e);
+            free(header);
+            return -1;
         }
-        data = tmp;
-        size = tmp_sz;
+        ar->flags |= TI_API_FLAG_CHUNKED;
     }
-    return api__close_resp(ar, data, size, api__write_free_cb);
+
+    if (n)
+    {
+        char hex[TI_API_CHUNK_PREFIX + 1];
+        int len = sprintf(hex, "%zx\r\n", n);
+
+        offset -= len;
+        memcpy(buffer->data + offset, hex, len);
+
+        if (msgpack_sbuffer_write(buffer, "\r\n", 2))
+            return -1;
+    }
+
+    if (is_last)
+    {
+        uv_buf_t uvbuf;
+
+        if (msgpack_sbuffer_write(buffer, "0\r\n\r\n", 5))
+            return -1;
+
+        uvbuf = uv_buf_init(buffer->data + offset, buffer->size - offset);
+
+        /* bind response to request to we can free in the callback */
+        ar->req.data = buffer->data;
+        memset(buffer, 0, sizeof(msgpack_sbuffer));
+
+        (void) uv_write(
+                &ar->req,
+                &ar->uvstream,
+                &uvbuf,
+                1,
+                api__write_free_cb);
+        return 0;
+    }
+
+    rc = ti_write_direct(
+            &ar->uvstream,
+            buffer->data + offset,
+            buffer->size - offset,
+            buffer->data,
+            cb,
+            arg);
+    if (rc < 0)
+        return -1;
+
+    memset(buffer, 0, sizeof(msgpack_sbuffer));
+    return rc;
 }
 
 int ti_api_close_with_err(ti_api_request_t * ar, ex_t * e)
@@ -471,6 +573,20 @@ int ti_api_close_with_err(ti_api_request_t * ar, ex_t * e)
     char * body = NULL;
     int header_size = 0, body_size = 0;
 
+    if (ar->flags & TI_API_FLAG_CHUNKED)
+    {
+        /*
+         * The response status is already written; close the connection
+         * without the last chunk so the client knows the response is not
+         * complete.
+         */
+        log_error(
+                "failed to complete chunked HTTP API response: %s (%d)",
+                e->msg, e->nr);
+        ti_api_close(ar);
+        return -1;
+    }
+
     switch (e->nr)
     {
     case EX_BAD_DATA:
@@ -743,19 +859,32 @@ static void api__fwd_cb(ti_req_t * req, ex_enum status)
         case TI_API_CT_JSON:
         {
             size_t size;
-            unsigned char * data;
-            yajl_gen_status stat = mpjson_mp_to_json(
-                    req->pkg_res->data,
+            char * data;
+            msgpack_packer pk;
+            mpjson_writer_t writer;
+
+            if (mpjson_writer_init(
+                    &writer,
+                    &pk,
                     req->pkg_res->n,
-                    &data,
-                    &size,
                     0,
-                    ar->flags);
-            if (stat)
+                    ar->flags))
             {
-                mpjson__set_err(&ar->e, stat);
+                ex_set_mem(&ar->e);
                 goto fail;
             }
+
+            if (mp_pack_append(&pk, req->pkg_res->data, req->pkg_res->n) ||
+                mpjson_writer_done(&writer))
+            {
+                mpjson_writer_set_err(&writer, &ar->e);
+                mpjson_writer_destroy(&writer);
+                goto fail;
+            }
+
+            take_buffer(&writer.buffer, &data, &size);
+            mpjson_writer_destroy(&writer);
+
             api__close_resp(ar, data, size, api__write_free_cb);
             goto done;
         }
@@ -11,6 +11,7 @@
 #include <ti/cpkg.inline.h>
 #include <unistd.h>
 #include <util/fx.h>
+#include <util/fz.h>
 #include <util/logger.h>
 #include <util/util.h>
 
@@ -123,7 +124,7 @@ static int archive__to_disk(void)
 {
     assert(archive->queue->n);
     int rc = -1;
-    FILE * f;
+    fz_t * f;
     msgpack_packer pk;
     ti_cpkg_t * cpkg;
     ti_cpkg_t * last_cpkg = queue_last(archive->queue);
@@ -163,14 +164,14 @@ static int archive__to_disk(void)
 
     log_info("saving `change` data to file: `%s`", archfile->fn);
 
-    f = fopen(archfile->fn, "w");
+    f = fz_open(archfile->fn, ti.cfg->store_compression);
     if (!f)
     {
         log_errno_file("cannot open file", errno, archfile->fn);
         goto fail1;
     }
 
-    msgpack_packer_init(&pk, f, msgpack_fbuffer_write);
+    msgpack_packer_init(&pk, f, fz_write);
 
     if (msgpack_pack_array(&pk, archive->queue->n + 1))
         goto fail2;
@@ -197,7 +198,7 @@ static int archive__to_disk(void)
     rc = 0;
 
 fail2:
-    if (fclose(f))
+    if (fz_close(f))
     {
         log_errno_file("cannot close file", errno, archfile->fn);
         rc = -1;
@@ -386,6 +386,16 @@ static void away__waiter_pre_cb(uv_timer_t * waiter)
         return;
     }
 
+    if (ti.streams_count)
+    {
+        log_info(
+                "wait for %zd streamed %s to finish before going into away "
+                "mode",
+                ti.streams_count,
+                ti.streams_count == 1 ? "response" : "responses");
+        return;
+    }
+
     if (changes_to_process)
     {
         /* empty the queue because other nodes might wait for these evens to
@@ -193,6 +193,146 @@ static int cfg__str(
     return *str ? 0 : -1;
 }
 
+static void cfg__store_threads(
+        cfgparser_t * parser,
+        const char * cfg_file,
+        uint8_t * store_threads)
+{
+    const int min_ = 1;
+    const int max_ = 64;
+
+    cfgparser_option_t * option;
+    cfgparser_return_t rc;
+    rc = cfgparser_get_option(&option, parser, cfg__section, "store_threads");
+
+    if (rc != CFGPARSER_SUCCESS)
+        return;
+
+    if (    option->tp != CFGPARSER_TP_INTEGER ||
+            option->val->integer < min_ ||
+            option->val->integer > max_)
+    {
+        log_warning(
+                "error reading `store_threads` in `%s` "
+                "(expecting a value between %d and %d), "
+                "using default value %u",
+                cfg_file,
+                min_,
+                max_,
+                *store_threads);
+        return;
+    }
+
+    *store_threads = (uint8_t) option->val->integer;
+}
+
+static void cfg__query_threads(
+        cfgparser_t * parser,
+        const char * cfg_file,
+        uint8_t * query_threads)
+{
+    const int min_ = 1;
+    const int max_ = 64;
+
+    cfgparser_option_t * option;
+    cfgparser_return_t rc;
+    rc = cfgparser_get_option(&option, parser, cfg__section, "query_threads");
+
+    if (rc != CFGPARSER_SUCCESS)
+        return;
+
+    if (    option->tp != CFGPARSER_TP_INTEGER ||
+            option->val->integer < min_ ||
+            option->val->integer > max_)
+    {
+        log_warning(
+                "error reading `query_threads` in `%s` "
+                "(expecting a value between %d and %d), "
+                "using default value %u",
+                cfg_file,
+                min_,
+                max_,
+                *query_threads);
+        return;
+    }
+
+    *query_threads = (uint8_t) option->val->integer;
+}
+
+static void cfg__store_compression(
+        cfgparser_t * parser,
+        const char * cfg_file,
+        uint8_t * store_compression)
+{
+    const int min_ = 0;
+    const int max_ = 9;
+
+    cfgparser_option_t * option;
+    cfgparser_return_t rc;
+    rc = cfgparser_get_option(
+            &option,
+            parser,
+            cfg__section,
+            "store_compression");
+
+    if (rc != CFGPARSER_SUCCESS)
+        return;
+
+    if (    option->tp != CFGPARSER_TP_INTEGER ||
+            option->val->integer < min_ ||
+            option->val->integer > max_)
+    {
+        log_warning(
+                "error reading `store_compression` in `%s` "
+                "(expecting a value between %d and %d), "
+                "using default value %u",
+                cfg_file,
+                min_,
+                max_,
+                *store_compression);
+        return;
+    }
+
+    *store_compression = (uint8_t) option->val->integer;
+}
+
+static void cfg__change_id_batch(
+        cfgparser_t * parser,
+        const char * cfg_file,
+        uint8_t * change_id_batch)
+{
+    const int min_ = 1;
+    const int max_ = 64;
+
+    cfgparser_option_t * option;
+    cfgparser_return_t rc;
+    rc = cfgparser_get_option(
+            &option,
+            parser,
+            cfg__section,
+            "change_id_batch");
+
+    if (rc != CFGPARSER_SUCCESS)
+        return;
+
+    if (    option->tp != CFGPARSER_TP_INTEGER ||
+            option->val->integer < min_ ||
+            option->val->integer > max_)
+    {
+        log_warning(
+                "error reading `change_id_batch` in `%s` "
+                "(expecting a value between %d and %d), "
+                "using default value %u",
+                cfg_file,
+                min_,
+                max_,
+                *change_id_batch);
+        return;
+    }
+
+    *change_id_batch = (uint8_t) option->val->integer;
+}
+
 static void cfg__threshold_full_storage(
         cfgparser_t * parser,
         const char * cfg_file)
@@ -411,6 +551,8 @@ int ti_cfg_create(void)
             ? strdup("/usr/lib/thingsdb-modules")
             : fx_path_join(homedir, ".thingsdb-modules/");
     cfg->wait_for_modules = 0;
+    cfg->change_pipelines = 0;
+    cfg->lazy_load = 0;
     cfg->python_interpreter = strdup("python");
     cfg->gcloud_key_file = NULL;
     cfg->pipe_client_name = NULL;
@@ -418,6 +560,10 @@ int ti_cfg_create(void)
     cfg->ws_key_file = NULL;
     cfg->zone = 0;
     cfg->shutdown_period = 6;
+    cfg->store_threads = TI_DEFAULT_STORE_THREADS;
+    cfg->query_threads = TI_DEFAULT_QUERY_THREADS;
+    cfg->store_compression = 0;
+    cfg->change_id_batch = 1;
     cfg->query_duration_warn = 0;
     cfg->query_duration_error = 0;
     cfg->node_name = strdup(hostname);
@@ -526,6 +672,12 @@ int ti_cfg_parse(const char * cfg_file)
         goto exit_parse;
 
     cfg__bool(parser, cfg_file, "wait_for_modules", &cfg->wait_for_modules);
+    cfg__bool(
+            parser,
+            "change_pipelines",
+            cfg_file,
+            &cfg->change_pipelines);
+    cfg__bool(parser, "lazy_load", cfg_file, &cfg->lazy_load);
     cfg__port(parser, cfg_file, "listen_client_port", &cfg->client_port);
     cfg__port(parser, cfg_file, "listen_node_port", &cfg->node_port);
     cfg__port(parser, cfg_file, "http_status_port", &cfg->http_status_port);
@@ -535,6 +687,10 @@ int ti_cfg_parse(const char * cfg_file)
     cfg__shutdown_period(parser, cfg_file, &cfg->shutdown_period);
     cfg__ip_support(parser, cfg_file);
     cfg__threshold_full_storage(parser, cfg_file);
+    cfg__store_threads(parser, cfg_file, &cfg->store_threads);
+    cfg__query_threads(parser, cfg_file, &cfg->query_threads);
+    cfg__store_compression(parser, cfg_file, &cfg->store_compression);
+    cfg__change_id_batch(parser, cfg_file, &cfg->change_id_batch);
     cfg__result_size_limit(parser, cfg_file);
     cfg__threshold_query_cache(parser, cfg_file);
     cfg__cache_expiration_time(parser, cfg_file);
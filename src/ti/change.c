@@ -244,8 +244,8 @@ int ti_change_run(ti_change_t * change)
 
     ti_thing_t * thing;
     ti_pkg_t * pkg = change->via.cpkg->pkg;
-    mp_unp_t up;
-    size_t i, ii;
+    mp_unp_t up, peek;
+    size_t i, ii, ntasks;
     mp_obj_t obj, mp_scope, mp_id;
 
     mp_unp_init(&up, pkg->data, pkg->n);
@@ -272,7 +272,16 @@ int ti_change_run(ti_change_t * change)
 
     ti_changes_keep_dropped();
 
-    for (i = obj.via.sz-2; i--;)
+    /* skip the optional dependency, see ti_cpkg_dep() */
+    ntasks = obj.via.sz-2;
+    peek = up;
+    if (ntasks && mp_next(&peek, &obj) == MP_U64)
+    {
+        up = peek;
+        --ntasks;
+    }
+
+    for (i = ntasks; i--;)
     {
         /*
          * Loop over change tasks. Each iteration is a task related to a
@@ -3,9 +3,11 @@
  */
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 #include <ti/change.h>
 #include <ti/changes.h>
 #include <ti.h>
+#include <ti/collections.h>
 #include <ti/cpkg.h>
 #include <ti/cpkg.inline.h>
 #include <ti/proto.h>
@@ -47,6 +49,12 @@
  */
 #define CHANGES__INIT_DROPPED_SZ 128
 
+/*
+ * Number of changes processed by a single run of the change loop; when
+ * change id batching is enabled, at least a full batch is processed
+ */
+#define CHANGES__LOOP_MAX 5
+
 ti_changes_t changes_;
 static ti_changes_t * changes;
 
@@ -54,6 +62,8 @@ static void changes__destroy(uv_handle_t * UNUSED(handle));
 static void changes__new_id(ti_change_t * change);
 static int changes__req_change_id(ti_change_t * change, ex_t * e);
 static void changes__on_req_change_id(ti_change_t * change, _Bool accepted);
+static void changes__flush(uv_timer_t * handle);
+static void changes__on_req_batch(vec_t * batch, _Bool accepted);
 static int changes__push(ti_change_t * change);
 static void changes__loop(uv_async_t * handle);
 
@@ -88,12 +98,17 @@ int ti_changes_create(void)
     changes->keep_dropped = false;
     changes->queue = queue_new(4);
     changes->changeloop = malloc(sizeof(uv_async_t));
+    changes->batch_timer = malloc(sizeof(uv_timer_t));
+    changes->pending = vec_new(8);
     changes->lock = malloc(sizeof(uv_mutex_t));
     changes->next_change_id = 0;
     changes->dropped = vec_new(CHANGES__INIT_DROPPED_SZ);
     changes->skipped_ids = olist_create();
     memset(&changes->wait_gap_time, 0, sizeof(changes->wait_gap_time));
     changes->wait_ccid = 0;
+    changes->barrier_id = 0;
+    changes->loop_ccid = 0;
+    changes->run_ahead = false;
 
     if (!changes->skipped_ids ||
         !changes->lock ||
@@ -103,7 +118,10 @@ int ti_changes_create(void)
         goto failed;
     }
 
-    if (!changes->queue || !changes->changeloop)
+    if (!changes->queue ||
+        !changes->changeloop ||
+        !changes->batch_timer ||
+        !changes->pending)
         goto failed;
 
     ti.changes = changes;
@@ -120,7 +138,8 @@ failed:
  */
 int ti_changes_start(void)
 {
-    if (uv_async_init(ti.loop, changes->changeloop, changes__loop))
+    if (uv_timer_init(ti.loop, changes->batch_timer) ||
+        uv_async_init(ti.loop, changes->changeloop, changes__loop))
         return -1;
     changes->is_started = true;
     return 0;
@@ -135,7 +154,11 @@ void ti_changes_stop(void)
         return;
 
     if (changes->is_started)
+    {
+        uv_close((uv_handle_t *) changes->batch_timer, (uv_close_cb) free);
+        changes->batch_timer = NULL;
         uv_close((uv_handle_t *) changes->changeloop, changes__destroy);
+    }
     else
         changes__destroy(NULL);
 }
@@ -194,7 +217,28 @@ int ti_changes_create_new_change(ti_query_t * query, ex_t * e)
     query->change = ti_grab(change);
     change->collection = ti_grab(query->collection);
 
-    return changes__req_change_id(change, e);
+    if (ti.cfg->change_id_batch <= 1)
+        return changes__req_change_id(change, e);
+
+    /*
+     * Batching is enabled; the change id is requested together with other
+     * changes which are created within this iteration of the event loop.
+     */
+    if (vec_push(&changes->pending, change))
+    {
+        ti_change_drop(change);
+        ex_set_mem(e);
+        return e->nr;
+    }
+
+    if (changes->pending->n == 1 &&
+        uv_timer_start(changes->batch_timer, changes__flush, 0, 0))
+    {
+        (void) vec_pop(changes->pending);
+        return changes__req_change_id(change, e);
+    }
+
+    return 0;
 }
 
 /*
@@ -277,6 +321,7 @@ int ti_changes_add_change(ti_node_t * node, ti_cpkg_t * cpkg)
     (void) changes__push(change);
 
     change->status = TI_CHANGE_STAT_READY;
+    changes->run_ahead = true;
 
     if (changes__trigger() < 0)
         log_error("cannot trigger the change loop");
@@ -284,6 +329,23 @@ int ti_changes_add_change(ti_node_t * node, ti_cpkg_t * cpkg)
     return 0;
 }
 
+/* Registers all id's between the next expected change id and `change_id` as
+ * skipped. After this call, `change_id` is the next expected change id.
+ */
+static void changes__skip_ids(uint64_t change_id)
+{
+    log_info("skipped %u change id%s while accepting "TI_CHANGE_ID,
+            change_id - changes->next_change_id,
+            change_id - changes->next_change_id == 1 ? "" : "s",
+            change_id);
+    do
+    {
+        if (olist_set(changes->skipped_ids, changes->next_change_id))
+            log_error(EX_MEMORY_S);
+
+    } while (++changes->next_change_id < change_id);
+}
+
 /* Returns true if the change is accepted, false if not. In case the change
  * is not accepted due to an error, logging is done.
  */
@@ -300,17 +362,7 @@ ti_proto_enum_t ti_changes_accept_id(uint64_t change_id, uint8_t * n)
 
     if (change_id > changes->next_change_id)
     {
-        log_info("skipped %u change id%s while accepting "TI_CHANGE_ID,
-                change_id - changes->next_change_id,
-                change_id - changes->next_change_id == 1 ? "" : "s",
-                change_id);
-        do
-        {
-            if (olist_set(changes->skipped_ids, changes->next_change_id))
-                log_error(EX_MEMORY_S);
-
-        } while (++changes->next_change_id < change_id);
-
+        changes__skip_ids(change_id);
         ++changes->next_change_id;
         return TI_PROTO_NODE_RES_ACCEPT;
     }
@@ -354,6 +406,40 @@ ti_proto_enum_t ti_changes_accept_id(uint64_t change_id, uint8_t * n)
     return TI_PROTO_NODE_ERR_REJECT;
 }
 
+/* Same as ti_changes_accept_id() but for `n_ids` change id's, starting at
+ * `change_id`. A range is only accepted as a whole and therefore never
+ * taken from skipped change id's.
+ */
+ti_proto_enum_t ti_changes_accept_range(
+        uint64_t change_id,
+        uint64_t n_ids,
+        uint8_t * n)
+{
+    uint64_t end = change_id + n_ids;
+
+    if (change_id >= changes->next_change_id)
+    {
+        if (change_id > changes->next_change_id)
+            changes__skip_ids(change_id);
+        changes->next_change_id = end;
+        return TI_PROTO_NODE_RES_ACCEPT;
+    }
+
+    for (queue_each(changes->queue, ti_change_t, change))
+    {
+        if (change->id >= end)
+            break;
+
+        if (change->id >= change_id)
+            return change->tp == TI_CHANGE_TP_MASTER && (
+                        (*n = change->requests) || 1)
+                    ? TI_PROTO_NODE_ERR_COLLISION
+                    : TI_PROTO_NODE_ERR_REJECT;
+    }
+
+    return TI_PROTO_NODE_ERR_REJECT;
+}
+
 /* Sets the next missing change id, at least higher than the given change_id.
  *
  */
@@ -378,6 +464,18 @@ void ti_changes_set_next_missing_id(uint64_t * change_id)
     ++(*change_id);
 }
 
+/*
+ * Returns the change id on which a new change for the given collection
+ * depends. Changes with a global scope, and change id's for which the scope
+ * is unknown, act as a barrier for all collections.
+ */
+uint64_t ti_changes_dep_id(ti_collection_t * collection)
+{
+    return collection->change_id > changes->barrier_id
+            ? collection->change_id
+            : changes->barrier_id;
+}
+
 void ti_changes_free_dropped(void)
 {
     ti_thing_t * thing;
@@ -405,6 +503,8 @@ static void changes__destroy(uv_handle_t * UNUSED(handle))
     if (!changes)
         return;
     queue_destroy(changes->queue, (queue_destroy_cb) ti_change_drop);
+    vec_destroy(changes->pending, (vec_destroy_cb) ti_change_drop);
+    free(changes->batch_timer);
     uv_mutex_destroy(changes->lock);
     free(changes->lock);
     free(changes->changeloop);
@@ -449,15 +549,43 @@ fail:
     change->status = TI_CHANGE_STAT_CACNCEL;
 }
 
+static void changes__send_req(ti_pkg_t * pkg, ti_quorum_t * quorum)
+{
+    vec_t * nodes_vec = ti.nodes->vec;
+    ti_pkg_t * dup;
+
+    for (vec_each(nodes_vec, ti_node_t, node))
+    {
+        if (node == ti.node)
+            continue;
+
+        dup = NULL;
+        if (node->status <= TI_NODE_STAT_SHUTTING_DOWN ||
+            !(dup = ti_pkg_dup(pkg)) ||
+            ti_req_create(
+                node->stream,
+                dup,
+                TI_PROTO_NODE_REQ_CHANGE_ID_TIMEOUT,
+                ti_quorum_req_cb,
+                quorum))
+        {
+            free(dup);
+            if (ti_quorum_shrink_one(quorum))
+                log_error(
+                        "failed to reach quorum while the previous check"
+                        "was successful");
+        }
+    }
+}
+
 static int changes__req_change_id(ti_change_t * change, ex_t * e)
 {
     assert(queue_space(changes->queue) > 0);
 
     msgpack_packer pk;
     msgpack_sbuffer buffer;
-    vec_t * nodes_vec = ti.nodes->vec;
     ti_quorum_t * quorum;
-    ti_pkg_t * pkg, * dup;
+    ti_pkg_t * pkg;
 
     quorum = ti_quorum_new((ti_quorum_cb) changes__on_req_change_id, change);
     if (!quorum)
@@ -487,28 +615,7 @@ static int changes__req_change_id(ti_change_t * change, ex_t * e)
     /* we have space so this function always succeeds */
     (void) changes__push(change);
 
-    for (vec_each(nodes_vec, ti_node_t, node))
-    {
-        if (node == ti.node)
-            continue;
-
-        dup = NULL;
-        if (node->status <= TI_NODE_STAT_SHUTTING_DOWN ||
-            !(dup = ti_pkg_dup(pkg)) ||
-            ti_req_create(
-                node->stream,
-                dup,
-                TI_PROTO_NODE_REQ_CHANGE_ID_TIMEOUT,
-                ti_quorum_req_cb,
-                quorum))
-        {
-            free(dup);
-            if (ti_quorum_shrink_one(quorum))
-                log_error(
-                        "failed to reach quorum while the previous check"
-                        "was successful");
-        }
-    }
+    changes__send_req(pkg, quorum);
 
     change->requests = quorum->requests;
 
@@ -541,6 +648,171 @@ done:
     ti_change_drop(change);
 }
 
+static void changes__cancel(ti_change_t * change, ex_t * e)
+{
+    change->status = TI_CHANGE_STAT_CACNCEL;
+    ti_change_drop(change);  /* reference for the queue */
+    ti_query_response(change->via.query, e);
+}
+
+/*
+ * Requests change id's for `n` pending changes using a single request, the
+ * other nodes accept the range `[first_id, n]` as a whole.
+ */
+static void changes__req_batch(ti_change_t ** pending, uint32_t n)
+{
+    ex_t e = {0};
+    msgpack_packer pk;
+    msgpack_sbuffer buffer;
+    ti_quorum_t * quorum;
+    ti_pkg_t * pkg;
+    vec_t * batch;
+    uint32_t i;
+
+    if (queue_reserve(&changes->queue, n))
+    {
+        ex_set_mem(&e);
+        goto fail;
+    }
+
+    if (!ti_nodes_has_quorum())
+    {
+        ex_set(&e, EX_NODE_ERROR,
+                TI_NODE_ID" does not have the required quorum "
+                "of at least %u connected nodes",
+                ti.node->id,
+                ti_nodes_quorum());
+        goto fail;
+    }
+
+    if (n == 1)
+    {
+        if (changes__req_change_id(*pending, &e) == 0)
+            return;
+        goto fail;
+    }
+
+    batch = vec_new(n);
+    if (!batch)
+    {
+        ex_set_mem(&e);
+        goto fail;
+    }
+
+    quorum = ti_quorum_new((ti_quorum_cb) changes__on_req_batch, batch);
+    if (!quorum)
+    {
+        free(batch);
+        ex_set_mem(&e);
+        goto fail;
+    }
+
+    if (mp_sbuffer_alloc_init(&buffer, 32, sizeof(ti_pkg_t)))
+    {
+        ti_quorum_destroy(quorum);
+        free(batch);
+        ex_set_mem(&e);
+        goto fail;
+    }
+
+    msgpack_packer_init(&pk, &buffer, msgpack_sbuffer_write);
+    msgpack_pack_array(&pk, 2);
+    msgpack_pack_uint64(&pk, changes->next_change_id);
+    msgpack_pack_uint32(&pk, n);
+
+    pkg = (ti_pkg_t *) buffer.data;
+    pkg_init(pkg, 0, TI_PROTO_NODE_REQ_CHANGE_ID, buffer.size);
+
+    for (i = 0; i < n; ++i)
+    {
+        ti_change_t * change = pending[i];
+
+        change->id = changes->next_change_id;
+        ++changes->next_change_id;
+
+        VEC_push(batch, ti_grab(change));
+
+        /* we have space so this function always succeeds */
+        (void) changes__push(change);
+    }
+
+    ++ti.counters->change_id_batches;
+    ti.counters->change_id_batched += n;
+    if (n > ti.counters->largest_change_id_batch)
+        ti.counters->largest_change_id_batch = n;
+
+    changes__send_req(pkg, quorum);
+
+    for (vec_each(batch, ti_change_t, change))
+        change->requests = quorum->requests;
+
+    free(pkg);
+
+    ti_quorum_go(quorum);
+    return;
+
+fail:
+    for (i = 0; i < n; ++i)
+        changes__cancel(pending[i], &e);
+}
+
+/*
+ * Pending changes are taken from the vector before requesting the change
+ * id's since failed changes are answered right away, and answering a query
+ * may create a new pending change.
+ */
+static void changes__flush(uv_timer_t * UNUSED(handle))
+{
+    ti_change_t * batch[UINT8_MAX];
+    uint32_t max = ti.cfg->change_id_batch ? ti.cfg->change_id_batch : 1;
+    uint32_t n;
+    vec_t * pending;
+
+    while ((pending = changes->pending)->n)
+    {
+        n = pending->n < max ? pending->n : max;
+        memcpy(batch, pending->data, n * sizeof(void *));
+        pending->n -= n;
+        memmove(
+                pending->data,
+                pending->data + n,
+                pending->n * sizeof(void *));
+        changes__req_batch(batch, n);
+    }
+}
+
+static void changes__on_req_batch(vec_t * batch, _Bool accepted)
+{
+    ti_change_t * first = vec_first(batch);
+
+    if (!accepted)
+    {
+        ++ti.counters->quorum_lost;
+
+        log_debug(
+                "batch of %"PRIu32" change ids starting at "TI_CHANGE_ID
+                " quorum lost :-(", batch->n, first->id);
+
+        /* fall back to requesting a new change id for each change */
+        for (vec_each(batch, ti_change_t, change))
+            changes__new_id(change);
+        goto done;
+    }
+
+    log_debug(
+            "batch of %"PRIu32" change ids starting at "TI_CHANGE_ID
+            " quorum win :-)", batch->n, first->id);
+
+    for (vec_each(batch, ti_change_t, change))
+        change->status = TI_CHANGE_STAT_READY;
+
+    if (changes__trigger() < 0)
+        log_error("cannot trigger the change loop");
+
+done:
+    vec_destroy(batch, (vec_destroy_cb) ti_change_drop);
+}
+
 static int changes__push(ti_change_t * change)
 {
     size_t idx = 0;
@@ -557,12 +829,65 @@ static int changes__push(ti_change_t * change)
     return queue_insert(&changes->queue, idx, change);
 }
 
+static inline void changes__barrier(uint64_t change_id)
+{
+    if (change_id > changes->barrier_id)
+        changes->barrier_id = change_id;
+}
+
+/*
+ * Runs changes from other nodes ahead of the committed change id. This is
+ * only done for changes with a dependency (see ti_cpkg_dep()) which is
+ * already applied, so changes within a collection keep their order. The
+ * changes are still committed, and pushed to the archive, in order.
+ */
+static void changes__run_ahead(void)
+{
+    uint64_t ccid = ti.node->ccid;
+    uint64_t scope_id, dep_id;
+    ti_collection_t * collection;
+
+    if (!changes->run_ahead || ti.node->status != TI_NODE_STAT_READY)
+        return;
+
+    changes->run_ahead = false;
+
+    for (queue_each(changes->queue, ti_change_t, change))
+    {
+        if (change->tp != TI_CHANGE_TP_CPKG ||
+            change->id <= ccid ||
+            (change->flags & TI_CHANGE_FLAG_AHEAD) ||
+            ti_cpkg_dep(change->via.cpkg, &scope_id, &dep_id) ||
+            !(collection = ti_collections_get_by_id(scope_id)) ||
+            collection->change_id > dep_id ||
+            (dep_id > ccid && collection->change_id != dep_id))
+            continue;
+
+        ti_change_log("running ahead", change, LOGGER_DEBUG);
+
+        if (ti_change_run(change))
+        {
+            ++ti.counters->changes_failed;
+            ti_change_log("change has failed", change, LOGGER_ERROR);
+            change->flags |= TI_CHANGE_FLAG_FAILED;
+        }
+
+        change->flags |= TI_CHANGE_FLAG_AHEAD;
+        collection->dirty = true;
+        collection->gc_dirty = true;
+        collection->change_id = change->id;
+        ++ti.counters->changes_ahead;
+    }
+}
+
 static void changes__loop(uv_async_t * UNUSED(handle))
 {
     ti_change_t * change;
     util_time_t timing;
     uint64_t * ccid_p = &ti.node->ccid;
-    int process_changes = 5;
+    int process_changes = ti.cfg->change_id_batch > CHANGES__LOOP_MAX
+            ? ti.cfg->change_id_batch
+            : CHANGES__LOOP_MAX;
 
     if (uv_mutex_trylock(changes->lock))
         return;
@@ -570,6 +895,13 @@ static void changes__loop(uv_async_t * UNUSED(handle))
     if (clock_gettime(TI_CLOCK_MONOTONIC, &timing))
         goto stop;
 
+    /*
+     * The committed change id has changed outside the change loop, for
+     * example by a synchronization, thus the scope of those changes is unknown
+     */
+    if (changes->loop_ccid != *ccid_p)
+        changes__barrier(*ccid_p);
+
     while (process_changes-- && (change = queue_first(changes->queue)))
     {
         /* Cancelled change should be removed from the queue */
@@ -623,6 +955,7 @@ static void changes__loop(uv_async_t * UNUSED(handle))
 
             ++(*ccid_p);
             ++ti.counters->changes_with_gap;
+            changes__barrier(*ccid_p);
 
             log_warning(
                 "committed "TI_CHANGE_ID" since the change is not received "
@@ -663,14 +996,42 @@ process:
         {
             ti_query_run(change->via.query);
         }
+        else if (change->flags & TI_CHANGE_FLAG_AHEAD)
+        {
+            /* the change has already run, only archive when successful */
+            if ((~change->flags & TI_CHANGE_FLAG_FAILED) &&
+                ti_archive_push(change->via.cpkg))
+            {
+                ++ti.counters->changes_failed;
+                ti_change_log("change has failed", change, LOGGER_ERROR);
+                change->flags |= TI_CHANGE_FLAG_FAILED;
+            }
+        }
         else if (ti_change_run(change) || ti_archive_push(change->via.cpkg))
         {
             /* logging is done, but we increment the failed counter and
              * log the full change */
             ++ti.counters->changes_failed;
             ti_change_log("change has failed", change, LOGGER_ERROR);
+            change->flags |= TI_CHANGE_FLAG_FAILED;
+        }
+
+        if (change->collection)
+        {
+            /* the collection must be written on the next full store and
+             * changed things must be visited by the garbage collector */
+            change->collection->dirty = true;
+            change->collection->gc_dirty = true;
+
+            if (change->id > change->collection->change_id)
+                change->collection->change_id = change->id;
         }
 
+        /* a change to the thingsdb scope, or a failed change, is a barrier
+         * for changes to all collections */
+        if (!change->collection || (change->flags & TI_CHANGE_FLAG_FAILED))
+            changes__barrier(change->id);
+
         /* update counters */
         (void) ti_counters_upd_commit_change(&change->time);
 
@@ -686,6 +1047,15 @@ shift_drop_loop:
     }
 
 stop:
+    /* changes might be able to run ahead once the committed id changes */
+    if (changes->loop_ccid != *ccid_p)
+    {
+        changes->loop_ccid = *ccid_p;
+        changes->run_ahead = true;
+    }
+
+    changes__run_ahead();
+
     uv_mutex_unlock(changes->lock);
 
     /* status will be send to nodes on next `connect` loop */
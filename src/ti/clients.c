@@ -296,6 +296,9 @@ query:
     query->user = ti_grab(user);
     query->pkg_id = pkg->id;
 
+    if (pkg->tp == TI_PROTO_CLIENT_REQ_QUERY_STREAM)
+        query->flags |= TI_QUERY_FLAG_STREAM;
+
     if (ti_query_apply_scope(query, &scope, &e) ||
         ti_query_unpack_args(query, &up, &e))
         goto finish;
@@ -516,6 +519,9 @@ static void clients__on_run(ti_stream_t * stream, ti_pkg_t * pkg)
     query->via.stream = ti_grab(stream);
     query->user = ti_grab(user);
 
+    if (pkg->tp == TI_PROTO_CLIENT_REQ_RUN_STREAM)
+        query->flags |= TI_QUERY_FLAG_STREAM;
+
     if (ti_query_unp_run(query, &scope, pkg->id, pkg->data, pkg->n, &e))
         goto finish;
 
@@ -563,9 +569,11 @@ void ti_clients_pkg_cb(ti_stream_t * stream, ti_pkg_t * pkg)
         clients__on_auth(stream, pkg);
         break;
     case TI_PROTO_CLIENT_REQ_QUERY:
+    case TI_PROTO_CLIENT_REQ_QUERY_STREAM:
         clients__on_query(stream, pkg);
         break;
     case TI_PROTO_CLIENT_REQ_RUN:
+    case TI_PROTO_CLIENT_REQ_RUN_STREAM:
         clients__on_run(stream, pkg);
         break;
     case TI_PROTO_CLIENT_REQ_JOIN:
@@ -397,6 +397,7 @@ int ti_closure_inc(ti_closure_t * closure, ti_query_t * query, ex_t * e)
     case 0:
         if (n && vec_extend(&query->vars, closure->vars->data, n))
             goto err_alloc;
+        ti_query_var_slots_reset(query);
         break;
     default:
         if (n)
@@ -413,6 +414,7 @@ int ti_closure_inc(ti_closure_t * closure, ti_query_t * query, ex_t * e)
                 ti_incref(p->val);
             }
             vec_move(query->vars, pos, n, to);
+            ti_query_var_slots_reset(query);
         }
     }
 
@@ -448,6 +450,7 @@ void ti_closure_dec(ti_closure_t * closure, ti_query_t * query)
 
         /* move the property values to the correct place on the stack */
         vec_move(query->vars, pos, n, to);
+        ti_query_var_slots_reset(query);
     }
     else
     {
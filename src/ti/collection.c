@@ -29,8 +29,6 @@
 #include <util/fx.h>
 #include <util/strx.h>
 
-static void collection__gc_mark_thing(ti_thing_t * thing);
-
 static const size_t ti_collection_min_name = 1;
 static const size_t ti_collection_max_name = 128;
 
@@ -50,6 +48,9 @@ ti_collection_t * ti_collection_create(
         return NULL;
 
     collection->ref = 1;
+    collection->flags = 0;
+    collection->dirty = true;
+    collection->gc_dirty = true;
     collection->deep = deep;
     collection->root = NULL;
     collection->id = collection_id;
@@ -67,6 +68,7 @@ ti_collection_t * ti_collection_create(
     collection->tz = tz;
     collection->futures = vec_new(4);
     collection->vtasks = vec_new(4);
+    collection->change_id = 0;
 
     memcpy(&collection->guid, guid, sizeof(guid_t));
 
@@ -254,6 +256,8 @@ ti_thing_t * ti_collection_thing_restore_gc(
                 ti_panic("unable to restore from garbage collection");
 
             ti_decref(thing);
+            collection->dirty = true;
+            collection->gc_dirty = true;
             /*
              * The references of thing may be 0 at this point but even if this
              * is the case we still should not drop the thing since it will
@@ -267,114 +271,183 @@ ti_thing_t * ti_collection_thing_restore_gc(
     return NULL;
 }
 
-static void collection__gc_mark_varr(ti_varr_t * varr)
+/*
+ * The garbage collector works in slices; when a slice takes longer than
+ * `COLLECTION__GC_SLICE` seconds, the collection lock is released for a short
+ * moment. The time is checked once every `COLLECTION__GC_CHECK` things.
+ */
+#define COLLECTION__GC_SLICE 0.01
+#define COLLECTION__GC_CHECK 512
+#define COLLECTION__GC_STACK_SZ 1024
+
+typedef struct
+{
+    ti_collection_t * collection;
+    vec_t * stack;          /* marked things which are not yet scanned */
+    uint64_t ccid;
+    uint64_t next_id;       /* the sweep continues at this thing id */
+    size_t n;               /* number of things visited in this slice */
+    double largest_pause;   /* longest time the lock was held (seconds) */
+    struct timespec locked;
+} collection__gc_t;
+
+static void collection__gc_scan(ti_thing_t * thing, collection__gc_t * w);
+
+static void collection__gc_lock(collection__gc_t * w)
+{
+    uv_mutex_lock(w->collection->lock);
+    (void) clock_gettime(TI_CLOCK_MONOTONIC, &w->locked);
+    w->n = 0;
+}
+
+static void collection__gc_unlock(collection__gc_t * w)
+{
+    struct timespec now;
+    double pause;
+
+    (void) clock_gettime(TI_CLOCK_MONOTONIC, &now);
+    uv_mutex_unlock(w->collection->lock);
+
+    pause = util_time_diff(&w->locked, &now);
+    if (pause > w->largest_pause)
+        w->largest_pause = pause;
+}
+
+/*
+ * Returns `true` when the current slice has used all of its time.
+ */
+static _Bool collection__gc_is_due(collection__gc_t * w)
+{
+    struct timespec now;
+
+    if (++w->n % COLLECTION__GC_CHECK)
+        return false;
+
+    (void) clock_gettime(TI_CLOCK_MONOTONIC, &now);
+    return util_time_diff(&w->locked, &now) > COLLECTION__GC_SLICE;
+}
+
+static void collection__gc_yield(collection__gc_t * w)
+{
+    collection__gc_unlock(w);
+    (void) ti_sleep(2);
+    collection__gc_lock(w);
+}
+
+static inline void collection__gc_push(
+        ti_thing_t * thing,
+        collection__gc_t * w)
+{
+    if (~thing->flags & TI_THING_FLAG_SWEEP)
+        return;
+
+    thing->flags &= ~TI_THING_FLAG_SWEEP;
+
+    /* without room on the stack, the thing is scanned right away */
+    if (vec_push(&w->stack, thing))
+        collection__gc_scan(thing, w);
+}
+
+static void collection__gc_mark_varr(ti_varr_t * varr, collection__gc_t * w)
 {
     for (vec_each(varr->vec, ti_val_t, val))
     {
         switch(val->tp)
         {
         case TI_VAL_THING:
-        {
-            ti_thing_t * thing = (ti_thing_t *) val;
-            if (thing->flags & TI_THING_FLAG_SWEEP)
-                collection__gc_mark_thing(thing);
+            collection__gc_push((ti_thing_t *) val, w);
             continue;
-        }
         case TI_VAL_WRAP:
-        {
-            ti_thing_t * thing = ((ti_wrap_t *) val)->thing;
-            if (thing->flags & TI_THING_FLAG_SWEEP)
-                collection__gc_mark_thing(thing);
+            collection__gc_push(((ti_wrap_t *) val)->thing, w);
             continue;
-        }
         case TI_VAL_ARR:
         {
             ti_varr_t * varr = (ti_varr_t *) val;
             if (ti_varr_may_have_things(varr))
-                collection__gc_mark_varr(varr);
+                collection__gc_mark_varr(varr, w);
             continue;
         }
         }
     }
 }
 
-static inline int colection__set_cb(ti_thing_t * thing, void * UNUSED(arg))
+static inline int colection__set_cb(ti_thing_t * thing, collection__gc_t * w)
 {
-    if (thing->flags & TI_THING_FLAG_SWEEP)
-        collection__gc_mark_thing(thing);
+    collection__gc_push(thing, w);
     return 0;
 }
 
-static inline void collection__gc_val(ti_val_t * val)
+static inline void collection__gc_val(ti_val_t * val, collection__gc_t * w)
 {
     switch(val->tp)
     {
     case TI_VAL_THING:
-    {
-        ti_thing_t * thing = (ti_thing_t *) val;
-        if (thing->flags & TI_THING_FLAG_SWEEP)
-            collection__gc_mark_thing(thing);
+        collection__gc_push((ti_thing_t *) val, w);
         return;
-    }
     case TI_VAL_WRAP:
-    {
-        ti_thing_t * thing = ((ti_wrap_t *) val)->thing;
-        if (thing->flags & TI_THING_FLAG_SWEEP)
-            collection__gc_mark_thing(thing);
+        collection__gc_push(((ti_wrap_t *) val)->thing, w);
         return;
-    }
     case TI_VAL_ARR:
     {
         ti_varr_t * varr = (ti_varr_t *) val;
         if (ti_varr_may_have_things(varr))
-            collection__gc_mark_varr(varr);
+            collection__gc_mark_varr(varr, w);
         return;
     }
     case TI_VAL_SET:
     {
         ti_vset_t * vset = (ti_vset_t *) val;
-        (void) imap_walk(vset->imap, (imap_cb) colection__set_cb, NULL);
+        (void) imap_walk(vset->imap, (imap_cb) colection__set_cb, w);
         return;
     }
     }
 }
 
-static int collection__mark_enum_cb(ti_enum_t * enum_, void * UNUSED(data))
+static int collection__mark_enum_cb(ti_enum_t * enum_, collection__gc_t * w)
 {
     if (enum_->enum_tp == TI_ENUM_THING)
-    {
         for (vec_each(enum_->members, ti_member_t, member))
-        {
-            ti_thing_t * thing = (ti_thing_t *) VMEMBER(member);
-            if (thing->flags & TI_THING_FLAG_SWEEP)
-                collection__gc_mark_thing(thing);
-        }
-    }
+            collection__gc_push((ti_thing_t *) VMEMBER(member), w);
     return 0;
 }
 
-static int collection__gc_i_cb(ti_item_t * item, void * UNUSED(arg))
+static int collection__gc_i_cb(ti_item_t * item, collection__gc_t * w)
 {
-    collection__gc_val(item->val);
+    collection__gc_val(item->val, w);
     return 0;
 }
 
-static void collection__gc_mark_thing(ti_thing_t * thing)
+static void collection__gc_scan(ti_thing_t * thing, collection__gc_t * w)
 {
-    thing->flags &= ~TI_THING_FLAG_SWEEP;
-
     if (ti_thing_is_object(thing))
         if (ti_thing_is_dict(thing))
             (void) smap_values(
                     thing->items.smap,
                     (smap_val_cb) collection__gc_i_cb,
-                    NULL);
+                    w);
         else
             for (vec_each(thing->items.vec, ti_prop_t, prop))
-                collection__gc_val(prop->val);
+                collection__gc_val(prop->val, w);
     else
         for (vec_each(thing->items.vec, ti_val_t, val))
-            collection__gc_val(val);
+            collection__gc_val(val, w);
+}
+
+/*
+ * Scan all things on the stack. Instead of recursion, an explicit stack is
+ * used so the work can be split into slices.
+ */
+static void collection__gc_mark(collection__gc_t * w)
+{
+    ti_thing_t * thing;
+
+    while ((thing = vec_pop(w->stack)))
+    {
+        collection__gc_scan(thing, w);
+
+        if (collection__gc_is_due(w))
+            collection__gc_yield(w);
+    }
 }
 
 void ti_collection_gc_clear(ti_collection_t * collection)
@@ -394,12 +467,6 @@ void ti_collection_gc_clear(ti_collection_t * collection)
     }
 }
 
-typedef struct
-{
-    ti_collection_t * collection;
-    uint64_t ccid;
-} collection__gc_t;
-
 static int collection__gc_thing(ti_thing_t * thing, collection__gc_t * w)
 {
     if (thing->flags & TI_THING_FLAG_SWEEP)
@@ -422,6 +489,12 @@ static int collection__gc_thing(ti_thing_t * thing, collection__gc_t * w)
 
     thing->flags |= TI_THING_FLAG_SWEEP;
 
+    if (collection__gc_is_due(w))
+    {
+        w->next_id = thing->id + 1;
+        return 1;
+    }
+
     /*
      * Return success, also when marking has failed to make sure at least
      * all thing flags are restored
@@ -449,7 +522,8 @@ void ti_collection_stop_futures(ti_collection_t * collection)
 
 int ti_collection_gc(ti_collection_t * collection, _Bool do_mark_things)
 {
-    size_t n = 0, m = 0, idx = 0;
+    int rc;
+    size_t n = 0, m = 0, marked = 0;
     uint64_t scid = ti.global_stored_change_id;
     struct timespec start, stop;
     double duration;
@@ -458,32 +532,69 @@ int ti_collection_gc(ti_collection_t * collection, _Bool do_mark_things)
             .ccid = ti.node ? ti.node->ccid : 0,
     };
 
+    /*
+     * Nothing can have become garbage when the collection has not changed
+     * since the last garbage collection and no garbage is waiting.
+     */
+    if (do_mark_things &&
+        !collection->gc_dirty &&
+        !collection->gc->n)
+    {
+        log_debug(
+            "skip garbage collection for collection `%.*s`; "
+            "nothing has changed",
+            collection->name->n, (char *) collection->name->data);
+        return 0;
+    }
+
+    /*
+     * Without properties, all things would be marked as garbage; an unloaded
+     * collection is unchanged since it was restored from the store.
+     */
+    if (do_mark_things && (collection->flags & TI_COLLECTION_FLAG_UNLOADED))
+    {
+        log_debug(
+            "skip garbage collection for collection `%.*s`; "
+            "collection is not loaded",
+            collection->name->n, (char *) collection->name->data);
+        return 0;
+    }
+
     (void) clock_gettime(TI_CLOCK_MONOTONIC, &start);
 
     if (do_mark_things)
     {
         assert(collection->futures->n == 0 && "Futures must be cancelled");
 
+        w.stack = vec_new(COLLECTION__GC_STACK_SZ);
+        if (!w.stack)
+            return -1;
+
         /* Take a lock because flags are not atomic and might be changed */
-        uv_mutex_lock(collection->lock);
+        collection__gc_lock(&w);
+
+        collection->gc_dirty = false;
 
         for (vec_each(collection->vtasks, ti_vtask_t, vtask))
             for (vec_each(vtask->args, ti_val_t, val))
-                collection__gc_val(val);
+                collection__gc_val(val, &w);
 
         imap_walk(
                 collection->enums->imap,
                 (imap_cb) collection__mark_enum_cb,
-                NULL);
-        collection__gc_mark_thing(collection->root);
+                &w);
+        collection__gc_push(collection->root, &w);
+        collection__gc_mark(&w);
 
         /* Release the lock */
-        uv_mutex_unlock(collection->lock);
+        collection__gc_unlock(&w);
+
+        vec_destroy(w.stack, NULL);
 
         (void) ti_sleep(5);
     }
 
-    uv_mutex_lock(collection->lock);
+    collection__gc_lock(&w);
 
     for (queue_each(collection->gc, ti_gc_t, gc))
     {
@@ -510,6 +621,10 @@ int ti_collection_gc(ti_collection_t * collection, _Bool do_mark_things)
         }
     }
 
+    /* destroyed or restored things change the store files */
+    if (m)
+        collection->dirty = true;
+
     while (m--)
     {
         ti_gc_t * gc = queue_shift(collection->gc);
@@ -540,44 +655,62 @@ int ti_collection_gc(ti_collection_t * collection, _Bool do_mark_things)
     }
 
     /* Release the lock and let the thread sleep some time */
-    uv_mutex_unlock(collection->lock);
+    collection__gc_unlock(&w);
 
     (void) ti_sleep(5);
 
     /* Take a new lock */
-    uv_mutex_lock(collection->lock);
+    collection__gc_lock(&w);
 
-    /*
-     * Take the current garbage size to see which things are assigned by the
-     * walk below.
-     */
-    m = collection->gc->n;
+    do
+    {
+        /*
+         * Take the current garbage size to see which things are assigned by
+         * the walk below.
+         */
+        size_t i = collection->gc->n;
 
-    (void) imap_walk(collection->things, (imap_cb) collection__gc_thing, &w);
+        rc = imap_walk_from(
+                collection->things,
+                w.next_id,
+                (imap_cb) collection__gc_thing,
+                &w);
 
-    /*
-     * Remove the marked things from the collection. This is done after the
-     * walk to prevent changes to the collection map.
-     */
-    for (queue_each(collection->gc, ti_gc_t, gc), ++idx)
-        if (idx >= m)
+        /*
+         * Remove the marked things from the collection. This is done after
+         * the walk to prevent changes to the collection map.
+         */
+        for (marked += collection->gc->n - i; i < collection->gc->n; ++i)
+        {
+            ti_gc_t * gc = queue_get(collection->gc, i);
             (void) imap_pop(collection->things, gc->thing->id);
+        }
 
+        /* the walk has stopped; continue with the next slice */
+        if (rc)
+            collection__gc_yield(&w);
+    }
+    while (rc);
+
+    /* new garbage changes the store files of this collection */
+    if (marked)
+        collection->dirty = true;
 
     /* Finished, release the collection lock */
-    uv_mutex_unlock(collection->lock);
+    collection__gc_unlock(&w);
 
     (void) ti_sleep(2);
 
     ti_counters_add_garbage_collected(n);
+    ti_counters_upd_gc_pause(w.largest_pause);
 
     (void) clock_gettime(TI_CLOCK_MONOTONIC, &stop);
     duration = util_time_diff(&start, &stop);
 
     log_info(
-        "garbage collection took %f seconds; "
+        "garbage collection took %f seconds (largest pause %f seconds); "
         "%zu things(s) are marked as garbage and %zu thing(s) are cleaned",
-        duration, idx-m, n);
+        duration, w.largest_pause, marked, n);
 
     return 0;
 }
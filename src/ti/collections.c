@@ -7,12 +7,15 @@
 #include <string.h>
 #include <ti.h>
 #include <ti/access.h>
+#include <ti/away.h>
 #include <ti/auth.h>
 #include <ti/collection.h>
 #include <ti/collection.inline.h>
 #include <ti/collections.h>
 #include <ti/enums.h>
 #include <ti/proto.h>
+#include <ti/store.h>
+#include <ti/tasks.h>
 #include <ti/things.h>
 #include <ti/val.inline.h>
 #include <ti/vint.h>
@@ -21,6 +24,46 @@
 static ti_collections_t * collections;
 static ti_collections_t collections_;
 
+static ti_collection_t * collections__by_strn(const char * str, size_t n)
+{
+    for (vec_each(collections->vec, ti_collection_t, collection))
+        if (ti_raw_eq_strn(collection->name, str, n))
+            return collection;
+    return NULL;
+}
+
+static ti_collection_t * collections__by_id(const uint64_t id)
+{
+    for (vec_each(collections->vec, ti_collection_t, collection))
+        if (id == collection->id)
+            return collection;
+    return NULL;
+}
+
+/*
+ * Collections which are restored with `lazy_load` are loaded on first use.
+ * Loading is not allowed while the away worker is running so NULL is returned
+ * for an unloaded collection in that case; ti_collections_is_busy_strn() can
+ * be used to tell the difference with a collection which does not exist.
+ * A failed load is fatal, just like it is when collections are restored at
+ * start; a collection which exists on other nodes must never be treated as
+ * "not found" since this node would diverge from the rest of the cluster.
+ */
+static ti_collection_t * collections__loaded(ti_collection_t * collection)
+{
+    if (!collection || (~collection->flags & TI_COLLECTION_FLAG_UNLOADED))
+        return collection;
+
+    if (ti_away_is_working())
+        return NULL;
+
+    if (ti_store_load_collection(collection))
+        ti_panic("failed to load collection `%.*s`",
+                collection->name->n, (char *) collection->name->data);
+
+    return collection;
+}
+
 int ti_collections_create(void)
 {
     collections = &collections_;
@@ -56,8 +99,12 @@ void ti_collections_destroy(void)
 
 void ti_collections_clear(void)
 {
-    while (collections->vec->n)
-        ti_collection_drop(VEC_pop(collections->vec));
+    ti_collection_t * collection;
+    while ((collection = vec_pop(collections->vec)))
+    {
+        ti_tasks_del_collection(collection);
+        ti_collection_drop(collection);
+    }
 }
 
 /*
@@ -89,8 +136,18 @@ int ti_collections_gc(void)
 int ti_collections_check_empty(ex_t * e)
 {
     for (vec_each(collections->vec, ti_collection_t, collection))
+    {
+        if (!collections__loaded(collection))
+        {
+            ex_set(e, EX_NODE_ERROR,
+                "collection `%.*s` is not loaded and cannot be loaded while "
+                "the node is in away mode; try again later",
+                collection->name->n, (char *) collection->name->data);
+            return e->nr;
+        }
         if (ti_collection_check_empty(collection, e))
             return e->nr;
+    }
     return e->nr;
 }
 
@@ -101,6 +158,7 @@ _Bool ti_collections_del_collection(const uint64_t collection_id)
     {
         if (collection->id == collection_id)
         {
+            ti_tasks_del_collection(collection);
             ti_collection_drop(vec_swap_remove(collections->vec, i));
             return true;
         }
@@ -164,14 +222,14 @@ ti_collection_t * ti_collections_create_collection(
         goto fail0;
     }
 
-    if (ti_collections_get_by_strn(name, name_n))
+    if (collections__by_strn(name, name_n))
     {
         ex_set(e, EX_LOOKUP_ERROR,
                 "collection `%.*s` already exists", name_n, name);
         goto fail0;
     }
 
-    if (collection_id && ti_collections_get_by_id(collection_id))
+    if (collection_id && collections__by_id(collection_id))
     {
         ex_set(e, EX_LOOKUP_ERROR,
                 TI_COLLECTION_ID" already exists", collection_id);
@@ -230,19 +288,39 @@ fail0:
 /* returns a weak reference */
 ti_collection_t * ti_collections_get_by_strn(const char * str, size_t n)
 {
-    for (vec_each(collections->vec, ti_collection_t, collection))
-        if (ti_raw_eq_strn(collection->name, str, n))
-            return collection;
-    return NULL;
+    return collections__loaded(collections__by_strn(str, n));
 }
 
 /* returns a weak reference */
 ti_collection_t * ti_collections_get_by_id(const uint64_t id)
 {
-    for (vec_each(collections->vec, ti_collection_t, collection))
-        if (id == collection->id)
-            return collection;
-    return NULL;
+    return collections__loaded(collections__by_id(id));
+}
+
+static inline _Bool collections__is_busy(ti_collection_t * collection)
+{
+    return (
+        collection &&
+        (collection->flags & TI_COLLECTION_FLAG_UNLOADED) &&
+        ti_away_is_working()
+    );
+}
+
+/*
+ * Returns `true` when a collection exists but is not loaded and cannot be
+ * loaded right now since the away worker is running.
+ */
+_Bool ti_collections_is_busy_strn(const char * str, size_t n)
+{
+    return collections__is_busy(collections__by_strn(str, n));
+}
+
+/*
+ * Like ti_collections_is_busy_strn() but using the collection Id.
+ */
+_Bool ti_collections_is_busy_id(const uint64_t id)
+{
+    return collections__is_busy(collections__by_id(id));
 }
 
 /*
@@ -3,6 +3,7 @@
  */
 #include <assert.h>
 #include <ti/connect.h>
+#include <ti/interest.h>
 #include <stdbool.h>
 #include <ti/node.h>
 #include <ti.h>
@@ -141,6 +142,9 @@ static void connect__cb(uv_timer_t * UNUSED(handle))
     }
     ti_rpkg_drop(rpkg);
 
+    /* write the room interest filter when changed */
+    ti_interest_update();
+
     /* trigger the change loop */
     (void) ti_changes_trigger_loop();
 }
@@ -28,6 +28,7 @@ void ti_counters_destroy(void)
 
 void ti_counters_reset(void)
 {
+    double zero = 0.0;
     counters->started_at = util_now_usec();
     counters->queries_success = 0;
     counters->queries_with_error = 0;
@@ -40,6 +41,11 @@ void ti_counters_reset(void)
     counters->changes_committed = 0;
     counters->quorum_lost = 0;
     counters->changes_unaligned = 0;
+    counters->change_id_batches = 0;
+    counters->change_id_batched = 0;
+    counters->largest_change_id_batch = 0;
+    counters->changes_ahead = 0;
+    counters->room_emits_suppressed = 0;
     counters->largest_result_size = 0;
     counters->queries_from_cache = 0;
     ti_counters_zero_garbage_collected();
@@ -48,6 +54,7 @@ void ti_counters_reset(void)
     counters->longest_change_duration = 0.0;
     counters->total_query_duration = 0.0;
     counters->total_change_duration = 0.0;
+    __atomic_store(&counters->largest_gc_pause, &zero, __ATOMIC_SEQ_CST);
 }
 
 /*
@@ -96,10 +103,20 @@ double ti_counters_upd_success_query(struct timespec * start)
     return duration;
 }
 
+/*
+ * Update the largest garbage collector pause. Only one garbage collection
+ * runs at a time, but the counters might be read by another thread.
+ */
+void ti_counters_upd_gc_pause(double pause)
+{
+    if (pause > ti_counters_largest_gc_pause())
+        __atomic_store(&counters->largest_gc_pause, &pause, __ATOMIC_SEQ_CST);
+}
+
 int ti_counters_to_pk(msgpack_packer * pk)
 {
     return -(
-        msgpack_pack_map(pk, 20) ||
+        msgpack_pack_map(pk, 26) ||
 
         mp_pack_str(pk, "queries_success") ||
         msgpack_pack_uint64(pk, counters->queries_success) ||
@@ -131,6 +148,18 @@ int ti_counters_to_pk(msgpack_packer * pk)
         mp_pack_str(pk, "changes_unaligned") ||
         msgpack_pack_uint64(pk, counters->changes_unaligned) ||
 
+        mp_pack_str(pk, "changes_ahead") ||
+        msgpack_pack_uint64(pk, counters->changes_ahead) ||
+
+        mp_pack_str(pk, "change_id_batches") ||
+        msgpack_pack_uint64(pk, counters->change_id_batches) ||
+
+        mp_pack_str(pk, "change_id_batched") ||
+        msgpack_pack_uint64(pk, counters->change_id_batched) ||
+
+        mp_pack_str(pk, "largest_change_id_batch") ||
+        msgpack_pack_uint64(pk, counters->largest_change_id_batch) ||
+
         mp_pack_str(pk, "garbage_collected") ||
         msgpack_pack_uint64(pk, ti_counters_garbage_collected()) ||
 
@@ -140,6 +169,9 @@ int ti_counters_to_pk(msgpack_packer * pk)
         mp_pack_str(pk, "queries_from_cache") ||
         msgpack_pack_uint64(pk, counters->queries_from_cache) ||
 
+        mp_pack_str(pk, "room_emits_suppressed") ||
+        msgpack_pack_uint64(pk, counters->room_emits_suppressed) ||
+
         mp_pack_str(pk, "wasted_cache") ||
         msgpack_pack_uint64(pk, ti_counters_wasted_cache()) ||
 
@@ -151,6 +183,9 @@ int ti_counters_to_pk(msgpack_packer * pk)
             ? counters->total_query_duration / counters->queries_success
             : 0.0) ||
 
+        mp_pack_str(pk, "largest_gc_pause") ||
+        msgpack_pack_double(pk, ti_counters_largest_gc_pause()) ||
+
         mp_pack_str(pk, "longest_change_duration") ||
         msgpack_pack_double(pk, counters->longest_change_duration) ||
 
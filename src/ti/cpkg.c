@@ -181,3 +181,30 @@ ti_cpkg_t * ti_cpkg_from_pkg(ti_pkg_t * pkg)
 
     return cpkg;
 }
+
+/*
+ * Returns 0 if the change package contains a dependency, or -1 if not.
+ *
+ * A change to a collection may contain the id of the last change it depends
+ * on, which is the last change for the same collection or the last change
+ * with an unknown or global scope. The format is then:
+ *
+ *   [change_id, scope_id, dep_id, tasks...]
+ */
+int ti_cpkg_dep(ti_cpkg_t * cpkg, uint64_t * scope_id, uint64_t * dep_id)
+{
+    mp_unp_t up;
+    mp_obj_t obj, mp_scope, mp_dep;
+
+    mp_unp_init(&up, cpkg->pkg->data, cpkg->pkg->n);
+
+    if (mp_next(&up, &obj) != MP_ARR || obj.via.sz < 4 ||
+        mp_skip(&up) != MP_U64 ||
+        mp_next(&up, &mp_scope) != MP_U64 ||
+        mp_next(&up, &mp_dep) != MP_U64)
+        return -1;
+
+    *scope_id = mp_scope.via.u64;
+    *dep_id = mp_dep.via.u64;
+    return 0;
+}
@@ -2087,6 +2087,60 @@ static int ctask__mod_type_hid(ti_thing_t * thing, mp_unp_t * up)
     return 0;
 }
 
+static int ctask__mod_type_idx(ti_thing_t * thing, mp_unp_t * up)
+{
+    ti_collection_t * collection = thing->collection;
+    ti_type_t * type;
+    ti_name_t * name;
+    ti_field_t * field;
+    mp_obj_t obj, mp_id, mp_modified, mp_name, mp_idx;
+
+    if (mp_next(up, &obj) != MP_MAP || obj.via.sz != 4 ||
+        mp_skip(up) != MP_STR ||
+        mp_next(up, &mp_id) != MP_U64 ||
+        mp_skip(up) != MP_STR ||
+        mp_next(up, &mp_modified) != MP_U64 ||
+        mp_skip(up) != MP_STR ||
+        mp_next(up, &mp_name) != MP_STR ||
+        mp_skip(up) != MP_STR ||
+        mp_next(up, &mp_idx) != MP_BOOL)
+    {
+        log_critical(
+                "task `mod_type_idx` for "TI_COLLECTION_ID" is invalid",
+                collection->id);
+        return -1;
+    }
+
+    type = ti_types_by_id(collection->types, mp_id.via.u64);
+    if (!type)
+    {
+        log_critical(
+                "task `mod_type_idx` for "TI_COLLECTION_ID" is invalid; "
+                "type with id %"PRIu64" not found",
+                collection->id, mp_id.via.u64);
+        return -1;
+    }
+
+    name = ti_names_weak_get_strn(mp_name.via.str.data, mp_name.via.str.n);
+    field = name ? ti_field_by_name(type, name) : NULL;
+    if (!field || !ti_field_is_indexable(field))
+    {
+        log_critical(
+                "task `mod_type_idx` for "TI_COLLECTION_ID" is invalid; "
+                "type `%s` has no property `%.*s` which can be indexed",
+                collection->id, type->name,
+                mp_name.via.str.n, mp_name.via.str.data);
+        return -1;
+    }
+
+    field->is_indexed = mp_idx.via.bool_;
+    if (!field->is_indexed)
+        ti_field_index_destroy(field);
+
+    type->modified_at = mp_modified.via.u64;
+
+    return 0;
+}
 
 /*
  * Returns 0 on success
@@ -2368,7 +2422,7 @@ static int ctask__vtask_new(ti_thing_t * thing, mp_unp_t * up)
         goto fail0;
 
     ti_collection_update_next_free_id(collection, vtask->id);
-    (void) ti_tasks_append(&collection->vtasks, vtask);
+    (void) ti_tasks_append(&collection->vtasks, vtask, collection);
     free(varr);
     ti_decref(closure);
     return 0;
@@ -2476,7 +2530,7 @@ static int ctask__vtask_finish(ti_thing_t * thing, mp_unp_t * up)
         goto fail0;
 
     vtask->run_at = mp_run_at.via.u64;
-    ti_tasks_vtask_finish(vtask);
+    ti_tasks_vtask_finish(vtask, collection);
 
     ti_val_drop((ti_val_t *) vtask->verr);
     vtask->verr = (ti_verror_t *) val;
@@ -3286,6 +3340,7 @@ int ti_ctask_run(ti_thing_t * thing, mp_unp_t * up)
     case TI_TASK_SET_ENUM_DATA:     return ctask__set_enum_data(thing, up);
     case TI_TASK_REPLACE_ROOT:      return ctask__replace_root(thing, up);
     case TI_TASK_IMPORT:            return ctask__import(thing, up);
+    case TI_TASK_MOD_TYPE_IDX:      return ctask__mod_type_idx(thing, up);
     }
 
     log_critical("unknown collection task: %"PRIu64, mp_task.via.u64);
@@ -102,17 +102,16 @@ ti_datetime_t * ti_datetime_copy(ti_datetime_t * dt)
 int ti_datetime_time(ti_datetime_t * dt, struct tm * tm)
 {
     if (dt->tz)
-    {
-        ti_tz_set(dt->tz);
-        tzset();
-        return -(localtime_r(&dt->ts, tm) != tm);
-    }
+        return ti_tz_localtime(dt->tz, dt->ts, tm);
 
     if (dt->offset)
     {
-        ti_tz_set_offset(dt->offset);
-        tzset();
-        return -(localtime_r(&dt->ts, tm) != tm);
+        time_t ts = dt->ts + dt->offset * 60;
+        if (gmtime_r(&ts, tm) != tm)
+            return -1;
+        tm->tm_gmtoff = dt->offset * 60;
+        tm->tm_zone = "UTC";
+        return 0;
     }
 
     return -(gmtime_r(&dt->ts, tm) != tm);
@@ -213,15 +212,13 @@ static ti_datetime_t * datetime__from_strn(
     switch (fmt[n-1])
     {
     case 'Z':
-        ti_tz_set_utc();
-        ts = mktime(&tm);
+        ts = timegm(&tm);
         offset = 0;
         tz = ti_tz_utc();
         break;
     case 'z':
         {
-            ti_tz_set_utc();
-            ts = mktime(&tm);
+            ts = timegm(&tm);
             n = str->n;
             while (n--)
                 if (buf[n] == '+' || buf[n] == '-')
@@ -240,8 +237,7 @@ static ti_datetime_t * datetime__from_strn(
         }
         break;
     default:
-        ti_tz_set(tz);
-        ts = mktime(&tm);
+        ts = ti_tz_mktime(tz, &tm);
         offset = tm.tm_gmtoff / 60;
     }
 
@@ -507,16 +503,14 @@ ti_datetime_t * ti_datetime_from_tm_tz(struct tm * tm, ti_tz_t * tz, ex_t * e)
     if (tz)
     {
         /* get offset after calculating time stamp */
-        ti_tz_set(tz);
-        ts = mktime(tm);
+        ts = ti_tz_mktime(tz, tm);
         offset = tm->tm_gmtoff / 60;
     }
     else
     {
         /* get offset before calculating time stamp */
         offset = tm->tm_gmtoff;
-        ti_tz_set_utc();
-        ts = mktime(tm) - offset;
+        ts = timegm(tm) - offset;
         offset /= 60;
     }
 
@@ -570,8 +564,7 @@ ti_datetime_t * ti_datetime_from_tm_tzinfo(
         if (e->nr)
             return NULL;
 
-        ti_tz_set_utc();
-        ts = mktime(tm) - offset;
+        ts = timegm(tm) - offset;
         offset /= 60;
         tz = NULL;
     }
@@ -584,8 +577,7 @@ ti_datetime_t * ti_datetime_from_tm_tzinfo(
             return NULL;
         }
 
-        ti_tz_set(tz);
-        ts = mktime(tm);
+        ts = ti_tz_mktime(tz, tm);
         offset = tm->tm_gmtoff / 60;
     }
 
@@ -671,7 +663,13 @@ int ti_datetime_move(
          */
         tm.tm_isdst = -1;
 
-        dt->ts = mktime(&tm);
+        if (dt->tz)
+            dt->ts = ti_tz_mktime(dt->tz, &tm);
+        else
+        {
+            long int offset = tm.tm_gmtoff;
+            dt->ts = timegm(&tm) - offset;
+        }
         return 0;
     }
     else
@@ -210,7 +210,12 @@ static inline int do__t_upd_prop(
                 thing->items.vec,
                 field->idx);
 
-        return ti_opr_a_to_b(*wprop->val, tokens_nd, &query->rval, e);
+        if (ti_opr_a_to_b(*wprop->val, tokens_nd, &query->rval, e))
+            return e->nr;
+
+        /* the value will be replaced by the caller */
+        ti_field_index_replace(field, thing, *wprop->val, query->rval);
+        return 0;
     }
 
     ex_set(e, EX_LOOKUP_ERROR,
@@ -1585,21 +1590,15 @@ static inline int do__var(ti_query_t * query, cleri_node_t * nd, ex_t * e)
 
 static inline ti_prop_t * do__prop_scope(ti_query_t * query, ti_name_t * name)
 {
-    register uint32_t n = query->vars->n;
-    register uint32_t end = query->local_stack;
-
     /*
-     * End is the position in the variable stack where this body has
-     * started, therefore we start at the end and then look back until
-     * the "end" position in the stack.
+     * The local stack is the position in the variable stack where this body
+     * has started. The last variable with this name must be at or above this
+     * position to be in scope.
      */
-    while (n-- > end)
-    {
-        ti_prop_t * prop = VEC_get(query->vars, n);
-        if (prop->name == name)
-            return prop;
-    }
-    return NULL;
+    int64_t idx = ti_query_var_idx(query, name);
+    return idx < (int64_t) query->local_stack
+            ? NULL
+            : VEC_get(query->vars, idx);
 }
 
 static inline ti_name_t * do__ensure_name_cache(
@@ -1736,12 +1735,13 @@ static int do__var_assign(ti_query_t * query, cleri_node_t * nd, ex_t * e)
     if (vec_push(&query->vars, prop))
         goto alloc_err_with_prop;
 
+    ti_query_var_pushed(query);
     ti_incref(query->rval);
     return e->nr;
 
 alloc_err_with_prop:
     /* prop->name will be dropped and prop->val is still on query->rval */
-    free(prop);
+    ti_prop_free(prop);
 
 alloc_err:
     ex_set_mem(e);
@@ -1781,9 +1781,10 @@ int ti_do_prepare_for_loop(ti_query_t * query, cleri_node_t * vars_nd)
             prop = ti_prop_create(name, (ti_val_t *) nil);
             if (!prop || vec_push(&query->vars, prop))
             {
-                free(prop);
+                ti_prop_free(prop);
                 goto failed;
             }
+            ti_query_var_pushed(query);
             ti_incref(name);
         }
 
@@ -1831,6 +1832,130 @@ static inline int do__template(ti_query_t * query, cleri_node_t * nd, ex_t * e)
     return ti_template_compile(nd->data, query, e);
 }
 
+static inline int do__t_float(ti_query_t * query, cleri_node_t * nd, ex_t * e)
+{
+    if (!nd->data)
+    {
+        nd->data = ti_vfloat_create(strx_to_double(nd->str, NULL));
+        if (!nd->data)
+        {
+            ex_set_mem(e);
+            return e->nr;
+        }
+        assert(vec_space(query->immutable_cache));
+        VEC_push(query->immutable_cache, nd->data);
+    }
+    query->rval = nd->data;
+    ti_incref(query->rval);
+    return 0;
+}
+
+static inline int do__t_int(ti_query_t * query, cleri_node_t * nd, ex_t * e)
+{
+    if (!nd->data)
+    {
+        int64_t i = strx_to_int64(nd->str, NULL);
+        if (errno == ERANGE)
+        {
+            ex_set(e, EX_OVERFLOW, "integer overflow");
+            return e->nr;
+        }
+        nd->data = ti_vint_create(i);
+        if (!nd->data)
+        {
+            ex_set_mem(e);
+            return e->nr;
+        }
+        assert(vec_space(query->immutable_cache));
+        VEC_push(query->immutable_cache, nd->data);
+    }
+    query->rval = nd->data;
+    ti_incref(query->rval);
+    return 0;
+}
+
+static inline int do__t_regex(ti_query_t * query, cleri_node_t * nd, ex_t * e)
+{
+    if (!nd->data)
+    {
+        nd->data = ti_regex_from_strn(nd->str, nd->len, e);
+        if (!nd->data)
+            return e->nr;
+        assert(vec_space(query->immutable_cache));
+        VEC_push(query->immutable_cache, nd->data);
+    }
+    query->rval = nd->data;
+    ti_incref(query->rval);
+    return 0;
+}
+
+static inline int do__t_string(ti_query_t * query, cleri_node_t * nd, ex_t * e)
+{
+    if (!nd->data)
+    {
+        nd->data = ti_str_from_ti_string(nd->str, nd->len);
+        if (!nd->data)
+        {
+            ex_set_mem(e);
+            return e->nr;
+        }
+        assert(vec_space(query->immutable_cache));
+        VEC_push(query->immutable_cache, nd->data);
+    }
+    query->rval = nd->data;
+    ti_incref(query->rval);
+    return 0;
+}
+
+/*
+ * The functions below are bound by `ti_qbind_probe(..)` in place of
+ * ti_do_expression(..) for an expression without a pre-operator, index and
+ * chain. They skip the generic expression handling and directly run the
+ * only part of the expression.
+ */
+int ti_do_expr_false(ti_query_t * query, cleri_node_t * UNUSED(nd), ex_t * e)
+{
+    query->rval = (ti_val_t *) ti_vbool_get(false);
+    return e->nr;
+}
+
+int ti_do_expr_true(ti_query_t * query, cleri_node_t * UNUSED(nd), ex_t * e)
+{
+    query->rval = (ti_val_t *) ti_vbool_get(true);
+    return e->nr;
+}
+
+int ti_do_expr_nil(ti_query_t * query, cleri_node_t * UNUSED(nd), ex_t * e)
+{
+    query->rval = (ti_val_t *) ti_nil_get();
+    return e->nr;
+}
+
+int ti_do_expr_float(ti_query_t * query, cleri_node_t * nd, ex_t * e)
+{
+    return do__t_float(query, nd->children->next, e);
+}
+
+int ti_do_expr_int(ti_query_t * query, cleri_node_t * nd, ex_t * e)
+{
+    return do__t_int(query, nd->children->next, e);
+}
+
+int ti_do_expr_string(ti_query_t * query, cleri_node_t * nd, ex_t * e)
+{
+    return do__t_string(query, nd->children->next, e);
+}
+
+int ti_do_expr_var(ti_query_t * query, cleri_node_t * nd, ex_t * e)
+{
+    return do__var(query, nd->children->next->children, e);
+}
+
+int ti_do_expr_function(ti_query_t * query, cleri_node_t * nd, ex_t * e)
+{
+    return do__function(query, nd->children->next, e);
+}
+
 int ti_do_expression(ti_query_t * query, cleri_node_t * nd, ex_t * e)
 {
     int preopr = (int) ((intptr_t) nd->children->data);
@@ -1865,70 +1990,23 @@ int ti_do_expression(ti_query_t * query, cleri_node_t * nd, ex_t * e)
         query->rval = (ti_val_t *) ti_vbool_get(false);
         break;
     case CLERI_GID_T_FLOAT:
-        if (!nd->data)
-        {
-            nd->data = ti_vfloat_create(strx_to_double(nd->str, NULL));
-            if (!nd->data)
-            {
-                ex_set_mem(e);
-                return e->nr;
-            }
-            assert(vec_space(query->immutable_cache));
-            VEC_push(query->immutable_cache, nd->data);
-        }
-        query->rval = nd->data;
-        ti_incref(query->rval);
+        if (do__t_float(query, nd, e))
+            return e->nr;
         break;
     case CLERI_GID_T_INT:
-        if (!nd->data)
-        {
-            int64_t i = strx_to_int64(nd->str, NULL);
-            if (errno == ERANGE)
-            {
-                ex_set(e, EX_OVERFLOW, "integer overflow");
-                return e->nr;
-            }
-            nd->data = ti_vint_create(i);
-            if (!nd->data)
-            {
-                ex_set_mem(e);
-                return e->nr;
-            }
-            assert(vec_space(query->immutable_cache));
-            VEC_push(query->immutable_cache, nd->data);
-        }
-        query->rval = nd->data;
-        ti_incref(query->rval);
+        if (do__t_int(query, nd, e))
+            return e->nr;
         break;
     case CLERI_GID_T_NIL:
         query->rval = (ti_val_t *) ti_nil_get();
         break;
     case CLERI_GID_T_REGEX:
-        if (!nd->data)
-        {
-            nd->data = ti_regex_from_strn(nd->str, nd->len, e);
-            if (!nd->data)
-                return e->nr;
-            assert(vec_space(query->immutable_cache));
-            VEC_push(query->immutable_cache, nd->data);
-        }
-        query->rval = nd->data;
-        ti_incref(query->rval);
+        if (do__t_regex(query, nd, e))
+            return e->nr;
         break;
     case CLERI_GID_T_STRING:
-        if (!nd->data)
-        {
-            nd->data = ti_str_from_ti_string(nd->str, nd->len);
-            if (!nd->data)
-            {
-                ex_set_mem(e);
-                return e->nr;
-            }
-            assert(vec_space(query->immutable_cache));
-            VEC_push(query->immutable_cache, nd->data);
-        }
-        query->rval = nd->data;
-        ti_incref(query->rval);
+        if (do__t_string(query, nd, e))
+            return e->nr;
         break;
     case CLERI_GID_T_TRUE:
         query->rval = (ti_val_t *) ti_vbool_get(true);
@@ -127,6 +127,12 @@ void ti_evars_cfg_parse(void)
     evars__bool(
             "THINGSDB_WAIT_FOR_MODULES",
             &ti.cfg->wait_for_modules);
+    evars__bool(
+            "THINGSDB_CHANGE_PIPELINES",
+            &ti.cfg->change_pipelines);
+    evars__bool(
+            "THINGSDB_LAZY_LOAD",
+            &ti.cfg->lazy_load);
     evars__str(
             "THINGSDB_PYTHON_INTERPRETER",
             &ti.cfg->python_interpreter);
@@ -160,6 +166,18 @@ void ti_evars_cfg_parse(void)
     evars__u8(
             "THINGSDB_SHUTDOWN_PERIOD",
             &ti.cfg->shutdown_period);
+    evars__u8(
+            "THINGSDB_STORE_THREADS",
+            &ti.cfg->store_threads);
+    evars__u8(
+            "THINGSDB_QUERY_THREADS",
+            &ti.cfg->query_threads);
+    evars__u8(
+            "THINGSDB_STORE_COMPRESSION",
+            &ti.cfg->store_compression);
+    evars__u8(
+            "THINGSDB_CHANGE_ID_BATCH",
+            &ti.cfg->change_id_batch);
     evars__abs_double(
             "THINGSDB_QUERY_DURATION_WARN",
             &ti.cfg->query_duration_warn);
@@ -5,10 +5,12 @@
 #include <doc.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 #include <ti.h>
 #include <ti/closure.h>
 #include <ti/condition.h>
 #include <ti/data.h>
+#include <ti/datetime.h>
 #include <ti/enum.h>
 #include <ti/enum.inline.h>
 #include <ti/enums.inline.h>
@@ -822,6 +824,8 @@ ti_field_t * ti_field_create(
     field->spec_raw = spec_raw;
     field->idx = type->fields->n;
     field->condition.none = NULL;
+    field->is_indexed = false;
+    field->index = NULL;
 
     ti_incref(name);
     ti_incref(spec_raw);
@@ -833,10 +837,13 @@ ti_field_t * ti_field_create(
         return NULL;
     }
 
+    ti_type_lookup_clear(type);
+
     if (field__init(field, e))
     {
         assert(e->nr);        ;
         ti_field_destroy(vec_pop(type->fields));
+        ti_type_lookup_clear(type);
         return NULL;
     }
 
@@ -868,6 +875,8 @@ ti_field_t * ti_field_as_new(ti_field_t * field, ti_raw_t * spec_raw, ex_t * e)
     new_field->type = field->type;
     new_field->idx = field->idx;
     new_field->condition.none = NULL;
+    new_field->is_indexed = field->is_indexed;
+    new_field->index = NULL;
 
     ti_incref(new_field->name);
     ti_incref(new_field->spec_raw);
@@ -901,6 +910,9 @@ void ti_field_replace(ti_field_t * field, ti_field_t ** with_field)
     field->dval_cb = (*with_field)->dval_cb;
     field->flags = (*with_field)->flags;
 
+    ti_field_index_destroy(field);
+    field->is_indexed = field->is_indexed && ti_field_is_indexable(field);
+
     (*with_field)->condition.none = NULL;
 
     ti_incref(field->spec_raw);
@@ -919,6 +931,7 @@ int ti_field_mod_force(ti_field_t * field, ti_raw_t * spec_raw, ex_t * e)
     int prev_flags = field->flags;
 
     field__remove_dep(field);
+    ti_field_index_destroy(field);
 
     field->spec_raw = spec_raw;
 
@@ -928,6 +941,7 @@ int ti_field_mod_force(ti_field_t * field, ti_raw_t * spec_raw, ex_t * e)
     ti_incref(spec_raw);
     ti_val_unsafe_drop((ti_val_t *) prev_spec_raw);
     ti_condition_destroy(prev_condition, prev_spec);
+    field->is_indexed = field->is_indexed && ti_field_is_indexable(field);
     return 0;
 
 undo:
@@ -955,6 +969,7 @@ int ti_field_mod(
     int prev_flags = field->flags;
 
     field__remove_dep(field);
+    ti_field_index_destroy(field);
 
     field->spec_raw = spec_raw;
     if (field__init(field, e))
@@ -1027,6 +1042,7 @@ done:
     ti_incref(spec_raw);
     ti_val_unsafe_drop((ti_val_t *) prev_spec_raw);
     ti_condition_destroy(prev_condition, prev_spec);
+    field->is_indexed = field->is_indexed && ti_field_is_indexable(field);
     return 0;
 }
 
@@ -1065,6 +1081,7 @@ int ti_field_set_name(
 
     ti_name_drop(field->name);
     field->name = name;
+    ti_type_lookup_clear(field->type);
 
     return 0;
 
@@ -1121,6 +1138,8 @@ void ti_field_remove(ti_field_t * field)
     if (swap)
         swap->idx = field->idx;
 
+    ti_type_lookup_clear(field->type);
+
     ti_field_destroy(field);
 }
 
@@ -1134,6 +1153,7 @@ void ti_field_destroy(ti_field_t * field)
     if (field->spec_raw)
         ti_val_unsafe_drop((ti_val_t *) field->spec_raw);
     ti_condition_destroy(field->condition, field->spec);
+    ti_field_index_destroy(field);
     free(field);
 }
 
@@ -2429,14 +2449,10 @@ int ti_field_init_things(ti_field_t * field, ti_val_t ** vaddr)
             .e = {0}
     };
 
-    rc = imap_walk(
-            field->type->types->collection->things,
+    rc = ti_type_walk_instances(
+            field->type,
             (imap_cb) field__add,
             &addjob);
-    rc = rc ? rc : ti_gc_walk(
-            field->type->types->collection->gc,
-            (queue_cb) field__add,
-            &addjob);
 
     return rc;
 }
@@ -2795,3 +2811,370 @@ int ti_field_relation_make(
             (imap_cb) field__rel_st_cb,
             &w);
 }
+
+/*
+ * Field indexes map an order preserving 64-bit key to a bucket with all the
+ * instances (by thing id) which have a value with this key. Integer, float
+ * and date/time values have a unique key; strings share a bucket when the
+ * first eight bytes are equal so the value itself must still be compared.
+ * Values which cannot be keyed (nil, NaN) are not indexed.
+ */
+#define FIELD__IDX_SIGN 0x8000000000000000ULL
+
+typedef enum
+{
+    FIELD__IDX_NONE,
+    FIELD__IDX_INT,
+    FIELD__IDX_FLOAT,
+    FIELD__IDX_STR,
+    FIELD__IDX_DATETIME,
+} field__idx_kind_t;
+
+typedef struct
+{
+    uint64_t key;
+    imap_t * things;
+} field__idx_bucket_t;
+
+typedef struct
+{
+    field__idx_kind_t kind;
+    ti_field_t * field;
+    ti_val_t * min;         /* may be NULL */
+    ti_val_t * max;         /* may be NULL */
+    uint64_t max_key;
+    vec_t * vec;
+} field__idx_find_t;
+
+static field__idx_kind_t field__idx_kind(uint16_t spec)
+{
+    switch ((ti_spec_enum_t) (spec & TI_SPEC_MASK_NILLABLE))
+    {
+    case TI_SPEC_INT:
+    case TI_SPEC_UINT:
+    case TI_SPEC_PINT:
+    case TI_SPEC_NINT:
+    case TI_SPEC_INT_RANGE:
+        return FIELD__IDX_INT;
+    case TI_SPEC_FLOAT:
+    case TI_SPEC_FLOAT_RANGE:
+        return FIELD__IDX_FLOAT;
+    case TI_SPEC_STR:
+    case TI_SPEC_UTF8:
+    case TI_SPEC_EMAIL:
+    case TI_SPEC_URL:
+    case TI_SPEC_TEL:
+    case TI_SPEC_REMATCH:
+    case TI_SPEC_STR_RANGE:
+    case TI_SPEC_UTF8_RANGE:
+        return FIELD__IDX_STR;
+    case TI_SPEC_DATETIME:
+    case TI_SPEC_TIMEVAL:
+        return FIELD__IDX_DATETIME;
+    default:
+        return FIELD__IDX_NONE;
+    }
+}
+
+static inline double field__idx_double(ti_val_t * val)
+{
+    return ti_val_is_int(val) ? (double) VINT(val) : VFLOAT(val);
+}
+
+/*
+ * Returns `false` if the value cannot be used with the index.
+ */
+static _Bool field__idx_key(
+        field__idx_kind_t kind,
+        ti_val_t * val,
+        uint64_t * key)
+{
+    switch (kind)
+    {
+    case FIELD__IDX_NONE:
+        return false;
+    case FIELD__IDX_INT:
+        if (!ti_val_is_int(val))
+            return false;
+        *key = (uint64_t) VINT(val) ^ FIELD__IDX_SIGN;
+        return true;
+    case FIELD__IDX_FLOAT:
+    {
+        uint64_t u;
+        double d;
+
+        if (!ti_val_is_float(val) && !ti_val_is_int(val))
+            return false;
+
+        d = field__idx_double(val);
+        if (isnan(d))
+            return false;
+        if (d == 0.0)
+            d = 0.0;  /* -0.0 and 0.0 must share a key */
+
+        memcpy(&u, &d, sizeof(uint64_t));
+        *key = (u & FIELD__IDX_SIGN) ? ~u : u | FIELD__IDX_SIGN;
+        return true;
+    }
+    case FIELD__IDX_STR:
+    {
+        ti_raw_t * raw = (ti_raw_t *) val;
+        uint64_t u = 0;
+        uint32_t i;
+
+        if (!ti_val_is_str(val))
+            return false;
+
+        for (i = 0; i < sizeof(uint64_t); ++i)
+            u = (u << 8) | (i < raw->n ? raw->data[i] : 0);
+        *key = u;
+        return true;
+    }
+    case FIELD__IDX_DATETIME:
+        if (!ti_val_is_datetime(val))
+            return false;
+        *key = (uint64_t) (int64_t) DATETIME(val) ^ FIELD__IDX_SIGN;
+        return true;
+    }
+    return false;
+}
+
+/*
+ * Both values must be accepted by field__idx_key() for the given kind.
+ */
+static int field__idx_cmp(field__idx_kind_t kind, ti_val_t * a, ti_val_t * b)
+{
+    switch (kind)
+    {
+    case FIELD__IDX_NONE:
+        break;
+    case FIELD__IDX_INT:
+        return (VINT(a) > VINT(b)) - (VINT(a) < VINT(b));
+    case FIELD__IDX_FLOAT:
+    {
+        double da = field__idx_double(a), db = field__idx_double(b);
+        return (da > db) - (da < db);
+    }
+    case FIELD__IDX_STR:
+        return ti_raw_cmp((ti_raw_t *) a, (ti_raw_t *) b);
+    case FIELD__IDX_DATETIME:
+        return (DATETIME(a) > DATETIME(b)) - (DATETIME(a) < DATETIME(b));
+    }
+    return 0;
+}
+
+static void field__idx_bucket_destroy(field__idx_bucket_t * bucket)
+{
+    imap_destroy(bucket->things, NULL);
+    free(bucket);
+}
+
+static int field__idx_add(
+        ti_field_t * field,
+        ti_thing_t * thing,
+        ti_val_t * val)
+{
+    field__idx_bucket_t * bucket;
+    uint64_t key;
+
+    if (!field__idx_key(field__idx_kind(field->spec), val, &key))
+        return 0;
+
+    bucket = imap_get(field->index, key);
+    if (!bucket)
+    {
+        bucket = malloc(sizeof(field__idx_bucket_t));
+        if (!bucket)
+            return -1;
+
+        bucket->key = key;
+        bucket->things = imap_create();
+
+        if (!bucket->things || imap_add(field->index, key, bucket))
+        {
+            field__idx_bucket_destroy(bucket);
+            return -1;
+        }
+    }
+    return imap_add(bucket->things, thing->id, thing) == IMAP_ERR_ALLOC;
+}
+
+static int field__idx_add_cb(ti_thing_t * thing, ti_field_t * field)
+{
+    return thing->type_id == field->type->type_id ? field__idx_add(
+            field,
+            thing,
+            VEC_get(thing->items.vec, field->idx)) : 0;
+}
+
+_Bool ti_field_is_indexable(ti_field_t * field)
+{
+    return field__idx_kind(field->spec) != FIELD__IDX_NONE;
+}
+
+/*
+ * Returns `true` if the value may be used to search the index of the field.
+ */
+_Bool ti_field_index_accepts(ti_field_t * field, ti_val_t * val)
+{
+    uint64_t key;
+    return field__idx_key(field__idx_kind(field->spec), val, &key);
+}
+
+/*
+ * Creates the index for a field with an index declaration. The index is
+ * build from the instances of the type and will be kept up-to-date from then
+ * on, until the field or the type is changed.
+ */
+int ti_field_index_create(ti_field_t * field)
+{
+    assert(field->is_indexed);
+
+    if (field->index)
+        return 0;
+
+    field->index = imap_create();
+    if (!field->index)
+        return -1;
+
+    if (ti_type_walk_instances(
+            field->type,
+            (imap_cb) field__idx_add_cb,
+            field))
+    {
+        ti_field_index_destroy(field);
+        return -1;
+    }
+
+    field->type->flags |= TI_TYPE_FLAG_INDEXED;
+    return 0;
+}
+
+/*
+ * Removes the index (if in use); the declaration is kept so the index will
+ * be created again on next use.
+ */
+void ti_field_index_destroy(ti_field_t * field)
+{
+    imap_destroy(field->index, (imap_destroy_cb) field__idx_bucket_destroy);
+    field->index = NULL;
+}
+
+/*
+ * Adds a thing with the given value to the index. The index must be in use
+ * and the thing must have an id. When out of memory, the index is removed
+ * and will be re-created on next use.
+ */
+void ti_field_index_add(
+        ti_field_t * field,
+        ti_thing_t * thing,
+        ti_val_t * val)
+{
+    if (field__idx_add(field, thing, val))
+        ti_field_index_destroy(field);
+}
+
+void ti_field_index_del(
+        ti_field_t * field,
+        ti_thing_t * thing,
+        ti_val_t * val)
+{
+    field__idx_bucket_t * bucket;
+    uint64_t key;
+
+    if (!field__idx_key(field__idx_kind(field->spec), val, &key))
+        return;
+
+    bucket = imap_get(field->index, key);
+    if (bucket && imap_pop(bucket->things, thing->id) && !bucket->things->n)
+        field__idx_bucket_destroy(imap_pop(field->index, key));
+}
+
+static int field__idx_find_cb(ti_thing_t * thing, field__idx_find_t * w)
+{
+    ti_val_t * val;
+    uint64_t key;
+
+    if (thing->type_id != w->field->type->type_id)
+        return 0;
+
+    val = VEC_get(thing->items.vec, w->field->idx);
+
+    /* skip things marked for garbage collection */
+    return (
+        !field__idx_key(w->kind, val, &key) ||
+        (w->min && field__idx_cmp(w->kind, val, w->min) < 0) ||
+        (w->max && field__idx_cmp(w->kind, val, w->max) > 0) ||
+        imap_get(thing->collection->things, thing->id) != thing
+    ) ? 0 : vec_push(&w->vec, thing);
+}
+
+static int field__idx_bucket_cb(
+        field__idx_bucket_t * bucket,
+        field__idx_find_t * w)
+{
+    return (w->max && bucket->key > w->max_key)
+            ? 1  /* stop */
+            : imap_walk(bucket->things, (imap_cb) field__idx_find_cb, w);
+}
+
+static int field__idx_id_cmp(ti_thing_t ** a, ti_thing_t ** b)
+{
+    return ((*a)->id > (*b)->id) - ((*a)->id < (*b)->id);
+}
+
+/*
+ * Returns a vector with all instances of the type of the field with a value
+ * between `min` and `max` (inclusive), ordered by thing id. Both `min` and
+ * `max` are optional and must be accepted by ti_field_index_accepts().
+ * Things in the vector have no extra reference and things marked for
+ * garbage collection are excluded. If the index is not declared or cannot be
+ * created, all the instances are scanned instead.
+ *
+ * Returns NULL if failed to allocate memory.
+ */
+vec_t * ti_field_index_find(
+        ti_field_t * field,
+        ti_val_t * min,
+        ti_val_t * max)
+{
+    uint64_t min_key = 0;
+    field__idx_find_t w = {
+            .kind = field__idx_kind(field->spec),
+            .field = field,
+            .min = min,
+            .max = max,
+            .max_key = 0,
+            .vec = vec_new(0),
+    };
+
+    if (!w.vec)
+        return NULL;
+
+    if (min)
+        (void) field__idx_key(w.kind, min, &min_key);
+    if (max)
+        (void) field__idx_key(w.kind, max, &w.max_key);
+
+    if (field->is_indexed && ti_field_index_create(field) == 0)
+    {
+        if (imap_walk_from(
+                field->index,
+                min_key,
+                (imap_cb) field__idx_bucket_cb,
+                &w) < 0)
+            goto fail;
+    }
+    else if (ti_type_walk_instances(
+            field->type,
+            (imap_cb) field__idx_find_cb,
+            &w))
+        goto fail;
+
+    vec_sort(w.vec, (vec_sort_cb) field__idx_id_cmp);
+    return w.vec;
+
+fail:
+    free(w.vec);
+    return NULL;
+}
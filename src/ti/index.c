@@ -511,7 +511,12 @@ static inline int index__t_upd_prop(
         wprop->name = field->name;
         wprop->val = (ti_val_t **) vec_get_addr(thing->items.vec, field->idx);
 
-        return ti_opr_a_to_b(*wprop->val, tokens_nd, &query->rval, e);
+        if (ti_opr_a_to_b(*wprop->val, tokens_nd, &query->rval, e))
+            return e->nr;
+
+        /* the value will be replaced by the caller */
+        ti_field_index_replace(field, thing, *wprop->val, query->rval);
+        return 0;
     }
 
     ti_thing_t_set_not_found(thing, name, rname, e);
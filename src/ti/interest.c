@@ -0,0 +1,364 @@
+/*
+ * ti/interest.c
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <ti.h>
+#include <ti/collection.t.h>
+#include <ti/interest.h>
+#include <ti/node.h>
+#include <ti/proto.h>
+#include <ti/room.t.h>
+#include <ti/rpkg.h>
+#include <ti/stream.h>
+#include <ti/watch.t.h>
+#include <util/imap.h>
+#include <util/logger.h>
+#include <util/mpack.h>
+#include <util/vec.h>
+
+/*
+ * Number of bits set for each room; with thousands of rooms on a node the
+ * number of false positives stays just a few percent.
+ */
+#define INTEREST__K 3
+#define INTEREST__MASK (TI_INTEREST_BITS-1)
+#define INTEREST__SHIFT 14
+
+static uint8_t interest__bits[TI_INTEREST_SZ];
+static uint32_t interest__version = 1;
+static _Bool interest__changed = false;
+
+static inline uint64_t interest__hash(
+        uint64_t collection_id,
+        uint64_t room_id)
+{
+    uint64_t x = room_id * 0x9e3779b97f4a7c15ULL ^ collection_id;
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+static inline _Bool interest__has(const uint8_t * bits, uint16_t pos)
+{
+    return bits[pos >> 3] & (1u << (pos & 7));
+}
+
+static inline void interest__set(uint8_t * bits, uint16_t pos)
+{
+    bits[pos >> 3] |= 1u << (pos & 7);
+}
+
+/*
+ * Older nodes do not know the room interest package and therefore only
+ * receive the filter when they have the room interest capability.
+ */
+static _Bool interest__status(ti_node_t * node)
+{
+    return node != ti.node &&
+        ti_node_has_cap(node, TI_NODE_CAP_ROOM_INTEREST) &&
+        (node->status & (
+            TI_NODE_STAT_READY |
+            TI_NODE_STAT_AWAY_SOON |
+            TI_NODE_STAT_AWAY |
+            TI_NODE_STAT_SYNCHRONIZING));
+}
+
+/*
+ * Package: [replace, bin] or [replace, [pos, ...]]
+ *
+ * When `replace` is `false`, the positions are added to the filter which is
+ * received before; otherwise the filter is replaced.
+ */
+static ti_rpkg_t * interest__rpkg(
+        _Bool replace,
+        const uint16_t * pos,
+        size_t n,
+        _Bool as_bin)
+{
+    msgpack_packer pk;
+    msgpack_sbuffer buffer;
+    ti_rpkg_t * rpkg;
+    ti_pkg_t * pkg;
+    size_t alloc = as_bin ? TI_INTEREST_SZ + 16 : n * 3 + 16;
+
+    if (mp_sbuffer_alloc_init(&buffer, alloc, sizeof(ti_pkg_t)))
+        return NULL;
+
+    msgpack_packer_init(&pk, &buffer, msgpack_sbuffer_write);
+
+    msgpack_pack_array(&pk, 2);
+    mp_pack_bool(&pk, replace);
+
+    if (as_bin)
+        mp_pack_bin(&pk, interest__bits, TI_INTEREST_SZ);
+    else
+    {
+        msgpack_pack_array(&pk, n);
+        while (n--)
+            msgpack_pack_uint16(&pk, *pos++);
+    }
+
+    pkg = (ti_pkg_t *) buffer.data;
+    pkg_init(pkg, 0, TI_PROTO_NODE_ROOM_INTEREST, buffer.size);
+
+    rpkg = ti_rpkg_create(pkg);
+    if (!rpkg)
+        free(pkg);
+    return rpkg;
+}
+
+static ti_rpkg_t * interest__full_rpkg(void)
+{
+    uint16_t * pos, * p;
+    size_t n = 0;
+    ti_rpkg_t * rpkg;
+
+    for (size_t i = 0; i < TI_INTEREST_SZ; ++i)
+        n += __builtin_popcount(interest__bits[i]);
+
+    /* each position takes at most 3 bytes when packed as an array */
+    if (n * 3 >= TI_INTEREST_SZ)
+        return interest__rpkg(true, NULL, 0, true);
+
+    p = pos = malloc(n * sizeof(uint16_t) + 1);
+    if (!pos)
+        return NULL;
+
+    for (uint32_t i = 0; i < TI_INTEREST_BITS; ++i)
+        if (interest__has(interest__bits, i))
+            *p++ = i;
+
+    rpkg = interest__rpkg(true, pos, n, false);
+    free(pos);
+    return rpkg;
+}
+
+static size_t interest__add(
+        uint8_t * bits,
+        uint64_t collection_id,
+        uint64_t room_id,
+        uint16_t * added)
+{
+    size_t n = 0;
+    uint64_t h = interest__hash(collection_id, room_id);
+
+    for (int k = 0; k < INTEREST__K; ++k, h >>= INTEREST__SHIFT)
+    {
+        uint16_t pos = h & INTEREST__MASK;
+        if (interest__has(bits, pos))
+            continue;
+        interest__set(bits, pos);
+        added[n++] = pos;
+    }
+    return n;
+}
+
+/*
+ * Must be called when a room gets a listener. New bits are written to the
+ * other nodes right away so emits for the room are no longer suppressed.
+ */
+void ti_interest_add(ti_room_t * room)
+{
+    uint16_t added[INTEREST__K];
+    size_t n;
+    ti_rpkg_t * rpkg;
+
+    if (!room->id || !room->collection)
+        return;
+
+    n = interest__add(interest__bits, room->collection->id, room->id, added);
+    if (!n)
+        return;
+
+    rpkg = interest__rpkg(false, added, n, false);
+    if (!rpkg)
+    {
+        log_critical(EX_MEMORY_S);
+        return;
+    }
+
+    for (vec_each(ti.nodes->vec, ti_node_t, node))
+    {
+        /* nodes without the full filter receive the bits later */
+        if (!interest__status(node) || !node->interest_version)
+            continue;
+
+        if (ti_stream_write_rpkg(node->stream, rpkg))
+        {
+            log_error(EX_INTERNAL_S);
+            node->interest_version = 0;
+        }
+    }
+
+    ti_rpkg_drop(rpkg);
+}
+
+/*
+ * Must be called when a room might have lost its last listener. The filter
+ * is re-created on the next update.
+ */
+void ti_interest_changed(void)
+{
+    interest__changed = true;
+}
+
+static int interest__rebuild_cb(ti_room_t * room, uint8_t * bits)
+{
+    uint16_t added[INTEREST__K];
+
+    for (vec_each(room->listeners, ti_watch_t, watch))
+    {
+        if (!ti_stream_is_closed(watch->stream))
+        {
+            (void) interest__add(bits, room->collection->id, room->id, added);
+            break;
+        }
+    }
+    return 0;
+}
+
+static void interest__rebuild(void)
+{
+    uint8_t bits[TI_INTEREST_SZ] = {0};
+
+    for (vec_each(ti.collections->vec, ti_collection_t, collection))
+    {
+        uv_mutex_lock(collection->lock);
+        (void) imap_walk(
+                collection->rooms,
+                (imap_cb) interest__rebuild_cb,
+                bits);
+        uv_mutex_unlock(collection->lock);
+    }
+
+    if (memcmp(bits, interest__bits, TI_INTEREST_SZ) == 0)
+        return;
+
+    memcpy(interest__bits, bits, TI_INTEREST_SZ);
+
+    /* version 0 is reserved for nodes which have not received a filter */
+    if (!++interest__version)
+        interest__version = 1;
+}
+
+/*
+ * Called from the connect loop; re-creates the filter when rooms might have
+ * lost listeners and writes the filter to nodes which do not have the
+ * latest version.
+ */
+void ti_interest_update(void)
+{
+    ti_rpkg_t * rpkg = NULL;
+
+    if (interest__changed)
+    {
+        interest__changed = false;
+        interest__rebuild();
+    }
+
+    for (vec_each(ti.nodes->vec, ti_node_t, node))
+    {
+        if (!interest__status(node) ||
+            node->interest_version == interest__version)
+            continue;
+
+        rpkg = rpkg ? rpkg : interest__full_rpkg();
+        if (!rpkg)
+        {
+            log_critical(EX_MEMORY_S);
+            return;
+        }
+
+        if (ti_stream_write_rpkg(node->stream, rpkg))
+            log_error(EX_INTERNAL_S);
+        else
+            node->interest_version = interest__version;
+    }
+
+    ti_rpkg_drop(rpkg);
+}
+
+void ti_interest_on_pkg(ti_node_t * node, ti_pkg_t * pkg)
+{
+    mp_unp_t up;
+    mp_obj_t obj, mp_replace, mp_pos;
+    uint8_t * bits = node->interest;
+
+    mp_unp_init(&up, pkg->data, pkg->n);
+
+    if (mp_next(&up, &obj) != MP_ARR || obj.via.sz != 2 ||
+        mp_next(&up, &mp_replace) != MP_BOOL)
+        goto invalid;
+
+    if (!mp_replace.via.bool_ && !bits)
+        return;  /* no filter, all emits are forwarded to this node */
+
+    if (!bits)
+    {
+        bits = malloc(TI_INTEREST_SZ);
+        if (!bits)
+        {
+            log_critical(EX_MEMORY_S);
+            return;
+        }
+        node->interest = bits;
+    }
+
+    switch (mp_next(&up, &obj))
+    {
+    case MP_BIN:
+        if (!mp_replace.via.bool_ || obj.via.bin.n != TI_INTEREST_SZ)
+            goto invalid;
+        memcpy(bits, obj.via.bin.data, TI_INTEREST_SZ);
+        return;
+    case MP_ARR:
+        if (mp_replace.via.bool_)
+            memset(bits, 0, TI_INTEREST_SZ);
+
+        for (size_t i = obj.via.sz; i--;)
+        {
+            if (mp_next(&up, &mp_pos) != MP_U64 ||
+                mp_pos.via.u64 >= TI_INTEREST_BITS)
+                goto invalid;
+            interest__set(bits, mp_pos.via.u64);
+        }
+        return;
+    default:
+        goto invalid;
+    }
+
+invalid:
+    log_error(
+            "invalid room interest from "TI_NODE_ID"; "
+            "forward all room emits to this node",
+            node->id);
+    free(node->interest);
+    node->interest = NULL;
+}
+
+/*
+ * Returns `true` if the node might have listeners for the given room, or if
+ * the interest of the node is unknown.
+ */
+_Bool ti_interest_test(
+        ti_node_t * node,
+        uint64_t collection_id,
+        uint64_t room_id)
+{
+    uint64_t h;
+
+    if (!node->interest)
+        return true;
+
+    h = interest__hash(collection_id, room_id);
+
+    for (int k = 0; k < INTEREST__K; ++k, h >>= INTEREST__SHIFT)
+        if (!interest__has(node->interest, h & INTEREST__MASK))
+            return false;
+
+    return true;
+}
@@ -152,6 +152,7 @@ int ti_method_set_name_t(
 
     ti_name_unsafe_drop(method->name);
     method->name = name;
+    ti_type_lookup_clear(type);
 
     return 0;
 
@@ -47,6 +47,9 @@ ti_node_t * ti_node_create(
     node->scid = 0;
     node->next_free_id = 0;
     node->stream = NULL;
+    node->interest = NULL;
+    node->interest_version = 0;
+    node->caps = 0;
     node->port = port;
     node->addr = strdup(addr);
     memcpy(node->secret, secret, CRYPTX_SZ);
@@ -70,6 +73,7 @@ void ti_node_drop(ti_node_t * node)
             node->stream->via.node = NULL;
             ti_stream_close(node->stream);
         }
+        free(node->interest);
         free(node->addr);
         free(node);
     }
@@ -420,6 +424,36 @@ int ti_node_status_from_unp(ti_node_t * node, mp_unp_t * up)
     return 0;
 }
 
+/*
+ * Writes the capabilities of this node to the given node; when `reply` is
+ * `true`, the node will respond with its own capabilities.
+ */
+int ti_node_write_caps(ti_node_t * node, _Bool reply)
+{
+    msgpack_packer pk;
+    msgpack_sbuffer buffer;
+    ti_pkg_t * pkg;
+
+    if (mp_sbuffer_alloc_init(&buffer, 16, sizeof(ti_pkg_t)))
+        return -1;
+
+    msgpack_packer_init(&pk, &buffer, msgpack_sbuffer_write);
+
+    msgpack_pack_array(&pk, 2);
+    msgpack_pack_uint8(&pk, TI_NODE_CAPS);
+    mp_pack_bool(&pk, reply);
+
+    pkg = (ti_pkg_t *) buffer.data;
+    pkg_init(pkg, 0, TI_PROTO_NODE_CAPS, buffer.size);
+
+    if (ti_stream_write_pkg(node->stream, pkg))
+    {
+        free(pkg);
+        return -1;
+    }
+    return 0;
+}
+
 static void node__on_connect(uv_connect_t * req, int status)
 {
     int rc;
@@ -12,6 +12,7 @@
 #include <ti/away.h>
 #include <ti/collection.inline.h>
 #include <ti/fwd.h>
+#include <ti/interest.h>
 #include <ti/nodes.h>
 #include <ti/proto.h>
 #include <ti/qcache.h>
@@ -124,7 +125,7 @@ static void nodes__on_req_connect(ti_stream_t * stream, ti_pkg_t * pkg)
         from_node_syntax_ver,
         from_node_port;
 
-    ti_node_t * node, * this_node = ti.node;
+    ti_node_t * node = NULL, * this_node = ti.node;
     char * min_ver = NULL;
     char * version = NULL;
     msgpack_packer pk;
@@ -402,6 +403,10 @@ done:
         free(resp);
         log_error(EX_INTERNAL_S);
     }
+    else if (node &&
+             ti_version_cmp(version, TI_NODE_CAPS_VERSION) >= 0 &&
+             ti_node_write_caps(node, true))
+        log_error(EX_INTERNAL_S);
 
 fail:
     free(version);
@@ -415,7 +420,7 @@ static void nodes__on_req_change_id(ti_stream_t * stream, ti_pkg_t * pkg)
     ti_pkg_t * resp = NULL;
     ti_node_t * other_node = stream->via.node;
     ti_node_t * this_node = ti.node;
-    mp_obj_t mp_change_id;
+    mp_obj_t obj, mp_change_id, mp_n_ids;
     ti_proto_enum_t accepted;
     uint8_t n = 0;
 
@@ -437,16 +442,37 @@ static void nodes__on_req_change_id(ti_stream_t * stream, ti_pkg_t * pkg)
 
     mp_unp_init(&up, pkg->data, pkg->n);
 
-    if (mp_next(&up, &mp_change_id) != MP_U64)
+    /*
+     * The request is either a single change id, or an array with the first
+     * change id and the number of change id's for a batch of changes.
+     */
+    switch (mp_next(&up, &obj))
     {
+    case MP_U64:
+        mp_change_id = obj;
+        accepted = ti_changes_accept_id(mp_change_id.via.u64, &n);
+        break;
+    case MP_ARR:
+        if (obj.via.sz == 2 &&
+            mp_next(&up, &mp_change_id) == MP_U64 &&
+            mp_next(&up, &mp_n_ids) == MP_U64 &&
+            mp_n_ids.via.u64 &&
+            mp_n_ids.via.u64 <= UINT8_MAX)
+        {
+            accepted = ti_changes_accept_range(
+                    mp_change_id.via.u64,
+                    mp_n_ids.via.u64,
+                    &n);
+            break;
+        }
+        /* fall through */
+    default:
         ex_set(&e, EX_BAD_DATA,
                 "invalid `%s` request from "TI_NODE_ID" to "TI_NODE_ID,
                 ti_proto_str(pkg->tp), other_node->id, this_node->id);
         goto finish;
     }
 
-    accepted = ti_changes_accept_id(mp_change_id.via.u64, &n);
-
     log_debug("respond with %s to requested "TI_CHANGE_ID" from "TI_NODE_ID,
             ti_proto_str(accepted),
             mp_change_id.via.u64,
@@ -925,6 +951,7 @@ static void nodes__on_req_syncfdone(ti_stream_t * stream, ti_pkg_t * pkg)
     }
 
     (void) ti_store_restore();
+    (void) ti_store_load_start();
     resp = ti_pkg_new(pkg->id, TI_PROTO_NODE_RES_SYNCFDONE, NULL, 0);
 
 finish:
@@ -1087,6 +1114,54 @@ static void nodes__on_missing_change(ti_stream_t * stream, ti_pkg_t * pkg)
             other_node->id);
 }
 
+static void nodes__on_room_interest(ti_stream_t * stream, ti_pkg_t * pkg)
+{
+    ti_node_t * other_node = stream->via.node;
+
+    if (!other_node)
+    {
+        LOG_UNAUTHORIZED_NODE
+        return;
+    }
+
+    ti_interest_on_pkg(other_node, pkg);
+}
+
+/*
+ * Package: [caps, reply]
+ *
+ * The accepting node sends its capabilities after the connect response when
+ * the other node is known to handle this package; the other node replies
+ * with its own capabilities.
+ */
+static void nodes__on_caps(ti_stream_t * stream, ti_pkg_t * pkg)
+{
+    mp_unp_t up;
+    mp_obj_t obj, mp_caps, mp_reply;
+    ti_node_t * other_node = stream->via.node;
+
+    if (!other_node)
+    {
+        LOG_UNAUTHORIZED_NODE
+        return;
+    }
+
+    mp_unp_init(&up, pkg->data, pkg->n);
+
+    if (mp_next(&up, &obj) != MP_ARR || obj.via.sz != 2 ||
+        mp_next(&up, &mp_caps) != MP_U64 ||
+        mp_next(&up, &mp_reply) != MP_BOOL)
+    {
+        LOG_INVALID
+        return;
+    }
+
+    other_node->caps = (uint8_t) mp_caps.via.u64;
+
+    if (mp_reply.via.bool_ && ti_node_write_caps(other_node, false))
+        log_error(EX_INTERNAL_S);
+}
+
 static void nodes__on_room_emit(ti_stream_t * stream, ti_pkg_t * pkg)
 {
     ti_collection_t * collection;
@@ -1431,6 +1506,39 @@ void ti_nodes_write_rpkg(ti_rpkg_t * rpkg)
     }
 }
 
+/*
+ * Like ti_nodes_write_rpkg() but skips nodes which have no listeners for the
+ * given room according to their room interest filter.
+ */
+void ti_nodes_write_room_rpkg(
+        ti_rpkg_t * rpkg,
+        uint64_t collection_id,
+        uint64_t room_id)
+{
+    ti_node_t * this_node = ti.node;
+    vec_t * nodes_vec = nodes->vec;
+    for (vec_each(nodes_vec, ti_node_t, node))
+    {
+        ti_node_status_t status = node->status;
+
+        if (node == this_node || !(status & (
+                TI_NODE_STAT_READY |
+                TI_NODE_STAT_AWAY_SOON |
+                TI_NODE_STAT_AWAY |
+                TI_NODE_STAT_SYNCHRONIZING)))
+            continue;
+
+        if (!ti_interest_test(node, collection_id, room_id))
+        {
+            ++ti.counters->room_emits_suppressed;
+            continue;
+        }
+
+        if (ti_stream_write_rpkg(node->stream, rpkg))
+            log_error(EX_INTERNAL_S);
+    }
+}
+
 int ti_nodes_to_pk(msgpack_packer * pk)
 {
     vec_t * nodes_vec = nodes->vec;
@@ -1652,7 +1760,7 @@ ti_node_t * ti_nodes_new_node(
 
     /* update relative node id */
     ti_update_rel_id();
-    ti_tasks_reset_lowest_run_at();
+    ti_tasks_reschedule();
 
     return node;
 }
@@ -1668,6 +1776,7 @@ void ti_nodes_del_node(uint32_t node_id)
 
             /* update relative node id */
             ti_update_rel_id();
+            ti_tasks_reschedule();
 
             return;
         }
@@ -1864,6 +1973,12 @@ void ti_nodes_pkg_cb(ti_stream_t * stream, ti_pkg_t * pkg)
     case TI_PROTO_NODE_FWD_TASK:
         nodes__on_fwd_task(stream, pkg);
         break;
+    case TI_PROTO_NODE_ROOM_INTEREST:
+        nodes__on_room_interest(stream, pkg);
+        break;
+    case TI_PROTO_NODE_CAPS:
+        nodes__on_caps(stream, pkg);
+        break;
     case TI_PROTO_NODE_REQ_QUERY:
         nodes__on_req_query(stream, pkg);
         break;
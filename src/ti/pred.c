@@ -0,0 +1,670 @@
+/*
+ * ti/pred.c
+ *
+ * Simple closures like `|x| x.age > 18 && x.name != ''` only read values,
+ * and can therefore be evaluated on multiple threads at once. The closure
+ * is not called; instead the statement is translated to a small tree of
+ * comparisons which is tested without changing any reference counter.
+ *
+ * If a value cannot be tested (for example when a property is missing or
+ * the values cannot be compared), the result is dropped and the caller falls
+ * back to calling the closure for each value. This way errors and results
+ * are always equal to the single threaded code path.
+ */
+#include <assert.h>
+#include <errno.h>
+#include <langdef/langdef.h>
+#include <ti.h>
+#include <ti/closure.h>
+#include <ti/field.h>
+#include <ti/names.h>
+#include <ti/nil.h>
+#include <ti/opr/oprinc.h>
+#include <ti/pred.h>
+#include <ti/preopr.h>
+#include <ti/prop.h>
+#include <ti/query.h>
+#include <ti/raw.h>
+#include <ti/thing.h>
+#include <ti/val.inline.h>
+#include <ti/vbool.h>
+#include <ti/vfloat.h>
+#include <ti/vint.h>
+#include <util/logger.h>
+#include <util/strx.h>
+#include <uv.h>
+
+#define PRED__MAX_NODES 16
+#define PRED__MAX_VALS (PRED__MAX_NODES * 2)
+#define PRED__MAX_PATH 4
+#define PRED__MAX_THREADS 64
+#define PRED__MIN_SHARD 4096
+
+typedef enum
+{
+    PRED__AND,
+    PRED__OR,
+    PRED__BOOL,     /* left operand as boolean */
+    PRED__EQ,
+    PRED__NE,
+    PRED__LT,
+    PRED__LE,
+    PRED__GT,
+    PRED__GE,
+} pred__op_t;
+
+typedef struct
+{
+    ti_val_t * val;                     /* constant or variable, NULL for
+                                           the closure argument */
+    ti_name_t * path[PRED__MAX_PATH];   /* properties, without reference */
+    uint8_t n;                          /* number of properties in path */
+} pred__operand_t;
+
+typedef struct pred__node_s pred__node_t;
+
+struct pred__node_s
+{
+    pred__op_t op;
+    pred__node_t * a;           /* and, or */
+    pred__node_t * b;           /* and, or */
+    pred__operand_t left;
+    pred__operand_t right;
+};
+
+typedef struct
+{
+    ti_closure_t * closure;
+    ti_query_t * query;
+    ti_name_t * arg;            /* name of the first closure argument */
+    uint32_t n;                 /* number of nodes; nodes[0] is the root */
+    uint32_t n_vals;            /* number of values in vals */
+    pred__node_t nodes[PRED__MAX_NODES];
+    ti_val_t * vals[PRED__MAX_VALS];    /* with references */
+} pred__t;
+
+typedef struct
+{
+    pred__t * pred;
+    vec_t * vec;
+    uint8_t * res;
+    uint32_t start;
+    uint32_t end;
+    int rc;                     /* -1 when a value cannot be tested */
+} pred__shard_t;
+
+/*
+ * The query threads are started once by ti_pred_init() and wait for shards
+ * to test; the main thread tests shards as well while waiting for the result.
+ */
+typedef struct
+{
+    uv_mutex_t lock;
+    uv_cond_t work;             /* shards are available, or stop */
+    uv_cond_t done;             /* all shards are tested */
+    pred__shard_t * shards;
+    uint32_t n_shards;
+    uint32_t next;              /* next shard to test */
+    uint32_t n_done;            /* number of tested shards */
+    uint32_t n;                 /* number of started threads */
+    _Bool stop;
+    uv_thread_t threads[PRED__MAX_THREADS];
+} pred__pool_t;
+
+static pred__pool_t * pool;
+static pred__pool_t pool_;
+
+static int pred__keep(pred__t * pred, ti_val_t * val)
+{
+    if (pred->n_vals == PRED__MAX_VALS)
+    {
+        ti_val_drop(val);
+        return -1;
+    }
+    pred->vals[pred->n_vals++] = val;
+    return 0;
+}
+
+static ti_val_t * pred__const(cleri_node_t * nd)
+{
+    int64_t i;
+
+    switch (nd->cl_obj->gid)
+    {
+    case CLERI_GID_T_FALSE:
+        return (ti_val_t *) ti_vbool_get(false);
+    case CLERI_GID_T_FLOAT:
+        return (ti_val_t *) ti_vfloat_create(strx_to_double(nd->str, NULL));
+    case CLERI_GID_T_INT:
+        i = strx_to_int64(nd->str, NULL);
+        return errno == ERANGE ? NULL : (ti_val_t *) ti_vint_create(i);
+    case CLERI_GID_T_NIL:
+        return (ti_val_t *) ti_nil_get();
+    case CLERI_GID_T_STRING:
+        return (ti_val_t *) ti_str_from_ti_string(nd->str, nd->len);
+    case CLERI_GID_T_TRUE:
+        return (ti_val_t *) ti_vbool_get(true);
+    }
+    return NULL;
+}
+
+static int pred__var(pred__t * pred, cleri_node_t * nd, ti_val_t ** val)
+{
+    ti_prop_t * prop;
+    ti_name_t * name = ti_names_weak_get_strn(nd->str, nd->len);
+
+    if (!name)
+        return -1;
+
+    if (name == pred->arg)
+    {
+        *val = NULL;
+        return 0;
+    }
+
+    /* other closure arguments change for each value */
+    for (vec_each(pred->closure->vars, ti_prop_t, p))
+        if (p->name == name)
+            return -1;
+
+    /* a variable cannot change since the statement has no assignments */
+    prop = ti_query_var_get(pred->query, name);
+    if (!prop)
+        return -1;
+
+    *val = prop->val;
+    ti_incref(*val);
+    return pred__keep(pred, *val);
+}
+
+/*
+ * Operand: a constant, or a variable with an optional chain of properties.
+ */
+static int pred__operand(
+        pred__t * pred,
+        cleri_node_t * nd,
+        pred__operand_t * operand)
+{
+    int preopr;
+    cleri_node_t * choice, * chain;
+
+    if (nd->cl_obj->gid != CLERI_GID_EXPRESSION)
+        return -1;
+
+    preopr = (int) ((intptr_t) nd->children->data);
+    choice = nd->children->next;
+    chain = choice->next->next;
+    operand->n = 0;
+
+    if (choice->next->children)
+        return -1;  /* index */
+
+    if (choice->cl_obj->gid == CLERI_GID_VAR_OPT_MORE)
+    {
+        if (preopr ||
+            choice->children->next ||
+            pred__var(pred, choice->children, &operand->val))
+            return -1;
+
+        for (; chain; chain = chain->children->next->next->next)
+        {
+            cleri_node_t * name_nd = chain->children->next;
+            ti_name_t * name;
+
+            if (chain->children->len != 1 ||       /* ?. */
+                name_nd->children->next ||          /* assign, function */
+                name_nd->next->children ||          /* index */
+                operand->n == PRED__MAX_PATH)
+                return -1;
+
+            name = ti_names_weak_get_strn(
+                    name_nd->children->str,
+                    name_nd->children->len);
+            if (!name)
+                return -1;
+
+            operand->path[operand->n++] = name;
+        }
+        return 0;
+    }
+
+    if (chain || !(operand->val = pred__const(choice)))
+        return -1;
+
+    if (preopr)
+    {
+        ex_t e = {0};
+        if (ti_preopr_calc(preopr, &operand->val, &e) || !operand->val)
+        {
+            ti_val_drop(operand->val);
+            return -1;
+        }
+    }
+    return pred__keep(pred, operand->val);
+}
+
+static pred__node_t * pred__statement(pred__t * pred, cleri_node_t * nd)
+{
+    pred__node_t * node;
+    cleri_node_t * opr;
+
+    if (pred->n == PRED__MAX_NODES)
+        return NULL;
+
+    /* reserve the node before the children so nodes[0] is the root */
+    node = &pred->nodes[pred->n++];
+    nd = nd->children;
+
+    if (nd->cl_obj->gid == CLERI_GID_EXPRESSION)
+    {
+        cleri_node_t * choice = nd->children->next;
+        if (choice->cl_obj->gid == CLERI_GID_PARENTHESIS &&
+            !nd->children->data &&
+            !choice->next->children &&
+            !choice->next->next)
+        {
+            --pred->n;
+            return pred__statement(pred, choice->children->next);
+        }
+        node->op = PRED__BOOL;
+        return pred__operand(pred, nd, &node->left) ? NULL : node;
+    }
+
+    if (nd->cl_obj->gid != CLERI_GID_OPERATIONS)
+        return NULL;
+
+    opr = nd->children->next;
+    switch (opr->cl_obj->gid)
+    {
+    case CLERI_GID_OPR6_COMPARE:
+        switch (*opr->str)
+        {
+        case '=': node->op = PRED__EQ; break;
+        case '!': node->op = PRED__NE; break;
+        case '<': node->op = opr->len == 1 ? PRED__LT : PRED__LE; break;
+        case '>': node->op = opr->len == 1 ? PRED__GT : PRED__GE; break;
+        default:
+            return NULL;
+        }
+        return (
+            pred__operand(pred, nd->children->children, &node->left) ||
+            pred__operand(pred, opr->next->children, &node->right)
+        ) ? NULL : node;
+    case CLERI_GID_OPR7_CMP_AND:
+        node->op = PRED__AND;
+        break;
+    case CLERI_GID_OPR8_CMP_OR:
+        node->op = PRED__OR;
+        break;
+    default:
+        return NULL;
+    }
+
+    return (
+        (node->a = pred__statement(pred, nd->children)) &&
+        (node->b = pred__statement(pred, opr->next))
+    ) ? node : NULL;
+}
+
+static void pred__clear(pred__t * pred)
+{
+    while (pred->n_vals)
+        ti_val_unsafe_drop(pred->vals[--pred->n_vals]);
+}
+
+static int pred__init(pred__t * pred, ti_closure_t * closure, ti_query_t * q)
+{
+    pred->closure = closure;
+    pred->query = q;
+    pred->arg = closure->vars->n
+            ? ((ti_prop_t *) VEC_first(closure->vars))->name
+            : NULL;
+    pred->n = 0;
+
+    return pred__statement(pred, ti_closure_statement(closure)) ? 0 : -1;
+}
+
+/*
+ * Walks the properties; a typed thing is searched without the lookup table
+ * of the type since that table might be created by ti_field_by_name(..).
+ */
+static ti_val_t * pred__resolve(pred__operand_t * operand, ti_val_t * val)
+{
+    uint8_t i;
+
+    if (operand->val)
+        val = operand->val;
+
+    for (i = 0; i < operand->n; ++i)
+    {
+        ti_name_t * name = operand->path[i];
+        ti_thing_t * thing = (ti_thing_t *) val;
+
+        if (!ti_val_is_thing(val))
+            return NULL;
+
+        if (ti_thing_is_object(thing))
+        {
+            ti_prop_t * prop = ti_thing_o_prop_weak_get(thing, name);
+            if (!prop)
+                return NULL;
+            val = prop->val;
+            continue;
+        }
+
+        val = NULL;
+        for (vec_each(thing->via.type->fields, ti_field_t, field))
+        {
+            if (field->name == name)
+            {
+                val = VEC_get(thing->items.vec, field->idx);
+                break;
+            }
+        }
+        if (!val)
+            return NULL;
+    }
+    return val;
+}
+
+#define PRED__ORDER(op__, a__, b__) (                                   \
+    (op__) == PRED__LT ? (a__) < (b__) :                                \
+    (op__) == PRED__LE ? (a__) <= (b__) :                               \
+    (op__) == PRED__GT ? (a__) > (b__) :                                \
+    (a__) >= (b__))
+
+/*
+ * Equal to the `<`, `<=`, `>` and `>=` operators, except that -1 is returned
+ * where the operator would raise an error.
+ */
+static int pred__order(pred__op_t op, ti_val_t * a, ti_val_t * b)
+{
+    switch ((ti_opr_perm_t) TI_OPR_PERM(a, b))
+    {
+    case OPR_INT_INT:
+        return PRED__ORDER(op, VINT(a), VINT(b));
+    case OPR_INT_FLOAT:
+        return PRED__ORDER(op, VINT(a), VFLOAT(b));
+    case OPR_INT_BOOL:
+        return PRED__ORDER(op, VINT(a), VBOOL(b));
+    case OPR_FLOAT_INT:
+        return PRED__ORDER(op, VFLOAT(a), VINT(b));
+    case OPR_FLOAT_FLOAT:
+        return PRED__ORDER(op, VFLOAT(a), VFLOAT(b));
+    case OPR_FLOAT_BOOL:
+        return PRED__ORDER(op, VFLOAT(a), VBOOL(b));
+    case OPR_BOOL_INT:
+        return PRED__ORDER(op, VBOOL(a), VINT(b));
+    case OPR_BOOL_FLOAT:
+        return PRED__ORDER(op, VBOOL(a), VFLOAT(b));
+    case OPR_BOOL_BOOL:
+        return PRED__ORDER(op, VBOOL(a), VBOOL(b));
+    case OPR_DATETIME_DATETIME:
+        return PRED__ORDER(op, DATETIME(a), DATETIME(b));
+    case OPR_NAME_NAME:
+    case OPR_NAME_STR:
+    case OPR_NAME_BYTES:
+    case OPR_STR_DATETIME:
+    case OPR_STR_NAME:
+    case OPR_STR_STR:
+    case OPR_STR_BYTES:
+    case OPR_BYTES_NAME:
+    case OPR_BYTES_STR:
+    case OPR_BYTES_BYTES:
+        return PRED__ORDER(op, ti_raw_cmp((ti_raw_t *) a, (ti_raw_t *) b), 0);
+    default:
+        return -1;
+    }
+}
+
+/*
+ * Returns 1 (true), 0 (false) or -1 when the value cannot be tested.
+ */
+static int pred__test(pred__node_t * node, ti_val_t * val)
+{
+    int rc;
+    ti_val_t * a, * b;
+
+    switch (node->op)
+    {
+    case PRED__AND:
+        rc = pred__test(node->a, val);
+        return rc == 1 ? pred__test(node->b, val) : rc;
+    case PRED__OR:
+        rc = pred__test(node->a, val);
+        return rc == 0 ? pred__test(node->b, val) : rc;
+    default:
+        break;
+    }
+
+    if (!(a = pred__resolve(&node->left, val)))
+        return -1;
+
+    if (node->op == PRED__BOOL)
+        return ti_val_as_bool(a);
+
+    if (!(b = pred__resolve(&node->right, val)))
+        return -1;
+
+    switch (node->op)
+    {
+    case PRED__EQ:
+        return ti_opr_eq(a, b);
+    case PRED__NE:
+        return !ti_opr_eq(a, b);
+    default:
+        return pred__order(node->op, a, b);
+    }
+}
+
+static void pred__work(pred__shard_t * shard)
+{
+    uint32_t i;
+    pred__node_t * root = shard->pred->nodes;
+    void ** data = shard->vec->data;
+
+    for (i = shard->start; i < shard->end; ++i)
+    {
+        int rc = pred__test(root, data[i]);
+        if (rc < 0)
+        {
+            shard->rc = -1;
+            return;
+        }
+        shard->res[i] = (uint8_t) rc;
+    }
+}
+
+static void pred__worker(pred__pool_t * pool)
+{
+    pred__shard_t * shard;
+
+    uv_mutex_lock(&pool->lock);
+    while (!pool->stop)
+    {
+        if (pool->next == pool->n_shards)
+        {
+            uv_cond_wait(&pool->work, &pool->lock);
+            continue;
+        }
+
+        shard = &pool->shards[pool->next++];
+        uv_mutex_unlock(&pool->lock);
+
+        pred__work(shard);
+
+        uv_mutex_lock(&pool->lock);
+        if (++pool->n_done == pool->n_shards)
+            uv_cond_signal(&pool->done);
+    }
+    uv_mutex_unlock(&pool->lock);
+}
+
+/*
+ * Tests all shards using the query threads and the calling thread, and
+ * returns when all shards are tested.
+ */
+static void pred__pool_run(pred__shard_t * shards, uint32_t n)
+{
+    pred__shard_t * shard;
+
+    uv_mutex_lock(&pool->lock);
+    pool->shards = shards;
+    pool->n_shards = n;
+    pool->next = 0;
+    pool->n_done = 0;
+    uv_cond_broadcast(&pool->work);
+
+    while (pool->next < pool->n_shards)
+    {
+        shard = &pool->shards[pool->next++];
+        uv_mutex_unlock(&pool->lock);
+
+        pred__work(shard);
+
+        uv_mutex_lock(&pool->lock);
+        ++pool->n_done;
+    }
+
+    while (pool->n_done < pool->n_shards)
+        uv_cond_wait(&pool->done, &pool->lock);
+
+    pool->shards = NULL;
+    pool->n_shards = 0;
+    pool->next = 0;
+    uv_mutex_unlock(&pool->lock);
+}
+
+/*
+ * Starts the query threads; one less than `query_threads` since the thread
+ * which runs the query tests values as well. When starting a thread fails,
+ * the work is done by the threads which are started.
+ */
+int ti_pred_init(void)
+{
+    uint32_t n = ti.cfg->query_threads;
+
+    pool = &pool_;
+    pool->shards = NULL;
+    pool->n_shards = 0;
+    pool->next = 0;
+    pool->n_done = 0;
+    pool->n = 0;
+    pool->stop = false;
+
+    if (n > PRED__MAX_THREADS)
+        n = PRED__MAX_THREADS;
+
+    if (uv_mutex_init(&pool->lock))
+        goto fail0;
+
+    if (uv_cond_init(&pool->work))
+        goto fail1;
+
+    if (uv_cond_init(&pool->done))
+        goto fail2;
+
+    for (; pool->n + 1 < n; ++pool->n)
+    {
+        if (uv_thread_create(
+                &pool->threads[pool->n],
+                (uv_thread_cb) pred__worker,
+                pool))
+        {
+            log_warning("failed to start query thread %"PRIu32, pool->n);
+            break;
+        }
+    }
+    return 0;
+
+fail2:
+    uv_cond_destroy(&pool->work);
+fail1:
+    uv_mutex_destroy(&pool->lock);
+fail0:
+    pool = NULL;
+    return -1;
+}
+
+void ti_pred_destroy(void)
+{
+    if (!pool)
+        return;
+
+    uv_mutex_lock(&pool->lock);
+    pool->stop = true;
+    uv_cond_broadcast(&pool->work);
+    uv_mutex_unlock(&pool->lock);
+
+    while (pool->n)
+        (void) uv_thread_join(&pool->threads[--pool->n]);
+
+    uv_cond_destroy(&pool->done);
+    uv_cond_destroy(&pool->work);
+    uv_mutex_destroy(&pool->lock);
+    pool = NULL;
+}
+
+/*
+ * Returns `true` when query threads are started.
+ */
+_Bool ti_pred_has_threads(void)
+{
+    return pool && pool->n;
+}
+
+/*
+ * Tests the closure for each value in `vec` using the query threads. Returns
+ * NULL when the closure is not a simple predicate, or when at least one of
+ * the values cannot be tested. The caller must then call the closure for
+ * each value; otherwise the return value contains a result for each value,
+ * in the same order as `vec`.
+ *
+ * Must be called after ti_closure_inc(..) so variables can be resolved.
+ */
+uint8_t * ti_pred_run(ti_closure_t * closure, ti_query_t * query, vec_t * vec)
+{
+    pred__t pred;
+    pred__shard_t shards[PRED__MAX_THREADS];
+    uint8_t * res = NULL;
+    uint32_t i, size, n = pool ? pool->n + 1 : 0;
+
+    pred.n_vals = 0;
+
+    if (n > vec->n / PRED__MIN_SHARD)
+        n = vec->n / PRED__MIN_SHARD;
+
+    if (n < 2 || pred__init(&pred, closure, query))
+        goto done;
+
+    res = malloc(vec->n);
+    if (!res)
+        goto done;
+
+    size = vec->n / n;
+    for (i = 0; i < n; ++i)
+    {
+        shards[i].pred = &pred;
+        shards[i].vec = vec;
+        shards[i].res = res;
+        shards[i].start = i * size;
+        shards[i].end = i == n - 1 ? vec->n : (i + 1) * size;
+        shards[i].rc = 0;
+    }
+
+    pred__pool_run(shards, n);
+
+    for (i = 0; i < n; ++i)
+    {
+        if (shards[i].rc)
+        {
+            free(res);
+            res = NULL;
+            break;
+        }
+    }
+
+done:
+    pred__clear(&pred);
+    return res;
+}
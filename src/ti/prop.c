@@ -9,7 +9,7 @@
 
 ti_prop_t * ti_prop_create(ti_name_t * name, ti_val_t * val)
 {
-    ti_prop_t * prop = malloc(sizeof(ti_prop_t));
+    ti_prop_t * prop = ti_slab_alloc(sizeof(ti_prop_t));
     if (!prop)
         return NULL;
 
@@ -24,7 +24,7 @@ ti_prop_t * ti_prop_create(ti_name_t * name, ti_val_t * val)
  */
 ti_prop_t * ti_prop_dup(ti_prop_t * prop)
 {
-    ti_prop_t * dup = malloc(sizeof(ti_prop_t));
+    ti_prop_t * dup = ti_slab_alloc(sizeof(ti_prop_t));
     if (!prop)
         return NULL;
 
@@ -41,7 +41,7 @@ void ti_prop_destroy(ti_prop_t * prop)
         return;
     ti_name_unsafe_drop(prop->name);
     ti_val_unsafe_gc_drop(prop->val);
-    free(prop);
+    ti_prop_free(prop);
 }
 
 void ti_prop_unassign_destroy(ti_prop_t * prop)
@@ -50,11 +50,11 @@ void ti_prop_unassign_destroy(ti_prop_t * prop)
         return;
     ti_name_unsafe_drop(prop->name);
     ti_val_unassign_unsafe_drop(prop->val);
-    free(prop);
+    ti_prop_free(prop);
 }
 
 void ti_prop_unsafe_vdestroy(ti_prop_t * prop)
 {
     ti_name_unsafe_drop(prop->name);
-    free(prop);
+    ti_prop_free(prop);
 }
@@ -19,6 +19,7 @@ const char * ti_proto_str(ti_proto_enum_t tp)
     case TI_PROTO_CLIENT_RES_OK:            return "CLIENT_RES_OK";
     case TI_PROTO_CLIENT_RES_DATA:          return "CLIENT_RES_DATA";
     case TI_PROTO_CLIENT_RES_ERROR:         return "CLIENT_RES_ERROR";
+    case TI_PROTO_CLIENT_RES_DATA_PART:     return "CLIENT_RES_DATA_PART";
 
     case TI_PROTO_CLIENT_REQ_PING:          return "CLIENT_REQ_PING";
     case TI_PROTO_CLIENT_REQ_AUTH:          return "CLIENT_REQ_AUTH";
@@ -29,6 +30,8 @@ const char * ti_proto_str(ti_proto_enum_t tp)
     case TI_PROTO_CLIENT_REQ_JOIN:          return "CLIENT_REQ_JOIN";
     case TI_PROTO_CLIENT_REQ_LEAVE:         return "CLIENT_REQ_LEAVE";
     case TI_PROTO_CLIENT_REQ_EMIT:          return "CLIENT_REQ_EMIT";
+    case TI_PROTO_CLIENT_REQ_QUERY_STREAM:  return "CLIENT_REQ_QUERY_STREAM";
+    case TI_PROTO_CLIENT_REQ_RUN_STREAM:    return "CLIENT_REQ_RUN_STREAM";
 
     case TI_PROTO_MODULE_CONF:              return "MODULE_CONF";
     case TI_PROTO_MODULE_CONF_OK:           return "MODULE_CONF_OK";
@@ -43,6 +46,8 @@ const char * ti_proto_str(ti_proto_enum_t tp)
     case TI_PROTO_NODE_ROOM_EMIT:           return "NODE_ROOM_EMIT";
     case TI_PROTO_NODE_FWD_WARN:            return "NODE_FWD_WARN";
     case TI_PROTO_NODE_FWD_TASK:            return "NODE_FWD_TASK";
+    case TI_PROTO_NODE_ROOM_INTEREST:       return "NODE_ROOM_INTEREST";
+    case TI_PROTO_NODE_CAPS:                return "NODE_CAPS";
 
     case TI_PROTO_NODE_REQ_QUERY:           return "NODE_REQ_QUERY";
     case TI_PROTO_NODE_REQ_RUN:             return "NODE_REQ_RUN";
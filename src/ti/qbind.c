@@ -248,7 +248,9 @@
 #include <ti/fn/fntry.h>
 #include <ti/fn/fntype.h>
 #include <ti/fn/fntypeassert.h>
+#include <ti/fn/fntypebetween.h>
 #include <ti/fn/fntypecount.h>
+#include <ti/fn/fntypefilter.h>
 #include <ti/fn/fntypeinfo.h>
 #include <ti/fn/fntypesinfo.h>
 #include <ti/fn/fnunique.h>
@@ -296,7 +298,7 @@ static void qbind__statement(ti_qbind_t * qbind, cleri_node_t * nd);
  */
 enum
 {
-    TOTAL_KEYWORDS = 271,
+    TOTAL_KEYWORDS = 273,
     MIN_WORD_LENGTH = 2,
     MAX_WORD_LENGTH = 17,
     MIN_HASH_VALUE = 30,
@@ -729,8 +731,10 @@ qbind__fmap_t qbind__fn_mapping[TOTAL_KEYWORDS] = {
     {.name="trim",              .fn=do__f_trim,                 CHAIN_NE},
     {.name="try",               .fn=do__f_try,                  XROOT_NE},
     {.name="type_assert",       .fn=do__f_type_assert,          ROOT_NE},
+    {.name="type_between",      .fn=do__f_type_between,         ROOT_NE},
     {.name="type_count",        .fn=do__f_type_count,           ROOT_NE},
     {.name="type_err",          .fn=do__f_type_err,             ROOT_NE},
+    {.name="type_filter",       .fn=do__f_type_filter,          ROOT_NE},
     {.name="type_info",         .fn=do__f_type_info,            ROOT_NE},
     {.name="type",              .fn=do__f_type,                 ROOT_NE},
     {.name="types_info",        .fn=do__f_types_info,           ROOT_NE},
@@ -1283,6 +1287,30 @@ static void qbind__expr_choice(ti_qbind_t * qbind, cleri_node_t * nd)
     }
 }
 
+/*
+ * Returns a callback for an expression without a pre-operator, index and
+ * chain. Such expressions can skip the generic ti_do_expression(..) and
+ * directly run the only part of the expression.
+ */
+static ti_do_cb qbind__expr_direct(cleri_node_t * nd)
+{
+    switch (nd->cl_obj->gid)
+    {
+    case CLERI_GID_T_FALSE:     return ti_do_expr_false;
+    case CLERI_GID_T_FLOAT:     return ti_do_expr_float;
+    case CLERI_GID_T_INT:       return ti_do_expr_int;
+    case CLERI_GID_T_NIL:       return ti_do_expr_nil;
+    case CLERI_GID_T_STRING:    return ti_do_expr_string;
+    case CLERI_GID_T_TRUE:      return ti_do_expr_true;
+    case CLERI_GID_VAR_OPT_MORE:
+        if (!nd->children->next)
+            return ti_do_expr_var;
+        if (nd->children->next->cl_obj->gid == CLERI_GID_FUNCTION)
+            return ti_do_expr_function;
+    }
+    return ti_do_expression;
+}
+
 /*
  * Analyze an expression. An expression may start with some +, - or ! signs,
  * followed by a function, variable or something else, next an optional index
@@ -1314,6 +1342,8 @@ static inline void qbind__expression(ti_qbind_t * qbind, cleri_node_t * nd)
     /* chain */
     if (nd->children->next->next->next)
         qbind__chain(qbind, nd->children->next->next->next);
+    else if (!preopr && !nd->children->next->next->children)
+        nd->data = qbind__expr_direct(nd->children->next);
 }
 
 static inline void qbind__if_statement(ti_qbind_t * qbind, cleri_node_t * nd)
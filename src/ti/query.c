@@ -12,6 +12,7 @@
 #include <ti/api.h>
 #include <ti/auth.h>
 #include <ti/change.h>
+#include <ti/changes.h>
 #include <ti/closure.h>
 #include <ti/collection.inline.h>
 #include <ti/collections.h>
@@ -37,6 +38,7 @@
 #include <ti/verror.h>
 #include <ti/vset.h>
 #include <ti/wrap.h>
+#include <util/mpjson.h>
 #include <util/strx.h>
 
 ti_query_done_cb ti_query_done_map[] = {
@@ -67,6 +69,13 @@ static ti_cpkg_t * query__cpkg_change(ti_query_t * query)
     ti_cpkg_t * cpkg;
     ti_pkg_t * pkg;
     vec_t * tasks = query->change->tasks;
+    uint64_t dep_id = 0;
+    _Bool with_dep = (
+            ti.cfg->change_pipelines &&
+            tasks->n &&
+            query->collection &&
+            (dep_id = ti_changes_dep_id(query->collection)) <
+                query->change->id);
 
     for (vec_each(tasks, ti_task_t, task))
         init_buffer_sz += task->approx_sz;
@@ -75,12 +84,16 @@ static ti_cpkg_t * query__cpkg_change(ti_query_t * query)
         return NULL;
     msgpack_packer_init(&pk, &buffer, msgpack_sbuffer_write);
 
-    msgpack_pack_array(&pk, tasks->n+2);
+    msgpack_pack_array(&pk, tasks->n+2+with_dep);
     msgpack_pack_uint64(&pk, query->change->id);
     msgpack_pack_uint64(&pk, tasks->n && query->collection
             ? query->collection->id
             : 0);
 
+    /* dependency, see ti_cpkg_dep() */
+    if (with_dep)
+        msgpack_pack_uint64(&pk, dep_id);
+
     for (vec_each(tasks, ti_task_t, task))
     {
         msgpack_pack_array(&pk, task->list->n+1);
@@ -300,6 +313,7 @@ int ti_query_unpack_args(ti_query_t * query, mp_unp_t * up, ex_t * e)
             ex_set_mem(e);
             return e->nr;
         }
+        ti_query_var_pushed(query);
     }
 
     return 0;
@@ -1025,7 +1039,7 @@ void query__task_finish(ti_query_t * query, const ex_t * e, _Bool set_err)
                         : ti_verror_ensure_from_e(e);
             }
 
-            ti_tasks_vtask_finish(vtask);
+            ti_tasks_vtask_finish(vtask, query->collection);
 
             if (ti_task_add_vtask_finish(task, vtask))
                 log_critical("failed to add task finish change");
@@ -1092,22 +1106,65 @@ void ti_query_run_task(ti_query_t * query)
     ti_query_done(query, &e, &ti_query_task_result);
 }
 
-static inline int query__pack_response(
+/*
+ * When a query response is streamed, parts are written as soon as they have
+ * at least `QUERY__STREAM_SZ` bytes.
+ */
+#define QUERY__STREAM_SZ 262144
+#define QUERY__STREAM_ALLOC (QUERY__STREAM_SZ + (QUERY__STREAM_SZ >> 2))
+
+/*
+ * A streamed response continues on the event loop after each part, so other
+ * work is handled while the response is written. The items of a list or tuple
+ * result are packed one by one and packing continues when the written parts
+ * have been sent, or on the next loop iteration when they are sent right away.
+ * Other results are packed at once; parts are written without blocking but
+ * can only be sent after the complete value is packed.
+ */
+typedef struct
+{
+    msgpack_sbuffer buffer;     /* must be the first member */
+    ti_query_t * query;
+    ex_t e;
+    size_t n;                   /* number of bytes written in parts */
+    size_t offset;              /* bytes reserved at the start of a part */
+    ti_vp_t vp;
+    mpjson_writer_t writer;     /* only used for a JSON response */
+    vec_t * items;              /* items of a list or tuple result, or NULL */
+    uint32_t idx;               /* next item to pack */
+    uint32_t pending;           /* number of parts which are queued */
+    _Bool is_json;
+    _Bool is_part;              /* a part is written while packing an item */
+    uv_timer_t * timer;
+} query__stream_t;
+
+static void query__stream_step(query__stream_t * s);
+static void query__response_done(ti_query_t * query, ex_t * e, int rc);
+
+static inline void query__result_size(size_t size)
+{
+    if (size > ti.counters->largest_result_size)
+        ti.counters->largest_result_size = size;
+}
+
+static inline int query__pack_val(
         ti_query_t * query,
-        msgpack_sbuffer * buffer,
+        ti_val_t * val,
+        ti_vp_t * vp,
         ex_t * e)
 {
-    ti_vp_t vp = {
-            .query=query
-    };
-    msgpack_packer_init(&vp.pk, buffer, msgpack_sbuffer_write);
+    /* the packer data always starts with a MessagePack buffer */
+    msgpack_sbuffer * buffer = vp->pk.data;
 
     if (ti_val_to_client_pk(
-            query->rval,
-            &vp,
+            val,
+            vp,
             (int) query->qbind.deep,
             (int) query->flags & TI_FLAGS_NO_IDS))
     {
+        if (e->nr)
+            return e->nr;  /* error is set while writing a part */
+
         if (buffer->size > ti.cfg->result_size_limit)
             ex_set(e, EX_RESULT_TOO_LARGE,
                     "too much data to return; "
@@ -1116,32 +1173,386 @@ static inline int query__pack_response(
         else
             ex_set_mem(e);
 
-        msgpack_sbuffer_destroy(buffer);
         return e->nr;
     }
 
-    if (buffer->size > ti.counters->largest_result_size)
-        ti.counters->largest_result_size = buffer->size;
+    return 0;
+}
+
+static inline int query__pack_response(
+        ti_query_t * query,
+        ti_vp_t * vp,
+        ex_t * e)
+{
+    if (query__pack_val(query, query->rval, vp, e))
+        return e->nr;
 
+    query__result_size(((msgpack_sbuffer *) vp->pk.data)->size);
     return 0;
 }
 
+static inline msgpack_sbuffer * query__stream_buffer(query__stream_t * s)
+{
+    return s->is_json ? &s->writer.buffer : &s->buffer;
+}
+
+static void query__stream_written_cb(query__stream_t * s, int status)
+{
+    if (status && !s->e.nr)
+        ex_set(&s->e, EX_WRITE_UV, "stream write error: `%s`",
+                uv_strerror(status));
+
+    if (!--s->pending)
+        query__stream_step(s);
+}
+
+static void query__stream_timer_cb(uv_timer_t * timer)
+{
+    query__stream_step(timer->data);
+}
+
+/*
+ * Write the data in `buffer` as a part of a streamed response. The buffer
+ * is re-initialized for the next part.
+ */
+static int query__stream_part(query__stream_t * s, msgpack_sbuffer * buffer)
+{
+    int rc;
+    ti_query_t * query = s->query;
+    size_t queued = query->flags & TI_QUERY_FLAG_API
+            ? query->via.api_request->uvstream.write_queue_size
+            : ti_stream_queued(query->via.stream);
+
+    /*
+     * Data which cannot be written is queued; packing waits for the queue
+     * but a single large value might still be written in many parts so the
+     * result size limit applies.
+     */
+    if (queued > ti.cfg->result_size_limit)
+    {
+        ex_set(&s->e, EX_RESULT_TOO_LARGE,
+                "too much data to return; "
+                "the client is not reading the response fast enough");
+        return -1;
+    }
+
+    s->n += buffer->size - s->offset;
+
+    if (query->flags & TI_QUERY_FLAG_API)
+    {
+        rc = ti_api_write_chunk(
+                query->via.api_request,
+                buffer,
+                false,
+                (ti_write_direct_cb) query__stream_written_cb,
+                s);
+    }
+    else
+    {
+        ti_pkg_t * pkg = (ti_pkg_t *) buffer->data;
+        pkg_init(pkg,
+                query->pkg_id,
+                TI_PROTO_CLIENT_RES_DATA_PART,
+                buffer->size);
+
+        rc = ti_stream_write_pkg_direct(
+                query->via.stream,
+                pkg,
+                (ti_write_direct_cb) query__stream_written_cb,
+                s);
+    }
+
+    if (rc < 0)
+        return -1;
+
+    s->pending += rc;
+    s->is_part = true;
+
+    return mp_sbuffer_alloc_init(buffer, QUERY__STREAM_ALLOC, s->offset);
+}
+
+static int query__stream_write(void * data, const char * buf, size_t len)
+{
+    query__stream_t * s = data;
+    return -(
+        msgpack_sbuffer_write(&s->buffer, buf, len) ||
+        (s->buffer.size >= QUERY__STREAM_SZ &&
+         query__stream_part(s, &s->buffer))
+    );
+}
+
+static int query__stream_json_cb(mpjson_writer_t * w, query__stream_t * s)
+{
+    return query__stream_part(s, &w->buffer);
+}
+
+static void query__stream_destroy(query__stream_t * s)
+{
+    if (s->is_json)
+        mpjson_writer_destroy(&s->writer);
+    else
+        msgpack_sbuffer_destroy(&s->buffer);
+
+    vec_destroy(s->items, (vec_destroy_cb) ti_val_unsafe_drop);
+
+    if (s->timer)
+        uv_close((uv_handle_t *) s->timer, (uv_close_cb) free);
+
+    free(s);
+}
+
+/*
+ * Write the last part, or an error, and finish the query.
+ */
+static void query__stream_finish(query__stream_t * s)
+{
+    ti_query_t * query = s->query;
+    msgpack_sbuffer * buffer = query__stream_buffer(s);
+    ti_pkg_t * pkg;
+
+    if (!s->e.nr && s->is_json && mpjson_writer_done(&s->writer))
+        mpjson_writer_set_err(&s->writer, &s->e);
+
+    if (!s->e.nr)
+        query__result_size(s->n + buffer->size - s->offset);
+
+    if (query->flags & TI_QUERY_FLAG_API)
+    {
+        if (!s->e.nr && ti_api_write_chunk(
+                query->via.api_request,
+                buffer,
+                true,
+                NULL,
+                NULL))
+            ex_set_mem(&s->e);
+
+        if (s->e.nr)
+            (void) ti_api_close_with_err(query->via.api_request, &s->e);
+    }
+    else
+    {
+        if (s->e.nr)
+            pkg = ti_pkg_client_err(query->pkg_id, &s->e);
+        else
+        {
+            pkg = (ti_pkg_t *) buffer->data;
+            pkg_init(pkg,
+                    query->pkg_id,
+                    TI_PROTO_CLIENT_RES_DATA,
+                    buffer->size);
+            memset(buffer, 0, sizeof(msgpack_sbuffer));
+        }
+
+        if (!pkg || ti_stream_write_pkg(query->via.stream, pkg))
+        {
+            free(pkg);
+            log_critical(EX_MEMORY_S);
+        }
+    }
+
+    query__response_done(query, &s->e, s->e.nr ? -1 : 0);
+    query__stream_destroy(s);
+    --ti.streams_count;
+}
+
+/*
+ * Pack the next items until a part is written. Packing continues when all
+ * queued parts are written, or on the next loop iteration when nothing is
+ * queued. The response is finished when all items are packed, or on an
+ * error, as soon as no parts are queued.
+ */
+static void query__stream_step(query__stream_t * s)
+{
+    s->is_part = false;
+
+    while (!s->e.nr && s->items && s->idx < s->items->n)
+    {
+        ti_val_t * val = VEC_get(s->items, s->idx++);
+
+        if (query__pack_val(s->query, val, &s->vp, &s->e) || !s->is_part)
+            continue;
+
+        if (!s->pending &&
+            uv_timer_start(s->timer, query__stream_timer_cb, 0, 0))
+        {
+            ex_set_internal(&s->e);
+            break;
+        }
+        return;
+    }
+
+    if (!s->pending)
+        query__stream_finish(s);
+}
+
+/*
+ * Start a streamed response; the response is finished and the query is
+ * destroyed by query__stream_finish(). Returns -1 if the stream cannot be
+ * created, in which case `e` is set.
+ */
+static int query__stream_start(ti_query_t * query, ex_t * e)
+{
+    query__stream_t * s = calloc(1, sizeof(query__stream_t));
+    ti_val_t * rval = query->rval;
+    size_t offset = query->flags & TI_QUERY_FLAG_API
+            ? TI_API_CHUNK_PREFIX
+            : sizeof(ti_pkg_t);
+
+    if (!s)
+        goto fail0;
+
+    s->query = query;
+    s->offset = offset;
+    s->vp.query = query;
+    s->is_json = (
+        (query->flags & TI_QUERY_FLAG_API) &&
+        query->via.api_request->content_type == TI_API_CT_JSON
+    );
+
+    if (s->is_json)
+    {
+        if (mpjson_writer_init(
+                &s->writer,
+                &s->vp.pk,
+                QUERY__STREAM_ALLOC,
+                offset,
+                query->via.api_request->flags))
+            goto fail1;
+
+        s->writer.flush_cb = (mpjson_flush_cb) query__stream_json_cb;
+        s->writer.flush_arg = s;
+        s->writer.flush_sz = QUERY__STREAM_SZ;
+    }
+    else
+    {
+        if (mp_sbuffer_alloc_init(&s->buffer, QUERY__STREAM_ALLOC, offset))
+            goto fail1;
+
+        msgpack_packer_init(&s->vp.pk, s, query__stream_write);
+    }
+
+    s->timer = malloc(sizeof(uv_timer_t));
+    if (!s->timer)
+        goto fail2;
+
+    if (uv_timer_init(ti.loop, s->timer))
+    {
+        free(s->timer);
+        s->timer = NULL;
+        goto fail2;
+    }
+    s->timer->data = s;
+
+    /*
+     * The items of a list or tuple are copied since a list might change
+     * while the response is being written.
+     */
+    if (ti_val_is_array(rval))
+    {
+        vec_t * vec = ((ti_varr_t *) rval)->vec;
+
+        s->items = vec_dup(vec);
+        if (!s->items)
+            goto fail2;
+
+        for (vec_each(s->items, ti_val_t, val))
+            ti_incref(val);
+
+        if (msgpack_pack_array(&s->vp.pk, vec->n))
+            ex_set_mem(&s->e);
+    }
+    else
+        (void) query__pack_val(query, rval, &s->vp, &s->e);
+
+    /*
+     * Packing continues on next loop iterations; away mode must wait for
+     * the stream to finish since packing changes flags on things.
+     */
+    ++ti.streams_count;
+
+    query__stream_step(s);
+    return 0;
+
+fail2:
+    query__stream_destroy(s);
+    goto fail0;
+fail1:
+    free(s);
+fail0:
+    ex_set_mem(e);
+    return -1;
+}
+
+/*
+ * JSON is written directly while packing the value, without using an
+ * intermediate MessagePack buffer.
+ */
+static int query__response_json(ti_query_t * query, ex_t * e)
+{
+    ti_api_request_t * ar = query->via.api_request;
+    mpjson_writer_t writer;
+    char * data;
+    size_t size;
+    ti_vp_t vp = {
+            .query=query
+    };
+
+    if (mpjson_writer_init(
+            &writer,
+            &vp.pk,
+            ti_val_alloc_size(query->rval),
+            0,
+            ar->flags))
+    {
+        ex_set_mem(e);
+        goto response_err;
+    }
+
+    if (query__pack_response(query, &vp, e) || mpjson_writer_done(&writer))
+    {
+        /* errors from the JSON writer take precedence */
+        if (writer.stat)
+            mpjson_writer_set_err(&writer, e);
+        mpjson_writer_destroy(&writer);
+        goto response_err;
+    }
+
+    take_buffer(&writer.buffer, &data, &size);
+    mpjson_writer_destroy(&writer);
+
+    return ti_api_close_with_response(ar, data, size);
+
+response_err:
+    return -(ti_api_close_with_err(ar, e) || 1);
+}
+
 static int query__response_api(ti_query_t * query, ex_t * e)
 {
     ti_api_request_t * ar = query->via.api_request;
     msgpack_sbuffer buffer;
+    ti_vp_t vp = {
+            .query=query
+    };
 
     if (e->nr)
         goto response_err;
 
+    if (ar->content_type == TI_API_CT_JSON)
+        return query__response_json(query, e);
+
     if (mp_sbuffer_alloc_init(&buffer, ti_val_alloc_size(query->rval), 0))
     {
         ex_set_mem(e);
         goto response_err;
     }
 
-    if (query__pack_response(query, &buffer, e))
+    msgpack_packer_init(&vp.pk, &buffer, msgpack_sbuffer_write);
+
+    if (query__pack_response(query, &vp, e))
+    {
+        msgpack_sbuffer_destroy(&buffer);
         goto response_err;
+    }
 
     return ti_api_close_with_response(ar, buffer.data, buffer.size);
 
@@ -1153,6 +1564,9 @@ static int query__response_pkg(ti_query_t * query, ex_t * e)
 {
     ti_pkg_t * pkg;
     msgpack_sbuffer buffer;
+    ti_vp_t vp = {
+            .query=query
+    };
 
     if (e->nr)
         goto pkg_err;
@@ -1166,8 +1580,13 @@ static int query__response_pkg(ti_query_t * query, ex_t * e)
         goto pkg_err;
     }
 
-    if (query__pack_response(query, &buffer, e))
+    msgpack_packer_init(&vp.pk, &buffer, msgpack_sbuffer_write);
+
+    if (query__pack_response(query, &vp, e))
+    {
+        msgpack_sbuffer_destroy(&buffer);
         goto pkg_err;
+    }
 
     pkg = (ti_pkg_t *) buffer.data;
     pkg_init(pkg,
@@ -1194,14 +1613,31 @@ pkg_err:
 
 typedef int (*query__cb)(ti_query_t *, ex_t *);
 
+static inline _Bool query__is_stream(ti_query_t * query)
+{
+    return (query->flags & TI_QUERY_FLAG_API)
+            ? query->via.api_request->flags & TI_API_FLAG_STREAM
+            : query->flags & TI_QUERY_FLAG_STREAM;
+}
+
 void ti_query_send_response(ti_query_t * query, ex_t * e)
 {
-    double duration, warn = ti.cfg->query_duration_warn;
     query__cb cb = query->flags & TI_QUERY_FLAG_API
             ? query__response_api
             : query__response_pkg;
 
-    if (cb(query, e))
+    /* a streamed response finishes the query when it is written */
+    if (!e->nr && query__is_stream(query) && !query__stream_start(query, e))
+        return;
+
+    query__response_done(query, e, cb(query, e));
+}
+
+static void query__response_done(ti_query_t * query, ex_t * e, int rc)
+{
+    double duration, warn = ti.cfg->query_duration_warn;
+
+    if (rc)
     {
         switch((ti_query_with_enum) query->with_tp)
         {
@@ -1271,10 +1707,8 @@ void ti_query_done(ti_query_t * query, ex_t * e, ti_query_done_cb cb)
 
 ti_prop_t * ti_query_var_get(ti_query_t * query, ti_name_t * name)
 {
-    for (vec_each_rev(query->vars, ti_prop_t, prop))
-        if (prop->name == name)
-            return prop;
-    return NULL;
+    int64_t idx = ti_query_var_idx(query, name);
+    return idx < 0 ? NULL : VEC_get(query->vars, idx);
 }
 
 ti_thing_t * ti_query_thing_from_id(
@@ -1369,6 +1803,7 @@ ssize_t ti_query_count_type(ti_query_t * query, ti_type_t * type)
     if (ti_type_is_wrap_only(type))
         return 0;
 
+    /* things without an id are only found using the variable */
     if (ti_query_vars_walk(
             query->vars,
             query->collection,
@@ -1376,6 +1811,9 @@ ssize_t ti_query_count_type(ti_query_t * query, ti_type_t * type)
             &c))
         return -1;
 
+    if (ti_type_instances_create(type) == 0)
+        return c.n + type->instances->n;
+
     (void) imap_walk(query->collection->things, (imap_cb) query__count, &c);
     (void) ti_gc_walk(query->collection->gc, (queue_cb) query__count, &c);
 
@@ -1558,6 +1996,24 @@ static int query__spec_cb(ti_thing_t * thing, query__thing_spec_cb_t * w)
     return 0;
 }
 
+static int query__spec_walk(query__thing_spec_cb_t * w)
+{
+    ti_collection_t * collection = w->thing->collection;
+
+    for (vec_each(w->fields_to_check, ti_field_t, field))
+        if (ti_type_instances_create(field->type))
+            return (
+                imap_walk(collection->things, (imap_cb) query__spec_cb, w) ||
+                ti_gc_walk(collection->gc, (queue_cb) query__spec_cb, w));
+
+    /* only the instances of the types with a matching field are checked */
+    for (vec_each(w->fields_to_check, ti_field_t, field))
+        if (imap_walk(field->type->instances, (imap_cb) query__spec_cb, w))
+            return -1;
+
+    return 0;
+}
+
 static int query__type_spec_cp(ti_type_t * type, query__thing_spec_cb_t * w)
 {
     for (vec_each(type->fields, ti_field_t, field))
@@ -1590,8 +2046,7 @@ _Bool ti_query_thing_can_change_spec(ti_query_t * query, ti_thing_t * thing)
         rc = (
             ti_query_vars_walk(
                     query->vars, collection, (imap_cb) query__spec_cb, &w) ||
-            imap_walk(collection->things, (imap_cb) query__spec_cb, &w) ||
-            ti_gc_walk(collection->gc, (queue_cb) query__spec_cb, &w));
+            query__spec_walk(&w));
 
     free(w.fields_to_check);
     return rc == 0;
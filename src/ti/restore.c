@@ -336,6 +336,8 @@ static void restore__master_cb(uv_timer_t * UNUSED(timer))
 
     restore__after_changes();
 
+    (void) ti_store_load_start();
+
     /* write global status (write loaded status) */
     (void) ti_nodes_write_global_status();
 }
@@ -3,6 +3,8 @@
  */
 #include <ti.h>
 #include <ti/collection.inline.h>
+#include <ti/interest.h>
+#include <ti/nodes.h>
 #include <ti/pkg.t.h>
 #include <ti/proto.t.h>
 #include <ti/room.h>
@@ -180,7 +182,7 @@ int ti_room_emit(
     if (!client_pkg || !node_rpkg || !client_rpkg)
         goto fail_pkg;
 
-    ti_nodes_write_rpkg(node_rpkg);
+    ti_nodes_write_room_rpkg(node_rpkg, room->collection->id, room->id);
     ti_rpkg_drop(node_rpkg);
 
     room__write_rpkg(room, client_rpkg);
@@ -429,6 +431,9 @@ void ti_room_destroy(ti_room_t * room)
          */
         room__emit_delete(room);
 
+    if (ti_room_has_listeners(room))
+        ti_interest_changed();
+
     vec_destroy(room->listeners, (vec_destroy_cb) ti_watch_drop);
 
     if (room->id)
@@ -442,7 +447,12 @@ int ti_room_gen_id(ti_room_t * room)
     assert(!room->id);
 
     room->id = ti_collection_next_free_id(room->collection);
-    return ti_room_to_map(room);
+    if (ti_room_to_map(room))
+        return -1;
+
+    if (ti_room_has_listeners(room))
+        ti_interest_add(room);
+    return 0;
 }
 
 int ti_room_join(ti_room_t * room, ti_stream_t * stream)
@@ -474,8 +484,10 @@ finish:
         goto failed;
 
     if (room->id)
+    {
+        ti_interest_add(room);
         room__async_emit_join(room, stream);
-
+    }
     return 0;
 
 failed:
@@ -495,6 +507,7 @@ int ti_room_leave(ti_room_t * room, ti_stream_t * stream)
             watch->stream = NULL;
             vec_swap_remove(room->listeners, idx);
             room__emit_leave(room, stream);
+            ti_interest_changed();
             return 0;
         }
     }
@@ -318,12 +318,23 @@ ti_collection_t * ti_scope_get_collection(ti_scope_t * scope, ex_t * e)
         collection = ti_collections_get_by_strn(
                 scope->via.collection_name.name,
                 scope->via.collection_name.sz);
-        if (!collection)
+        if (collection)
+            return collection;
+
+        if (ti_collections_is_busy_strn(
+                scope->via.collection_name.name,
+                scope->via.collection_name.sz))
+            ex_set(e, EX_NODE_ERROR,
+                "collection `%.*s` is not loaded and cannot be loaded while "
+                "the node is in away mode; try again later",
+                scope->via.collection_name.sz,
+                scope->via.collection_name.name);
+        else
             ex_set(e, EX_LOOKUP_ERROR, "collection `%.*s` not found",
                 scope->via.collection_name.sz,
                 scope->via.collection_name.name);
 
-        return collection;
+        return NULL;
     }
     assert(0);
     return NULL;
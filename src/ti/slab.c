@@ -0,0 +1,54 @@
+/*
+ * ti/slab.c
+ */
+#include <ti/slab.h>
+#include <util/mpack.h>
+
+#ifdef TI_WITH_SLAB
+
+slab_t ti_slabs[TI_SLAB_N] = {
+    SLAB_INIT(16),
+    SLAB_INIT(32),
+    SLAB_INIT(48),
+};
+
+void ti_slab_destroy(void)
+{
+    for (size_t i = 0; i < TI_SLAB_N; ++i)
+        slab_destroy(&ti_slabs[i]);
+}
+
+int ti_slab_to_pk(msgpack_packer * pk)
+{
+    if (msgpack_pack_array(pk, TI_SLAB_N))
+        return -1;
+
+    for (size_t i = 0; i < TI_SLAB_N; ++i)
+    {
+        slab_t * slab = &ti_slabs[i];
+        if (msgpack_pack_map(pk, 4) ||
+            mp_pack_str(pk, "size") ||
+            msgpack_pack_uint64(pk, slab->sz) ||
+            mp_pack_str(pk, "chunks") ||
+            msgpack_pack_uint64(pk, slab->n_chunks) ||
+            mp_pack_str(pk, "total") ||
+            msgpack_pack_uint64(pk, slab->n_total) ||
+            mp_pack_str(pk, "used") ||
+            msgpack_pack_uint64(pk, slab->n_used))
+            return -1;
+    }
+    return 0;
+}
+
+#else
+
+void ti_slab_destroy(void)
+{
+}
+
+int ti_slab_to_pk(msgpack_packer * pk)
+{
+    return msgpack_pack_nil(pk);
+}
+
+#endif  /* TI_WITH_SLAB */
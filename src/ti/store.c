@@ -2,8 +2,12 @@
  * ti/store.c
  */
 #include <assert.h>
+#include <fcntl.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <uv.h>
 #include <ti.h>
+#include <ti/away.h>
 #include <ti/name.h>
 #include <ti/store.h>
 #include <ti/store/storeaccess.h>
@@ -19,6 +23,7 @@
 #include <ti/store/storethings.h>
 #include <ti/store/storetypes.h>
 #include <ti/store/storeusers.h>
+#include <ti/tasks.h>
 #include <ti/things.h>
 #include <util/fx.h>
 #include <util/imap.h>
@@ -43,6 +48,34 @@ static const char * store__modules_fn           = "modules.mp";
 static ti_store_t * store;
 static ti_store_t store_;
 
+#define STORE__MAX_THREADS 64
+#define STORE__LOAD_INTERVAL 1000    /* load a collection every second */
+
+static uv_timer_t store__load_timer_;
+static uv_timer_t * store__load_timer = NULL;   /* NULL when not started */
+
+typedef struct
+{
+    uv_mutex_t lock;
+    uv_cond_t cond;
+    vec_t * collections;    /* ti_collection_t, without reference */
+    uint32_t next;          /* next collection to pick */
+    uint32_t done;          /* collections loaded by the main thread */
+    uint32_t ahead;         /* maximum prefetch distance */
+    uint32_t n;             /* number of threads */
+    uint32_t * n_linked;    /* unchanged collections, protected by lock */
+    int rc;                 /* set to -1 by the first failing thread */
+    uv_thread_t threads[STORE__MAX_THREADS];
+} store__pool_t;
+
+static _Bool store__has_unloaded(void)
+{
+    for (vec_each(ti.collections->vec, ti_collection_t, collection))
+        if (collection->flags & TI_COLLECTION_FLAG_UNLOADED)
+            return true;
+    return false;
+}
+
 static int store__thing_drop(ti_thing_t * thing, void * UNUSED(arg))
 {
     assert(thing->ref > 1);
@@ -85,6 +118,379 @@ static int store__collection_ids(void)
     return 0;
 }
 
+/*
+ * Hard link file `src` to `dst`, or copy the file when linking fails, for
+ * example when the file system does not support hard links.
+ */
+static inline int store__link_file(const char * src, const char * dst)
+{
+    return link(src, dst) && fx_copy(src, dst);
+}
+
+/*
+ * Link the files of an unchanged collection from the current store into the
+ * new (temporary) store. The `access` and `collection.dat` files are small
+ * and may change without a collection change, these must be written by the
+ * caller.
+ *
+ * Note: names are stored using their pointer address as key. When the
+ *       collection files are written by another process (they are restored
+ *       and not written since), the names of that process are linked as well,
+ *       either from the collection or from the restored store.
+ */
+static int store__link_collection(
+        ti_collection_t * collection,
+        ti_store_collection_t * store_collection)
+{
+    int rc = -1;
+    _Bool with_names = true;
+    char * names_fn = NULL;
+    ti_store_collection_t * prev_collection = ti_store_collection_create(
+            store->store_path,
+            &collection->guid);
+
+    if (!prev_collection)
+        return -1;
+
+    if (fx_file_exist(prev_collection->names_fn))
+        names_fn = strdup(prev_collection->names_fn);
+    else if (store->foreign_names)
+        names_fn = fx_path_join(store->store_path, store__names_fn);
+    else
+        with_names = false;
+
+    if ((with_names && !names_fn) ||
+            store__link_file(prev_collection->enums_fn,
+                             store_collection->enums_fn) ||
+            store__link_file(prev_collection->types_fn,
+                             store_collection->types_fn) ||
+            store__link_file(prev_collection->things_fn,
+                             store_collection->things_fn) ||
+            store__link_file(prev_collection->props_fn,
+                             store_collection->props_fn) ||
+            store__link_file(prev_collection->gcthings_fn,
+                             store_collection->gcthings_fn) ||
+            store__link_file(prev_collection->gcprops_fn,
+                             store_collection->gcprops_fn) ||
+            store__link_file(prev_collection->procedures_fn,
+                             store_collection->procedures_fn) ||
+            store__link_file(prev_collection->tasks_fn,
+                             store_collection->tasks_fn) ||
+            (with_names && store__link_file(
+                    names_fn,
+                    store_collection->names_fn)))
+    {
+        log_warning(
+                "cannot link files for collection `%.*s` (%s)",
+                collection->name->n, (char *) collection->name->data,
+                strerror(errno));
+
+        /* remove partial links */
+        (void) fx_rmdir(store_collection->collection_path);
+        if (mkdir(store_collection->collection_path, FX_DEFAULT_DIR_ACCESS))
+            log_errno_file("cannot create collection path",
+                    errno, store_collection->collection_path);
+        goto done;
+    }
+
+    log_debug(
+            "linked files for unchanged collection `%.*s`",
+            collection->name->n, (char *) collection->name->data);
+
+    rc = 0;
+done:
+    free(names_fn);
+    ti_store_collection_destroy(prev_collection);
+    return rc;
+}
+
+/*
+ * Write a single collection to the (temporary) store. Unchanged collections
+ * are linked from the previous store. A collection which is not loaded must
+ * be linked since the properties are not in memory. This function may run
+ * concurrently for different collections and must therefore not change any
+ * shared state.
+ */
+static int store__collection_store(
+        ti_collection_t * collection,
+        uint32_t * n_linked)
+{
+    int rc;
+    ti_store_collection_t * store_collection = ti_store_collection_create(
+            store->tmp_path,
+            &collection->guid);
+
+    if (!store_collection)
+        return -1;
+
+    (void) ti_sleep(2);
+
+    rc = mkdir(store_collection->collection_path, FX_DEFAULT_DIR_ACCESS);
+    if (rc)
+    {
+        log_errno_file("cannot create collection path",
+                errno, store_collection->collection_path);
+    }
+    else if (
+        !collection->dirty &&
+        store__link_collection(collection, store_collection) == 0)
+    {
+        ++(*n_linked);
+        rc = (
+            ti_store_access_store(
+                    collection->access,
+                    store_collection->access_fn) ||
+            ti_store_collection_store(
+                    collection,
+                    store_collection->collection_fn)
+        );
+    }
+    else if (collection->flags & TI_COLLECTION_FLAG_UNLOADED)
+    {
+        log_error(
+                "cannot store collection `%.*s` since the collection is "
+                "not loaded and the files cannot be linked",
+                collection->name->n, (char *) collection->name->data);
+        rc = -1;
+    }
+    else
+    {
+        rc = (
+            ti_store_enums_store(
+                    collection->enums,
+                    store_collection->enums_fn) ||
+            ti_store_types_store(
+                    collection->types,
+                    store_collection->types_fn) ||
+            ti_store_access_store(
+                    collection->access,
+                    store_collection->access_fn) ||
+            ti_store_things_store(
+                    collection->things,
+                    store_collection->things_fn) ||
+            ti_store_collection_store(
+                    collection,
+                    store_collection->collection_fn) ||
+            ti_store_things_store_data(
+                    collection->things,
+                    store_collection->props_fn) ||
+            ti_store_gcollect_store(
+                    collection->gc,
+                    store_collection->gcthings_fn) ||
+            ti_store_gcollect_store_data(
+                    collection->gc,
+                    store_collection->gcprops_fn) ||
+            ti_store_procedures_store(
+                    collection->procedures,
+                    store_collection->procedures_fn) ||
+            ti_store_tasks_store(
+                    collection->vtasks,
+                    store_collection->tasks_fn)
+        );
+    }
+    ti_store_collection_destroy(store_collection);
+    return rc;
+}
+
+/*
+ * Read all files of a collection so they are in the page cache before the
+ * main thread starts loading the collection.
+ */
+static void store__collection_prefetch(ti_collection_t * collection)
+{
+    char buf[65536];
+    ti_store_collection_t * store_collection = ti_store_collection_create(
+            store->store_path,
+            &collection->guid);
+    char * fns[11];
+
+    if (!store_collection)
+        return;
+
+    fns[0] = store_collection->enums_fn;
+    fns[1] = store_collection->types_fn;
+    fns[2] = store_collection->access_fn;
+    fns[3] = store_collection->things_fn;
+    fns[4] = store_collection->collection_fn;
+    fns[5] = store_collection->gcthings_fn;
+    fns[6] = store_collection->tasks_fn;
+    fns[7] = store_collection->props_fn;
+    fns[8] = store_collection->gcprops_fn;
+    fns[9] = store_collection->procedures_fn;
+    fns[10] = store_collection->names_fn;
+
+    for (size_t i = 0; i < sizeof(fns)/sizeof(char *); ++i)
+    {
+        int fd = open(fns[i], O_RDONLY);
+        if (fd < 0)
+            continue;
+        while (read(fd, buf, sizeof(buf)) > 0);
+        (void) close(fd);
+    }
+
+    ti_store_collection_destroy(store_collection);
+}
+
+static void store__store_worker(store__pool_t * pool)
+{
+    uint32_t n_linked = 0;
+    ti_collection_t * collection;
+
+    uv_mutex_lock(&pool->lock);
+    while (!pool->rc && pool->next < pool->collections->n)
+    {
+        collection = VEC_get(pool->collections, pool->next++);
+        uv_mutex_unlock(&pool->lock);
+
+        if (store__collection_store(collection, &n_linked))
+        {
+            uv_mutex_lock(&pool->lock);
+            pool->rc = -1;
+            break;
+        }
+        uv_mutex_lock(&pool->lock);
+    }
+    *pool->n_linked += n_linked;
+    uv_mutex_unlock(&pool->lock);
+}
+
+/*
+ * The prefetch workers stay at most `ahead` collections in front of the
+ * main thread which is loading the collections; see store__pool_done().
+ * The workers only read the files ahead; decoding stays on the main thread
+ * since names and values are shared between collections.
+ */
+static void store__prefetch_worker(store__pool_t * pool)
+{
+    ti_collection_t * collection;
+
+    uv_mutex_lock(&pool->lock);
+    while (!pool->rc && pool->next < pool->collections->n)
+    {
+        if (pool->next >= pool->done + pool->ahead)
+        {
+            uv_cond_wait(&pool->cond, &pool->lock);
+            continue;
+        }
+        collection = VEC_get(pool->collections, pool->next++);
+        uv_mutex_unlock(&pool->lock);
+
+        store__collection_prefetch(collection);
+
+        uv_mutex_lock(&pool->lock);
+    }
+    uv_mutex_unlock(&pool->lock);
+}
+
+static int store__pool_init(store__pool_t * pool, uint32_t * n_linked)
+{
+    uint32_t n = ti.collections->vec->n;
+
+    pool->collections = ti.collections->vec;
+    pool->next = 0;
+    pool->done = 0;
+    pool->rc = 0;
+    pool->n_linked = n_linked;
+    pool->n = ti.cfg->store_threads ? ti.cfg->store_threads : 1;
+
+    if (pool->n > STORE__MAX_THREADS)
+        pool->n = STORE__MAX_THREADS;
+
+    pool->ahead = pool->n;
+
+    if (pool->n > n)
+        pool->n = n;
+
+    if (uv_mutex_init(&pool->lock))
+        return -1;
+
+    if (uv_cond_init(&pool->cond))
+    {
+        uv_mutex_destroy(&pool->lock);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Called by the main thread when a collection is loaded; this allows the
+ * prefetch workers to continue with the next collection.
+ */
+static void store__pool_done(store__pool_t * pool)
+{
+    uv_mutex_lock(&pool->lock);
+    ++pool->done;
+    uv_cond_broadcast(&pool->cond);
+    uv_mutex_unlock(&pool->lock);
+}
+
+static void store__pool_stop(store__pool_t * pool)
+{
+    uv_mutex_lock(&pool->lock);
+    pool->rc = -1;
+    uv_cond_broadcast(&pool->cond);
+    uv_mutex_unlock(&pool->lock);
+}
+
+static void store__pool_destroy(store__pool_t * pool)
+{
+    uv_cond_destroy(&pool->cond);
+    uv_mutex_destroy(&pool->lock);
+}
+
+/*
+ * Start `n` threads. When starting a thread fails, the work will be done by
+ * the threads which are started. Returns the number of started threads.
+ */
+static uint32_t store__pool_start(store__pool_t * pool, uv_thread_cb cb)
+{
+    uint32_t i;
+    for (i = 0; i < pool->n; ++i)
+    {
+        if (uv_thread_create(&pool->threads[i], cb, pool))
+        {
+            log_warning("failed to start store thread %"PRIu32, i);
+            break;
+        }
+    }
+    return i;
+}
+
+static void store__pool_join(store__pool_t * pool, uint32_t n)
+{
+    while (n--)
+        (void) uv_thread_join(&pool->threads[n]);
+}
+
+/*
+ * Write all collections using the store thread pool.
+ */
+static int store__pool_store(uint32_t * n_linked)
+{
+    int rc;
+    uint32_t n;
+    store__pool_t pool;
+
+    *n_linked = 0;
+
+    if (store__pool_init(&pool, n_linked))
+        return -1;
+
+    n = pool.n > 1
+            ? store__pool_start(&pool, (uv_thread_cb) store__store_worker)
+            : 0;
+
+    /* when no threads are started, do the work in this thread */
+    if (!n)
+        store__store_worker(&pool);
+
+    store__pool_join(&pool, n);
+
+    rc = pool.rc;
+    store__pool_destroy(&pool);
+    return rc;
+}
+
 int ti_store_create(void)
 {
     char * storage_path = ti.cfg->storage_path;
@@ -119,6 +525,8 @@ int ti_store_create(void)
     store->modules_fn = fx_path_join(store->tmp_path, store__modules_fn);
     store->last_stored_change_id = 0;
     store->collection_ids = NULL;
+    store->namesmap = NULL;
+    store->foreign_names = false;
 
     if (    !store->prev_path ||
             !store->store_path ||
@@ -176,6 +584,8 @@ void ti_store_destroy(void)
     free(store->users_fn);
     free(store->modules_fn);
     vec_destroy(store->collection_ids, free);
+    if (store->namesmap)
+        imap_destroy(store->namesmap, (imap_destroy_cb) ti_name_unsafe_drop);
     ti.store = store = NULL;
 }
 
@@ -186,6 +596,7 @@ void ti_store_destroy(void)
 int ti_store_store(void)
 {
     int rc = 0;
+    uint32_t n_linked;
     assert(store);
 
     /* not need for checking on errors */
@@ -214,62 +625,8 @@ int ti_store_store(void)
             ti_store_modules_store(store->modules_fn))
         goto failed;
 
-    for (vec_each(ti.collections->vec, ti_collection_t, collection))
-    {
-        ti_store_collection_t * store_collection = ti_store_collection_create(
-                store->tmp_path,
-                &collection->guid);
-
-        if (!store_collection)
-            goto failed;
-
-        (void) ti_sleep(2);
-
-        rc = mkdir(store_collection->collection_path, FX_DEFAULT_DIR_ACCESS);
-        if (rc)
-        {
-            log_errno_file("cannot create collection path",
-                    errno, store_collection->collection_path);
-        }
-        else
-        {
-            rc = (
-                ti_store_enums_store(
-                        collection->enums,
-                        store_collection->enums_fn) ||
-                ti_store_types_store(
-                        collection->types,
-                        store_collection->types_fn) ||
-                ti_store_access_store(
-                        collection->access,
-                        store_collection->access_fn) ||
-                ti_store_things_store(
-                        collection->things,
-                        store_collection->things_fn) ||
-                ti_store_collection_store(
-                        collection,
-                        store_collection->collection_fn) ||
-                ti_store_things_store_data(
-                        collection->things,
-                        store_collection->props_fn) ||
-                ti_store_gcollect_store(
-                        collection->gc,
-                        store_collection->gcthings_fn) ||
-                ti_store_gcollect_store_data(
-                        collection->gc,
-                        store_collection->gcprops_fn) ||
-                ti_store_procedures_store(
-                        collection->procedures,
-                        store_collection->procedures_fn) ||
-                ti_store_tasks_store(
-                        collection->vtasks,
-                        store_collection->tasks_fn)
-            );
-        }
-        ti_store_collection_destroy(store_collection);
-        if (rc)
-            goto failed;
-    }
+    if (store__pool_store(&n_linked))
+        goto failed;
 
     (void) rename(store->store_path, store->prev_path);
     (void) ti_sleep(2);
@@ -289,8 +646,17 @@ int ti_store_store(void)
 
     store->last_stored_change_id = ti.node->ccid;
 
-    log_info("stored thingsdb until "TI_CHANGE_ID" to: `%s`",
-            store->last_stored_change_id, store->store_path);
+    /* all collections are now on disk, written by this process */
+    for (vec_each(ti.collections->vec, ti_collection_t, collection))
+        collection->dirty = false;
+
+    /* linked collections have their own names, see store__link_collection */
+    store->foreign_names = false;
+
+    log_info("stored thingsdb until "TI_CHANGE_ID" to: `%s` "
+            "(%"PRIu32" of %"PRIu32" collection(s) unchanged)",
+            store->last_stored_change_id, store->store_path,
+            n_linked, ti.collections->vec->n);
 
     rc = store__collection_ids();  /* can only fail with mem allow error */
 
@@ -310,6 +676,8 @@ int ti_store_restore(void)
 {
     int rc;
     imap_t * namesmap;
+    store__pool_t pool;
+    uint32_t n_prefetch = 0;
 
     assert(store);
 
@@ -349,8 +717,26 @@ int ti_store_restore(void)
     if (rc)
         goto stop;
 
+    /*
+     * Loading collections must be done by this thread since names and values
+     * are shared between collections. The pool is only used to read the
+     * collection files ahead so loading is not waiting for disk I/O.
+     * With `lazy_load`, the properties of things are not loaded here and
+     * the remaining files are too small to prefetch.
+     */
+    if (!ti.cfg->lazy_load &&
+        store__pool_init(&pool, NULL) == 0 &&
+        (n_prefetch = store__pool_start(
+                &pool,
+                (uv_thread_cb) store__prefetch_worker)) == 0)
+        store__pool_destroy(&pool);
+
+    /* the names are written by another process, see ti_store_store() */
+    store->foreign_names = true;
+
     for (vec_each(ti.collections->vec, ti_collection_t, collection))
     {
+        imap_t * names = namesmap, * cnamesmap = NULL;
         ti_store_collection_t * store_collection = ti_store_collection_create(
                 store->store_path,
                 &collection->guid);
@@ -374,13 +760,18 @@ int ti_store_restore(void)
                     store_collection->gcprops_fn);
         }
 
-        rc = (  -(!store_collection) ||
+        /* collections which are linked may have their own names */
+        if (store_collection && fx_file_exist(store_collection->names_fn))
+            names = cnamesmap = ti_store_names_restore(
+                    store_collection->names_fn);
+
+        rc = (  -(!store_collection || !names) ||
                 ti_store_enums_restore(
                         collection->enums,
                         store_collection->enums_fn) ||
                 ti_store_types_restore(
                         collection->types,
-                        namesmap,
+                        names,
                         store_collection->types_fn) ||
                 ti_store_access_restore(
                         &collection->access,
@@ -393,7 +784,7 @@ int ti_store_restore(void)
                         store_collection->collection_fn) ||
                 ti_store_enums_restore_members(
                         collection->enums,
-                        namesmap,
+                        names,
                         store_collection->enums_fn) ||
                 /*
                  * First load the things from the garbage collector; There
@@ -411,14 +802,15 @@ int ti_store_restore(void)
                         &collection->vtasks,
                         store_collection->tasks_fn,
                         collection) ||
-                ti_store_things_restore_data(
-                        collection,
-                        namesmap,
-                        store_collection->props_fn) ||
-                ti_store_gcollect_restore_data(
-                        collection,
-                        namesmap,
-                        store_collection->gcprops_fn) ||
+                (!ti.cfg->lazy_load && (
+                    ti_store_things_restore_data(
+                            collection,
+                            names,
+                            store_collection->props_fn) ||
+                    ti_store_gcollect_restore_data(
+                            collection,
+                            names,
+                            store_collection->gcprops_fn))) ||
                 ti_store_procedures_restore(
                         collection->procedures,
                         store_collection->procedures_fn,
@@ -427,10 +819,25 @@ int ti_store_restore(void)
 
         ti_store_collection_destroy(store_collection);
 
+        if (cnamesmap)
+            imap_destroy(cnamesmap, (imap_destroy_cb) ti_name_unsafe_drop);
+
         assert(collection->root);
 
         if (rc)
-            goto stop;
+            goto stop_pool;
+
+        /* the collection equals the store, the files can be linked */
+        collection->dirty = false;
+
+        if (n_prefetch)
+            store__pool_done(&pool);
+
+        if (ti.cfg->lazy_load)
+        {
+            collection->flags |= TI_COLLECTION_FLAG_UNLOADED;
+            continue;
+        }
 
         (void) imap_walk(
                 collection->things,
@@ -446,10 +853,179 @@ int ti_store_restore(void)
 
     rc = store__collection_ids();  /* can only fail with mem allow error */
 
+stop_pool:
+    if (n_prefetch)
+    {
+        store__pool_stop(&pool);
+        store__pool_join(&pool, n_prefetch);
+        store__pool_destroy(&pool);
+    }
+
 stop:
-    if (namesmap)
+    /*
+     * The scheduler heap might contain tasks of the collections which are
+     * replaced by this restore; the heap is re-build on the next callback.
+     */
+    ti_tasks_reschedule();
+
+    /* names of a previous restore are no longer used by any collection */
+    if (store->namesmap)
+    {
+        imap_destroy(store->namesmap, (imap_destroy_cb) ti_name_unsafe_drop);
+        store->namesmap = NULL;
+    }
+
+    if (namesmap && ti.cfg->lazy_load && ti.collections->vec->n)
+        store->namesmap = namesmap;
+    else if (namesmap)
         imap_destroy(namesmap, (imap_destroy_cb) ti_name_unsafe_drop);
 
     return rc;
 }
 
+/*
+ * Load the properties of a collection which is restored with `lazy_load`
+ * enabled; does nothing when the collection is already loaded. Returns 0 when
+ * successful or -1 in case of an error and logging is done.
+ *
+ * Must be called from the main thread and not while the away worker is
+ * running, since names and values are shared between collections.
+ */
+int ti_store_load_collection(ti_collection_t * collection)
+{
+    int rc;
+    struct timespec start, stop;
+    ti_store_collection_t * store_collection;
+    imap_t * names = store->namesmap, * cnamesmap = NULL;
+
+    if (~collection->flags & TI_COLLECTION_FLAG_UNLOADED)
+        return 0;
+
+    (void) clock_gettime(TI_CLOCK_MONOTONIC, &start);
+
+    store_collection = ti_store_collection_create(
+            store->store_path,
+            &collection->guid);
+
+    /* the collection has its own names when linked by a full store */
+    if (store_collection && fx_file_exist(store_collection->names_fn))
+        names = cnamesmap = ti_store_names_restore(store_collection->names_fn);
+
+    rc = (  -(!store_collection || !names) ||
+            ti_store_things_restore_data(
+                    collection,
+                    names,
+                    store_collection->props_fn) ||
+            ti_store_gcollect_restore_data(
+                    collection,
+                    names,
+                    store_collection->gcprops_fn)
+    );
+
+    ti_store_collection_destroy(store_collection);
+
+    if (cnamesmap)
+        imap_destroy(cnamesmap, (imap_destroy_cb) ti_name_unsafe_drop);
+
+    if (rc)
+    {
+        /*
+         * The collection keeps the UNLOADED flag so it will not be used and
+         * the store files of the collection will not be overwritten.
+         */
+        log_critical(
+                "failed to load collection `%.*s`",
+                collection->name->n, (char *) collection->name->data);
+        return rc;
+    }
+
+    collection->flags &= ~TI_COLLECTION_FLAG_UNLOADED;
+
+    (void) imap_walk(
+            collection->things,
+            (imap_cb) store__thing_drop,
+            NULL);
+
+    (void) clock_gettime(TI_CLOCK_MONOTONIC, &stop);
+
+    log_info(
+            "loaded collection `%.*s` with %zu thing(s) in %f seconds",
+            collection->name->n, (char *) collection->name->data,
+            collection->things->n, util_time_diff(&start, &stop));
+
+    /* the names are no longer required when all collections are loaded */
+    if (!store__has_unloaded())
+    {
+        imap_destroy(store->namesmap, (imap_destroy_cb) ti_name_unsafe_drop);
+        store->namesmap = NULL;
+    }
+    return 0;
+}
+
+static void store__load_close_cb(uv_handle_t * UNUSED(handle))
+{
+    store__load_timer = NULL;
+}
+
+/*
+ * Collections are loaded as a whole, since the properties of a thing may be
+ * used anywhere without a check. To bound the time a collection is waiting
+ * for its first use, the node loads the collections which are not used yet
+ * in the background, one collection each interval while the node is ready.
+ */
+static void store__load_cb(uv_timer_t * UNUSED(timer))
+{
+    if (!ti.node ||
+        ti.node->status != TI_NODE_STAT_READY ||
+        ti_away_is_working())
+        return;  /* try again on the next interval */
+
+    for (vec_each(ti.collections->vec, ti_collection_t, collection))
+    {
+        if (~collection->flags & TI_COLLECTION_FLAG_UNLOADED)
+            continue;
+
+        if (ti_store_load_collection(collection) == 0)
+            return;  /* only one collection each interval */
+
+        break;  /* stop loading in the background, logging is done */
+    }
+
+    ti_store_load_stop();
+}
+
+/*
+ * Start loading the collections which are not loaded in the background; does
+ * nothing when all collections are loaded. Returns 0 when successful or -1 if
+ * the timer has failed to start. Collections are still loaded on first use.
+ */
+int ti_store_load_start(void)
+{
+    if (store__load_timer || !store__has_unloaded())
+        return 0;
+
+    if (uv_timer_init(ti.loop, &store__load_timer_))
+        return -1;
+
+    store__load_timer = &store__load_timer_;
+
+    if (uv_timer_start(
+            store__load_timer,
+            store__load_cb,
+            STORE__LOAD_INTERVAL,
+            STORE__LOAD_INTERVAL))
+    {
+        ti_store_load_stop();
+        return -1;
+    }
+    return 0;
+}
+
+void ti_store_load_stop(void)
+{
+    if (!store__load_timer || uv_is_closing((uv_handle_t *) store__load_timer))
+        return;
+
+    (void) uv_timer_stop(store__load_timer);
+    uv_close((uv_handle_t *) store__load_timer, store__load_close_cb);
+}
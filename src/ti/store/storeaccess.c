@@ -7,19 +7,20 @@
 #include <ti/store/storeaccess.h>
 #include <ti/users.h>
 #include <util/fx.h>
+#include <util/fz.h>
 #include <util/mpack.h>
 
 int ti_store_access_store(const vec_t * access, const char * fn)
 {
     msgpack_packer pk;
-    FILE * f = fopen(fn, "w");
+    fz_t * f = fz_open(fn, ti.cfg->store_compression);
     if (!f)
     {
         log_errno_file("cannot open file", errno, fn);
         return -1;
     }
 
-    msgpack_packer_init(&pk, f, msgpack_fbuffer_write);
+    msgpack_packer_init(&pk, f, fz_write);
 
     if (msgpack_pack_map(&pk, 1) ||
         mp_pack_str(&pk, "access") ||
@@ -39,7 +40,7 @@ int ti_store_access_store(const vec_t * access, const char * fn)
 fail:
     log_error("failed to write file: `%s`", fn);
 done:
-    if (fclose(f))
+    if (fz_close(f))
     {
         log_errno_file("cannot close file", errno, fn);
         return -1;
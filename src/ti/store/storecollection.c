@@ -18,6 +18,7 @@ static const char * collection___types_fn      = "types.mp";
 static const char * collection___enums_fn      = "enums.mp";
 static const char * collection___gcprops_fn    = "gcprops.mp";
 static const char * collection___gcthings_fn   = "gcthings.mp";
+static const char * collection___names_fn      = "names.mp";
 
 ti_store_collection_t * ti_store_collection_create(
         const char * path,
@@ -47,6 +48,7 @@ ti_store_collection_t * ti_store_collection_create(
     store_collection->enums_fn = fx_path_join(cpath, collection___enums_fn);
     store_collection->gcprops_fn = fx_path_join(cpath, collection___gcprops_fn);
     store_collection->gcthings_fn = fx_path_join(cpath, collection___gcthings_fn);
+    store_collection->names_fn = fx_path_join(cpath, collection___names_fn);
 
     if (    !store_collection->access_fn ||
             !store_collection->collection_fn ||
@@ -57,7 +59,8 @@ ti_store_collection_t * ti_store_collection_create(
             !store_collection->types_fn ||
             !store_collection->enums_fn ||
             !store_collection->gcprops_fn ||
-            !store_collection->gcthings_fn)
+            !store_collection->gcthings_fn ||
+            !store_collection->names_fn)
         goto fail1;
 
     return store_collection;
@@ -84,6 +87,7 @@ void ti_store_collection_destroy(ti_store_collection_t * store_collection)
     free(store_collection->enums_fn);
     free(store_collection->gcprops_fn);
     free(store_collection->gcthings_fn);
+    free(store_collection->names_fn);
     free(store_collection);
 }
 
@@ -293,3 +297,15 @@ char * ti_store_collection_gcthings_fn(
     free(cpath);
     return fn;
 }
+
+char * ti_store_collection_names_fn(
+        const char * path,
+        uint64_t collection_id)
+{
+    char * fn, * cpath = ti_store_collection_get_path(path, collection_id);
+    if (!cpath)
+        return NULL;
+    fn = fx_path_join(cpath, collection___names_fn);
+    free(cpath);
+    return fn;
+}
@@ -9,6 +9,7 @@
 #include <ti/raw.inline.h>
 #include <ti/store/storecollections.h>
 #include <util/fx.h>
+#include <util/fz.h>
 #include <util/mpack.h>
 #include <util/vec.h>
 
@@ -16,14 +17,14 @@ int ti_store_collections_store(const char * fn)
 {
     msgpack_packer pk;
     vec_t * vec = ti.collections->vec;
-    FILE * f = fopen(fn, "w");
+    fz_t * f = fz_open(fn, ti.cfg->store_compression);
     if (!f)
     {
         log_errno_file("cannot open file", errno, fn);
         return -1;
     }
 
-    msgpack_packer_init(&pk, f, msgpack_fbuffer_write);
+    msgpack_packer_init(&pk, f, fz_write);
 
     if (
         msgpack_pack_map(&pk, 1) ||
@@ -50,7 +51,7 @@ int ti_store_collections_store(const char * fn)
 fail:
     log_error("failed to write file: `%s`", fn);
 done:
-    if (fclose(f))
+    if (fz_close(f))
     {
         log_errno_file("cannot close file", errno, fn);
         return -1;
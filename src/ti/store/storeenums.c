@@ -13,6 +13,7 @@
 #include <ti/things.h>
 #include <ti/val.inline.h>
 #include <util/fx.h>
+#include <util/fz.h>
 #include <util/mpack.h>
 
 static int mkenum_cb(ti_enum_t * enum_, msgpack_packer * pk)
@@ -48,14 +49,14 @@ static int mkenum_cb(ti_enum_t * enum_, msgpack_packer * pk)
 int ti_store_enums_store(ti_enums_t * enums, const char * fn)
 {
     msgpack_packer pk;
-    FILE * f = fopen(fn, "w");
+    fz_t * f = fz_open(fn, ti.cfg->store_compression);
     if (!f)
     {
         log_errno_file("cannot open file", errno, fn);
         return -1;
     }
 
-    msgpack_packer_init(&pk, f, msgpack_fbuffer_write);
+    msgpack_packer_init(&pk, f, fz_write);
 
     if (msgpack_pack_map(&pk, 1) ||
         /* active enums */
@@ -69,7 +70,7 @@ int ti_store_enums_store(ti_enums_t * enums, const char * fn)
 fail:
     log_error("failed to write file: `%s`", fn);
 done:
-    if (fclose(f))
+    if (fz_close(f))
     {
         log_errno_file("cannot close file", errno, fn);
         return -1;
@@ -12,6 +12,7 @@
 #include <ti/types.inline.h>
 #include <ti/val.inline.h>
 #include <util/fx.h>
+#include <util/fz.h>
 #include <util/mpack.h>
 
 static int store__gcollect_cb(ti_gc_t * gc, msgpack_packer * pk)
@@ -27,14 +28,14 @@ static int store__gcollect_cb(ti_gc_t * gc, msgpack_packer * pk)
 int ti_store_gcollect_store(queue_t * queue, const char * fn)
 {
     msgpack_packer pk;
-    FILE * f = fopen(fn, "w");
+    fz_t * f = fz_open(fn, ti.cfg->store_compression);
     if (!f)
     {
         log_errno_file("cannot open file", errno, fn);
         return -1;
     }
 
-    msgpack_packer_init(&pk, f, msgpack_fbuffer_write);
+    msgpack_packer_init(&pk, f, fz_write);
 
     if (
         msgpack_pack_map(&pk, 1) ||
@@ -50,7 +51,7 @@ int ti_store_gcollect_store(queue_t * queue, const char * fn)
 fail:
     log_error("failed to write file: `%s`", fn);
 done:
-    if (fclose(f))
+    if (fz_close(f))
     {
         log_errno_file("cannot close file", errno, fn);
         return -1;
@@ -110,14 +111,14 @@ static int store__walk_data(ti_thing_t * thing, msgpack_packer * pk)
 int ti_store_gcollect_store_data(queue_t * queue, const char * fn)
 {
     msgpack_packer pk;
-    FILE * f = fopen(fn, "w");
+    fz_t * f = fz_open(fn, ti.cfg->store_compression);
     if (!f)
     {
         log_errno_file("cannot open file", errno, fn);
         return -1;
     }
 
-    msgpack_packer_init(&pk, f, msgpack_fbuffer_write);
+    msgpack_packer_init(&pk, f, fz_write);
 
     if (
         msgpack_pack_map(&pk, 1) ||
@@ -133,7 +134,7 @@ int ti_store_gcollect_store_data(queue_t * queue, const char * fn)
 fail:
     log_error("failed to write file: `%s`", fn);
 done:
-    if (fclose(f))
+    if (fz_close(f))
     {
         log_errno_file("cannot close file", errno, fn);
         return -1;
@@ -5,6 +5,7 @@
 #include <ti/names.h>
 #include <ti/store/storenames.h>
 #include <util/fx.h>
+#include <util/fz.h>
 #include <util/logger.h>
 #include <util/smap.h>
 #include <util/mpack.h>
@@ -14,14 +15,14 @@ static inline int names__write_cb(ti_name_t * name, msgpack_packer * pk);
 int ti_store_names_store(const char * fn)
 {
     msgpack_packer pk;
-    FILE * f = fopen(fn, "w");
+    fz_t * f = fz_open(fn, ti.cfg->store_compression);
     if (!f)
     {
         log_errno_file("cannot open file", errno, fn);
         return -1;
     }
 
-    msgpack_packer_init(&pk, f, msgpack_fbuffer_write);
+    msgpack_packer_init(&pk, f, fz_write);
 
     if (
         msgpack_pack_array(&pk, ti.names->n) ||
@@ -33,7 +34,7 @@ int ti_store_names_store(const char * fn)
 fail:
     log_error("failed to write file: `%s`", fn);
 done:
-    if (fclose(f))
+    if (fz_close(f))
     {
         log_errno_file("cannot close file", errno, fn);
         return -1;
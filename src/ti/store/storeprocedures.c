@@ -10,6 +10,7 @@
 #include <ti/store/storeprocedures.h>
 #include <ti/val.inline.h>
 #include <util/fx.h>
+#include <util/fz.h>
 #include <util/mpack.h>
 
 static int procedure__store_cb(ti_procedure_t * procedure, msgpack_packer * pk)
@@ -25,14 +26,14 @@ static int procedure__store_cb(ti_procedure_t * procedure, msgpack_packer * pk)
 int ti_store_procedures_store(smap_t * procedures, const char * fn)
 {
     msgpack_packer pk;
-    FILE * f = fopen(fn, "w");
+    fz_t * f = fz_open(fn, ti.cfg->store_compression);
     if (!f)
     {
         log_errno_file("cannot open file", errno, fn);
         return -1;
     }
 
-    msgpack_packer_init(&pk, f, msgpack_fbuffer_write);
+    msgpack_packer_init(&pk, f, fz_write);
 
     if (
         msgpack_pack_map(&pk, 1) ||
@@ -48,7 +49,7 @@ int ti_store_procedures_store(smap_t * procedures, const char * fn)
 fail:
     log_error("failed to write file: `%s`", fn);
 done:
-    if (fclose(f))
+    if (fz_close(f))
     {
         log_errno_file("cannot close file", errno, fn);
         return -1;
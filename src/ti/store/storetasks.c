@@ -11,19 +11,20 @@
 #include <ti/vtask.h>
 #include <ti/vtask.inline.h>
 #include <util/fx.h>
+#include <util/fz.h>
 #include <util/mpack.h>
 
 int ti_store_tasks_store(vec_t * vtasks, const char * fn)
 {
     msgpack_packer pk;
-    FILE * f = fopen(fn, "w");
+    fz_t * f = fz_open(fn, ti.cfg->store_compression);
     if (!f)
     {
         log_errno_file("cannot open file", errno, fn);
         return -1;
     }
 
-    msgpack_packer_init(&pk, f, msgpack_fbuffer_write);
+    msgpack_packer_init(&pk, f, fz_write);
 
     if (
         msgpack_pack_map(&pk, 1) ||
@@ -55,7 +56,7 @@ int ti_store_tasks_store(vec_t * vtasks, const char * fn)
 fail:
     log_error("failed to write file: `%s`", fn);
 done:
-    if (fclose(f))
+    if (fz_close(f))
     {
         log_errno_file("cannot close file", errno, fn);
         return -1;
@@ -155,7 +156,7 @@ int ti_store_tasks_restore(
 
         /* push the task to the list, use ti_tasks_append() to re-schedule
          * at startup, bug #248 */
-        (void) ti_tasks_append(vtasks, vtask);
+        (void) ti_tasks_append(vtasks, vtask, collection);
     }
 
     up.pt = keep;
@@ -11,6 +11,7 @@
 #include <ti/types.inline.h>
 #include <ti/val.inline.h>
 #include <util/fx.h>
+#include <util/fz.h>
 #include <util/mpack.h>
 
 /*
@@ -48,14 +49,14 @@ static int store__things_cb(ti_thing_t * thing, msgpack_packer * pk)
 int ti_store_things_store(imap_t * things, const char * fn)
 {
     msgpack_packer pk;
-    FILE * f = fopen(fn, "w");
+    fz_t * f = fz_open(fn, ti.cfg->store_compression);
     if (!f)
     {
         log_errno_file("cannot open file", errno, fn);
         return -1;
     }
 
-    msgpack_packer_init(&pk, f, msgpack_fbuffer_write);
+    msgpack_packer_init(&pk, f, fz_write);
 
     if (
         msgpack_pack_map(&pk, 1) ||
@@ -71,7 +72,7 @@ int ti_store_things_store(imap_t * things, const char * fn)
 fail:
     log_error("failed to write file: `%s`", fn);
 done:
-    if (fclose(f))
+    if (fz_close(f))
     {
         log_errno_file("cannot close file", errno, fn);
         return -1;
@@ -127,14 +128,14 @@ static int store__walk_data(ti_thing_t * thing, msgpack_packer * pk)
 int ti_store_things_store_data(imap_t * things, const char * fn)
 {
     msgpack_packer pk;
-    FILE * f = fopen(fn, "w");
+    fz_t * f = fz_open(fn, ti.cfg->store_compression);
     if (!f)
     {
         log_errno_file("cannot open file", errno, fn);
         return -1;
     }
 
-    msgpack_packer_init(&pk, f, msgpack_fbuffer_write);
+    msgpack_packer_init(&pk, f, fz_write);
 
     if (
         msgpack_pack_map(&pk, 1) ||
@@ -150,7 +151,7 @@ int ti_store_things_store_data(imap_t * things, const char * fn)
 fail:
     log_error("failed to write file: `%s`", fn);
 done:
-    if (fclose(f))
+    if (fz_close(f))
     {
         log_errno_file("cannot close file", errno, fn);
         return -1;
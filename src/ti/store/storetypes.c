@@ -15,6 +15,7 @@
 #include <ti/types.inline.h>
 #include <ti/val.inline.h>
 #include <util/fx.h>
+#include <util/fz.h>
 #include <util/mpack.h>
 
 static int rmtype_cb(
@@ -110,12 +111,31 @@ static int rltype_cb(ti_type_t * type, msgpack_packer * pk)
     return 0;
 }
 
+static int count_indexes_cb(ti_type_t * type, size_t * n)
+{
+    for (vec_each(type->fields, ti_field_t, field))
+        if (field->is_indexed)
+            (*n)++;
+    return 0;
+}
+
+static int ixtype_cb(ti_type_t * type, msgpack_packer * pk)
+{
+    for (vec_each(type->fields, ti_field_t, field))
+        if (field->is_indexed && (
+                msgpack_pack_array(pk, 2) ||
+                msgpack_pack_uint16(pk, type->type_id) ||
+                mp_pack_strn(pk, field->name->str, field->name->n)))
+            return -1;
+    return 0;
+}
+
 int ti_store_types_store(ti_types_t * types, const char * fn)
 {
     msgpack_packer pk;
     char namebuf[TI_NAME_MAX];
-    FILE * f = fopen(fn, "w");
-    size_t n = 0;
+    fz_t * f = fz_open(fn, ti.cfg->store_compression);
+    size_t n = 0, n_indexes = 0;
 
     if (!f)
     {
@@ -126,9 +146,12 @@ int ti_store_types_store(ti_types_t * types, const char * fn)
     /* count the number of relations */
     (void) imap_walk(types->imap, (imap_cb) count_relations_cb, &n);
 
-    msgpack_packer_init(&pk, f, msgpack_fbuffer_write);
+    /* count the number of indexes */
+    (void) imap_walk(types->imap, (imap_cb) count_indexes_cb, &n_indexes);
+
+    msgpack_packer_init(&pk, f, fz_write);
 
-    if (msgpack_pack_map(&pk, 3) ||
+    if (msgpack_pack_map(&pk, 4) ||
         /* removed types */
         mp_pack_str(&pk, "removed") ||
         msgpack_pack_map(&pk, types->removed->n) ||
@@ -140,7 +163,11 @@ int ti_store_types_store(ti_types_t * types, const char * fn)
         /* relations */
         mp_pack_str(&pk, "relations") ||
         msgpack_pack_array(&pk, n) ||
-        imap_walk(types->imap, (imap_cb) rltype_cb, &pk)
+        imap_walk(types->imap, (imap_cb) rltype_cb, &pk) ||
+        /* indexes */
+        mp_pack_str(&pk, "indexes") ||
+        msgpack_pack_array(&pk, n_indexes) ||
+        imap_walk(types->imap, (imap_cb) ixtype_cb, &pk)
     ) goto fail;
 
     log_debug("stored types to file: `%s`", fn);
@@ -148,7 +175,7 @@ int ti_store_types_store(ti_types_t * types, const char * fn)
 fail:
     log_error("failed to write file: `%s`", fn);
 done:
-    if (fclose(f))
+    if (fz_close(f))
     {
         log_errno_file("cannot close file", errno, fn);
         return -1;
@@ -166,6 +193,7 @@ int ti_store_types_restore(ti_types_t * types, imap_t * names, const char * fn)
     _Bool with_wrap_only = true;
     _Bool with_hide_id = true;
     _Bool with_relations = true;
+    _Bool with_indexes = true;
     fx_mmap_t fmap;
     ex_t e = {0};
     ti_name_t * name, * oname;
@@ -189,11 +217,12 @@ int ti_store_types_restore(ti_types_t * types, imap_t * names, const char * fn)
 
     mp_unp_init(&up, fmap.data, fmap.n);
 
-    if (mp_next(&up, &obj) != MP_MAP || (obj.via.sz != 2 && obj.via.sz != 3) ||
+    if (mp_next(&up, &obj) != MP_MAP || obj.via.sz < 2 || obj.via.sz > 4 ||
         mp_skip(&up) != MP_STR)
         goto fail1;
 
-    with_relations = obj.via.sz == 3;
+    with_relations = obj.via.sz >= 3;
+    with_indexes = obj.via.sz == 4;
 
     if (mp_next(&up, &obj) != MP_MAP)
         goto fail1;
@@ -461,6 +490,37 @@ int ti_store_types_restore(ti_types_t * types, imap_t * names, const char * fn)
         }
     }
 
+    if (with_indexes)
+    {
+        ti_field_t * field;
+
+        if (mp_skip(&up) != MP_STR ||
+            mp_next(&up, &obj) != MP_ARR
+        ) goto fail1;
+
+        for (i = obj.via.sz; i--;)
+        {
+            if (mp_next(&up, &obj) != MP_ARR || obj.via.sz != 2 ||
+                mp_next(&up, &mp_id) != MP_U64 ||
+                mp_next(&up, &mp_name) != MP_STR
+            ) goto fail1;
+
+            type = ti_types_by_id(types, mp_id.via.u64);
+            name = ti_names_weak_get_strn(
+                    mp_name.via.str.data,
+                    mp_name.via.str.n);
+
+            if (!type || !name)
+                goto fail1;
+
+            field = ti_field_by_name(type, name);
+            if (!field || !ti_field_is_indexable(field))
+                goto fail1;
+
+            field->is_indexed = true;
+        }
+    }
+
     rc = 0;
 
 fail1:
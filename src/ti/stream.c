@@ -6,6 +6,7 @@
 #include <string.h>
 #include <sys/socket.h>
 #include <ti.h>
+#include <ti/interest.h>
 #include <ti/pipe.h>
 #include <ti/req.h>
 #include <ti/stream.h>
@@ -111,6 +112,7 @@ void ti_stream_stop_listeners(ti_stream_t * stream)
 {
     if (!stream || !stream->listeners)
         return;
+    ti_interest_changed();
     vec_destroy(stream->listeners, (vec_destroy_cb) ti_watch_drop);
     stream->listeners = NULL;
 }
@@ -129,6 +131,15 @@ void ti_stream_set_node(ti_stream_t * stream, ti_node_t * node)
     stream->via.node = node;
     node->stream = stream;
 
+    /*
+     * A new connection starts without knowing the room interest and the
+     * capabilities of the node.
+     */
+    free(node->interest);
+    node->interest = NULL;
+    node->interest_version = 0;
+    node->caps = 0;
+
     ti_incref(node);
 }
 
@@ -311,6 +322,32 @@ int ti_stream_write_pkg(ti_stream_t * stream, ti_pkg_t * pkg)
     return ti_write(stream, pkg, NULL, stream__write_pkg_cb);
 }
 
+/*
+ * Like ti_stream_write_pkg() but, if possible, the package is written right
+ * away; see ti_write_direct() for the return value and when `cb` is called.
+ * WebSocket streams use the normal write and return 0.
+ */
+int ti_stream_write_pkg_direct(
+        ti_stream_t * stream,
+        ti_pkg_t * pkg,
+        ti_write_direct_cb cb,
+        void * arg)
+{
+    if (ti_stream_is_closed(stream))
+        return -1;
+
+    if (stream->tp == TI_STREAM_WS_IN_CLIENT)
+        return ti_stream_write_pkg(stream, pkg);
+
+    return ti_write_direct(
+            stream->with.uvstream,
+            (char *) pkg,
+            sizeof(ti_pkg_t) + pkg->n,
+            pkg,
+            cb,
+            arg);
+}
+
 /* increases with a new reference as long as required */
 int ti_stream_write_rpkg(ti_stream_t * stream, ti_rpkg_t * rpkg)
 {
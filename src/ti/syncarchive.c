@@ -4,6 +4,7 @@
 #include <assert.h>
 #include <ti.h>
 #include <ti/archfile.h>
+#include <ti/node.h>
 #include <ti/nodes.h>
 #include <ti/proto.h>
 #include <ti/req.h>
@@ -12,7 +13,10 @@
 #include <util/mpack.h>
 #include <util/syncpart.h>
 
-static ti_pkg_t * syncarchive__pkg(ti_archfile_t * archfile, off_t offset);
+static ti_pkg_t * syncarchive__pkg(
+        ti_stream_t * stream,
+        ti_archfile_t * archfile,
+        off_t offset);
 static void syncarchive__push_cb(ti_req_t * req, ex_enum status);
 static void syncarchive__done_cb(ti_req_t * req, ex_enum status);
 static int syncarchive__init(ti_stream_t * stream, ti_archfile_t * archfile);
@@ -60,19 +64,23 @@ ti_pkg_t * ti_syncarchive_on_part(ti_pkg_t * pkg, ex_t * e)
     msgpack_sbuffer buffer;
     mp_unp_t up;
     ti_pkg_t * resp;
-    mp_obj_t obj, mp_first, mp_last, mp_offset, mp_bin, mp_more;
+    mp_obj_t obj, mp_first, mp_last, mp_offset, mp_bin, mp_more, mp_z;
     off_t offset;
     uint64_t first, last;
     ti_archfile_t * archfile;
+    unsigned char * data, * raw = NULL;
+    size_t n;
 
     mp_unp_init(&up, pkg->data, pkg->n);
 
-    if (mp_next(&up, &obj) != MP_ARR || obj.via.sz != 5 ||
+    if (mp_next(&up, &obj) != MP_ARR ||
+        (obj.via.sz != 5 && obj.via.sz != 6) ||
         mp_next(&up, &mp_first) != MP_U64 ||
         mp_next(&up, &mp_last) != MP_U64 ||
         mp_next(&up, &mp_offset) != MP_I64 ||
         mp_next(&up, &mp_bin) != MP_BIN ||
-        mp_next(&up, &mp_more) != MP_BOOL)
+        mp_next(&up, &mp_more) != MP_BOOL ||
+        (obj.via.sz == 6 && mp_next(&up, &mp_z) != MP_BOOL))
     {
         ex_set(e, EX_BAD_DATA, "invalid multipart request (archive sync)");
         return NULL;
@@ -106,19 +114,22 @@ ti_pkg_t * ti_syncarchive_on_part(ti_pkg_t * pkg, ex_t * e)
         (void) vec_push(&archive->archfiles, archfile);
     }
 
-    rc = syncpart_write(
-            archfile->fn,
-            mp_bin.via.bin.data,
-            mp_bin.via.bin.n,
-            offset,
-            e);
+    data = (unsigned char *) mp_bin.via.bin.data;
+    n = mp_bin.via.bin.n;
+
+    if (obj.via.sz == 6 && mp_z.via.bool_ &&
+        !(data = raw = syncpart_decompress(data, &n, e)))
+        return NULL;
+
+    rc = syncpart_write(archfile->fn, data, n, offset, e);
+    free(raw);
 
     if (rc)
         return NULL;
 
     if (mp_more.via.bool_)
     {
-        offset += mp_bin.via.bin.n;
+        offset += n;
     }
     else
     {
@@ -146,9 +157,19 @@ ti_pkg_t * ti_syncarchive_on_part(ti_pkg_t * pkg, ex_t * e)
 }
 
 
-static ti_pkg_t * syncarchive__pkg(ti_archfile_t * archfile, off_t offset)
+/*
+ * Parts are compressed when the receiving node supports it; compressed parts
+ * have a sixth value which tells if the part is compressed.
+ */
+static ti_pkg_t * syncarchive__pkg(
+        ti_stream_t * stream,
+        ti_archfile_t * archfile,
+        off_t offset)
 {
-    int more;
+    int more, level = ti_node_has_cap(stream->via.node, TI_NODE_CAP_SYNC_Z)
+            ? SYNCPART_LEVEL
+            : 0;
+    _Bool is_compressed;
     ti_pkg_t * pkg;
     msgpack_packer pk;
     msgpack_sbuffer buffer;
@@ -157,17 +178,20 @@ static ti_pkg_t * syncarchive__pkg(ti_archfile_t * archfile, off_t offset)
         return NULL;
     msgpack_packer_init(&pk, &buffer, msgpack_sbuffer_write);
 
-    msgpack_pack_array(&pk, 5);
+    msgpack_pack_array(&pk, level ? 6 : 5);
     msgpack_pack_uint64(&pk, archfile->first);
     msgpack_pack_uint64(&pk, archfile->last);
     msgpack_pack_fix_int64(&pk, offset);
 
-    more = syncpart_to_pk(&pk, archfile->fn, offset);
+    more = syncpart_to_pk(&pk, archfile->fn, offset, level, &is_compressed);
     if (more < 0)
         goto failed;
 
     mp_pack_bool(&pk, (_Bool) more);
 
+    if (level)
+        mp_pack_bool(&pk, is_compressed);
+
     pkg = (ti_pkg_t *) buffer.data;
     pkg_init(pkg, 0, TI_PROTO_NODE_REQ_SYNCAPART, buffer.size);
 
@@ -230,7 +254,7 @@ static void syncarchive__push_cb(ti_req_t * req, ex_enum status)
             goto failed;
         }
 
-        next_pkg = syncarchive__pkg(archfile, offset);
+        next_pkg = syncarchive__pkg(req->stream, archfile, offset);
         if (!next_pkg)
         {
             log_error(
@@ -319,7 +343,7 @@ static void syncarchive__done_cb(ti_req_t * req, ex_enum status)
 
 static int syncarchive__init(ti_stream_t * stream, ti_archfile_t * archfile)
 {
-    ti_pkg_t * pkg = syncarchive__pkg(archfile, 0 /* offset */);
+    ti_pkg_t * pkg = syncarchive__pkg(stream, archfile, 0 /* offset */);
     if (!pkg)
         return -1;
 
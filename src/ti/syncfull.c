@@ -7,6 +7,7 @@
 #include <stdlib.h>
 #include <ti.h>
 #include <ti/collection.h>
+#include <ti/node.h>
 #include <ti/proto.h>
 #include <ti/req.h>
 #include <ti/store.h>
@@ -41,6 +42,7 @@ typedef enum
     SYNCFULL__COLLECTION_TASKS_FILE,
     SYNCFULL__COLLECTION_THINGS_FILE,
     SYNCFULL__COLLECTION_PROPS_FILE,
+    SYNCFULL__COLLECTION_NAMES_FILE,    /* optional, see ti_store_store() */
     /* end */
     SYNCFULL__COLLECTION_END,
 } syncfull__file_t;
@@ -89,6 +91,8 @@ static char * syncfull__get_fn(uint64_t scope_id, syncfull__file_t ft)
         return ti_store_collection_things_fn(path, scope_id);
     case SYNCFULL__COLLECTION_PROPS_FILE:
         return ti_store_collection_props_fn(path, scope_id);
+    case SYNCFULL__COLLECTION_NAMES_FILE:
+        return ti_store_collection_names_fn(path, scope_id);
     case SYNCFULL__COLLECTION_END:
         break;
     }
@@ -96,9 +100,26 @@ static char * syncfull__get_fn(uint64_t scope_id, syncfull__file_t ft)
     return NULL;
 }
 
+/*
+ * Collections only have a names file when the collection files are written by
+ * another process; the file is skipped when it does not exist.
+ */
+static _Bool syncfull__has_names(uint64_t scope_id)
+{
+    _Bool has_names;
+    char * fn = ti_store_collection_names_fn(ti.store->store_path, scope_id);
+    has_names = fn && fx_file_exist(fn);
+    free(fn);
+    return has_names;
+}
+
 static _Bool syncfull__next_file(uint64_t * scope_id, syncfull__file_t * ft)
 {
     (*ft)++;
+    if (*ft == SYNCFULL__COLLECTION_NAMES_FILE &&
+        !syncfull__has_names(*scope_id))
+        (*ft)++;
+
     if (*ft == SYNCFULL__COLLECTION_END)
         *ft = SYNCFULL__COLLECTION_DAT_FILE;
 
@@ -163,7 +184,12 @@ static void syncfull__done_cb(ti_req_t * req, ex_enum status)
     ti_req_destroy(req);
 }
 
+/*
+ * Parts are compressed when the receiving node supports it; compressed parts
+ * have a sixth value which tells if the part is compressed.
+ */
 static ti_pkg_t * syncfull__pkg(
+        ti_stream_t * stream,
         uint64_t scope_id,
         syncfull__file_t ft,
         off_t offset)
@@ -171,14 +197,27 @@ static ti_pkg_t * syncfull__pkg(
     ti_pkg_t * pkg;
     msgpack_packer pk;
     msgpack_sbuffer buffer;
-    int more;
+    int more, level = ti_node_has_cap(stream->via.node, TI_NODE_CAP_SYNC_Z)
+            ? SYNCPART_LEVEL
+            : 0;
+    _Bool is_compressed;
     char * fn;
 
     if (mp_sbuffer_alloc_init(&buffer, 64 + SYNCPART_SIZE, sizeof(ti_pkg_t)))
         return NULL;
     msgpack_packer_init(&pk, &buffer, msgpack_sbuffer_write);
 
-    msgpack_pack_array(&pk, 5);
+    if (ft == SYNCFULL__COLLECTION_NAMES_FILE &&
+        !ti_node_has_cap(stream->via.node, TI_NODE_CAP_SYNC_NAMES))
+    {
+        log_error(
+                "cannot synchronize collection names with `%s`; "
+                "the node must be upgraded",
+                ti_stream_name(stream));
+        goto failed;
+    }
+
+    msgpack_pack_array(&pk, level ? 6 : 5);
 
     msgpack_pack_uint64(&pk, scope_id);    /* scope */
     msgpack_pack_uint8(&pk, ft);           /* file type */
@@ -188,13 +227,16 @@ static ti_pkg_t * syncfull__pkg(
     if (!fn)
         goto failed;
 
-    more = syncpart_to_pk(&pk, fn, offset);
+    more = syncpart_to_pk(&pk, fn, offset, level, &is_compressed);
     free(fn);
     if (more < 0)
         goto failed;
 
     mp_pack_bool(&pk, (_Bool) more);
 
+    if (level)
+        mp_pack_bool(&pk, is_compressed);
+
     pkg = (ti_pkg_t *) buffer.data;
     pkg_init(pkg, 0, TI_PROTO_NODE_REQ_SYNCFPART, buffer.size);
 
@@ -264,7 +306,7 @@ static void syncfull__push_cb(ti_req_t * req, ex_enum status)
         goto done;
     }
 
-    next_pkg = syncfull__pkg(scope_id, ft, offset);
+    next_pkg = syncfull__pkg(req->stream, scope_id, ft, offset);
     if (!next_pkg)
     {
         log_error(
@@ -295,7 +337,7 @@ done:
 
 int ti_syncfull_start(ti_stream_t * stream)
 {
-    ti_pkg_t * pkg = syncfull__pkg(0, SYNCFULL__USERS_FILE, 0);
+    ti_pkg_t * pkg = syncfull__pkg(stream, 0, SYNCFULL__USERS_FILE, 0);
     if (!pkg)
         return -1;
 
@@ -317,27 +359,38 @@ ti_pkg_t * ti_syncfull_on_part(ti_pkg_t * pkg, ex_t * e)
     int rc;
     mp_unp_t up;
     ti_pkg_t * resp;
-    mp_obj_t obj, mp_scope, mp_ft, mp_offset, mp_bin, mp_more;
+    mp_obj_t obj, mp_scope, mp_ft, mp_offset, mp_bin, mp_more, mp_z;
     msgpack_packer pk;
     msgpack_sbuffer buffer;
     syncfull__file_t ft;
     off_t offset;
     uint64_t scope_id;
     char * fn;
+    unsigned char * data, * raw = NULL;
+    size_t n;
 
     mp_unp_init(&up, pkg->data, pkg->n);
 
-    if (mp_next(&up, &obj) != MP_ARR || obj.via.sz != 5 ||
+    if (mp_next(&up, &obj) != MP_ARR ||
+        (obj.via.sz != 5 && obj.via.sz != 6) ||
         mp_next(&up, &mp_scope) != MP_U64 ||
         mp_next(&up, &mp_ft) != MP_U64 ||
         mp_next(&up, &mp_offset) != MP_I64 ||
         mp_next(&up, &mp_bin) != MP_BIN ||
-        mp_next(&up, &mp_more) != MP_BOOL)
+        mp_next(&up, &mp_more) != MP_BOOL ||
+        (obj.via.sz == 6 && mp_next(&up, &mp_z) != MP_BOOL))
     {
         ex_set(e, EX_BAD_DATA, "invalid multipart request (full sync)");
         return NULL;
     }
 
+    data = (unsigned char *) mp_bin.via.bin.data;
+    n = mp_bin.via.bin.n;
+
+    if (obj.via.sz == 6 && mp_z.via.bool_ &&
+        !(data = raw = syncpart_decompress(data, &n, e)))
+        return NULL;
+
     scope_id = mp_scope.via.u64;
     ft = (syncfull__file_t) mp_ft.via.u64;
     offset = (off_t) mp_offset.via.i64;
@@ -364,11 +417,13 @@ ti_pkg_t * ti_syncfull_on_part(ti_pkg_t * pkg, ex_t * e)
     {
         ex_set(e, EX_BAD_DATA, "invalid file type %d for "TI_COLLECTION_ID,
                 ft, scope_id);
+        free(raw);
         return NULL;
     }
 
-    rc = syncpart_write(fn, mp_bin.via.bin.data, mp_bin.via.bin.n, offset, e);
+    rc = syncpart_write(fn, data, n, offset, e);
     free(fn);
+    free(raw);
     if (rc)
         return NULL;
 
@@ -382,7 +437,7 @@ ti_pkg_t * ti_syncfull_on_part(ti_pkg_t * pkg, ex_t * e)
     msgpack_pack_array(&pk, 3);
     msgpack_pack_uint64(&pk, mp_scope.via.u64);
     msgpack_pack_uint64(&pk, mp_ft.via.u64);
-    msgpack_pack_fix_int64(&pk, mp_more.via.bool_?offset+mp_bin.via.bin.n:0);
+    msgpack_pack_fix_int64(&pk, mp_more.via.bool_ ? offset + (off_t) n : 0);
 
     resp = (ti_pkg_t *) buffer.data;
     pkg_init(resp, pkg->id, TI_PROTO_NODE_RES_SYNCFPART, buffer.size);
@@ -2069,6 +2069,48 @@ fail_data:
     return -1;
 }
 
+int ti_task_add_mod_type_idx(ti_task_t * task, ti_field_t * field)
+{
+    size_t alloc = 64 + field->name->n;
+    ti_data_t * data;
+    msgpack_packer pk;
+    msgpack_sbuffer buffer;
+
+    if (mp_sbuffer_alloc_init(&buffer, alloc, sizeof(ti_data_t)))
+        return -1;
+    msgpack_packer_init(&pk, &buffer, msgpack_sbuffer_write);
+
+    msgpack_pack_array(&pk, 2);
+
+    msgpack_pack_uint8(&pk, TI_TASK_MOD_TYPE_IDX);
+    msgpack_pack_map(&pk, 4);
+
+    mp_pack_str(&pk, "type_id");
+    msgpack_pack_uint16(&pk, field->type->type_id);
+
+    mp_pack_str(&pk, "modified_at");
+    msgpack_pack_uint64(&pk, field->type->modified_at);
+
+    mp_pack_str(&pk, "name");
+    mp_pack_strn(&pk, field->name->str, field->name->n);
+
+    mp_pack_str(&pk, "index");
+    mp_pack_bool(&pk, field->is_indexed);
+
+    data = (ti_data_t *) buffer.data;
+    ti_data_init(data, buffer.size);
+
+    if (vec_push(&task->list, data))
+        goto fail_data;
+
+    task__upd_approx_sz(task, data);
+    return 0;
+
+fail_data:
+    free(data);
+    return -1;
+}
+
 
 int ti_task_add_del_node(ti_task_t * task, uint32_t node_id)
 {
@@ -14,14 +14,201 @@
 #include <ti/vtask.inline.h>
 #include <util/fx.h>
 
-/* Tasks will be checked every X seconds */
+/* Minimum time between two checks, in milliseconds */
 #define VTASKS__INTERVAL 1 * 1000
 
+/* Maximum time the timer will sleep, in milliseconds; protects against
+ * changes in the system clock */
+#define VTASKS__MAX_SLEEP 60 * 1000
+
 static ti_tasks_t * tasks;
 
 static void tasks__destroy(uv_handle_t * UNUSED(handle));
 static void tasks__cb(uv_timer_t * UNUSED(handle));
 
+static inline _Bool tasks__is_owner(ti_vtask_t * vtask)
+{
+    return vtask->id % ti.nodes->vec->n == ti.rel_id;
+}
+
+static void tasks__sched_up(uint32_t idx)
+{
+    ti_tasks_sched_t * sched = tasks->sched;
+    ti_tasks_sched_t entry = sched[idx];
+
+    while (idx)
+    {
+        uint32_t parent = (idx - 1) / 2;
+        if (sched[parent].at <= entry.at)
+            break;
+        sched[idx] = sched[parent];
+        idx = parent;
+    }
+    sched[idx] = entry;
+}
+
+static void tasks__sched_down(uint32_t idx)
+{
+    ti_tasks_sched_t * sched = tasks->sched;
+    ti_tasks_sched_t entry = sched[idx];
+    uint32_t n = tasks->sched_n;
+
+    while (1)
+    {
+        uint32_t child = idx * 2 + 1;
+        if (child >= n)
+            break;
+        if (child + 1 < n && sched[child + 1].at < sched[child].at)
+            ++child;
+        if (entry.at <= sched[child].at)
+            break;
+        sched[idx] = sched[child];
+        idx = child;
+    }
+    sched[idx] = entry;
+}
+
+/*
+ * An entry is valid when the task still exists and is still scheduled at
+ * the time the entry was made for.
+ */
+static inline _Bool tasks__sched_is_valid(ti_tasks_sched_t * entry)
+{
+    return entry->vtask->id && entry->vtask->run_at == entry->run_at;
+}
+
+/*
+ * Removes entries which are no longer valid, used before the heap grows.
+ */
+static void tasks__sched_compact(void)
+{
+    uint32_t i, n = 0;
+    ti_tasks_sched_t * sched = tasks->sched;
+
+    for (i = 0; i < tasks->sched_n; ++i)
+    {
+        if (tasks__sched_is_valid(sched + i))
+            sched[n++] = sched[i];
+        else
+            ti_vtask_unsafe_drop(sched[i].vtask);
+    }
+
+    tasks->sched_n = n;
+    for (i = n / 2; i--;)
+        tasks__sched_down(i);
+}
+
+static void tasks__sched_clear(void)
+{
+    while (tasks->sched_n)
+        ti_vtask_unsafe_drop(tasks->sched[--tasks->sched_n].vtask);
+}
+
+static void tasks__timer_set(uint64_t run_at)
+{
+    struct timespec ts;
+    uint64_t now_ms, delay;
+
+    (void) clock_gettime(CLOCK_REALTIME, &ts);
+    now_ms = (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+
+    delay = run_at > now_ms / 1000 ? run_at * 1000 - now_ms : 0;
+    if (delay > VTASKS__MAX_SLEEP)
+        delay = VTASKS__MAX_SLEEP;
+
+    tasks->timer_at = run_at;
+    (void) uv_timer_start(tasks->timer, tasks__cb, delay, 0);
+}
+
+static int tasks__sched_push(ti_vtask_t * vtask, uint64_t scope_id)
+{
+    if (tasks->do_reschedule)
+        return 0;  /* the heap will be re-build on the next callback */
+
+    if (tasks->sched_n == tasks->sched_sz)
+    {
+        ti_tasks_sched_t * tmp;
+        uint32_t sz;
+
+        tasks__sched_compact();
+        sz = tasks->sched_n * 2;
+
+        if (sz > tasks->sched_sz || tasks->sched_n == tasks->sched_sz)
+        {
+            sz = sz < 8 ? 8 : sz;
+            tmp = realloc(tasks->sched, sz * sizeof(ti_tasks_sched_t));
+            if (!tmp)
+                return -1;
+            tasks->sched = tmp;
+            tasks->sched_sz = sz;
+        }
+    }
+
+    tasks->sched[tasks->sched_n] = (ti_tasks_sched_t) {
+            .at = vtask->run_at,
+            .run_at = vtask->run_at,
+            .scope_id = scope_id,
+            .vtask = vtask,
+    };
+    ti_incref(vtask);
+    tasks__sched_up(tasks->sched_n++);
+    return 0;
+}
+
+/*
+ * Schedule a task owned by this node. This must be called each time the
+ * `run_at` value of a task is set.
+ */
+static void tasks__schedule(ti_vtask_t * vtask, ti_collection_t * collection)
+{
+    if (!vtask->run_at || !tasks__is_owner(vtask))
+        return;
+
+    if (tasks__sched_push(
+            vtask,
+            collection ? collection->id : TI_SCOPE_THINGSDB))
+    {
+        /* on allocation failure, fall back to a full rebuild */
+        log_error(EX_MEMORY_S);
+        ti_tasks_reschedule();
+        return;
+    }
+
+    if (tasks->is_started && (
+            !tasks->timer_at ||
+            vtask->run_at < tasks->timer_at))
+        tasks__timer_set(vtask->run_at);
+}
+
+/*
+ * Re-build the heap from all the tasks. This is required when the number of
+ * nodes has been changed as the tasks owned by this node have changed.
+ */
+static void tasks__sched_rebuild(void)
+{
+    tasks__sched_clear();
+    tasks->do_reschedule = false;
+
+    for (vec_each(tasks->vtasks, ti_vtask_t, vtask))
+        if (vtask->run_at &&
+            tasks__is_owner(vtask) &&
+            tasks__sched_push(vtask, TI_SCOPE_THINGSDB))
+            goto fail;
+
+    for (vec_each(ti.collections->vec, ti_collection_t, collection))
+        for (vec_each(collection->vtasks, ti_vtask_t, vtask))
+            if (vtask->run_at &&
+                tasks__is_owner(vtask) &&
+                tasks__sched_push(vtask, collection->id))
+                goto fail;
+    return;
+
+fail:
+    log_error(EX_MEMORY_S);
+    tasks__sched_clear();
+    tasks->do_reschedule = true;
+}
+
 int ti_tasks_create(void)
 {
     tasks = malloc(sizeof(ti_tasks_t));
@@ -30,7 +217,11 @@ int ti_tasks_create(void)
 
     tasks->is_stopping = false;
     tasks->is_started = false;
-    tasks->lowest_run_at = 0;
+    tasks->do_reschedule = true;
+    tasks->sched_n = 0;
+    tasks->sched_sz = 0;
+    tasks->timer_at = 0;
+    tasks->sched = NULL;
     tasks->timer = malloc(sizeof(uv_timer_t));
     tasks->vtasks = vec_new(4);
 
@@ -50,12 +241,15 @@ int ti_tasks_start(void)
 {
     assert(tasks->is_started == false);
 
+    tasks->do_reschedule = true;
+    tasks->timer_at = 0;
+
     if (uv_timer_init(ti.loop, tasks->timer) ||
         uv_timer_start(
             tasks->timer,
             tasks__cb,
             VTASKS__INTERVAL,       /* start at VTASKS__INTERVAL */
-            VTASKS__INTERVAL))      /* repeat at VTASKS__INTERVAL */
+            0))                     /* the timer re-arms itself */
         goto fail;
 
     tasks->is_started = true;
@@ -89,6 +283,8 @@ static void tasks__destroy(uv_handle_t * UNUSED(handle))
 {
     if (tasks)
     {
+        tasks__sched_clear();
+        free(tasks->sched);
         free(tasks->timer);
         vec_destroy(tasks->vtasks, (vec_destroy_cb) ti_vtask_drop);
     }
@@ -96,92 +292,128 @@ static void tasks__destroy(uv_handle_t * UNUSED(handle))
     tasks = ti.tasks = NULL;
 }
 
-static inline int tasks__handle_vtask(
-        ti_vtask_t * vtask,
-        ti_collection_t * collection,
-        const uint64_t now,
-        const uint32_t rel_id,
-        const uint32_t nodes_n)
-{
-    if (vtask->run_at &&
-        (vtask->id % nodes_n == rel_id) &&
-        (~vtask->flags & TI_VTASK_FLAG_RUNNING))
+/*
+ * Pops due tasks from the heap and runs them. Tasks which fail to start are
+ * pushed back and will be tried again after VTASKS__INTERVAL.
+ */
+static int tasks__run_due(const uint64_t now)
+{
+    ti_tasks_sched_t entry;
+    ti_collection_t * collection;
+    int n = 0;
+
+    while (tasks->sched_n && tasks->sched[0].at <= now)
     {
-        if (vtask->run_at <= now)
+        entry = tasks->sched[0];
+
+        if (!tasks__sched_is_valid(&entry) ||
+            (entry.vtask->flags & TI_VTASK_FLAG_RUNNING))
+            goto pop;
+
+        if (entry.scope_id == TI_SCOPE_THINGSDB)
+            collection = NULL;
+        else if (!(collection = ti_collections_get_by_id(entry.scope_id)))
         {
-            if (ti_vtask_run(vtask, collection) == 0)
-                return 1;
-            /* re-schedule on error */
+            if (!ti_collections_is_busy_id(entry.scope_id))
+                goto pop;  /* the collection is removed */
+
+            /* the collection cannot be loaded while in away mode */
+            goto again;
         }
 
-        /* update the next lowest run */
-        if (vtask->run_at < tasks->lowest_run_at)
-            tasks->lowest_run_at = vtask->run_at;
+        if (ti_vtask_run(entry.vtask, collection))
+            goto again;  /* re-schedule on error */
+
+        ++n;
+pop:
+        tasks->sched[0] = tasks->sched[--tasks->sched_n];
+        if (tasks->sched_n)
+            tasks__sched_down(0);
+        ti_vtask_unsafe_drop(entry.vtask);
+        continue;
+again:
+        tasks->sched[0].at = now + VTASKS__INTERVAL / 1000;
+        tasks__sched_down(0);
     }
-    return 0;
+    return n;
 }
 
 /*
- * Called from the main thread at CONNECT__INTERVAL (every X seconds)
+ * Called from the main thread when the earliest scheduled task is due, or
+ * at VTASKS__INTERVAL when this node is not ready to run tasks.
  */
 static void tasks__cb(uv_timer_t * UNUSED(handle))
 {
-    const uint64_t now = util_now_usec();
-    const uint32_t rel_id = ti.rel_id;
-    const uint32_t nodes_n = ti.nodes->vec->n;
-    int n = 0;
+    int n;
 
-    /* ThingsDB knows the first time-stamp it should handle, thus this call is
-     * usually very sort as it will return immediately. Only when required, it
-     * will loop through the tasks.
-     */
-    if (tasks->lowest_run_at > now || ti_restore_is_busy() || (
+    tasks->timer_at = 0;
+
+    if (ti_restore_is_busy() || (
         ti.node->status & (
             TI_NODE_STAT_AWAY|
             TI_NODE_STAT_AWAY_SOON|
             TI_NODE_STAT_READY)) == 0)
+    {
+        (void) uv_timer_start(tasks->timer, tasks__cb, VTASKS__INTERVAL, 0);
         return;
+    }
 
-    tasks->lowest_run_at = UINT64_MAX;
-
-    for (vec_each(tasks->vtasks, ti_vtask_t, vtask))
-        n += tasks__handle_vtask(vtask, NULL, now, rel_id, nodes_n);
-
-    for (vec_each(ti.collections->vec, ti_collection_t, collection))
-        for (vec_each(collection->vtasks, ti_vtask_t, vtask))
-            n += tasks__handle_vtask(vtask, collection, now, rel_id, nodes_n);
+    if (tasks->do_reschedule)
+        tasks__sched_rebuild();
 
+    n = tasks__run_due(util_now_usec());
     if (n)
         log_info("initiated %d task%s", n, n == 1 ? "": "s");
+
+    if (tasks->do_reschedule)
+        (void) uv_timer_start(tasks->timer, tasks__cb, VTASKS__INTERVAL, 0);
+    else if (tasks->sched_n)
+        tasks__timer_set(tasks->sched[0].at);
 }
 
-int ti_tasks_append(vec_t ** vtasks, ti_vtask_t * vtask)
+int ti_tasks_append(
+        vec_t ** vtasks,
+        ti_vtask_t * vtask,
+        ti_collection_t * collection)
 {
-    uint32_t rel_id = ti.rel_id;
-    uint32_t nodes_n = ti.nodes->vec->n;
-
     if (vec_push(vtasks, vtask))
         return -1;
 
-    if ((vtask->id % nodes_n == rel_id) &&
-        vtask->run_at < tasks->lowest_run_at)
-        tasks->lowest_run_at = vtask->run_at;
-
+    tasks__schedule(vtask, collection);
     return 0;
 }
 /*
  * Only for dropped collections.
+ *
+ * This function might run from the away worker and therefore does not touch
+ * the scheduler heap; use ti_tasks_del_collection() from the main thread.
  */
 void ti_tasks_clear_dropped(vec_t ** vtasks)
 {
     ti_vtask_t * vtask;
     while ((vtask = vec_pop(*vtasks)))
     {
+        vtask->run_at = 0;  /* invalidates the entry in the heap */
         ti_vtask_unsafe_drop(vtask);
     }
     vec_shrink(vtasks);
 }
 
+/*
+ * Must be called from the main thread when a collection is removed.
+ *
+ * The scheduler heap holds a reference to scheduled tasks; these entries must
+ * be removed right away since the closure and arguments of a task refer to
+ * things and names of the collection which is about to be destroyed.
+ */
+void ti_tasks_del_collection(ti_collection_t * collection)
+{
+    ti_tasks_clear_dropped(&collection->vtasks);
+
+    if (tasks)
+        tasks__sched_compact();
+}
+
 void ti_tasks_del_user(ti_user_t * user)
 {
     for (vec_each_rev(tasks->vtasks, ti_vtask_t, vtask))
@@ -230,22 +462,24 @@ vec_t * ti_tasks_from_scope_id(uint64_t scope_id)
     return NULL;
 }
 
-void ti_tasks_reset_lowest_run_at(void)
+/*
+ * Must be called when the number of nodes or the relative Id of this node is
+ * changed; the heap will be re-build on the next callback.
+ */
+void ti_tasks_reschedule(void)
 {
-    tasks->lowest_run_at = 0;  /* forces a one time loop */
-}
+    tasks__sched_clear();
+    tasks->do_reschedule = true;
 
-void ti_tasks_vtask_finish(ti_vtask_t * vtask)
-{
-    if (vtask->run_at)
+    if (tasks->is_started)
     {
-        uint32_t rel_id = ti.rel_id;
-        uint32_t nodes_n = ti.nodes->vec->n;
-
-        if ((vtask->id % nodes_n == rel_id) &&
-            vtask->run_at < tasks->lowest_run_at)
-            tasks->lowest_run_at = vtask->run_at;
+        tasks->timer_at = 0;
+        (void) uv_timer_start(tasks->timer, tasks__cb, 0, 0);
     }
-    vtask->flags &= ~(TI_VTASK_FLAG_RUNNING|TI_VTASK_FLAG_AGAIN);
 }
 
+void ti_tasks_vtask_finish(ti_vtask_t * vtask, ti_collection_t * collection)
+{
+    vtask->flags &= ~(TI_VTASK_FLAG_RUNNING|TI_VTASK_FLAG_AGAIN);
+    tasks__schedule(vtask, collection);
+}
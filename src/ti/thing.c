@@ -30,6 +30,8 @@
 #include <util/logger.h>
 #include <util/mpack.h>
 
+TI_SLAB_ASSERT(ti_thing_t, 48);
+
 static vec_t * thing__gc_swp;
 vec_t * ti_thing_gc_vec;
 
@@ -39,7 +41,7 @@ ti_thing_t * ti_thing_o_create(
         size_t init_sz,
         ti_collection_t * collection)
 {
-    ti_thing_t * thing = malloc(sizeof(ti_thing_t));
+    ti_thing_t * thing = ti_slab_alloc(sizeof(ti_thing_t));
     if (!thing)
         return NULL;
 
@@ -63,7 +65,7 @@ ti_thing_t * ti_thing_o_create(
 
 ti_thing_t * ti_thing_i_create(uint64_t id, ti_collection_t * collection)
 {
-    ti_thing_t * thing = malloc(sizeof(ti_thing_t));
+    ti_thing_t * thing = ti_slab_alloc(sizeof(ti_thing_t));
     if (!thing)
         return NULL;
 
@@ -90,7 +92,7 @@ ti_thing_t * ti_thing_t_create(
         ti_type_t * type,
         ti_collection_t * collection)
 {
-    ti_thing_t * thing = malloc(sizeof(ti_thing_t));
+    ti_thing_t * thing = ti_slab_alloc(sizeof(ti_thing_t));
     if (!thing)
         return NULL;
 
@@ -109,6 +111,9 @@ ti_thing_t * ti_thing_t_create(
         ti_thing_destroy(thing);
         return NULL;
     }
+
+    if (id)
+        ti_type_instances_add(type, thing);
     return thing;
 }
 
@@ -175,6 +180,12 @@ void ti_thing_destroy(ti_thing_t * thing)
             return;
 
         (void) imap_pop(thing->collection->things, thing->id);
+
+        if (!ti_thing_is_object(thing))
+        {
+            ti_type_instances_del(thing->via.type, thing);
+            ti_type_indexes_del(thing->via.type, thing);
+        }
         /*
          * It is not possible that the thing exist in garbage collection
          * since the garbage collector hold a reference to the thing and
@@ -198,7 +209,7 @@ void ti_thing_destroy(ti_thing_t * thing)
                 ? (vec_destroy_cb) ti_prop_unassign_destroy
                 : (vec_destroy_cb) ti_val_unassign_drop);
 
-    free(thing);
+    ti_slab_free(thing, sizeof(ti_thing_t));
 }
 
 void ti_thing_clear(ti_thing_t * thing)
@@ -216,6 +227,12 @@ void ti_thing_clear(ti_thing_t * thing)
     }
     else
     {
+        if (thing->id)
+        {
+            ti_type_instances_del(thing->via.type, thing);
+            ti_type_indexes_del(thing->via.type, thing);
+        }
+
         vec_clear_cb(
                 thing->items.vec,
                 (vec_destroy_cb) ti_val_unassign_unsafe_drop);
@@ -390,7 +407,7 @@ ti_prop_t * ti_thing_p_prop_add(
     ti_prop_t * prop = ti_prop_create(name, val);
     if (!prop || vec_push(&thing->items.vec, prop))
     {
-        free(prop);
+        ti_prop_free(prop);
         return NULL;
     }
     return prop;
@@ -466,7 +483,7 @@ int ti_thing_p_prop_add_assign(
     if (!prop || vec_push(&thing->items.vec, prop))
     {
         ti_val_unsafe_drop(val);
-        free(prop);
+        ti_prop_free(prop);
         ex_set_mem(e);
         return e->nr;
     }
@@ -608,7 +625,7 @@ static int thing_p__prop_set_e(
     prop = ti_prop_create(name, val);
     if (!prop || vec_push(&thing->items.vec, prop))
     {
-        free(prop);
+        ti_prop_free(prop);
         ex_set_mem(e);
     }
 
@@ -673,7 +690,7 @@ ti_prop_t * ti_thing_p_prop_set(
 
     prop = ti_prop_create(name, val);
     if (!prop || vec_push(&thing->items.vec, prop))
-        return free(prop), NULL;
+        return ti_prop_free(prop), NULL;
 
     return prop;
 }
@@ -722,6 +739,7 @@ void ti_thing_t_prop_set(
     ti_val_t ** vaddr = (ti_val_t **) vec_get_addr(
             thing->items.vec,
             field->idx);
+    ti_field_index_replace(field, thing, *vaddr, val);
     ti_val_replace_drop(*vaddr, val);
     *vaddr = val;
 }
@@ -868,6 +886,7 @@ int ti_thing_t_set_val_from_strn(
         ti_field_make_assignable(field, val, thing, e))
         return e->nr;
 
+    ti_field_index_replace(field, thing, *vaddr, *val);
     ti_val_replace_drop(*vaddr, *val);
     *vaddr = *val;
 
@@ -1174,6 +1193,12 @@ int ti_thing_gen_id(ti_thing_t * thing)
     if (ti_thing_to_map(thing))
         return -1;
 
+    if (!ti_thing_is_object(thing))
+    {
+        ti_type_instances_add(thing->via.type, thing);
+        ti_type_indexes_add(thing->via.type, thing);
+    }
+
     /*
      * Recursion is required since nested things did not generate a task
      * as long as their parent was not attached to the collection.
@@ -1245,6 +1270,13 @@ void ti_thing_t_to_object(ti_thing_t * thing)
     ti_name_t * name;
     ti_val_t ** val;
     ti_prop_t * prop;
+
+    if (thing->id)
+    {
+        ti_type_instances_del(thing->via.type, thing);
+        ti_type_indexes_del(thing->via.type, thing);
+    }
+
     for (thing_t_each_addr(thing, name, val))
     {
         prop = ti_prop_create(name, *val);
@@ -234,5 +234,6 @@ ti_thing_t * ti_things_thing_t_from_vup(ti_vup_t * vup, ex_t * e)
         VEC_push(thing->items.vec, val);
     }
 
+    ti_type_indexes_add(type, thing);
     return thing;
 }
@@ -19,6 +19,7 @@ ti_token_t * ti_token_create(
 
     token->expire_ts = expire_ts;
     token->created_at = created_at;
+    token->user = NULL;
     token->description = strndup(description, description_sz);
     if (!token->description)
     {
@@ -892,7 +892,7 @@ static int ttask__vtask_new(mp_unp_t * up)
         goto fail0;
 
     ti_update_next_free_id(vtask->id);
-    VEC_push(ti.tasks->vtasks, vtask);
+    (void) ti_tasks_append(&ti.tasks->vtasks, vtask, NULL);
     free(varr);
     ti_decref(closure);
     return 0;
@@ -989,7 +989,7 @@ static int ttask__vtask_finish(mp_unp_t * up)
         goto fail0;
 
     vtask->run_at = mp_run_at.via.u64;
-    ti_tasks_vtask_finish(vtask);
+    ti_tasks_vtask_finish(vtask, NULL);
 
     ti_val_drop((ti_val_t *) vtask->verr);
     vtask->verr = (ti_verror_t *) val;
@@ -1635,6 +1635,7 @@ int ti_ttask_run(ti_change_t * change, mp_unp_t * up)
     case TI_TASK_SET_ENUM_DATA:     break;
     case TI_TASK_REPLACE_ROOT:      break;
     case TI_TASK_IMPORT:            break;
+    case TI_TASK_MOD_TYPE_IDX:      break;
     }
 
     log_critical("unknown thingsdb task: %"PRIu64, mp_task.via.u64);
@@ -56,6 +56,8 @@ ti_type_t * ti_type_create(
     type->rname = ti_str_create(name, name_n);
     type->rwname = ti_str_from_str(type->wname);
     type->idname = NULL;
+    type->lookup = NULL;
+    type->instances = NULL;
     type->dependencies = vec_new(0);
     type->fields = vec_new(0);
     type->types = types;
@@ -145,6 +147,8 @@ void ti_type_destroy(ti_type_t * type)
     vec_destroy(type->fields, (vec_destroy_cb) ti_field_destroy);
     vec_destroy(type->methods, (vec_destroy_cb) ti_method_destroy);
     imap_destroy(type->t_mappings, type__map_free);
+    free(type->lookup);
+    imap_destroy(type->instances, NULL);
     ti_val_drop((ti_val_t *) type->rname);
     ti_val_drop((ti_val_t *) type->rwname);
     ti_val_drop((ti_val_t *) type->idname);
@@ -154,6 +158,146 @@ void ti_type_destroy(ti_type_t * type)
     free(type);
 }
 
+static inline void type__lookup_add(
+        ti_type_lookup_t * lookup,
+        ti_name_t * name,
+        uint32_t idx)
+{
+    uint32_t i = ti_type_lookup_hash(name);
+    while (lookup->slots[i & lookup->mask] != TI_TYPE_LOOKUP_EMPTY)
+        ++i;
+    lookup->slots[i & lookup->mask] = idx;
+}
+
+/*
+ * Create the lookup table for fields and methods. The table has at least
+ * twice the number of slots than entries so a search always ends on an
+ * empty slot.
+ */
+int ti_type_lookup_create(ti_type_t * type)
+{
+    ti_type_lookup_t * lookup;
+    uint32_t idx, sz = 16, n = type->fields->n + type->methods->n;
+
+    while (sz < n * 2)
+        sz <<= 1;
+
+    lookup = malloc(sizeof(ti_type_lookup_t) + sz * sizeof(uint32_t));
+    if (!lookup)
+        return -1;
+
+    lookup->mask = sz - 1;
+    memset(lookup->slots, 0xff, sz * sizeof(uint32_t));
+
+    idx = 0;
+    for (vec_each(type->fields, ti_field_t, field), ++idx)
+        type__lookup_add(lookup, field->name, idx);
+
+    idx = 0;
+    for (vec_each(type->methods, ti_method_t, method), ++idx)
+        type__lookup_add(lookup, method->name, idx|TI_TYPE_LOOKUP_METHOD);
+
+    free(type->lookup);
+    type->lookup = lookup;
+    return 0;
+}
+
+static int type__instances_cb(ti_thing_t * thing, ti_type_t * type)
+{
+    return thing->type_id == type->type_id
+            ? imap_add(type->instances, thing->id, thing) == IMAP_ERR_ALLOC
+            : 0;
+}
+
+/*
+ * Creates the instance index for a type by walking all the things in the
+ * collection, including those marked for garbage collection. Once created,
+ * the index is kept up-to-date when things are created, destroyed or
+ * converted so type scoped operations no longer require a full walk.
+ */
+int ti_type_instances_create(ti_type_t * type)
+{
+    ti_collection_t * collection = type->types->collection;
+
+    if (type->instances)
+        return 0;
+
+    type->instances = imap_create();
+    if (!type->instances)
+        return -1;
+
+    if (imap_walk(
+            collection->things,
+            (imap_cb) type__instances_cb,
+            type) ||
+        ti_gc_walk(collection->gc, (queue_cb) type__instances_cb, type))
+    {
+        imap_destroy(type->instances, NULL);
+        type->instances = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Walk all the things with an id which are an instance of the given type.
+ * The callback must still check the type as all things in the collection
+ * are walked if the instance index can not be created. Things of this type
+ * must not be added or removed by the callback.
+ */
+int ti_type_walk_instances(ti_type_t * type, imap_cb cb, void * arg)
+{
+    int rc;
+    ti_collection_t * collection = type->types->collection;
+
+    if (ti_type_instances_create(type) == 0)
+        return imap_walk(type->instances, cb, arg);
+
+    rc = imap_walk(collection->things, cb, arg);
+    return rc ? rc : ti_gc_walk(collection->gc, (queue_cb) cb, arg);
+}
+
+/*
+ * Adds a thing to the field indexes which are in use. The thing must have an
+ * id; values which are not set (yet) are ignored.
+ */
+void ti_type_indexes_add(ti_type_t * type, ti_thing_t * thing)
+{
+    if (type->flags & TI_TYPE_FLAG_INDEXED)
+        for (vec_each(type->fields, ti_field_t, field))
+            if (field->index && field->idx < thing->items.vec->n)
+                ti_field_index_add(
+                        field,
+                        thing,
+                        VEC_get(thing->items.vec, field->idx));
+}
+
+/*
+ * Removes a thing from the field indexes which are in use. Must be called
+ * before the values of the thing are cleared.
+ */
+void ti_type_indexes_del(ti_type_t * type, ti_thing_t * thing)
+{
+    if (type->flags & TI_TYPE_FLAG_INDEXED)
+        for (vec_each(type->fields, ti_field_t, field))
+            if (field->index && field->idx < thing->items.vec->n)
+                ti_field_index_del(
+                        field,
+                        thing,
+                        VEC_get(thing->items.vec, field->idx));
+}
+
+/*
+ * Removes all field indexes in use; declared indexes will be re-created on
+ * next use.
+ */
+void ti_type_indexes_clear(ti_type_t * type)
+{
+    for (vec_each(type->fields, ti_field_t, field))
+        ti_field_index_destroy(field);
+    type->flags &= ~TI_TYPE_FLAG_INDEXED;
+}
+
 size_t ti_type_fields_approx_pack_sz(ti_type_t * type)
 {
     size_t n = 0;
@@ -235,6 +379,7 @@ int ti_type_add_method(
         ti_method_destroy(method);
     }
 
+    ti_type_lookup_clear(type);
     return e->nr;
 }
 
@@ -246,6 +391,7 @@ void ti_type_remove_method(ti_type_t * type, ti_name_t * name)
         if (m->name == name)
         {
             ti_method_destroy(vec_swap_remove(type->methods, idx));
+            ti_type_lookup_clear(type);
             return;
         }
     }
@@ -1159,6 +1305,12 @@ int ti_type_convert(
     thing->type_id = type->type_id;
     thing->via.type = type;
     thing->items.vec = w.vec;
+
+    if (thing->id)
+    {
+        ti_type_instances_add(type, thing);
+        ti_type_indexes_add(type, thing);
+    }
     return e->nr;
 
 fail0:
@@ -1,8 +1,10 @@
 /*
  * ti/tz.c
  */
+#define _GNU_SOURCE
 #include <assert.h>
 #include <ti/tz.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
@@ -794,24 +796,86 @@ void ti_tz_init(void)
     }
 }
 
-void ti_tz_set_utc(void)
+static inline void tz__set_utc(void)
 {
     *tz__write_chr = ':';
     memcpy(tz__write_env, "UTC", 4);
 }
 
-void ti_tz_set(ti_tz_t * tz)
+static inline void tz__set(ti_tz_t * tz)
 {
     *tz__write_chr = ':';
     memcpy(tz__write_env, tz->name, tz->n+1);
 }
 
-void ti_tz_set_offset(int16_t offset)
+/*
+ * The zone info is loaded on first use. If the zone info cannot be loaded,
+ * conversions fall back to the C library using the `TZ` environment
+ * variable.
+ */
+static inline ti_tzinfo_t * tz__info(ti_tz_t * tz)
+{
+    if (!tz->is_loaded)
+    {
+        tz->info = ti_tzinfo_load(tz->name);
+        tz->is_loaded = true;
+        if (!tz->info)
+            log_warning(
+                    "no zone info for time zone `%s`; "
+                    "fall back to the C library",
+                    tz->name);
+    }
+    return tz->info;
+}
+
+int ti_tz_localtime(ti_tz_t * tz, time_t ts, struct tm * tm)
 {
-    int hours = abs(offset / 60);
-    int minutes = abs(offset % 60);
-    char sign = offset < 0 ? '+' : '-';  /* offset works in reverse here */
-    sprintf(tz__write_chr, "UTC%c%02d:%02d", sign, hours, minutes);
+    ti_tzinfo_t * info;
+    int rc;
+
+    if (tz->index == TI_TZ_UTC_INDEX)
+    {
+        if (gmtime_r(&ts, tm) != tm)
+            return -1;
+        tm->tm_zone = "UTC";
+        return 0;
+    }
+
+    info = tz__info(tz);
+    if (info)
+        return ti_tzinfo_localtime(info, (int64_t) ts, tm);
+
+    tz__set(tz);
+    tzset();
+    rc = -(localtime_r(&ts, tm) != tm);
+    tz__set_utc();
+    return rc;
+}
+
+/*
+ * Like mktime() for the given time zone; `tm` is normalized.
+ */
+time_t ti_tz_mktime(ti_tz_t * tz, struct tm * tm)
+{
+    ti_tzinfo_t * info;
+    int64_t ts;
+    time_t t;
+
+    if (tz->index == TI_TZ_UTC_INDEX)
+    {
+        t = timegm(tm);
+        tm->tm_zone = "UTC";
+        return t;
+    }
+
+    info = tz__info(tz);
+    if (info)
+        return ti_tzinfo_mktime(info, tm, &ts) ? (time_t) -1 : (time_t) ts;
+
+    tz__set(tz);
+    t = mktime(tm);
+    tz__set_utc();
+    return t;
 }
 
 ti_tz_t * ti_tz_utc(void)
@@ -0,0 +1,663 @@
+/*
+ * ti/tzinfo.c
+ *
+ * Reads compiled zoneinfo (TZif) files as described in RFC 8536. Times after
+ * the last transition in the file are calculated using the POSIX TZ rule in
+ * the footer of the file.
+ */
+#define _GNU_SOURCE
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ti/tzinfo.h>
+#include <util/fx.h>
+#include <util/logger.h>
+
+#define TZINFO__HEADER_SZ 44
+#define TZINFO__ABBR_SZ 16
+#define TZINFO__RULE_SZ 64
+#define TZINFO__DAY 86400
+
+/*
+ * Values used when a local time with a given `tm_isdst` is requested which
+ * does not match the daylight saving time of that local time. The same
+ * values are used by the GNU C library so the result of
+ * ti_tzinfo_mktime() is equal to mktime().
+ */
+#define TZINFO__STRIDE 601200
+#define TZINFO__DELTA_BOUND (457243200 / 2 + TZINFO__STRIDE)
+
+typedef struct
+{
+    int32_t utoff;          /* offset to UTC in seconds */
+    uint8_t isdst;
+    const char * abbr;      /* null terminated abbreviation */
+} tzinfo__type_t;
+
+typedef enum
+{
+    TZINFO__JULIAN,         /* Jn (1..365), February 29 is never counted */
+    TZINFO__YDAY,           /* n (0..365), February 29 is counted */
+    TZINFO__MONTH,          /* Mm.w.d, day d of week w in month m */
+} tzinfo__date_e;
+
+typedef struct
+{
+    tzinfo__date_e tp;
+    int day;
+    int mon;
+    int week;
+    int wday;
+    int32_t secs;           /* local time of day, may exceed 24 hours */
+} tzinfo__date_t;
+
+typedef struct
+{
+    _Bool has_dst;
+    tzinfo__type_t std;
+    tzinfo__type_t dst;
+    tzinfo__date_t start;   /* start of daylight saving time */
+    tzinfo__date_t end;     /* end of daylight saving time */
+    char std_abbr[TZINFO__ABBR_SZ];
+    char dst_abbr[TZINFO__ABBR_SZ];
+} tzinfo__rule_t;
+
+struct ti_tzinfo_s
+{
+    uint32_t n;             /* number of transitions */
+    uint32_t hint;          /* last found transition, only a hint */
+    uint32_t first;         /* type used before the first transition */
+    uint32_t n_types;
+    int64_t * trans;        /* transition times in UTC */
+    uint8_t * idx;          /* type for each transition */
+    tzinfo__type_t * types;
+    char * abbrs;           /* abbreviations, referred to by types */
+    tzinfo__rule_t * rule;  /* times after the last transition, or NULL */
+};
+
+static inline uint32_t tzinfo__u32(const unsigned char * p)
+{
+    return (
+        (uint32_t) p[0] << 24 |
+        (uint32_t) p[1] << 16 |
+        (uint32_t) p[2] << 8 |
+        (uint32_t) p[3]
+    );
+}
+
+static inline int64_t tzinfo__i64(const unsigned char * p)
+{
+    return (int64_t) ((uint64_t) tzinfo__u32(p) << 32 | tzinfo__u32(p + 4));
+}
+
+static inline int64_t tzinfo__floor_div(int64_t a, int64_t b)
+{
+    return a / b - (a % b < 0);
+}
+
+static inline _Bool tzinfo__is_leap(int64_t year)
+{
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+static inline int tzinfo__mdays(int64_t year, int mon)
+{
+    static const int mdays[12] = {
+            31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return mdays[mon-1] + (mon == 2 && tzinfo__is_leap(year));
+}
+
+/*
+ * Returns the number of days since 1970-01-01 for a date in the proleptic
+ * Gregorian calendar.
+ */
+static int64_t tzinfo__days(int64_t year, int mon, int mday)
+{
+    int64_t era, yoe, doy, doe;
+
+    year -= mon <= 2;
+    era = (year >= 0 ? year : year - 399) / 400;
+    yoe = year - era * 400;
+    doy = (153 * (mon + (mon > 2 ? -3 : 9)) + 2) / 5 + mday - 1;
+    doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+/*
+ * Returns the year for a given number of days since 1970-01-01.
+ */
+static int64_t tzinfo__year(int64_t days)
+{
+    int64_t era, doe, yoe, doy, mp;
+
+    days += 719468;
+    era = (days >= 0 ? days : days - 146096) / 146097;
+    doe = days - era * 146097;
+    yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    mp = (5 * doy + 2) / 153;
+    return yoe + era * 400 + (mp >= 10);
+}
+
+/*
+ * Returns the local time in seconds since the epoch at which the rule date
+ * takes effect in the given year.
+ */
+static int64_t tzinfo__date_ts(tzinfo__date_t * date, int64_t year)
+{
+    int64_t days;
+    int wday, mday;
+
+    switch (date->tp)
+    {
+    case TZINFO__JULIAN:
+        days = tzinfo__days(year, 1, 1) + date->day - 1;
+        days += date->day >= 60 && tzinfo__is_leap(year);
+        break;
+    case TZINFO__YDAY:
+        days = tzinfo__days(year, 1, 1) + date->day;
+        break;
+    case TZINFO__MONTH:
+        days = tzinfo__days(year, date->mon, 1);
+        wday = (int) ((days % 7 + 11) % 7);  /* 1970-01-01 is a Thursday */
+        mday = 1 + (date->wday - wday + 7) % 7 + (date->week - 1) * 7;
+        while (mday > tzinfo__mdays(year, date->mon))
+            mday -= 7;
+        days += mday - 1;
+        break;
+    default:
+        days = 0;
+    }
+    return days * TZINFO__DAY + date->secs;
+}
+
+static const tzinfo__type_t * tzinfo__rule_find(
+        tzinfo__rule_t * rule,
+        int64_t ts)
+{
+    int64_t year, start, end;
+
+    if (!rule->has_dst)
+        return &rule->std;
+
+    year = tzinfo__year(tzinfo__floor_div(ts + rule->std.utoff, TZINFO__DAY));
+
+    /* start is in standard time, end in daylight saving time */
+    start = tzinfo__date_ts(&rule->start, year) - rule->std.utoff;
+    end = tzinfo__date_ts(&rule->end, year) - rule->dst.utoff;
+
+    return (start < end
+            ? ts >= start && ts < end
+            : ts >= start || ts < end) ? &rule->dst : &rule->std;
+}
+
+/*
+ * Returns the time type for a given UTC time stamp. The last transition
+ * which is found is kept as a hint as most conversions are close to each
+ * other; since the hint is verified before it is used, this function may be
+ * called by multiple threads.
+ */
+static const tzinfo__type_t * tzinfo__find(ti_tzinfo_t * info, int64_t ts)
+{
+    uint32_t lo, hi, n = info->n;
+
+    if (!n || ts < info->trans[0])
+        return !n && info->rule
+                ? tzinfo__rule_find(info->rule, ts)
+                : &info->types[info->first];
+
+    if (info->rule && ts >= info->trans[n-1])
+        return tzinfo__rule_find(info->rule, ts);
+
+    lo = __atomic_load_n(&info->hint, __ATOMIC_RELAXED);
+    if (lo < n &&
+        ts >= info->trans[lo] &&
+        (lo + 1 == n || ts < info->trans[lo + 1]))
+        return &info->types[info->idx[lo]];
+
+    lo = 0;
+    hi = n;
+    while (hi - lo > 1)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (info->trans[mid] <= ts)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    __atomic_store_n(&info->hint, lo, __ATOMIC_RELAXED);
+    return &info->types[info->idx[lo]];
+}
+
+static const char * tzinfo__num(const char * s, int * num, int max)
+{
+    long int l;
+    char * end;
+
+    if (!isdigit(*s))
+        return NULL;
+
+    l = strtol(s, &end, 10);
+    if (l > max)
+        return NULL;
+
+    *num = (int) l;
+    return end;
+}
+
+static const char * tzinfo__parse_abbr(const char * s, char * abbr)
+{
+    const char * start;
+    size_t n;
+
+    if (*s == '<')
+    {
+        start = ++s;
+        while (*s && *s != '>')
+            ++s;
+        if (*s != '>')
+            return NULL;
+        n = s++ - start;
+    }
+    else
+    {
+        start = s;
+        while (isalpha(*s))
+            ++s;
+        n = s - start;
+    }
+
+    if (n < 3 || n >= TZINFO__ABBR_SZ)
+        return NULL;
+
+    memcpy(abbr, start, n);
+    abbr[n] = '\0';
+    return s;
+}
+
+/*
+ * Reads `[+|-]hh[:mm[:ss]]`, as used by offsets and rule times.
+ */
+static const char * tzinfo__parse_secs(const char * s, int32_t * secs)
+{
+    int sign = 1, hours, minutes = 0, seconds = 0;
+
+    if (*s == '+' || *s == '-')
+        sign = *s++ == '-' ? -1 : 1;
+
+    if (!(s = tzinfo__num(s, &hours, 167)))
+        return NULL;
+
+    if (*s == ':')
+    {
+        if (!(s = tzinfo__num(s + 1, &minutes, 59)))
+            return NULL;
+
+        if (*s == ':' && !(s = tzinfo__num(s + 1, &seconds, 59)))
+            return NULL;
+    }
+
+    *secs = sign * (hours * 3600 + minutes * 60 + seconds);
+    return s;
+}
+
+static const char * tzinfo__parse_date(const char * s, tzinfo__date_t * date)
+{
+    date->secs = 7200;  /* default is 02:00:00 */
+
+    switch (*s)
+    {
+    case 'M':
+        date->tp = TZINFO__MONTH;
+        if (!(s = tzinfo__num(s + 1, &date->mon, 12)) || !date->mon ||
+            *s != '.' ||
+            !(s = tzinfo__num(s + 1, &date->week, 5)) || !date->week ||
+            *s != '.' ||
+            !(s = tzinfo__num(s + 1, &date->wday, 6)))
+            return NULL;
+        break;
+    case 'J':
+        date->tp = TZINFO__JULIAN;
+        if (!(s = tzinfo__num(s + 1, &date->day, 365)) || !date->day)
+            return NULL;
+        break;
+    default:
+        date->tp = TZINFO__YDAY;
+        if (!(s = tzinfo__num(s, &date->day, 365)))
+            return NULL;
+    }
+
+    return *s == '/' ? tzinfo__parse_secs(s + 1, &date->secs) : s;
+}
+
+/*
+ * Parse a POSIX TZ rule, for example: `CET-1CEST,M3.5.0,M10.5.0/3`
+ */
+static tzinfo__rule_t * tzinfo__parse_rule(const char * s)
+{
+    int32_t secs;
+    tzinfo__rule_t * rule = calloc(1, sizeof(tzinfo__rule_t));
+    if (!rule)
+        return NULL;
+
+    if (!(s = tzinfo__parse_abbr(s, rule->std_abbr)) ||
+        !(s = tzinfo__parse_secs(s, &secs)))
+        goto fail;
+
+    /* POSIX offsets are positive west of Greenwich */
+    rule->std.utoff = -secs;
+    rule->std.abbr = rule->std_abbr;
+
+    if (!*s)
+        return rule;
+
+    if (!(s = tzinfo__parse_abbr(s, rule->dst_abbr)))
+        goto fail;
+
+    rule->has_dst = true;
+    rule->dst.isdst = 1;
+    rule->dst.abbr = rule->dst_abbr;
+    rule->dst.utoff = rule->std.utoff + 3600;
+
+    if (*s && *s != ',')
+    {
+        if (!(s = tzinfo__parse_secs(s, &secs)))
+            goto fail;
+        rule->dst.utoff = -secs;
+    }
+
+    if (!*s)
+        s = ",M3.2.0,M11.1.0";  /* POSIX default rules */
+
+    if (*s != ',' ||
+        !(s = tzinfo__parse_date(s + 1, &rule->start)) ||
+        *s != ',' ||
+        !(s = tzinfo__parse_date(s + 1, &rule->end)) ||
+        *s)
+        goto fail;
+
+    return rule;
+
+fail:
+    free(rule);
+    return NULL;
+}
+
+static void tzinfo__counts(const unsigned char * p, uint32_t * counts)
+{
+    /* isutcnt, isstdcnt, leapcnt, timecnt, typecnt, charcnt */
+    for (int i = 0; i < 6; ++i)
+        counts[i] = tzinfo__u32(p + 20 + i * 4);
+}
+
+static ti_tzinfo_t * tzinfo__parse(const unsigned char * p, size_t n)
+{
+    const unsigned char * end = p + n;
+    uint32_t counts[6], isutcnt, isstdcnt, leapcnt, timecnt, typecnt, charcnt;
+    size_t tsz = 4, sz;
+    _Bool v2;
+    ti_tzinfo_t * info;
+
+    if (n < TZINFO__HEADER_SZ || memcmp(p, "TZif", 4))
+        return NULL;
+
+    v2 = p[4] >= '2';
+
+    if (v2)
+    {
+        /* skip the version 1 data block */
+        tzinfo__counts(p, counts);
+        sz = (size_t) counts[3] * 5 + (size_t) counts[4] * 6 + counts[5] +
+             (size_t) counts[2] * 8 + counts[1] + counts[0];
+        if ((size_t) (end - p) < TZINFO__HEADER_SZ * 2 + sz)
+            return NULL;
+        p += TZINFO__HEADER_SZ + sz;
+        if (memcmp(p, "TZif", 4))
+            return NULL;
+        tsz = 8;
+    }
+
+    tzinfo__counts(p, counts);
+    isutcnt = counts[0];
+    isstdcnt = counts[1];
+    leapcnt = counts[2];
+    timecnt = counts[3];
+    typecnt = counts[4];
+    charcnt = counts[5];
+
+    p += TZINFO__HEADER_SZ;
+
+    sz = (size_t) timecnt * (tsz + 1) + (size_t) typecnt * 6 + charcnt +
+         (size_t) leapcnt * (tsz + 4) + isstdcnt + isutcnt;
+
+    if (!typecnt || typecnt > 256 || !charcnt || (size_t) (end - p) < sz)
+        return NULL;
+
+    info = calloc(1, sizeof(ti_tzinfo_t));
+    if (!info)
+        return NULL;
+
+    info->n = timecnt;
+    info->n_types = typecnt;
+    info->trans = malloc(sizeof(int64_t) * (timecnt + 1));
+    info->idx = malloc(timecnt + 1);
+    info->types = malloc(sizeof(tzinfo__type_t) * typecnt);
+    info->abbrs = malloc(charcnt + 1);
+
+    if (!info->trans || !info->idx || !info->types || !info->abbrs)
+        goto fail;
+
+    for (uint32_t i = 0; i < timecnt; ++i, p += tsz)
+        info->trans[i] = tsz == 8
+                ? tzinfo__i64(p)
+                : (int64_t) (int32_t) tzinfo__u32(p);
+
+    for (uint32_t i = 0; i < timecnt; ++i, ++p)
+    {
+        if (*p >= typecnt)
+            goto fail;
+        info->idx[i] = *p;
+    }
+
+    for (uint32_t i = 0; i < typecnt; ++i, p += 6)
+    {
+        if (p[5] >= charcnt)
+            goto fail;
+        info->types[i].utoff = (int32_t) tzinfo__u32(p);
+        info->types[i].isdst = p[4] != 0;
+        info->types[i].abbr = info->abbrs + p[5];
+    }
+
+    memcpy(info->abbrs, p, charcnt);
+    info->abbrs[charcnt] = '\0';
+    p += charcnt;
+
+    /* leap second records and indicators are not used */
+    p += (size_t) leapcnt * (tsz + 4) + isstdcnt + isutcnt;
+
+    /* like the GNU C library, use the first standard time type */
+    while (info->first < typecnt && info->types[info->first].isdst)
+        ++info->first;
+    if (info->first == typecnt)
+        info->first = 0;
+
+    if (v2 && p < end && *p == '\n')
+    {
+        char rule[TZINFO__RULE_SZ];
+        const unsigned char * s = ++p;
+
+        while (p < end && *p != '\n')
+            ++p;
+
+        sz = p - s;
+        if (p < end && sz && sz < TZINFO__RULE_SZ)
+        {
+            memcpy(rule, s, sz);
+            rule[sz] = '\0';
+            info->rule = tzinfo__parse_rule(rule);
+            if (!info->rule)
+                log_warning("unsupported time zone rule: `%s`", rule);
+        }
+    }
+
+    return info;
+
+fail:
+    ti_tzinfo_destroy(info);
+    return NULL;
+}
+
+/*
+ * Returns the zone info for a given time zone name, or NULL when the zone
+ * info file cannot be read. (an error is logged)
+ */
+ti_tzinfo_t * ti_tzinfo_load(const char * name)
+{
+    ssize_t size;
+    unsigned char * data;
+    ti_tzinfo_t * info;
+    const char * path = getenv("TZDIR");
+    char * fn = fx_path_join(path && *path ? path : TI_TZINFO_PATH, name);
+    if (!fn)
+        return NULL;
+
+    data = fx_read(fn, &size);
+    if (!data)
+    {
+        free(fn);
+        return NULL;
+    }
+
+    info = tzinfo__parse(data, (size_t) size);
+    if (!info)
+        log_error("cannot read zone info from file `%s`", fn);
+
+    free(data);
+    free(fn);
+    return info;
+}
+
+void ti_tzinfo_destroy(ti_tzinfo_t * info)
+{
+    if (!info)
+        return;
+    free(info->trans);
+    free(info->idx);
+    free(info->types);
+    free(info->abbrs);
+    free(info->rule);
+    free(info);
+}
+
+/*
+ * Like localtime_r() but for the zone info instead of the `TZ` environment.
+ */
+int ti_tzinfo_localtime(ti_tzinfo_t * info, int64_t ts, struct tm * tm)
+{
+    const tzinfo__type_t * tp = tzinfo__find(info, ts);
+    time_t t = (time_t) (ts + tp->utoff);
+
+    if (gmtime_r(&t, tm) != tm)
+        return -1;
+
+    tm->tm_isdst = tp->isdst;
+    tm->tm_gmtoff = tp->utoff;
+    tm->tm_zone = tp->abbr;
+    return 0;
+}
+
+/*
+ * Like mktime() but for the zone info instead of the `TZ` environment.
+ * The given `tm` is normalized and may be out of range. A local time which
+ * is skipped by a transition is read using the standard time offset.
+ *
+ * A local time which exists twice resolves to the one with the requested
+ * `tm_isdst`. Otherwise, like mktime(), the offset at the local time read as
+ * UTC is tried first; for zones east of Greenwich this is usually the second
+ * and for zones west of Greenwich the first. Note that mktime() of the GNU C
+ * library tries the offset of its previous call first, so its result for an
+ * ambiguous time depends on earlier calls in the process; the result of this
+ * function is always equal to that of a first call to mktime().
+ *
+ * Known differences with mktime() are local times in a gap between two
+ * daylight saving times (British Double Summer Time) and in a gap of a day or
+ * more (Pacific/Apia, 2011-12-30).
+ */
+int ti_tzinfo_mktime(ti_tzinfo_t * info, struct tm * tm, int64_t * ts)
+{
+    const tzinfo__type_t * tp, * before, * after;
+    int isdst = tm->tm_isdst;
+    int64_t t, local;
+    struct tm tmp = *tm;
+    time_t utc = timegm(&tmp);
+
+    if (utc == (time_t) -1 && tmp.tm_year != 69)
+        return -1;
+
+    local = (int64_t) utc;
+
+    /*
+     * Transitions are never less than a day apart, so the types before and
+     * after any transition around the local time can be found a day away.
+     */
+    before = tzinfo__find(info, local - TZINFO__DAY);
+    after = tzinfo__find(info, local + TZINFO__DAY);
+
+    if (before->utoff == after->utoff)
+        tp = after;
+    else
+    {
+        _Bool before_ok = tzinfo__find(
+                info, local - before->utoff)->utoff == before->utoff;
+        _Bool after_ok = tzinfo__find(
+                info, local - after->utoff)->utoff == after->utoff;
+
+        tp = before_ok && after_ok
+                ? (isdst >= 0 && !before->isdst != !after->isdst
+                    ? (!after->isdst == !isdst ? after : before)
+                    : tzinfo__find(info, local)->utoff == after->utoff
+                    ? after
+                    : before)
+                : after_ok
+                ? after
+                : before_ok
+                ? before
+                : before->isdst && !after->isdst
+                ? after     /* in a gap, use the standard time offset */
+                : before;
+    }
+
+    t = local - tp->utoff;
+
+    if (isdst >= 0 && !tp->isdst != !isdst)
+    {
+        /*
+         * The local time has a different daylight saving time than asked
+         * for; use the offset of the nearest time with the requested
+         * daylight saving time, or assume a difference of one hour.
+         */
+        for (int delta = TZINFO__STRIDE;
+             delta < TZINFO__DELTA_BOUND;
+             delta += TZINFO__STRIDE)
+        {
+            for (int direction = -1; direction <= 1; direction += 2)
+            {
+                const tzinfo__type_t * other = tzinfo__find(
+                        info,
+                        t + (int64_t) delta * direction);
+                if (!other->isdst == !isdst)
+                {
+                    t = local - other->utoff;
+                    goto found;
+                }
+            }
+        }
+        t += 3600 * ((isdst == 0) - (tp->isdst == 0));
+    }
+
+found:
+    *ts = t;
+    return ti_tzinfo_localtime(info, t, tm);
+}
@@ -7,6 +7,7 @@
 #include <ti/raw.inline.h>
 #include <ti/token.h>
 #include <ti/user.h>
+#include <ti/users.h>
 #include <ti/val.inline.h>
 #include <util/cryptx.h>
 #include <util/iso8601.h>
@@ -135,6 +136,21 @@ void ti_user_drop(ti_user_t * user)
     }
 }
 
+int ti_user_add_token(ti_user_t * user, ti_token_t * token)
+{
+    if (vec_push(&user->tokens, token))
+        return -1;
+
+    if (ti_users_index_token(token))
+    {
+        (void) vec_pop(user->tokens);
+        return -1;
+    }
+
+    token->user = user;
+    return 0;
+}
+
 void ti_user_del_expired(ti_user_t * user, uint64_t after_ts)
 {
     ti_token_t * token;
@@ -143,6 +159,7 @@ void ti_user_del_expired(ti_user_t * user, uint64_t after_ts)
         token = user->tokens->data[n];
         if (token->expire_ts && token->expire_ts < after_ts)
         {
+            ti_users_unindex_token(token);
             ti_token_destroy(vec_swap_remove(user->tokens, n));
             --m;
             continue;
@@ -216,6 +233,8 @@ int ti_user_rename(ti_user_t * user, ti_raw_t * name, ex_t * e)
     ti_val_unsafe_drop((ti_val_t *) user->name);
     user->name = ti_grab(name);
 
+    ti_users_clear_basic_cache();
+
     return e->nr;
 }
 
@@ -230,6 +249,7 @@ int ti_user_set_pass(ti_user_t * user, const char * pass)
         /* clear password */
         free(user->encpass);
         user->encpass = NULL;
+        ti_users_clear_basic_cache();
         return 0;
     }
 
@@ -248,6 +268,8 @@ int ti_user_set_pass(ti_user_t * user, const char * pass)
     free(user->encpass);
     user->encpass = password;
 
+    ti_users_clear_basic_cache();
+
     return 0;
 }
 
@@ -356,7 +378,13 @@ ti_token_t * ti_user_pop_token_by_key(ti_user_t * user, ti_token_key_t * key)
 {
     size_t idx = 0;
     for (vec_each(user->tokens, ti_token_t, token), ++idx)
+    {
         if (memcmp(token->key, key, sizeof(ti_token_key_t)) == 0)
+        {
+            ti_users_unindex_token(token);
+            token->user = NULL;
             return vec_swap_remove(user->tokens, idx);
+        }
+    }
     return NULL;
 }
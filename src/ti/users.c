@@ -14,22 +14,87 @@
 #include <ti/val.inline.h>
 #include <util/cryptx.h>
 #include <util/logger.h>
+#include <util/smap.h>
 #include <util/util.h>
 #include <util/vec.h>
 
+/*
+ * Verified `Basic` authorization headers are cached for a short time so the
+ * password does not need to be encrypted for each HTTP API request. Each
+ * header has a single slot in the cache, and the cache is cleared when any
+ * user is renamed, deleted or changes password.
+ */
+#define USERS__BASIC_CACHE_SZ 64
+#define USERS__BASIC_CACHE_TTL 30
+
+typedef struct
+{
+    uint64_t expire_ts;     /* UNIX time in seconds */
+    ti_user_t * user;       /* borrowed reference */
+    ti_raw_t * auth;        /* base64 encoded authorization */
+} users__basic_t;
+
+static smap_t * users__tokens;  /* token key to ti_token_t */
+static users__basic_t users__basic_cache[USERS__BASIC_CACHE_SZ];
+
 int ti_users_create(void)
 {
     ti.users = vec_new(1);
-    return ti.users ? 0 : -1;
+    users__tokens = smap_create();
+    return ti.users && users__tokens ? 0 : -1;
 }
 
 void ti_users_destroy(void)
 {
+    ti_users_clear_basic_cache();
+    smap_destroy(users__tokens, NULL);
+    users__tokens = NULL;
+
     if (!ti.users)
         return;
     vec_destroy(ti.users, (vec_destroy_cb) ti_user_drop);
 }
 
+/*
+ * Add a token to the index. A token key which already exists is not
+ * replaced; this is not an error since random keys are not checked for
+ * uniqueness.
+ */
+int ti_users_index_token(ti_token_t * token)
+{
+    int rc = smap_addn(
+            users__tokens,
+            token->key,
+            sizeof(ti_token_key_t),
+            token);
+    return rc == SMAP_ERR_ALLOC ? -1 : 0;
+}
+
+void ti_users_unindex_token(ti_token_t * token)
+{
+    const size_t key_sz = sizeof(ti_token_key_t);
+    if (smap_getn(users__tokens, token->key, key_sz) == token)
+        (void) smap_popn(users__tokens, token->key, key_sz);
+}
+
+void ti_users_clear_basic_cache(void)
+{
+    for (size_t i = 0; i < USERS__BASIC_CACHE_SZ; ++i)
+    {
+        users__basic_t * entry = &users__basic_cache[i];
+        ti_val_drop((ti_val_t *) entry->auth);
+        memset(entry, 0, sizeof(users__basic_t));
+    }
+}
+
+static inline users__basic_t * users__basic_entry(const char * b64, size_t n)
+{
+    uint32_t h = 2166136261u;  /* FNV-1a */
+    while (n--)
+        h = (h ^ (uint8_t) *b64++) * 16777619u;
+    return &users__basic_cache[h & (USERS__BASIC_CACHE_SZ-1)];
+}
+
 ti_user_t * ti_users_new_user(
         const char * name,
         size_t name_n,
@@ -129,6 +194,12 @@ void ti_users_del_user(ti_user_t * user)
         ti_access_revoke(collection->access, user, TI_AUTH_MASK_FULL);
     }
 
+    /* remove tokens from the index */
+    for (vec_each(user->tokens, ti_token_t, token))
+        ti_users_unindex_token(token);
+
+    ti_users_clear_basic_cache();
+
     /* remove user */
     for (vec_each(ti.users, ti_user_t, usr), ++i)
     {
@@ -188,23 +259,18 @@ failed:
  */
 ti_user_t * ti_users_auth_by_token(mp_obj_t * mp_token, ex_t * e)
 {
-    uint64_t now_ts = util_now_usec();
+    ti_token_t * token;
     const size_t key_sz = sizeof(ti_token_key_t);
 
     if (mp_token->tp != MP_STR || mp_token->via.str.n != key_sz)
         goto invalid;
 
-    for (vec_each(ti.users, ti_user_t, user))
+    token = smap_getn(users__tokens, mp_token->via.str.data, key_sz);
+    if (token)
     {
-        for (vec_each(user->tokens, ti_token_t, token))
-        {
-            if (memcmp(token->key, mp_token->via.str.data, key_sz) == 0)
-            {
-                if (token->expire_ts && token->expire_ts < now_ts)
-                    goto expired;
-                return user;
-            }
-        }
+        if (token->expire_ts && token->expire_ts < util_now_usec())
+            goto expired;
+        return token->user;
     }
     /* bubble down to `invalid token` if not found */
 invalid:
@@ -222,7 +288,16 @@ ti_user_t * ti_users_auth_by_basic(const char * b64, size_t n, ex_t * e)
 {
     ti_user_t * user = NULL;
     mp_obj_t mp_user, mp_pass;
-    ti_raw_t * auth = ti_bytes_from_base64(b64, n);
+    ti_raw_t * auth;
+    uint64_t now_ts = util_now_usec();
+    users__basic_t * entry = users__basic_entry(b64, n);
+
+    if (entry->auth &&
+        entry->expire_ts >= now_ts &&
+        ti_raw_eq_strn(entry->auth, b64, n))
+        return entry->user;
+
+    auth = ti_bytes_from_base64(b64, n);
     if (!auth)
     {
         ex_set_mem(e);
@@ -247,6 +322,17 @@ ti_user_t * ti_users_auth_by_basic(const char * b64, size_t n, ex_t * e)
             mp_pass.via.bin.n = end - n;
 
             user = ti_users_auth(&mp_user, &mp_pass, e);
+            if (user)
+            {
+                ti_raw_t * cached = ti_str_create(b64, n);
+                if (cached)
+                {
+                    ti_val_drop((ti_val_t *) entry->auth);
+                    entry->auth = cached;
+                    entry->user = user;
+                    entry->expire_ts = now_ts + USERS__BASIC_CACHE_TTL;
+                }
+            }
             goto done;
         }
     }
@@ -304,19 +390,12 @@ void ti_users_del_expired(uint64_t after_ts)
 
 _Bool ti_users_has_token(ti_token_key_t * key)
 {
-    for (vec_each(ti.users, ti_user_t, user))
-        for (vec_each(user->tokens, ti_token_t, token))
-            if (memcmp(token->key, key, sizeof(ti_token_key_t)) == 0)
-                return true;
-    return false;
+    return !!smap_getn(users__tokens, *key, sizeof(ti_token_key_t));
 }
 
 ti_token_t * ti_users_pop_token_by_key(ti_token_key_t * key)
 {
-    ti_token_t * token;
-    for (vec_each(ti.users, ti_user_t, user))
-        if ((token = ti_user_pop_token_by_key(user, key)))
-            return token;
-    return NULL;
+    ti_token_t * token = smap_getn(users__tokens, *key, sizeof(ti_token_key_t));
+    return token ? ti_user_pop_token_by_key(token->user, key) : NULL;
 }
 
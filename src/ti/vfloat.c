@@ -22,7 +22,7 @@ ti_vfloat_t * ti_vfloat_create(double d)
         return vfloat;
     }
 
-    vfloat = malloc(sizeof(ti_vfloat_t));
+    vfloat = ti_slab_alloc(sizeof(ti_vfloat_t));
     if (!vfloat)
         return NULL;
 
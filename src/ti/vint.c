@@ -109,7 +109,7 @@ ti_vint_t * ti_vint_create(int64_t i)
         return vint;
     }
 
-    vint = malloc(sizeof(ti_vint_t));
+    vint = ti_slab_alloc(sizeof(ti_vint_t));
     if (!vint)
         return NULL;
     vint->ref = 1;
@@ -10,6 +10,14 @@
 
 static void ti__write_cb(uv_write_t * req, int status);
 
+typedef struct
+{
+    uv_write_t req_;
+    void * buf;
+    ti_write_direct_cb cb;
+    void * arg;
+} write__direct_t;
+
 int ti_write(ti_stream_t * stream, ti_pkg_t * pkg, void * data, ti_write_cb cb)
 {
     uv_buf_t wrbuf;
@@ -58,3 +66,78 @@ static void ti__write_cb(uv_write_t * req, int status)
 
     ti_req->cb_(ti_req, status ? EX_WRITE_UV : 0);
 }
+
+static void write__direct_cb(uv_write_t * req, int status)
+{
+    write__direct_t * w = (write__direct_t *) req;
+
+    if (status)
+        log_error("stream write error: `%s`", uv_strerror(status));
+
+    if (w->cb)
+        w->cb(w->arg, status);
+
+    free(w->buf);
+    free(w);
+}
+
+/*
+ * Write `n` bytes at `data` to the stream; `data` must point into `buf`.
+ *
+ * This function never blocks. When nothing is queued for the stream, as much
+ * data as possible is written right away using uv_try_write() and only the
+ * remainder is queued. Returns 0 when all data is written, 1 when data is
+ * queued or -1 on failure. Only when data is queued, `cb` (if not NULL) is
+ * called with `arg` once the data is written or the write has failed.
+ *
+ * On success, `buf` is freed once written. On failure, the caller remains
+ * the owner of `buf`.
+ */
+int ti_write_direct(
+        uv_stream_t * uvstream,
+        char * data,
+        size_t n,
+        void * buf,
+        ti_write_direct_cb cb,
+        void * arg)
+{
+    int rc;
+    uv_buf_t wrbuf;
+    write__direct_t * w;
+
+    /* uv_try_write() fails with UV_EAGAIN when data is queued */
+    while (n && !uvstream->write_queue_size)
+    {
+        wrbuf = uv_buf_init(data, n);
+        rc = uv_try_write(uvstream, &wrbuf, 1);
+        if (rc <= 0)
+            break;  /* other errors than UV_EAGAIN are reported by uv_write */
+
+        data += rc;
+        n -= rc;
+    }
+
+    if (!n)
+    {
+        free(buf);
+        return 0;
+    }
+
+    w = malloc(sizeof(write__direct_t));
+    if (!w)
+        return -1;
+
+    w->buf = buf;
+    w->cb = cb;
+    w->arg = arg;
+    wrbuf = uv_buf_init(data, n);
+
+    rc = uv_write(&w->req_, uvstream, &wrbuf, 1, write__direct_cb);
+    if (rc)
+    {
+        log_error("stream write error: `%s`", uv_strerror(rc));
+        free(w);
+        return -1;
+    }
+    return 1;
+}
@@ -0,0 +1,119 @@
+/*
+ * argsort.c
+ */
+#include <stdlib.h>
+#include <util/argsort.h>
+
+/* below this size an insertion sort is used instead of a radix sort */
+#define ARGSORT__MIN_RADIX 64
+
+static void argsort__insertion(uint64_t * keys, uint32_t * idx, size_t n)
+{
+    for (size_t i = 1; i < n; ++i)
+    {
+        uint64_t key = keys[i];
+        uint32_t id = idx[i];
+        size_t j = i;
+
+        for (; j && keys[j-1] > key; --j)
+        {
+            keys[j] = keys[j-1];
+            idx[j] = idx[j-1];
+        }
+        keys[j] = key;
+        idx[j] = id;
+    }
+}
+
+/*
+ * Stable sort of `n` keys. On return, `keys` is sorted and `idx` contains
+ * the original position for each of the sorted keys. Unsigned keys can be
+ * created using argsort_key_i64() or argsort_key_f64().
+ *
+ * A least significant digit radix sort is used, where digits which are
+ * equal for all keys are skipped; the work is therefore linear in the number
+ * of keys and only a few passes are required for small or similar values.
+ *
+ * Returns 0 if successful or -1 in case of an allocation error, in which
+ * case `keys` and `idx` are left unchanged.
+ */
+int argsort_u64(uint64_t * keys, uint32_t * idx, size_t n)
+{
+    size_t (*counts)[256];
+    uint64_t * ktmp, * ksrc, * kdst;
+    uint32_t * itmp, * isrc, * idst;
+    size_t i, d;
+
+    if (n < ARGSORT__MIN_RADIX)
+    {
+        for (i = 0; i < n; ++i)
+            idx[i] = (uint32_t) i;
+        argsort__insertion(keys, idx, n);
+        return 0;
+    }
+
+    counts = calloc(8, sizeof(*counts));
+    ktmp = malloc(n * sizeof(uint64_t));
+    itmp = malloc(n * sizeof(uint32_t));
+
+    if (!counts || !ktmp || !itmp)
+    {
+        free(counts);
+        free(ktmp);
+        free(itmp);
+        return -1;
+    }
+
+    /* the digit counts do not depend on the order so collect them at once */
+    for (i = 0; i < n; ++i)
+    {
+        uint64_t key = keys[i];
+        for (d = 0; d < 8; ++d, key >>= 8)
+            ++counts[d][key & 0xff];
+        idx[i] = (uint32_t) i;
+    }
+
+    ksrc = keys;
+    kdst = ktmp;
+    isrc = idx;
+    idst = itmp;
+
+    for (d = 0; d < 8; ++d)
+    {
+        size_t * count = counts[d], pos = 0, c;
+        unsigned int shift = d * 8;
+        uint64_t * kswap;
+        uint32_t * iswap;
+
+        if (count[(ksrc[0] >> shift) & 0xff] == n)
+            continue;  /* digit is equal for all keys */
+
+        for (c = 0; c < 256; ++c)
+        {
+            size_t tmp = count[c];
+            count[c] = pos;
+            pos += tmp;
+        }
+
+        for (i = 0; i < n; ++i)
+        {
+            size_t at = count[(ksrc[i] >> shift) & 0xff]++;
+            kdst[at] = ksrc[i];
+            idst[at] = isrc[i];
+        }
+
+        kswap = ksrc; ksrc = kdst; kdst = kswap;
+        iswap = isrc; isrc = idst; idst = iswap;
+    }
+
+    if (ksrc != keys)
+    {
+        memcpy(keys, ksrc, n * sizeof(uint64_t));
+        memcpy(idx, isrc, n * sizeof(uint32_t));
+    }
+
+    free(counts);
+    free(ktmp);
+    free(itmp);
+    return 0;
+}
@@ -14,6 +14,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <util/fx.h>
+#include <util/fz.h>
 #include <util/logger.h>
 
 int fx_write(const char * fn, const void * data, size_t n)
@@ -41,6 +42,58 @@ int fx_write(const char * fn, const void * data, size_t n)
     return rc;
 }
 
+/*
+ * Copy file `src` to `dst`; the content is copied as is, so compressed files
+ * stay compressed. Returns 0 when successful or -1 in case of an error.
+ */
+int fx_copy(const char * src, const char * dst)
+{
+    char buf[65536];
+    size_t n;
+    int rc = 0;
+    FILE * fsrc, * fdst;
+
+    fsrc = fopen(src, "r");
+    if (!fsrc)
+    {
+        log_errno_file("cannot open file", errno, src);
+        return -1;
+    }
+
+    fdst = fopen(dst, "w");
+    if (!fdst)
+    {
+        log_errno_file("cannot open file", errno, dst);
+        (void) fclose(fsrc);
+        return -1;
+    }
+
+    while ((n = fread(buf, 1, sizeof(buf), fsrc)))
+    {
+        if (fwrite(buf, 1, n, fdst) != n)
+        {
+            log_error("cannot write %zu bytes to `%s`", n, dst);
+            rc = -1;
+            break;
+        }
+    }
+
+    if (ferror(fsrc))
+    {
+        log_error("cannot read from file `%s`", src);
+        rc = -1;
+    }
+
+    if (fclose(fdst))
+    {
+        log_errno_file("cannot close file", errno, dst);
+        rc = -1;
+    }
+
+    (void) fclose(fsrc);
+    return rc;
+}
+
 unsigned char * fx_read(const char * fn, ssize_t * size)
 {
     unsigned char * data = NULL;
@@ -73,6 +126,17 @@ unsigned char * fx_read(const char * fn, ssize_t * size)
         free(data);
         data = NULL;
     }
+    else if (fz_is_compressed(data, *size))
+    {
+        size_t n;
+        unsigned char * raw = fz_decompress(data, *size, &n);
+        if (!raw)
+            log_error("cannot decompress file `%s`", fn);
+        else
+            *size = (ssize_t) n;
+        free(data);
+        data = raw;
+    }
 
 final:
     if (fclose(fp))
@@ -288,6 +352,27 @@ int fx_mmap_open(fx_mmap_t * x)
     }
 
     x->n = (size_t) size;
+
+    if (fz_is_compressed(x->data, st.st_size))
+    {
+        /* compressed files are read in memory, see util/fz.h */
+        size_t n;
+        void * data = fz_decompress(x->data, st.st_size, &n);
+
+        if (munmap(x->data, x->n))
+            log_errno_file("memory unmap failed", errno, x->fn);
+
+        x->data = data;
+        if (!data)
+        {
+            log_error("cannot decompress file `%s`", x->fn);
+            goto fail;
+        }
+
+        x->n = n;
+        x->_is_alloc = true;
+    }
+
     return 0;
 
 fail:
@@ -298,6 +383,12 @@ fail:
 
 int fx_mmap_close(fx_mmap_t * x)
 {
+    if (x->_is_alloc)
+    {
+        free(x->data);
+        x->data = NULL;
+        x->_is_alloc = false;
+    }
     if (x->data && munmap(x->data, x->n))
     {
         log_errno_file("memory unmap failed", errno, x->fn);
@@ -0,0 +1,297 @@
+/*
+ * util/fz.c
+ */
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <util/fz.h>
+#include <util/logger.h>
+#include <zlib.h>
+
+static const char fz__magic[3] = {'T', 'I', 'Z'};
+
+/* maximum compression ratio of zlib (deflate) */
+#define FZ__MAX_RATIO 1032
+
+static inline void fz__put32(unsigned char * p, uint32_t v)
+{
+    p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+static inline uint32_t fz__get32(const unsigned char * p)
+{
+    return (
+        (uint32_t) p[0] |
+        (uint32_t) p[1] << 8 |
+        (uint32_t) p[2] << 16 |
+        (uint32_t) p[3] << 24
+    );
+}
+
+static inline void fz__put64(unsigned char * p, uint64_t v)
+{
+    fz__put32(p, (uint32_t) v);
+    fz__put32(p + 4, (uint32_t) (v >> 32));
+}
+
+static inline uint64_t fz__get64(const unsigned char * p)
+{
+    return (uint64_t) fz__get32(p) | (uint64_t) fz__get32(p + 4) << 32;
+}
+
+static int fz__header(fz_t * fz)
+{
+    unsigned char header[FZ_HEADER_SZ];
+
+    memcpy(header, fz__magic, sizeof(fz__magic));
+    header[3] = FZ_VERSION;
+    fz__put64(header + 4, fz->size);
+
+    return -(fwrite(header, FZ_HEADER_SZ, 1, fz->f) != 1);
+}
+
+static int fz__flush(fz_t * fz)
+{
+    size_t n;
+
+    if (!fz->n)
+        return 0;
+
+    n = fz_block_compress(fz->zbuf, fz->block, fz->n, fz->level);
+    if (!n)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    if (fwrite(fz->zbuf, 1, n, fz->f) != n)
+        return -1;
+
+    fz->n = 0;
+    return 0;
+}
+
+/*
+ * Open a file for writing. When `level` is 0, the file is written without
+ * compression and thus readable by older versions; otherwise `level` is the
+ * zlib compression level (1..9).
+ *
+ * Returns NULL in case of an error, `errno` is set.
+ */
+fz_t * fz_open(const char * fn, int level)
+{
+    fz_t * fz = calloc(1, sizeof(fz_t));
+    if (!fz)
+        return NULL;
+
+    fz->level = level > Z_BEST_COMPRESSION ? Z_BEST_COMPRESSION : level;
+
+    if (level)
+    {
+        fz->block = malloc(FZ_BLOCK_SZ);
+        fz->zbuf = malloc(fz_block_bound(FZ_BLOCK_SZ));
+        if (!fz->block || !fz->zbuf)
+            goto fail;
+    }
+
+    fz->f = fopen(fn, "w");
+    if (!fz->f)
+        goto fail;
+
+    if (level && fz__header(fz))
+    {
+        (void) fclose(fz->f);
+        goto fail;
+    }
+
+    return fz;
+
+fail:
+    free(fz->block);
+    free(fz->zbuf);
+    free(fz);
+    return NULL;
+}
+
+/*
+ * Write callback, compatible with msgpack_packer_init().
+ */
+int fz_write(void * data, const char * buf, size_t len)
+{
+    fz_t * fz = data;
+
+    if (!fz->level)
+        return -(fwrite(buf, len, 1, fz->f) != 1 && len);
+
+    fz->size += len;
+
+    while (len)
+    {
+        size_t n = FZ_BLOCK_SZ - fz->n;
+        if (n > len)
+            n = len;
+
+        memcpy(fz->block + fz->n, buf, n);
+        fz->n += n;
+        buf += n;
+        len -= n;
+
+        if (fz->n == FZ_BLOCK_SZ && fz__flush(fz))
+            return -1;
+    }
+    return 0;
+}
+
+/*
+ * Flush the last block, update the header and close the file. The `fz`
+ * object is destroyed, also in case of an error.
+ */
+int fz_close(fz_t * fz)
+{
+    int rc = 0;
+
+    if (fz->level && (
+            fz__flush(fz) ||
+            fseeko(fz->f, 0, SEEK_SET) ||
+            fz__header(fz)))
+        rc = -1;
+
+    if (fclose(fz->f))
+        rc = -1;
+
+    free(fz->block);
+    free(fz->zbuf);
+    free(fz);
+    return rc;
+}
+
+_Bool fz_is_compressed(const void * data, size_t n)
+{
+    return n >= FZ_HEADER_SZ && memcmp(data, fz__magic, 3) == 0;
+}
+
+/*
+ * Returns the decompressed data, which must be freed by the caller, or NULL
+ * if the data is invalid or allocation has failed. This is a log function.
+ */
+void * fz_decompress(const void * data, size_t n, size_t * size)
+{
+    const unsigned char * pt = data;
+    const unsigned char * end = pt + n;
+    unsigned char * out;
+    size_t total, pos = 0;
+
+    if (pt[3] != FZ_VERSION)
+    {
+        log_error("unsupported compressed file version: %u", pt[3]);
+        return NULL;
+    }
+
+    total = (size_t) fz__get64(pt + 4);
+    pt += FZ_HEADER_SZ;
+
+    /* the size is read from the file so check it before allocating */
+    if (total / FZ__MAX_RATIO > n - FZ_HEADER_SZ)
+        goto corrupt;
+
+    /* one extra byte so an empty file still returns an allocated buffer */
+    out = malloc(total + 1);
+    if (!out)
+    {
+        log_error("allocation error in `%s` at %s:%d",
+                __func__, __FILE__, __LINE__);
+        return NULL;
+    }
+
+    while (pt < end)
+    {
+        size_t zn, bn;
+
+        if (end - pt < FZ_BLOCK_HEADER_SZ)
+            goto invalid;
+
+        zn = FZ_BLOCK_HEADER_SZ + fz__get32(pt);
+        bn = fz__get32(pt + 4);
+
+        if ((size_t) (end - pt) < zn || total - pos < bn ||
+            fz_block_decompress(out + pos, pt, zn))
+            goto invalid;
+
+        pos += bn;
+        pt += zn;
+    }
+
+    if (pos != total)
+        goto invalid;
+
+    *size = total;
+    return out;
+
+invalid:
+    free(out);
+corrupt:
+    log_error("invalid or corrupt compressed data");
+    return NULL;
+}
+
+size_t fz_block_bound(size_t n)
+{
+    return FZ_BLOCK_HEADER_SZ + compressBound(n);
+}
+
+/*
+ * Compress `n` bytes at `src` into a single block at `dst`, which must have
+ * room for at least fz_block_bound(n) bytes. Returns the size of the block,
+ * including the block header, or 0 in case of an error.
+ */
+size_t fz_block_compress(
+        unsigned char * dst,
+        const void * src,
+        size_t n,
+        int level)
+{
+    uLongf zn = compressBound(n);
+
+    if (n > UINT32_MAX ||
+        compress2(dst + FZ_BLOCK_HEADER_SZ, &zn, src, n, level) != Z_OK)
+        return 0;
+
+    fz__put32(dst, (uint32_t) zn);
+    fz__put32(dst + 4, (uint32_t) n);
+
+    return FZ_BLOCK_HEADER_SZ + zn;
+}
+
+/*
+ * Returns the decompressed size of the block at `data`, or 0 if the data is
+ * not a complete block.
+ */
+size_t fz_block_size(const void * data, size_t n)
+{
+    const unsigned char * pt = data;
+    return (
+        n >= FZ_BLOCK_HEADER_SZ &&
+        n - FZ_BLOCK_HEADER_SZ == fz__get32(pt)
+    ) ? fz__get32(pt + 4) : 0;
+}
+
+/*
+ * Decompress the block at `data` into `dst`, which must have room for
+ * fz_block_size() bytes. Returns 0 on success or -1 if the block is invalid.
+ */
+int fz_block_decompress(unsigned char * dst, const void * data, size_t n)
+{
+    const unsigned char * pt = data;
+    uLongf bn = fz_block_size(data, n);
+
+    return -(
+        !bn ||
+        uncompress(
+            dst,
+            &bn,
+            pt + FZ_BLOCK_HEADER_SZ,
+            n - FZ_BLOCK_HEADER_SZ) != Z_OK ||
+        bn != fz__get32(pt + 4)
+    );
+}
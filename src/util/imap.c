@@ -9,188 +9,274 @@
 #include <util/logger.h>
 #include <tiinc.h>
 
-#define IMAP_NODE_SZ 32
+#define IMAP_BITS 6
+#define IMAP_MASK 0x3f
+#define IMAP_MAX_HEIGHT 11  /* 11 levels of 6 bits cover a 64 bit id */
 
-static int imap__nodes_dup(imap_node_t * dest, imap_node_t * node);
-
-static imap_node_t imap__empty_node = {
-        .data = NULL,
-        .nodes = NULL,
-        .sz = 0,
+enum
+{
+    IMAP__UNION,
+    IMAP__DIFFERENCE,
+    IMAP__INTERSECTION,
+    IMAP__SYMMDIFF,
 };
 
-static inline uint8_t imap__node_size(imap_node_t * node)
+static inline unsigned int imap__count(uint64_t bits)
 {
-    return node->key == IMAP_NODE_SZ ? IMAP_NODE_SZ : 1;
+    return (unsigned int) __builtin_popcountll(bits);
 }
 
-static inline imap_node_t * imap__unsafe_node(imap_node_t * node, uint8_t key)
+/*
+ * Returns the position of the item or child node in the node items.
+ */
+static inline unsigned int imap__idx(uint64_t bits, uint8_t digit)
 {
-    return node->key == IMAP_NODE_SZ
-            ? node->nodes + key
-            : node->nodes;
+    return imap__count(bits & ((1ULL << digit) - 1));
 }
 
-static inline imap_node_t * imap__get_node(imap_node_t * node, uint8_t key)
+static inline uint8_t imap__digit(uint64_t id, uint8_t level)
 {
-    return node->key == IMAP_NODE_SZ
-            ? node->nodes + key
-            : node->key == key ? node->nodes : NULL;
+    return (id >> (level * IMAP_BITS)) & IMAP_MASK;
 }
 
-static inline imap_node_t * imap__ensure_node(imap_node_t * node, uint8_t key)
+static inline _Bool imap__fits(uint64_t id, uint32_t height)
 {
-    return node->key == IMAP_NODE_SZ
-            ? node->nodes + key
-            : node->key == key ? node->nodes : &imap__empty_node;
+    return height >= IMAP_MAX_HEIGHT || !(id >> (height * IMAP_BITS));
 }
 
-static inline int imap__node_grow(imap_node_t * node)
+/*
+ * Returns the height which is required to store the given id.
+ */
+static inline uint32_t imap__height(uint64_t id)
 {
-    imap_node_t * tmp = calloc(IMAP_NODE_SZ, sizeof(imap_node_t));
-    if (!tmp)
-        return -1;
-    memcpy(tmp + node->key, node->nodes, sizeof(imap_node_t));
-    free(node->nodes);
-    node->nodes = tmp;
-    node->key = IMAP_NODE_SZ;
-    return 0;
+    uint32_t height = 1;
+    while (!imap__fits(id, height))
+        ++height;
+    return height;
 }
 
-
 /*
- * Returns a new imap or NULL in case of an allocation error.
+ * Items are allocated using a power of two for the size so a node only needs
+ * to grow when the number of items hits such boundary.
  */
-imap_t * imap_create(void)
+static inline size_t imap__size(unsigned int n)
 {
-    return calloc(1, sizeof(imap_t) + IMAP_NODE_SZ * sizeof(imap_node_t));
+    return sizeof(imap_node_t) + (n <= 1
+            ? 1
+            : (size_t) 1 << (64 - __builtin_clzll(n - 1))) * sizeof(void *);
 }
 
-static void imap__node_destroy(imap_node_t * node)
+static inline void imap__decref(void * data)
 {
-    imap_node_t * nd = node->nodes, * end = nd + imap__node_size(node);
-
-    do
-        if (nd->nodes)
-            imap__node_destroy(nd);
-    while (++nd < end);
+    ti_decref((ti_ref_t *) data);
+}
 
-    free(node->nodes);
+static imap_node_t * imap__node_create(void * item, uint8_t digit)
+{
+    imap_node_t * node = malloc(imap__size(1));
+    if (!node)
+        return NULL;
+    node->bits = 1ULL << digit;
+    node->items[0] = item;
+    return node;
 }
 
-static void imap__node_destroy_cb(imap_node_t * node, imap_destroy_cb cb)
+/*
+ * Destroy a node and all child nodes; The call-back is optional and is called
+ * for every item. Returns the number of items in the node.
+ */
+static size_t imap__node_destroy(
+        imap_node_t * node,
+        uint8_t level,
+        imap_destroy_cb cb)
 {
-    imap_node_t * nd = node->nodes, * end = nd + imap__node_size(node);
+    size_t n = imap__count(node->bits);
+    void ** item = node->items, ** end = item + n;
 
-    do
+    if (level)
     {
-        if (nd->data)
-        {
-            (*cb)(nd->data);
-        }
-
-        if (nd->nodes)
-        {
-            imap__node_destroy_cb(nd, cb);
-        }
+        n = 0;
+        for (; item < end; ++item)
+            n += imap__node_destroy(*item, level - 1, cb);
+    }
+    else if (cb)
+    {
+        for (; item < end; ++item)
+            (*cb)(*item);
     }
-    while (++nd < end);
-    free(node->nodes);
+
+    free(node);
+    return n;
 }
 
 /*
- * Destroy imap with optional call-back function.
+ * Add an item to a node; The digit must not exist in this node.
  */
-void imap_destroy(imap_t * imap, imap_destroy_cb cb)
+static int imap__node_add(imap_node_t ** addr, uint8_t digit, void * item)
 {
-    if (!imap)
-        return;
+    imap_node_t * node = *addr;
+    unsigned int n = imap__count(node->bits);
+    unsigned int idx = imap__idx(node->bits, digit);
 
-    if (imap->n)
+    if (n && !(n & (n - 1)))
     {
-        imap_node_t * nd = imap->nodes, * end = nd + IMAP_NODE_SZ;
-        if (!cb)
-        {
-            do
-                if (nd->nodes)
-                    imap__node_destroy(nd);
-            while (++nd < end);
-        }
-        else
-        {
-            do
-            {
-                if (nd->data)
-                    (*cb)(nd->data);
+        node = realloc(node, imap__size(n + 1));
+        if (!node)
+            return -1;
+        *addr = node;
+    }
 
-                if (nd->nodes)
-                    imap__node_destroy_cb(nd, cb);
-            }
-            while (++nd < end);
-        }
+    memmove(
+        node->items + idx + 1,
+        node->items + idx,
+        (n - idx) * sizeof(void *));
+    node->items[idx] = item;
+    node->bits |= 1ULL << digit;
+    return 0;
+}
+
+/*
+ * Remove an item from a node. When this was the last item, the node will be
+ * destroyed and the return value is `false`.
+ */
+static _Bool imap__node_del(imap_node_t ** addr, uint8_t digit)
+{
+    imap_node_t * node = *addr;
+    unsigned int n = imap__count(node->bits);
+    unsigned int idx = imap__idx(node->bits, digit);
+
+    if (n == 1)
+    {
+        free(node);
+        *addr = NULL;
+        return false;
     }
 
-    free(imap);
+    memmove(
+        node->items + idx,
+        node->items + idx + 1,
+        (--n - idx) * sizeof(void *));
+    node->bits &= ~(1ULL << digit);
+
+    if (!(n & (n - 1)))
+    {
+        /* shrink is not critical so ignore allocation errors */
+        node = realloc(node, imap__size(n));
+        if (node)
+            *addr = node;
+    }
+    return true;
 }
 
 /*
- * Destroy imap with optional call-back function.
+ * Increase the height of the map; This is required before an id which does
+ * not fit in the current height can be added.
  */
-void imap_clear(imap_t * imap, imap_destroy_cb cb)
+static int imap__grow(imap_t * imap, uint32_t height)
 {
-    assert(imap);
-    if (imap->n)
+    while (imap->height < height)
     {
-        imap_node_t * nd = imap->nodes, * end = nd + IMAP_NODE_SZ;
-        do
+        if (imap->root)
         {
-            if (nd->data && cb)
-                (*cb)(nd->data);
-
-            if (nd->nodes)
-                imap__node_destroy_cb(nd, cb);
+            imap_node_t * node = imap__node_create(imap->root, 0);
+            if (!node)
+                return -1;
+            imap->root = node;
         }
-        while (++nd < end);
-
-        /* reset everything to 0 */
-        memset(imap, 0, sizeof(imap_t) + IMAP_NODE_SZ * sizeof(imap_node_t));
+        imap->height++;
     }
+    return 0;
 }
 
-static void * imap__set(imap_node_t * node, uint64_t id, void * data)
+/*
+ * Returns 0 when the data is added to the map. When the id already exists the
+ * return value is IMAP_ERR_EXIST and `slot` is set to the existing item.
+ */
+static int imap__insert(imap_t * imap, uint64_t id, void * data, void *** slot)
 {
-    void * ret;
-    uint8_t key = id % IMAP_NODE_SZ;
-    imap_node_t * nd;
+    imap_node_t ** addr = &imap->root, * node;
+    void * item = data;
+    uint32_t level;
 
-    if (!node->sz)
+    if (imap__grow(imap, imap__height(id)))
+        return IMAP_ERR_ALLOC;
+
+    level = imap->height;
+    while ((node = *addr))
     {
-        node->nodes = calloc(1, sizeof(imap_node_t));
-        if (!node->nodes)
-            return NULL;
-        node->key = key;
-    }
-    else if (node->key != key &&
-             node->key != IMAP_NODE_SZ &&
-             imap__node_grow(node))
-        return NULL;
+        uint8_t digit = imap__digit(id, --level);
+        void ** pos;
+
+        if (!(node->bits & (1ULL << digit)))
+            break;
+
+        pos = node->items + imap__idx(node->bits, digit);
+        if (!level)
+        {
+            *slot = pos;
+            return IMAP_ERR_EXIST;
+        }
 
-    nd = imap__unsafe_node(node, key);
-    id /= IMAP_NODE_SZ;
+        addr = (imap_node_t **) pos;
+    }
 
-    if (!id)
+    /* create the missing path, bottom up, below `level` */
+    for (uint32_t l = 0; l < level; ++l)
     {
-        ret = nd->data ? nd->data : data;
-        nd->data = data;
+        imap_node_t * tmp = imap__node_create(item, imap__digit(id, l));
+        if (!tmp)
+        {
+            if (l)
+                (void) imap__node_destroy(item, l - 1, NULL);
+            return IMAP_ERR_ALLOC;
+        }
+        item = tmp;
     }
-    else
+
+    if (!node)
+        *addr = item;
+    else if (imap__node_add(addr, imap__digit(id, level), item))
     {
-        ret = imap__set(nd, id - 1, data);
+        if (level)
+            (void) imap__node_destroy(item, level - 1, NULL);
+        return IMAP_ERR_ALLOC;
     }
 
-    node->sz += (ret == data);
+    imap->n++;
+    return IMAP_SUCCESS;
+}
+
+/*
+ * Returns a new imap or NULL in case of an allocation error.
+ */
+imap_t * imap_create(void)
+{
+    return calloc(1, sizeof(imap_t));
+}
+
+/*
+ * Destroy imap with optional call-back function.
+ */
+void imap_destroy(imap_t * imap, imap_destroy_cb cb)
+{
+    if (!imap)
+        return;
+
+    imap_clear(imap, cb);
+    free(imap);
+}
+
+/*
+ * Clear imap with optional call-back function.
+ */
+void imap_clear(imap_t * imap, imap_destroy_cb cb)
+{
+    assert(imap);
+
+    if (imap->root)
+        (void) imap__node_destroy(imap->root, imap->height - 1, cb);
 
-    return ret;
+    memset(imap, 0, sizeof(imap_t));
 }
 
 /*
@@ -203,61 +289,20 @@ static void * imap__set(imap_node_t * node, uint64_t id, void * data)
 void * imap_set(imap_t * imap, uint64_t id, void * data)
 {
     assert(data != NULL);
-    void * ret;
-    imap_node_t * nd = imap->nodes + (id % IMAP_NODE_SZ);
-    id /= IMAP_NODE_SZ;
+    void ** slot;
 
-    if (!id)
+    switch (imap__insert(imap, id, data, &slot))
     {
-        ret = nd->data ? nd->data : data;
-        nd->data = data;
-    }
-    else
-    {
-        ret = imap__set(nd, id - 1, data);
-    }
-
-    imap->n += (ret == data);
-    return ret;
-}
-
-static int imap__add(imap_node_t * node, uint64_t id, void * data)
-{
-    int rc;
-    uint8_t key = id % IMAP_NODE_SZ;
-    imap_node_t * nd;
-
-    if (!node->sz)
+    case IMAP_SUCCESS:
+        return data;
+    case IMAP_ERR_EXIST:
     {
-        node->nodes = calloc(1, sizeof(imap_node_t));
-        if (!node->nodes)
-            return IMAP_ERR_ALLOC;
-        node->key = key;
+        void * prev = *slot;
+        *slot = data;
+        return prev;
     }
-    else if (node->key != key &&
-             node->key != IMAP_NODE_SZ &&
-             imap__node_grow(node))
-        return IMAP_ERR_ALLOC;
-
-    nd = imap__unsafe_node(node, key);
-    id /= IMAP_NODE_SZ;
-
-    if (!id)
-    {
-        if (nd->data)
-            return IMAP_ERR_EXIST;
-
-        nd->data = data;
-        node->sz++;
-
-        return 0;
     }
-
-    rc = imap__add(nd, id - 1, data);
-
-    node->sz += (rc == 0);
-
-    return rc;
+    return NULL;
 }
 
 /*
@@ -271,23 +316,8 @@ static int imap__add(imap_node_t * node, uint64_t id, void * data)
 int imap_add(imap_t * imap, uint64_t id, void * data)
 {
     assert(data != NULL);
-    imap_node_t * nd = imap->nodes + (id % IMAP_NODE_SZ);
-    id /= IMAP_NODE_SZ;
-
-    if (!id)
-    {
-        if (nd->data)
-            return IMAP_ERR_EXIST;
-        nd->data = data;
-    }
-    else
-    {
-        int rc = imap__add(nd, id - 1, data);
-        if (rc)
-            return rc;
-    }
-    imap->n++;
-    return 0;
+    void ** slot;
+    return imap__insert(imap, id, data, &slot);
 }
 
 /*
@@ -295,94 +325,46 @@ int imap_add(imap_t * imap, uint64_t id, void * data)
  */
 void * imap_get(imap_t * imap, uint64_t id)
 {
-    imap_node_t * nd = imap->nodes + (id % IMAP_NODE_SZ);
-    do
-    {
-        id /= IMAP_NODE_SZ;
+    imap_node_t * node = imap->root;
+    uint32_t level = imap->height;
 
-        if (!id)
-            return nd->data;
+    if (!node || !imap__fits(id, level))
+        return NULL;
 
-        if (!nd->nodes)
-            return NULL;
+    while (1)
+    {
+        uint8_t digit = imap__digit(id, --level);
+        void * item;
 
-        nd = imap__get_node(nd, --id % IMAP_NODE_SZ);
-    }
-    while (nd);
+        /* a full node has the item at `digit`; fetch while reading bits */
+        __builtin_prefetch(node->items + digit);
 
-    return NULL;
-}
+        if (!(node->bits & (1ULL << digit)))
+            return NULL;
 
-void * imap__one(imap_node_t * node)
-{
-    imap_node_t * nd = node->nodes, * end = nd + imap__node_size(node);
-    do
-    {
-        if (nd->data)
-            return  nd->data;
+        item = node->items[imap__idx(node->bits, digit)];
+        if (!level)
+            return item;
 
-        if (nd->nodes)
-            return imap__one(nd);
+        node = item;
     }
-    while (++nd < end);
-    assert(0);  /* should always have data */
-    return NULL;
 }
 
+/*
+ * Returns the item with the lowest id, or NULL if the map is empty.
+ */
 void * imap_one(imap_t * imap)
 {
-    if (imap->n)
-    {
-        imap_node_t * nd = imap->nodes, * end = nd + IMAP_NODE_SZ;
-        do
-        {
-            if (nd->data)
-                return  nd->data;
-
-            if (nd->nodes)
-                return imap__one(nd);
-        }
-        while (++nd < end);
-    }
-    return NULL;
-}
+    imap_node_t * node = imap->root;
+    uint32_t level = imap->height;
 
-static void * imap__pop(imap_node_t * node, uint64_t id)
-{
-    void * data;
-    imap_node_t * nd = imap__get_node(node, id % IMAP_NODE_SZ);
-    if (!nd)
+    if (!node)
         return NULL;
 
-    id /= IMAP_NODE_SZ;
-
-    if (!id)
-    {
-        if ((data = nd->data))
-        {
-            if (--node->sz)
-            {
-                nd->data = NULL;
-            }
-            else
-            {
-                free(node->nodes);
-                node->nodes = NULL;
-            }
-        }
-
-        return data;
-    }
-
-    data = nd->nodes ? imap__pop(nd, id - 1) : NULL;
-
-    if (data && !--node->sz)
-    {
-        free(node->nodes);
-        node->nodes = NULL;
-    }
+    while (--level)
+        node = node->items[0];
 
-    return data;
+    return node->items[0];
 }
 
 /*
@@ -390,69 +372,119 @@ static void * imap__pop(imap_node_t * node, uint64_t id)
  */
 void * imap_pop(imap_t * imap, uint64_t id)
 {
+    imap_node_t ** path[IMAP_MAX_HEIGHT], ** addr = &imap->root;
+    uint8_t digits[IMAP_MAX_HEIGHT];
+    uint32_t level = imap->height;
     void * data;
-    imap_node_t * nd = imap->nodes + (id % IMAP_NODE_SZ);
-    id /= IMAP_NODE_SZ;
 
-    if (id)
-    {
-        data = nd->nodes ? imap__pop(nd, id - 1) : NULL;
-    }
-    else if ((data = nd->data))
+    if (!imap->root || !imap__fits(id, level))
+        return NULL;
+
+    while (level--)
     {
-        nd->data = NULL;
+        imap_node_t * node = *addr;
+        uint8_t digit = imap__digit(id, level);
+
+        if (!(node->bits & (1ULL << digit)))
+            return NULL;
+
+        path[level] = addr;
+        digits[level] = digit;
+        addr = (imap_node_t **) (node->items + imap__idx(node->bits, digit));
     }
 
-    if (data)
-        imap->n--;
+    data = *addr;
+
+    /* remove bottom up, this way each `path` still points to a valid slot */
+    for (level = 0; level < imap->height; ++level)
+        if (imap__node_del(path[level], digits[level]))
+            break;
+
+    if (!--imap->n)
+        imap->height = 0;
 
     return data;
 }
 
-static int imap__walk(imap_node_t * node, imap_cb cb, void * arg)
+static int imap__walk(
+        imap_node_t * node,
+        uint32_t level,
+        imap_cb cb,
+        void * arg)
 {
     int rc;
-    imap_node_t * nd = node->nodes, * end = nd + imap__node_size(node);
+    void ** item = node->items, ** end = item + imap__count(node->bits);
 
-    do
+    if (level)
     {
-        if (nd->data && (rc = (*cb)(nd->data, arg)))
-            return rc;
-
-        if (nd->nodes && (rc = imap__walk(nd, cb, arg)))
-            return rc;
+        for (; item < end; ++item)
+            if ((rc = imap__walk(*item, level - 1, cb, arg)))
+                return rc;
+    }
+    else
+    {
+        for (; item < end; ++item)
+            if ((rc = (*cb)(*item, arg)))
+                return rc;
     }
-    while (++nd < end);
-
     return 0;
 }
 
 /*
- * Run the call-back function on all items in the map.
+ * Run the call-back function on all items in the map, ordered by id.
  *
  * Walking stops on the first callback returning a non zero value.
  * The return value is the last callback result. A return value of 0 means that
  * the callback function is called on all items in the map.
+ *
+ * The call-back must not add or remove items to or from the map; use
+ * `imap_walk_cp()` if this is required.
  */
 int imap_walk(imap_t * imap, imap_cb cb, void * arg)
 {
-    int rc = 0;
+    return imap->root ? imap__walk(imap->root, imap->height - 1, cb, arg) : 0;
+}
 
-    if (imap->n)
-    {
-        imap_node_t * nd = imap->nodes, * end = nd + IMAP_NODE_SZ;
-        do
-        {
-            if (nd->data && (rc = (*cb)(nd->data, arg)))
-                return rc;
+static int imap__walk_from(
+        imap_node_t * node,
+        uint32_t level,
+        uint64_t id,
+        imap_cb cb,
+        void * arg)
+{
+    int rc;
+    uint8_t digit = imap__digit(id, level);
+    void ** item = node->items + imap__idx(node->bits, digit),
+         ** end = node->items + imap__count(node->bits);
 
-            if (nd->nodes && (rc = imap__walk(nd, cb, arg)))
+    if (!level)
+    {
+        for (; item < end; ++item)
+            if ((rc = (*cb)(*item, arg)))
                 return rc;
-        }
-        while (++nd < end);
+        return 0;
     }
 
-    return rc;
+    /* only the child node at `digit` may contain id's lower than `id` */
+    if ((node->bits & (1ULL << digit)) &&
+        (rc = imap__walk_from(*item++, level - 1, id, cb, arg)))
+        return rc;
+
+    for (; item < end; ++item)
+        if ((rc = imap__walk(*item, level - 1, cb, arg)))
+            return rc;
+    return 0;
+}
+
+/*
+ * Like `imap_walk()` but skips all items with an id lower than `id`. This can
+ * be used to continue a walk which was stopped by the call-back function.
+ */
+int imap_walk_from(imap_t * imap, uint64_t id, imap_cb cb, void * arg)
+{
+    return imap->root && imap__fits(id, imap->height)
+        ? imap__walk_from(imap->root, imap->height - 1, id, cb, arg)
+        : 0;
 }
 
 int imap_walk_cp(
@@ -475,17 +507,21 @@ int imap_walk_cp(
     return rc;
 }
 
-static void imap__walkn(imap_node_t * node, imap_cb cb, void * arg, size_t * n)
+static void imap__walkn(
+        imap_node_t * node,
+        uint32_t level,
+        size_t * n,
+        imap_cb cb,
+        void * arg)
 {
-    imap_node_t * nd = node->nodes, * end = nd + imap__node_size(node);
+    void ** item = node->items, ** end = item + imap__count(node->bits);
 
-    for (; *n && nd < end; ++nd)
+    for (; *n && item < end; ++item)
     {
-        if (nd->data && !(*n -= (*cb)(nd->data, arg)))
-            return;
-
-        if (nd->nodes)
-            imap__walkn(nd, cb, arg, n);
+        if (level)
+            imap__walkn(*item, level - 1, n, cb, arg);
+        else
+            *n -= (*cb)(*item, arg);
     }
 }
 
@@ -497,117 +533,45 @@ static void imap__walkn(imap_node_t * node, imap_cb cb, void * arg, size_t * n)
  */
 void imap_walkn(imap_t * imap, size_t * n, imap_cb cb, void * arg)
 {
-    if (imap->n)
-    {
-        imap_node_t * nd = imap->nodes, * end = nd + IMAP_NODE_SZ;
-        do
-        {
-            if (nd->data && !(*n -= (*cb)(nd->data, arg)))
-                return;
-
-            if (nd->nodes)
-                imap__walkn(nd, cb, arg, n);
-        }
-        while (++nd < end);
-    }
+    if (imap->root)
+        imap__walkn(imap->root, imap->height - 1, n, cb, arg);
 }
 
-static _Bool imap__eq(imap_node_t * nodea, imap_node_t * nodeb)
+/*
+ * Returns the node of `imap` at the given level, or NULL if the map has no
+ * items at this level. The level must be below the height of the map and
+ * `other` is set to `true` when the map contains higher id's.
+ */
+static imap_node_t * imap__at(imap_t * imap, uint32_t level, _Bool * other)
 {
-    if (nodea->key == nodeb->key)
-    {
-        imap_node_t
-                * nda = nodea->nodes,
-                * ndb = nodeb->nodes,
-                * end = nda + imap__node_size(nodea);
-
-        for (; nda < end; ++nda, ++ndb)
-            if (nda->sz != ndb->sz ||
-                nda->data != ndb->data ||
-                !nda->nodes != !ndb->nodes ||
-                (nda->nodes && !imap__eq(nda, ndb)))
-                return false;
-        return true;
-    }
+    imap_node_t * node = imap->root;
+    uint32_t height = imap->height;
 
-    if (nodeb->key == IMAP_NODE_SZ)
-    {
-        imap_node_t * tmp = nodea;
-        nodea = nodeb;
-        nodeb = tmp;
-    }
-    else if (nodea->key != IMAP_NODE_SZ)
-        return false;
+    assert(level < height);
 
-    /* check if the nodes are equal unless the key's are different */
+    for (*other = false; node && height > level + 1; --height)
     {
-        uint8_t key = 0;
-        imap_node_t
-                * nda = nodea->nodes,
-                * ndb = nodeb->nodes,
-                * end = nda + IMAP_NODE_SZ;
-
-        for (; nda < end; ++nda, ++key)
-            if ((nodeb->key == key && (
-                    nda->sz != ndb->sz ||
-                    nda->data != ndb->data ||
-                    !nda->nodes != !ndb->nodes ||
-                    (nda->nodes && !imap__eq(nda, ndb))
-                )) || (nodeb->key != key && nda->sz))
-                return false;
-        return true;
+        *other |= node->bits != 1;
+        node = node->bits & 1 ? node->items[0] : NULL;
     }
+    return node;
 }
 
-static _Bool imap__le(imap_node_t * nodea, imap_node_t * nodeb)
+static _Bool imap__eq(imap_node_t * a, imap_node_t * b, uint32_t level)
 {
-    if (nodea->key == nodeb->key)
-    {
-        imap_node_t
-                * nda = nodea->nodes,
-                * ndb = nodeb->nodes,
-                * end = nda + imap__node_size(nodea);
-
-        for (; nda < end; ++nda, ++ndb)
-            if (nda->sz > ndb->sz ||
-                (nda->data && !ndb->data) ||
-                (nda->nodes && !ndb->nodes) ||
-                (nda->nodes && !imap__le(nda, ndb)))
-                return false;
-        return true;
-    }
+    size_t n = imap__count(a->bits);
 
-    if (nodeb->key == IMAP_NODE_SZ)
-    {
-        imap_node_t
-                * nda = nodea->nodes,
-                * ndb = nodeb->nodes + nodea->key;
-        return !(nda->sz > ndb->sz ||
-                (nda->data && !ndb->data) ||
-                (nda->nodes && !ndb->nodes) ||
-                (nda->nodes && !imap__le(nda, ndb)));
-    }
+    if (a->bits != b->bits)
+        return false;
 
-    if (nodea->key == IMAP_NODE_SZ)
-    {
-        uint8_t key = 0;
-        imap_node_t
-                * nda = nodea->nodes,
-                * ndb = nodeb->nodes,
-                * end = nda + IMAP_NODE_SZ;
-
-        for (; nda < end; ++nda, ++key)
-            if ((nodeb->key == key && (
-                    nda->sz > ndb->sz ||
-                    (nda->data && !ndb->data) ||
-                    (nda->nodes && !ndb->nodes) ||
-                    (nda->nodes && !imap__le(nda, ndb))
-                )) || (nodeb->key != key && nda->sz))
-                return false;
-        return true;
-    }
+    if (!level)
+        return memcmp(a->items, b->items, n * sizeof(void *)) == 0;
+
+    for (size_t i = 0; i < n; ++i)
+        if (!imap__eq(a->items[i], b->items[i], level - 1))
+            return false;
 
-    return false;
+    return true;
 }
 
 /*
@@ -615,157 +579,129 @@ static _Bool imap__le(imap_node_t * nodea, imap_node_t * nodeb)
  */
 _Bool imap__eq_(imap_t * a, imap_t * b)
 {
-    imap_node_t
-            * nda = a->nodes,
-            * ndb = b->nodes,
-            * end = nda + IMAP_NODE_SZ;
+    imap_node_t * nb;
+    uint32_t level;
+    _Bool other;
 
     assert(a != b && a->n == b->n && a->n);
 
-    for (; nda < end; ++nda, ++ndb)
-        if (nda->data != ndb->data ||
-            !nda->nodes != !ndb->nodes ||
-            (nda->nodes && !imap__eq(nda, ndb)))
-            return false;
-
-    return true;
+    if (a->height > b->height)
+    {
+        imap_t * tmp = a;
+        a = b;
+        b = tmp;
+    }
+
+    /* align `b` with the root of the lower map `a` */
+    level = a->height - 1;
+    nb = imap__at(b, level, &other);
+
+    /* when `b` has higher id's, these cannot exist in `a` */
+    return !other && nb && imap__eq(a->root, nb, level);
+}
+
+static _Bool imap__le(imap_node_t * a, imap_node_t * b, uint32_t level)
+{
+    void ** item = a->items, ** end = item + imap__count(a->bits);
+
+    if (a->bits & ~b->bits)
+        return false;
+
+    if (level)
+        for (uint64_t bits = a->bits; item < end; ++item, bits &= bits - 1)
+            if (!imap__le(
+                    *item,
+                    b->items[imap__idx(b->bits, __builtin_ctzll(bits))],
+                    level - 1))
+                return false;
+
+    return true;
 }
 
 /*
- * Returns `true` if the given imap objects are equal
+ * Returns `true` if all id's in `a` are also in `b`
  */
 _Bool imap__le_(imap_t * a, imap_t * b)
 {
-    imap_node_t
-            * nda = a->nodes,
-            * ndb = b->nodes,
-            * end = nda + IMAP_NODE_SZ;
+    imap_node_t * na, * nb;
+    uint32_t level = (a->height < b->height ? a : b)->height - 1;
+    _Bool other;
 
     assert(a != b && a->n <= b->n && a->n);
 
-    for (; nda < end; ++nda, ++ndb)
-        if ((nda->data && !ndb->data) ||
-            (nda->nodes && !ndb->nodes) ||
-            (nda->nodes && !imap__le(nda, ndb)))
-            return false;
+    na = imap__at(a, level, &other);
+    if (other)
+        return false;  /* `a` has id's which do not fit in `b` */
 
-    return true;
+    nb = imap__at(b, level, &other);
+    return na && nb && imap__le(na, nb, level);
 }
 
-static void imap__vec(imap_node_t * node, vec_t * vec)
+static void imap__vec(imap_node_t * node, uint32_t level, vec_t * vec)
 {
-    imap_node_t * nd = node->nodes, * end = nd + imap__node_size(node);
+    void ** item = node->items;
+    size_t n = imap__count(node->bits);
 
-    do
+    if (!level)
     {
-        if (nd->data)
-            VEC_push(vec, nd->data);
-
-        if (nd->nodes)
-            imap__vec(nd, vec);
+        memcpy(vec->data + vec->n, item, n * sizeof(void *));
+        vec->n += n;
+        return;
     }
-    while (++nd < end);
+
+    for (void ** end = item + n; item < end; ++item)
+        imap__vec(*item, level - 1, vec);
 }
 
 /*
- * Returns a pointer to imap->vec or NULL in case an allocation error has
- * occurred.
- *
- * The imap->vec will be created if it does not yet exist.
+ * Returns a new vector with all items in the map, ordered by id, or NULL in
+ * case an allocation error has occurred.
  */
 vec_t * imap_vec(imap_t * imap)
 {
     vec_t * vec = vec_new(imap->n);
-    if (vec && imap->n)
-    {
-        imap_node_t * nd = imap->nodes, * end = nd + IMAP_NODE_SZ;
-        do
-        {
-            if (nd->data)
-                VEC_push(vec, nd->data);
-
-            if (nd->nodes)
-                imap__vec(nd, vec);
-        }
-        while (++nd < end);
-    }
+    if (vec && imap->root)
+        imap__vec(imap->root, imap->height - 1, vec);
     return vec;
 }
 
-static void imap__vec_ref(imap_node_t * node, vec_t * vec)
-{
-    imap_node_t * nd = node->nodes, * end = nd + imap__node_size(node);
-
-    do
-    {
-        if (nd->data)
-        {
-            VEC_push(vec, nd->data);
-            ti_incref((ti_ref_t *) nd->data);
-        }
-        if (nd->nodes)
-            imap__vec_ref(nd, vec);
-    }
-    while (++nd < end);
-}
-
 /*
- * Returns a pointer to imap->vec or NULL in case an allocation error has
- * occurred.
- *
- * The imap->vec will be created if it does not yet exist.
+ * Same as `imap_vec()` except that each item gets a new reference.
  */
 vec_t * imap_vec_ref(imap_t * imap)
 {
-    vec_t * vec = vec_new(imap->n);
-    if (vec && imap->n)
-    {
-        imap_node_t * nd = imap->nodes, * end = nd + IMAP_NODE_SZ;
-        do
-        {
-            if (nd->data)
-            {
-                VEC_push(vec, nd->data);
-                ti_incref((ti_ref_t *) nd->data);
-            }
-            if (nd->nodes)
-                imap__vec_ref(nd, vec);
-        }
-        while (++nd < end);
-    }
+    vec_t * vec = imap_vec(imap);
+    if (vec)
+        for (vec_each(vec, ti_ref_t, data))
+            ti_incref(data);
     return vec;
 }
 
-static uint64_t imap__unused_id(imap_node_t * node, uint64_t max)
+/*
+ * Returns the lowest free offset within a node, or UINT64_MAX when the node
+ * is full.
+ */
+static uint64_t imap__unused_id(imap_node_t * node, uint32_t level)
 {
-    imap_node_t * nd = node->nodes;
-    size_t i, n, m, r;
-
-    if (node->key != IMAP_NODE_SZ)
-        return (node->key+1) % IMAP_NODE_SZ;
+    void ** item = node->items;
+    uint32_t shift = level * IMAP_BITS;
 
-    for (i = 0; i < IMAP_NODE_SZ; ++i, ++nd)
-        if (!nd->data)
-            return i;  /* we don't care if larger than max */
+    if (!level)
+        return ~node->bits
+                ? (uint64_t) __builtin_ctzll(~node->bits)
+                : UINT64_MAX;
 
-    n = IMAP_NODE_SZ + IMAP_NODE_SZ;
-    n = n < max ? n : max;
-    m = max / IMAP_NODE_SZ - 1;
-    nd = node->nodes;
-
-    for (i = IMAP_NODE_SZ; i < n; ++i, ++nd)
+    for (uint64_t digit = 0; digit <= IMAP_MASK; ++digit)
     {
-        if (!nd->nodes)
-            return i;
+        uint64_t r;
+        if (!(node->bits & (1ULL << digit)))
+            return digit << shift;
 
-        if ((r = imap__unused_id(nd, m)) < m)
-        {
-            r *= IMAP_NODE_SZ;
-            r += i;
-            return r;
-        }
+        r = imap__unused_id(*item++, level - 1);
+        if (r != UINT64_MAX)
+            return (digit << shift) + r;
     }
-    return max;
+    return UINT64_MAX;
 }
 
 /*
@@ -773,837 +709,445 @@ static uint64_t imap__unused_id(imap_node_t * node, uint64_t max)
  * the returned value will be equal to `max`. (This does not mean that `max`
  * is free to use)
  *
- * Note: the return value is not necessary the lowest free id, for example, 64
- * might be returned as a free id while 33 is also a free id.
+ * The returned id is the lowest free id.
  */
 uint64_t imap_unused_id(imap_t * imap, uint64_t max)
 {
-    imap_node_t * nd = imap->nodes;
-    size_t i, n, m, r;
+    uint64_t id;
 
-    if (!imap->n)
+    if (!imap->root)
         return 0;
 
-    for (i = 0; i < IMAP_NODE_SZ; ++i, ++nd)
-        if (!nd->data)
-            return i > max ? max : i;
-
-    n = IMAP_NODE_SZ + IMAP_NODE_SZ;
-    n = n < max ? n : max;
-    m = max / IMAP_NODE_SZ;
-    nd = imap->nodes;
-
-    for (i = IMAP_NODE_SZ; i < n; ++i, ++nd)
-    {
-        if (!nd->nodes)
-            return i;
-
-        if ((r = imap__unused_id(nd, m)) < m)
-        {
-            r *= IMAP_NODE_SZ;
-            r += i;
-            if (r < max)
-                return r;
-        }
-    }
+    id = imap__unused_id(imap->root, imap->height - 1);
+    if (id == UINT64_MAX && imap->height < IMAP_MAX_HEIGHT)
+        id = 1ULL << (imap->height * IMAP_BITS);
 
-    return max;
+    return id < max ? id : max;
 }
 
-static void imap__union_move(imap_node_t * dest, imap_node_t * node)
+/*
+ * Make sure node `a`, and the child nodes which are shared with `b`, can hold
+ * the items of both `a` and `b`. This must be done before moving so an
+ * allocation error leaves both maps intact; nodes are only allowed to be
+ * larger than required.
+ */
+static int imap__reserve(imap_node_t ** addr, imap_node_t * b, uint32_t level)
 {
-    imap_node_t * dest_nd;
-    imap_node_t * node_nd;
-
-    if (dest->key != IMAP_NODE_SZ &&
-        node->key != dest->key &&
-        imap__node_grow(dest))
-        abort();
+    imap_node_t * a = *addr;
+    size_t size;
 
-    for (uint_fast8_t i = dest->key & 0x1f,
-                      m = i + imap__node_size(dest); i < m; i++)
-    {
-        dest_nd = imap__unsafe_node(dest, i);
-        node_nd = imap__ensure_node(node, i);
-
-        if (node_nd->data)
-        {
-            if (dest_nd->data)
-            {
-                /* we are sure there is a reference left */
-                ti_decref((ti_ref_t *) node_nd->data);
-            }
-            else
-            {
-                dest_nd->data = node_nd->data;
-                dest->sz++;
-            }
-        }
-
-        if (node_nd->nodes)
-        {
-            if (dest_nd->nodes)
-            {
-                size_t tmp = dest_nd->sz;
-                imap__union_move(dest_nd, node_nd);
-                dest->sz += dest_nd->sz - tmp;
-            }
-            else
-            {
-                dest_nd->nodes = node_nd->nodes;
-                dest_nd->key = node_nd->key;
-                dest->sz += (dest_nd->sz = node_nd->sz);
-            }
-        }
-    }
-    free(node->nodes);
-}
+    if (!a || !b)
+        return 0;
 
-void imap_union_move(imap_t * dest, imap_t * imap)
-{
-    if (imap->n)
+    size = imap__size(imap__count(a->bits | b->bits));
+    if (size > imap__size(imap__count(a->bits)))
     {
-        imap_node_t * dest_nd;
-        imap_node_t * imap_nd;
-
-        for (uint_fast8_t i = 0; i < IMAP_NODE_SZ; i++)
-        {
-            dest_nd = dest->nodes + i;
-            imap_nd = imap->nodes + i;
-
-            if (imap_nd->data)
-            {
-                if (dest_nd->data)
-                {
-                    /* we are sure there is a reference left */
-                    ti_decref((ti_ref_t *) imap_nd->data);
-                }
-                else
-                {
-                    dest_nd->data = imap_nd->data;
-                    dest->n++;
-                }
-            }
-
-            if (imap_nd->nodes)
-            {
-                if (dest_nd->nodes)
-                {
-                    size_t tmp = dest_nd->sz;
-                    imap__union_move(dest_nd, imap_nd);
-                    dest->n += dest_nd->sz - tmp;
-                }
-                else
-                {
-                    dest_nd->nodes = imap_nd->nodes;
-                    dest_nd->key = imap_nd->key;
-                    dest->n += (dest_nd->sz = imap_nd->sz);
-                }
-            }
-        }
+        a = realloc(a, size);
+        if (!a)
+            return -1;
+        *addr = a;
     }
 
-    /* everything is clear */
-    memset(imap, 0, sizeof(imap_t) + IMAP_NODE_SZ * sizeof(imap_node_t));
-}
-
-static int imap__union_make(imap_node_t * dest, imap_node_t * node)
-{
-    imap_node_t * dest_nd;
-    imap_node_t * node_nd;
-
-    if (dest->key != IMAP_NODE_SZ &&
-        node->key != dest->key &&
-        imap__node_grow(dest))
-        return -1;
-
-    for (uint_fast8_t i = dest->key & 0x1f,
-                      m = i + imap__node_size(dest); i < m; i++)
+    if (level)
     {
-        dest_nd = imap__unsafe_node(dest, i);
-        node_nd = imap__ensure_node(node, i);
-
-        if (node_nd->data && !dest_nd->data)
-        {
-            dest_nd->data = node_nd->data;
-            ti_incref((ti_ref_t *) dest_nd->data);
-            dest->sz++;
-        }
-
-        if (node_nd->nodes)
+        for (uint64_t m = a->bits & b->bits; m; m &= m - 1)
         {
-            if (dest_nd->nodes)
-            {
-                size_t tmp = dest_nd->sz;
-                if (imap__union_make(dest_nd, node_nd))
-                    return -1;
-                dest->sz += dest_nd->sz - tmp;
-            }
-            else
-            {
-                if (imap__nodes_dup(dest_nd, node_nd))
-                    return -1;
-                dest->sz += dest_nd->sz;
-            }
+            uint8_t digit = __builtin_ctzll(m);
+            if (imap__reserve(
+                    (imap_node_t **) (a->items + imap__idx(a->bits, digit)),
+                    b->items[imap__idx(b->bits, digit)],
+                    level - 1))
+                return -1;
         }
     }
     return 0;
 }
 
-int imap_union_make(imap_t * dest, imap_t * a, imap_t * b)
+/*
+ * Merge node `b` into node `a` and return the resulting node, which is NULL
+ * when no items are left. Node `b` is moved, items which exist in both nodes
+ * are decremented once (`union`) or removed from both (`symmdiff`).
+ *
+ * Node `a` must be reserved using imap__reserve() so no allocation is
+ * required; the items are merged from the highest digit down so the items of
+ * `a` are not overwritten before they are read.
+ */
+static imap_node_t * imap__move(
+        imap_node_t * a,
+        imap_node_t * b,
+        uint32_t level,
+        imap_destroy_cb cb,
+        size_t * overlap)
 {
-    if (a->n || b->n)
-    {
-        imap_node_t * dest_nd;
-        imap_node_t * a_nd;
-        imap_node_t * b_nd;
+    uint64_t bits, keep = 0;
+    void ** ia, ** ib, ** out;
 
-        for (uint_fast8_t i = 0; i < IMAP_NODE_SZ; i++)
-        {
-            dest_nd = dest->nodes + i;
-            a_nd = a->nodes + i;
-            b_nd = b->nodes + i;
+    if (!a || !b)
+        return a ? a : b;
 
-            dest_nd->data = a_nd->data ? a_nd->data : b_nd->data;
-            if (dest_nd->data)
-            {
-                ti_incref((ti_ref_t *) dest_nd->data);
-                ++dest->n;
-            }
+    bits = a->bits | b->bits;
+    ia = a->items + imap__count(a->bits);
+    ib = b->items + imap__count(b->bits);
+    out = a->items + imap__count(bits);
 
-            if (a_nd->nodes)
-            {
-                if (imap__nodes_dup(dest_nd, a_nd))
-                    return -1;
-                dest->n += dest_nd->sz;
-            }
-
-            if (b_nd->nodes)
-            {
-                if (dest_nd->nodes)
-                {
-                    size_t tmp = dest_nd->sz;
-                    if (imap__union_make(dest_nd, b_nd))
-                        return -1;
-                    dest->n += dest_nd->sz - tmp;
-                }
-                else
-                {
-                    if (imap__nodes_dup(dest_nd, b_nd))
-                        return -1;
-                    dest->n += dest_nd->sz;
-                }
-            }
-        }
-    }
-    return 0;
-}
-
-static void imap__difference_inplace(imap_node_t * dest, imap_node_t * node)
-{
-    imap_node_t * dest_nd;
-    imap_node_t * node_nd;
-
-    for (uint_fast8_t i = dest->key & 0x1f,
-                      m = i + imap__node_size(dest); i < m; i++)
+    for (uint64_t m; bits; bits &= ~m)
     {
-        dest_nd = imap__unsafe_node(dest, i);
-        node_nd = imap__ensure_node(node, i);
-
-        if (node_nd->data && dest_nd->data)
-        {
-            /* we are sure to have one reference left */
-            ti_decref((ti_ref_t *) dest_nd->data);
-            dest_nd->data = NULL;
-            dest->sz--;
-        }
-
-        if (node_nd->nodes && dest_nd->nodes)
+        void * item;
+        m = 1ULL << (63 - __builtin_clzll(bits));
+
+        if (!(b->bits & m))
+            item = *--ia;
+        else if (!(a->bits & m))
+            item = *--ib;
+        else if (level)
         {
-            size_t tmp = dest_nd->sz;
-            imap__difference_inplace(dest_nd, node_nd);
-            dest->sz -= tmp - dest_nd->sz;
-            if (!dest_nd->sz)
-            {
-                free(dest_nd->nodes);
-                dest_nd->nodes = NULL;
-            }
+            --ia;
+            --ib;
+            item = imap__move(*ia, *ib, level - 1, cb, overlap);
         }
-    }
-}
-
-void imap_difference_inplace(imap_t * dest, imap_t * imap)
-{
-    if (imap->n)
-    {
-        imap_node_t * dest_nd;
-        imap_node_t * imap_nd;
-
-        for (uint_fast8_t i = 0; i < IMAP_NODE_SZ; i++)
+        else if (++(*overlap), cb)
         {
-            dest_nd = dest->nodes + i;
-            imap_nd = imap->nodes + i;
-
-            if (imap_nd->data && dest_nd->data)
-            {
-                /* we are sure to have one reference left */
-                ti_decref((ti_ref_t *) dest_nd->data);
-                dest_nd->data = NULL;
-                dest->n--;
-            }
+            /* we are sure to have one reference left */
+            ti_decref((ti_ref_t *) *--ia);
 
-            if (imap_nd->nodes && dest_nd->nodes)
-            {
-                size_t tmp = dest_nd->sz;
-                imap__difference_inplace(dest_nd, imap_nd);
-                dest->n -= tmp - dest_nd->sz;
-                if (!dest_nd->sz)
-                {
-                    free(dest_nd->nodes);
-                    dest_nd->nodes = NULL;
-                }
-            }
+            /* but now we are not sure anymore */
+            (*cb)(*--ib);
+            continue;
         }
-    }
-}
-
-static int imap__difference_make(
-        imap_node_t * dest,
-        imap_node_t * a,
-        imap_node_t * b)
-{
-    imap_node_t * dest_nd;
-    imap_node_t * a_nd;
-    imap_node_t * b_nd;
-    uint8_t size = imap__node_size(a);
-
-    dest->nodes = calloc(size, sizeof(imap_node_t));
-    if (!dest->nodes)
-        return -1;
-    dest->key = a->key;
-
-    for (uint_fast8_t i = dest->key & 0x1f,
-                      m = i + imap__node_size(dest); i < m; i++)
-    {
-        dest_nd = imap__unsafe_node(dest, i);
-        a_nd = imap__unsafe_node(a, i);
-        b_nd = imap__ensure_node(b, i);
-
-        if (a_nd->data && !b_nd->data)
+        else
         {
-            dest_nd->data = a_nd->data;
-            ti_incref((ti_ref_t *) dest_nd->data);
-            ++dest->sz;
+            /* we are sure there is a reference left */
+            ti_decref((ti_ref_t *) *--ib);
+            item = *--ia;
         }
 
-        if (a_nd->nodes)
+        if (item)
         {
-            if (!b_nd->nodes)
-            {
-                if (imap__nodes_dup(dest_nd, a_nd))
-                    return -1;
-                dest->sz += dest_nd->sz;
-            }
-            else if (a_nd->sz != b_nd->sz || !imap__eq(a_nd, b_nd))
-            {
-                if (imap__difference_make(dest_nd, a_nd, b_nd))
-                    return -1;
-                dest->sz += dest_nd->sz;
-            }
+            *--out = item;
+            keep |= m;
         }
     }
 
-    if (!dest->sz)
+    free(b);
+
+    if (!keep)
     {
-        free(dest->nodes);
-        dest->nodes = NULL;
+        free(a);
+        return NULL;
     }
 
-    return 0;
+    memmove(a->items, out, imap__count(keep) * sizeof(void *));
+    a->bits = keep;
+    return a;
 }
 
-int imap_difference_make(imap_t * dest, imap_t * a, imap_t * b)
+/*
+ * Move all items from `imap` to `dest`; Returns 0 when successful or -1 in
+ * case of an allocation error in which case both maps are left unchanged.
+ */
+int imap_union_move(imap_t * dest, imap_t * imap)
 {
-    if (a->n)
-    {
-        imap_node_t * dest_nd;
-        imap_node_t * a_nd;
-        imap_node_t * b_nd;
+    size_t overlap = 0;
 
-        for (uint_fast8_t i = 0; i < IMAP_NODE_SZ; i++)
-        {
-            dest_nd = dest->nodes + i;
-            a_nd = a->nodes + i;
-            b_nd = b->nodes + i;
+    if (!imap->n)
+        return 0;
 
-            if (a_nd->data && !b_nd->data)
-            {
-                dest_nd->data = a_nd->data;
-                ti_incref((ti_ref_t *) dest_nd->data);
-                ++dest->n;
-            }
+    if (imap__grow(dest, imap->height) ||
+        imap__grow(imap, dest->height) ||
+        imap__reserve(&dest->root, imap->root, dest->height - 1))
+        return -1;
 
-            if (a_nd->nodes)
-            {
-                if (!b_nd->nodes)
-                {
-                    if (imap__nodes_dup(dest_nd, a_nd))
-                        return -1;
-                    dest->n += dest_nd->sz;
-                }
-                else if (a_nd->sz != b_nd->sz || !imap__eq(a_nd, b_nd))
-                {
-                    if (imap__difference_make(dest_nd, a_nd, b_nd))
-                        return -1;
-                    dest->n += dest_nd->sz;
-                }
-            }
-        }
-    }
+    dest->root = imap__move(
+            dest->root,
+            imap->root,
+            dest->height - 1,
+            NULL,
+            &overlap);
+    dest->n += imap->n - overlap;
+
+    /* everything is moved */
+    memset(imap, 0, sizeof(imap_t));
     return 0;
 }
 
-static void imap__intersection_inplace(
-        imap_node_t * dest,
-        imap_node_t * node,
-        imap_destroy_cb cb)
+/*
+ * Returns a new node with the result of the operation on `a` and `b`. Both
+ * nodes are allowed to be NULL. Each item gets a new reference. When no items
+ * are left, NULL is returned and `rc` is not changed. On an allocation error,
+ * `rc` will be set to -1.
+ */
+static imap_node_t * imap__make(
+        imap_node_t * a,
+        imap_node_t * b,
+        uint32_t level,
+        int op,
+        size_t * n,
+        int * rc)
 {
-    imap_node_t * dest_nd;
-    imap_node_t * node_nd;
+    imap_node_t * node;
+    uint64_t ba = a ? a->bits : 0, bb = b ? b->bits : 0, bits, keep = 0;
+    void ** ia = a ? a->items : NULL, ** ib = b ? b->items : NULL, ** out;
 
-    for (uint_fast8_t i = dest->key & 0x1f,
-                      m = i + imap__node_size(dest); i < m; i++)
+    switch (op)
     {
-        dest_nd = imap__unsafe_node(dest, i);
-        node_nd = imap__ensure_node(node, i);
-
-        if (!node_nd->data && dest_nd->data)
-        {
-            (*cb)(dest_nd->data);
-            dest_nd->data = NULL;
-            dest->sz--;
-        }
-
-        if (dest_nd->nodes)
-        {
-            if (node_nd->nodes)
-            {
-                size_t tmp = dest_nd->sz;
-                imap__intersection_inplace(dest_nd, node_nd, cb);
-                dest->sz -= tmp - dest_nd->sz;
-            }
-            else
-            {
-                dest->sz -= dest_nd->sz;
-                imap__node_destroy_cb(dest_nd, cb);
-                dest_nd->nodes = NULL;
-                dest_nd->sz = 0;
-            }
-        }
+    case IMAP__UNION:
+    case IMAP__SYMMDIFF:
+        bits = ba | bb;
+        break;
+    case IMAP__DIFFERENCE:
+        bits = ba;
+        break;
+    case IMAP__INTERSECTION:
+        bits = ba & bb;
+        break;
+    default:
+        assert(0);
+        bits = 0;
     }
 
-    if (!dest->sz)
+    if (!bits)
+        return NULL;
+
+    node = malloc(imap__size(imap__count(bits)));
+    if (!node)
     {
-        free(dest->nodes);
-        dest->nodes = NULL;
+        *rc = -1;
+        return NULL;
     }
-}
 
-void imap_intersection_inplace(imap_t * dest, imap_t * imap, imap_destroy_cb cb)
-{
-    imap_node_t * dest_nd;
-    imap_node_t * imap_nd;
+    node->bits = 0;
+    out = node->items;
 
-    for (uint_fast8_t i = 0; i < IMAP_NODE_SZ; i++)
+    for (uint64_t m = ba | bb; m; m &= m - 1)
     {
-        dest_nd = dest->nodes + i;
-        imap_nd = imap->nodes + i;
+        uint64_t bit = m & -m;
+        void * itema = ba & bit ? *ia++ : NULL;
+        void * itemb = bb & bit ? *ib++ : NULL;
+        void * item;
 
-        if (!imap_nd->data && dest_nd->data)
-        {
-            (*cb)(dest_nd->data);
-            dest_nd->data = NULL;
-            dest->n--;
-        }
+        if (!(bits & bit))
+            continue;
 
-        if (dest_nd->nodes)
+        if (level)
         {
-            if (imap_nd->nodes)
+            item = imap__make(itema, itemb, level - 1, op, n, rc);
+            if (*rc)
             {
-                size_t tmp = dest_nd->sz;
-                imap__intersection_inplace(dest_nd, imap_nd, cb);
-                dest->n -= tmp - dest_nd->sz;
-            }
-            else
-            {
-                dest->n -= dest_nd->sz;
-                imap__node_destroy_cb(dest_nd, cb);
-                dest_nd->nodes = NULL;
-                dest_nd->sz = 0;
+                (void) imap__node_destroy(node, level, imap__decref);
+                return NULL;
             }
         }
-    }
-}
-
-static int imap__intersection_make(
-        imap_node_t * dest,
-        imap_node_t * a,
-        imap_node_t * b)
-{
-    imap_node_t * dest_nd;
-    imap_node_t * a_nd;
-    imap_node_t * b_nd;
-    uint8_t sizea = imap__node_size(a);
-    uint8_t sizeb = imap__node_size(b);
-
-    if (sizeb < sizea)
-    {
-        imap_node_t * tmp = a;
-        a = b;
-        b = tmp;
-        sizea = sizeb;
-    }
-
-    dest->nodes = calloc(sizea, sizeof(imap_node_t));
-    if (!dest->nodes)
-        return -1;
-    dest->key = a->key;
-
-    for (uint_fast8_t i = dest->key & 0x1f,
-                      m = i + imap__node_size(dest); i < m; i++)
-    {
-        dest_nd = imap__unsafe_node(dest, i);
-        a_nd = imap__unsafe_node(a, i);
-        b_nd = imap__ensure_node(b, i);
-
-        if (a_nd->data && b_nd->data)
+        else if (op == IMAP__SYMMDIFF && itema && itemb)
+            item = NULL;
+        else if (op == IMAP__DIFFERENCE && itemb)
+            item = NULL;
+        else
         {
-            dest_nd->data = a_nd->data;
-            ti_incref((ti_ref_t *) dest_nd->data);
-            ++dest->sz;
+            item = itema ? itema : itemb;
+            ti_incref((ti_ref_t *) item);
+            ++(*n);
         }
 
-        if (a_nd->nodes && b_nd->nodes)
+        if (item)
         {
-            if (imap__intersection_make(dest_nd, a_nd, b_nd))
-                return -1;
-            dest->sz += dest_nd->sz;
+            *out++ = item;
+            keep |= bit;
+            node->bits = keep;  /* keep the node valid for a cleanup */
         }
     }
 
-    if (!dest->sz)
+    if (!keep)
     {
-        free(dest->nodes);
-        dest->nodes = NULL;
+        free(node);
+        return NULL;
     }
 
-    return 0;
+    return node;
 }
 
-int imap_intersection_make(imap_t * dest, imap_t * a, imap_t * b)
+static int imap__make_root(imap_t * dest, imap_t * a, imap_t * b, int op)
 {
-    if (a->n && b->n)
-    {
-        imap_node_t * dest_nd;
-        imap_node_t * a_nd;
-        imap_node_t * b_nd;
+    int rc = 0;
+    size_t n = 0;
 
-        for (uint_fast8_t i = 0; i < IMAP_NODE_SZ; i++)
-        {
-            dest_nd = dest->nodes + i;
-            a_nd = a->nodes + i;
-            b_nd = b->nodes + i;
+    assert(dest->n == 0);
 
-            if (a_nd->data && b_nd->data)
-            {
-                dest_nd->data = a_nd->data;
-                ti_incref((ti_ref_t *) dest_nd->data);
-                ++dest->n;
-            }
+    if (!a->n && !b->n)
+        return 0;
 
-            if (a_nd->nodes && b_nd->nodes)
-            {
-                if (imap__intersection_make(dest_nd, a_nd, b_nd))
-                    return -1;
-                dest->n += dest_nd->sz;
-            }
-        }
-    }
-    return 0;
+    if (imap__grow(a, b->height) || imap__grow(b, a->height))
+        return -1;
+
+    dest->height = a->height;
+    dest->root = imap__make(a->root, b->root, a->height - 1, op, &n, &rc);
+    dest->n = n;
+    if (!dest->root)
+        dest->height = 0;
+    return rc;
 }
 
-static void imap__symmdiff_move(
-        imap_node_t * dest,
-        imap_node_t * node,
-        imap_destroy_cb cb)
+int imap_union_make(imap_t * dest, imap_t * a, imap_t * b)
 {
-    imap_node_t * dest_nd;
-    imap_node_t * node_nd;
+    return imap__make_root(dest, a, b, IMAP__UNION);
+}
 
-    if (dest->key != IMAP_NODE_SZ &&
-        node->key != dest->key &&
-        imap__node_grow(dest))
-        abort();
+/*
+ * Remove items from node `a` which are not in `b`, or which are in `b` when
+ * `inverse` is `true`. The call-back is called on each removed item. Returns
+ * node `a`, or NULL if no items are left.
+ */
+static imap_node_t * imap__filter(
+        imap_node_t * a,
+        imap_node_t * b,
+        uint32_t level,
+        _Bool inverse,
+        imap_destroy_cb cb,
+        size_t * removed)
+{
+    uint64_t bb = b ? b->bits : 0, keep = 0;
+    void ** ia = a->items, ** out = a->items;
 
-    for (uint_fast8_t i = dest->key & 0x1f,
-                      m = i + imap__node_size(dest); i < m; i++)
+    for (uint64_t m = a->bits; m; m &= m - 1)
     {
-        dest_nd = imap__unsafe_node(dest, i);
-        node_nd = imap__ensure_node(node, i);
+        uint64_t bit = m & -m;
+        void * item = *ia++;
+        void * itemb = bb & bit
+                ? b->items[imap__idx(bb, __builtin_ctzll(bit))]
+                : NULL;
 
-        if (node_nd->data)
+        if (level)
         {
-            if (dest_nd->data)
+            if (itemb)
+                item = imap__filter(
+                        item,
+                        itemb,
+                        level - 1,
+                        inverse,
+                        cb,
+                        removed);
+            else if (!inverse)
             {
-                /* we are sure to have one reference left */
-                ti_decref((ti_ref_t *) dest_nd->data);
-
-                /* but now we are not sure anymore */
-                (*cb)(node_nd->data);
-
-                dest_nd->data = NULL;
-                dest->sz--;
-            }
-            else
-            {
-                dest_nd->data = node_nd->data;
-                dest->sz++;
+                *removed += imap__node_destroy(item, level - 1, cb);
+                item = NULL;
             }
         }
+        else if (!itemb != inverse)
+        {
+            (*cb)(item);
+            ++(*removed);
+            item = NULL;
+        }
 
-        if (node_nd->nodes)
+        if (item)
         {
-            if (dest_nd->nodes)
-            {
-                size_t tmp = dest_nd->sz;
-                imap__symmdiff_move(dest_nd, node_nd, cb);
-                dest->sz += dest_nd->sz - tmp;
-            }
-            else
-            {
-                dest_nd->nodes = node_nd->nodes;
-                dest_nd->key = node_nd->key;
-                dest->sz += (dest_nd->sz = node_nd->sz);
-            }
+            *out++ = item;
+            keep |= bit;
         }
     }
 
-    if (!dest->sz)
+    if (!keep)
     {
-        free(dest->nodes);
-        dest->nodes = NULL;
-    }
-
-    free(node->nodes);
-}
-
-void imap_symmdiff_move(imap_t * dest, imap_t * imap, imap_destroy_cb cb)
-{
-    if (imap->n)
-    {
-        imap_node_t * dest_nd;
-        imap_node_t * imap_nd;
-
-        for (uint_fast8_t i = 0; i < IMAP_NODE_SZ; i++)
-        {
-            dest_nd = dest->nodes + i;
-            imap_nd = imap->nodes + i;
-
-            if (imap_nd->data)
-            {
-                if (dest_nd->data)
-                {
-                    /* we are sure to have one reference left */
-                    ti_decref((ti_ref_t *) dest_nd->data);
-
-                    /* but now we are not sure anymore */
-                    (*cb)(imap_nd->data);
-
-                    dest_nd->data = NULL;
-                    dest->n--;
-                }
-                else
-                {
-                    dest_nd->data = imap_nd->data;
-                    dest->n++;
-                }
-            }
-
-
-            if (imap_nd->nodes)
-            {
-                if (dest_nd->nodes)
-                {
-                    size_t tmp = dest_nd->sz;
-                    imap__symmdiff_move(dest_nd, imap_nd, cb);
-                    dest->n += dest_nd->sz - tmp;
-                }
-                else
-                {
-                    dest_nd->nodes = imap_nd->nodes;
-                    dest_nd->key = imap_nd->key;
-                    dest->n += (dest_nd->sz = imap_nd->sz);
-                }
-            }
-        }
+        free(a);
+        return NULL;
     }
 
-    /* everything is clear */
-    memset(imap, 0, sizeof(imap_t) + IMAP_NODE_SZ * sizeof(imap_node_t));
+    a->bits = keep;
+    return a;
 }
 
-static int imap__symmdiff_make(
-        imap_node_t * dest,
-        imap_node_t * a,
-        imap_node_t * b)
+static int imap__filter_root(
+        imap_t * dest,
+        imap_t * imap,
+        _Bool inverse,
+        imap_destroy_cb cb)
 {
-    imap_node_t * dest_nd;
-    imap_node_t * a_nd;
-    imap_node_t * b_nd;
-    uint8_t size, key;
+    size_t removed = 0;
 
-    if (a->key == b->key && a->key != IMAP_NODE_SZ)
-    {
-        size = 1;
-        key = a->key;
-    }
-    else
-        key = size = IMAP_NODE_SZ;
+    if (!dest->root)
+        return 0;
 
-    dest->nodes = calloc(size, sizeof(imap_node_t));
-    if (!dest->nodes)
+    if (imap__grow(dest, imap->height) || imap__grow(imap, dest->height))
         return -1;
-    dest->key = key;
 
-    for (uint_fast8_t i = dest->key & 0x1f,
-                      m = i + imap__node_size(dest); i < m; i++)
-    {
-        dest_nd = imap__unsafe_node(dest, i);
-        a_nd = imap__ensure_node(a, i);
-        b_nd = imap__ensure_node(b, i);
-
-        if (a_nd->data && !b_nd->data)
-        {
-            dest_nd->data = a_nd->data;
-            ti_incref((ti_ref_t *) dest_nd->data);
-            ++dest->sz;
-        }
-        else if (!a_nd->data && b_nd->data)
-        {
-            dest_nd->data = b_nd->data;
-            ti_incref((ti_ref_t *) dest_nd->data);
-            ++dest->sz;
-        }
-
-        if (a_nd->nodes &&
-            b_nd->nodes &&
-            (a_nd->sz != b_nd->sz || !imap__eq(a_nd, b_nd)))
-        {
-            if (imap__symmdiff_make(dest_nd, a_nd, b_nd))
-                return -1;
-            dest->sz += dest_nd->sz;
-        }
-        else if (a_nd->nodes && !b_nd->nodes)
-        {
-            if (imap__nodes_dup(dest_nd, a_nd))
-                return -1;
-            dest->sz += dest_nd->sz;
-        }
-        else if (!a_nd->nodes && b_nd->nodes)
-        {
-            if (imap__nodes_dup(dest_nd, b_nd))
-                return -1;
-            dest->sz += dest_nd->sz;
-        }
-    }
+    dest->root = imap__filter(
+            dest->root,
+            imap->root,
+            dest->height - 1,
+            inverse,
+            cb,
+            &removed);
+
+    dest->n -= removed;
+    if (!dest->root)
+        dest->height = 0;
     return 0;
 }
 
-int imap_symmdiff_make(imap_t * dest, imap_t * a, imap_t * b)
+/*
+ * Remove the items in `imap` from `dest`; Returns 0 when successful or -1 in
+ * case of an allocation error in which case `dest` is left unchanged.
+ */
+int imap_difference_inplace(imap_t * dest, imap_t * imap)
 {
-    if (a->n || b->n)
-    {
-        imap_node_t * dest_nd;
-        imap_node_t * a_nd;
-        imap_node_t * b_nd;
-
-        for (uint_fast8_t i = 0; i < IMAP_NODE_SZ; i++)
-        {
-            dest_nd = dest->nodes + i;
-            a_nd = a->nodes + i;
-            b_nd = b->nodes + i;
-
-            if (a_nd->data && !b_nd->data)
-            {
-                dest_nd->data = a_nd->data;
-                ti_incref((ti_ref_t *) dest_nd->data);
-                ++dest->n;
-            }
-            else if (!a_nd->data && b_nd->data)
-            {
-                dest_nd->data = b_nd->data;
-                ti_incref((ti_ref_t *) dest_nd->data);
-                ++dest->n;
-            }
-
-            if (a_nd->nodes &&
-                b_nd->nodes &&
-                (a_nd->sz != b_nd->sz || !imap__eq(a_nd, b_nd)))
-            {
-                if (imap__symmdiff_make(dest_nd, a_nd, b_nd))
-                    return -1;
-                dest->n += dest_nd->sz;
-            }
-            else if (a_nd->nodes && !b_nd->nodes)
-            {
-                if (imap__nodes_dup(dest_nd, a_nd))
-                    return -1;
-                dest->n += dest_nd->sz;
-            }
-            else if (!a_nd->nodes && b_nd->nodes)
-            {
-                if (imap__nodes_dup(dest_nd, b_nd))
-                    return -1;
-                dest->n += dest_nd->sz;
-            }
-        }
-    }
-    return 0;
+    /* we are sure to have one reference left */
+    return imap->n ? imap__filter_root(dest, imap, true, imap__decref) : 0;
 }
 
-static inline void imap__nodes_dec(void * data)
+int imap_difference_make(imap_t * dest, imap_t * a, imap_t * b)
 {
-    ti_decref((ti_ref_t *) data);
+    return imap__make_root(dest, a, b, IMAP__DIFFERENCE);
 }
 
-static int imap__nodes_dup(imap_node_t * dest, imap_node_t * node)
+/*
+ * Remove the items from `dest` which are not in `imap`; Returns 0 when
+ * successful or -1 in case of an allocation error in which case `dest` is
+ * left unchanged.
+ */
+int imap_intersection_inplace(
+        imap_t * dest,
+        imap_t * imap,
+        imap_destroy_cb cb)
 {
-    uint8_t size = imap__node_size(node);
-    imap_node_t * nd = node->nodes;
-    imap_node_t * end = nd + size;
-    imap_node_t * dest_nd;
+    return imap__filter_root(dest, imap, false, cb);
+}
 
-    dest_nd = dest->nodes = calloc(size, sizeof(imap_node_t));
-    if (!dest_nd)
-        return -1;
+int imap_intersection_make(imap_t * dest, imap_t * a, imap_t * b)
+{
+    return imap__make_root(dest, a, b, IMAP__INTERSECTION);
+}
 
-    for (; nd < end; ++nd, ++dest_nd)
-    {
-        if (nd->data)
-        {
-            dest_nd->data = nd->data;
-            ti_incref((ti_ref_t *) dest_nd->data);
-        }
+/*
+ * Same as imap_union_move() except that items which exist in both maps are
+ * removed from `dest`.
+ */
+int imap_symmdiff_move(imap_t * dest, imap_t * imap, imap_destroy_cb cb)
+{
+    size_t overlap = 0;
 
-        if (nd->nodes && imap__nodes_dup(dest_nd, nd))
-        {
-            imap__node_destroy_cb(dest->nodes, imap__nodes_dec);
-            return -1;
-        }
-    }
+    if (!imap->n)
+        return 0;
 
-    dest->key = node->key;
-    dest->sz = node->sz;
+    if (imap__grow(dest, imap->height) ||
+        imap__grow(imap, dest->height) ||
+        imap__reserve(&dest->root, imap->root, dest->height - 1))
+        return -1;
 
+    dest->root = imap__move(
+            dest->root,
+            imap->root,
+            dest->height - 1,
+            cb,
+            &overlap);
+    dest->n += imap->n - overlap - overlap;
+    if (!dest->root)
+        dest->height = 0;
+
+    /* everything is moved */
+    memset(imap, 0, sizeof(imap_t));
     return 0;
 }
+
+int imap_symmdiff_make(imap_t * dest, imap_t * a, imap_t * b)
+{
+    return imap__make_root(dest, a, b, IMAP__SYMMDIFF);
+}
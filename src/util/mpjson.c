@@ -0,0 +1,431 @@
+/*
+ * mpjson.c
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <ti/val.t.h>
+#include <util/mpjson.h>
+
+static void mpjson__print(mpjson_writer_t * w, const char * s, size_t n)
+{
+    if (!w->is_oom && msgpack_sbuffer_write(&w->buffer, s, n))
+        w->is_oom = true;
+}
+
+static inline int mpjson__check(mpjson_writer_t * w, yajl_gen_status stat)
+{
+    if (stat != yajl_gen_status_ok)
+        w->stat = stat;
+    return -(stat != yajl_gen_status_ok || w->is_oom);
+}
+
+/*
+ * Called each time a value is written; closes all maps and arrays which are
+ * completed by this value.
+ */
+static int mpjson__next(mpjson_writer_t * w)
+{
+    while (w->deep)
+    {
+        if (--w->n[w->deep])
+            return 0;
+
+        if (mpjson__check(w, w->is_map[w->deep]
+                ? yajl_gen_map_close(w->g)
+                : yajl_gen_array_close(w->g)))
+            return -1;
+
+        --w->deep;
+    }
+    w->is_complete = true;
+    return 0;
+}
+
+static int mpjson__value(mpjson_writer_t * w, yajl_gen_status stat)
+{
+    return mpjson__check(w, stat) || mpjson__next(w);
+}
+
+static int mpjson__open(mpjson_writer_t * w, size_t n, _Bool is_map)
+{
+    if (mpjson__check(w, is_map
+            ? yajl_gen_map_open(w->g)
+            : yajl_gen_array_open(w->g)))
+        return -1;
+
+    if (!n)
+        return mpjson__value(w, is_map
+                ? yajl_gen_map_close(w->g)
+                : yajl_gen_array_close(w->g));
+
+    if (++w->deep == YAJL_MAX_DEPTH)
+    {
+        w->stat = yajl_max_depth_exceeded;
+        return -1;
+    }
+
+    w->n[w->deep] = is_map ? n << 1 : n;
+    w->is_map[w->deep] = is_map;
+    return 0;
+}
+
+static int mpjson__u64(mpjson_writer_t * w, uint64_t u64)
+{
+    if (u64 > INT64_MAX)
+    {
+        char buf[21];
+        int len = sprintf(buf, "%"PRIu64, u64);
+        return mpjson__value(w, yajl_gen_number(w->g, buf, (size_t) len));
+    }
+    return mpjson__value(w, yajl_gen_integer(w->g, (int64_t) u64));
+}
+
+/*
+ * Writes a string with size `n`; if not all data is available, the data is
+ * collected until the string is complete.
+ */
+static int mpjson__str(
+        mpjson_writer_t * w,
+        size_t n,
+        const unsigned char ** pt,
+        const unsigned char * end)
+{
+    size_t avail = end - *pt;
+
+    if (n <= avail)
+    {
+        const unsigned char * s = *pt;
+        *pt += n;
+        return mpjson__value(w, yajl_gen_string(w->g, s, n));
+    }
+
+    w->str = malloc(n);
+    if (!w->str)
+    {
+        w->is_oom = true;
+        return -1;
+    }
+
+    memcpy(w->str, *pt, avail);
+    w->str_n = avail;
+    w->str_sz = n;
+    *pt = end;
+    return 0;
+}
+
+static inline uint8_t mpjson__hdr_sz(unsigned char token)
+{
+    switch (token)
+    {
+    case 0xcc: case 0xd0: case 0xd9:
+        return 2;
+    case 0xcd: case 0xd1: case 0xda: case 0xdc: case 0xde:
+        return 3;
+    case 0xca: case 0xce: case 0xd2: case 0xdb: case 0xdd: case 0xdf:
+        return 5;
+    case 0xcb: case 0xcf: case 0xd3:
+        return 9;
+    }
+    /* fixed types; binary and extension types fail on the first byte */
+    return 1;
+}
+
+/*
+ * Handle a value using a complete header; string data is read from `pt`.
+ */
+static int mpjson__token(
+        mpjson_writer_t * w,
+        const unsigned char * hdr,
+        const unsigned char ** pt,
+        const unsigned char * end)
+{
+    const unsigned char * data = hdr + 1;
+    unsigned char token = *hdr;
+
+    switch (token)
+    {
+    case 0x00 ... 0x7f:     /* fixed positive */
+        return mpjson__value(w, yajl_gen_integer(w->g, token));
+    case 0x80 ... 0x8f:     /* fixed map */
+        return mpjson__open(w, 0xf & token, true);
+    case 0x90 ... 0x9f:     /* fixed array */
+        return mpjson__open(w, 0xf & token, false);
+    case 0xa0 ... 0xbf:     /* fixed str */
+        return mpjson__str(w, 0x1f & token, pt, end);
+    case 0xc0:              /* nil */
+        return mpjson__value(w, yajl_gen_null(w->g));
+    case 0xc2:              /* false */
+        return mpjson__value(w, yajl_gen_bool(w->g, 0));
+    case 0xc3:              /* true */
+        return mpjson__value(w, yajl_gen_bool(w->g, 1));
+    case 0xc4:              /* bin 8 */
+    case 0xc5:              /* bin 16 */
+    case 0xc6:              /* bin 32 */
+        w->stat = yajl_gen_invalid_string;
+        return -1;
+    case 0xca:              /* float 32 */
+    {
+        union { float f; uint32_t u; } mem;
+        _msgpack_load32(uint32_t, data, &mem.u);
+        return mpjson__value(w, yajl_gen_double(w->g, (double) mem.f));
+    }
+    case 0xcb:              /* float 64 */
+    {
+        union { double d; uint64_t u; } mem;
+        _msgpack_load64(uint64_t, data, &mem.u);
+        return mpjson__value(w, yajl_gen_double(w->g, mem.d));
+    }
+    case 0xcc:              /* uint 8 */
+        return mpjson__u64(w, *data);
+    case 0xcd:              /* uint 16 */
+    {
+        uint16_t u16;
+        _msgpack_load16(uint16_t, data, &u16);
+        return mpjson__u64(w, u16);
+    }
+    case 0xce:              /* uint 32 */
+    {
+        uint32_t u32;
+        _msgpack_load32(uint32_t, data, &u32);
+        return mpjson__u64(w, u32);
+    }
+    case 0xcf:              /* uint 64 */
+    {
+        uint64_t u64;
+        _msgpack_load64(uint64_t, data, &u64);
+        return mpjson__u64(w, u64);
+    }
+    case 0xd0:              /* int 8 */
+        return mpjson__value(w, yajl_gen_integer(w->g, (int8_t) *data));
+    case 0xd1:              /* int 16 */
+    {
+        int16_t i16;
+        _msgpack_load16(int16_t, data, &i16);
+        return mpjson__value(w, yajl_gen_integer(w->g, i16));
+    }
+    case 0xd2:              /* int 32 */
+    {
+        int32_t i32;
+        _msgpack_load32(int32_t, data, &i32);
+        return mpjson__value(w, yajl_gen_integer(w->g, i32));
+    }
+    case 0xd3:              /* int 64 */
+    {
+        int64_t i64;
+        _msgpack_load64(int64_t, data, &i64);
+        return mpjson__value(w, yajl_gen_integer(w->g, i64));
+    }
+    case 0xd9:              /* str 8 */
+        return mpjson__str(w, *data, pt, end);
+    case 0xda:              /* str 16 */
+    {
+        uint16_t u16;
+        _msgpack_load16(uint16_t, data, &u16);
+        return mpjson__str(w, u16, pt, end);
+    }
+    case 0xdb:              /* str 32 */
+    {
+        uint32_t u32;
+        _msgpack_load32(uint32_t, data, &u32);
+        return mpjson__str(w, u32, pt, end);
+    }
+    case 0xdc:              /* array 16 */
+    {
+        uint16_t u16;
+        _msgpack_load16(uint16_t, data, &u16);
+        return mpjson__open(w, u16, false);
+    }
+    case 0xdd:              /* array 32 */
+    {
+        uint32_t u32;
+        _msgpack_load32(uint32_t, data, &u32);
+        return mpjson__open(w, u32, false);
+    }
+    case 0xde:              /* map 16 */
+    {
+        uint16_t u16;
+        _msgpack_load16(uint16_t, data, &u16);
+        return mpjson__open(w, u16, true);
+    }
+    case 0xdf:              /* map 32 */
+    {
+        uint32_t u32;
+        _msgpack_load32(uint32_t, data, &u32);
+        return mpjson__open(w, u32, true);
+    }
+    case 0xe0 ... 0xff:     /* fixed negative */
+        return mpjson__value(w, yajl_gen_integer(w->g, (int8_t) token));
+    }
+
+    /* never used (0xc1) and extension types */
+    w->stat = yajl_gen_in_error_state;
+    return -1;
+}
+
+/*
+ * Write callback for the `msgpack_packer`. The packer writes headers and
+ * string data using separate calls and raw MessagePack data might be
+ * appended at once, so both headers and strings may be split.
+ */
+static int mpjson__write(void * data, const char * buf, size_t len)
+{
+    mpjson_writer_t * w = data;
+    const unsigned char * pt = (const unsigned char *) buf;
+    const unsigned char * end = pt + len;
+    const unsigned char * hdr;
+    int rc;
+
+    if (w->stat || w->is_oom)
+        return -1;
+
+    while (pt < end)
+    {
+        size_t n, avail = end - pt;
+
+        if (w->str)
+        {
+            n = w->str_sz - w->str_n;
+            if (n > avail)
+            {
+                memcpy(w->str + w->str_n, pt, avail);
+                w->str_n += avail;
+                return 0;
+            }
+
+            memcpy(w->str + w->str_n, pt, n);
+            pt += n;
+
+            rc = mpjson__value(w, yajl_gen_string(w->g, w->str, w->str_sz));
+
+            free(w->str);
+            w->str = NULL;
+
+            if (rc)
+                return -1;
+            continue;
+        }
+
+        if (w->hdr_n)
+        {
+            n = w->hdr_sz - w->hdr_n;
+            if (n > avail)
+            {
+                memcpy(w->hdr + w->hdr_n, pt, avail);
+                w->hdr_n += avail;
+                return 0;
+            }
+
+            memcpy(w->hdr + w->hdr_n, pt, n);
+            pt += n;
+            w->hdr_n = 0;
+
+            if (mpjson__token(w, w->hdr, &pt, end))
+                return -1;
+            continue;
+        }
+
+        n = mpjson__hdr_sz(*pt);
+        if (n > avail)
+        {
+            memcpy(w->hdr, pt, avail);
+            w->hdr_n = (uint8_t) avail;
+            w->hdr_sz = (uint8_t) n;
+            return 0;
+        }
+
+        hdr = pt;
+        pt += n;
+
+        if (mpjson__token(w, hdr, &pt, end))
+            return -1;
+    }
+
+    return (w->flush_cb && w->buffer.size >= w->flush_sz)
+            ? w->flush_cb(w, w->flush_arg)
+            : 0;
+}
+
+/*
+ * Initialize a JSON writer and bind the given packer to the writer.
+ * Argument `offset` is reserved at the start of the buffer, just like
+ * `mp_sbuffer_alloc_init()`. Use `mpjson_writer_destroy()` when finished.
+ */
+int mpjson_writer_init(
+        mpjson_writer_t * w,
+        msgpack_packer * pk,
+        size_t alloc,
+        size_t offset,
+        int flags)
+{
+    w->g = NULL;
+    w->stat = yajl_gen_status_ok;
+    w->is_oom = false;
+    w->is_complete = false;
+    w->hdr_n = 0;
+    w->hdr_sz = 0;
+    w->str = NULL;
+    w->str_n = 0;
+    w->str_sz = 0;
+    w->deep = 0;
+    w->flush_cb = NULL;
+    w->flush_arg = NULL;
+    w->flush_sz = 0;
+
+    if (alloc <= offset)
+        alloc = offset + 1;
+
+    if (mp_sbuffer_alloc_init(&w->buffer, alloc, offset))
+        return -1;
+
+    w->g = yajl_gen_alloc(NULL);
+    if (!w->g)
+    {
+        msgpack_sbuffer_destroy(&w->buffer);
+        return -1;
+    }
+
+    yajl_gen_config(w->g, yajl_gen_beautify, flags & MPJSON_FLAG_BEAUTIFY);
+    yajl_gen_config(
+            w->g,
+            yajl_gen_validate_utf8,
+            flags & MPJSON_FLAG_VALIDATE_UTF8);
+    yajl_gen_config(
+            w->g,
+            yajl_gen_print_callback,
+            (yajl_print_t) mpjson__print,
+            w);
+
+    msgpack_packer_init(pk, w, mpjson__write);
+    return 0;
+}
+
+/*
+ * Returns 0 when a complete JSON document is written to the buffer.
+ */
+int mpjson_writer_done(mpjson_writer_t * w)
+{
+    if (w->stat || w->is_oom)
+        return -1;
+
+    if (!w->is_complete || w->deep || w->hdr_n || w->str)
+    {
+        w->stat = yajl_gen_in_error_state;
+        return -1;
+    }
+    return 0;
+}
+
+void mpjson_writer_destroy(mpjson_writer_t * w)
+{
+    free(w->str);
+    yajl_gen_free(w->g);
+    msgpack_sbuffer_destroy(&w->buffer);
+}
+
+void mpjson_writer_set_err(mpjson_writer_t * w, ex_t * e)
+{
+    if (w->stat)
+        mpjson__set_err(e, w->stat);
+    else
+        ex_set_mem(e);
+}
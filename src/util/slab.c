@@ -0,0 +1,99 @@
+/*
+ * util/slab.c
+ */
+#include <stdlib.h>
+#include <util/slab.h>
+
+/* size of a single chunk, including the chunk header */
+#define SLAB__CHUNK_SZ 65536
+
+/* chunk header, keeps objects aligned at 16 bytes */
+#define SLAB__HEADER_SZ 16
+
+static inline void slab__lock(slab_t * slab)
+{
+    while (atomic_flag_test_and_set_explicit(&slab->lock, memory_order_acquire))
+        ;
+}
+
+static inline void slab__unlock(slab_t * slab)
+{
+    atomic_flag_clear_explicit(&slab->lock, memory_order_release);
+}
+
+void slab_init(slab_t * slab, size_t sz)
+{
+    atomic_flag_clear(&slab->lock);
+    slab->sz = (sz + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+    slab->n_total = 0;
+    slab->n_used = 0;
+    slab->n_chunks = 0;
+    slab->free_list = NULL;
+    slab->chunks = NULL;
+    slab->next = NULL;
+    slab->end = NULL;
+}
+
+/*
+ * Releases all chunks; all objects allocated from the slab become invalid.
+ */
+void slab_destroy(slab_t * slab)
+{
+    void * chunk = slab->chunks;
+    while (chunk)
+    {
+        void * next = *((void **) chunk);
+        free(chunk);
+        chunk = next;
+    }
+    slab_init(slab, slab->sz);
+}
+
+void * slab_alloc(slab_t * slab)
+{
+    void * data;
+
+    slab__lock(slab);
+
+    if (slab->free_list)
+    {
+        data = slab->free_list;
+        slab->free_list = *((void **) data);
+    }
+    else
+    {
+        if (slab->next + slab->sz > slab->end)
+        {
+            char * chunk = malloc(SLAB__CHUNK_SZ);
+            if (!chunk)
+            {
+                slab__unlock(slab);
+                return NULL;
+            }
+            *((void **) chunk) = slab->chunks;
+            slab->chunks = chunk;
+            slab->next = chunk + SLAB__HEADER_SZ;
+            slab->end = chunk + SLAB__CHUNK_SZ;
+            slab->n_total += (SLAB__CHUNK_SZ - SLAB__HEADER_SZ) / slab->sz;
+            ++slab->n_chunks;
+        }
+        data = slab->next;
+        slab->next += slab->sz;
+    }
+
+    ++slab->n_used;
+    slab__unlock(slab);
+    return data;
+}
+
+void slab_free(slab_t * slab, void * data)
+{
+    if (!data)
+        return;
+
+    slab__lock(slab);
+    *((void **) data) = slab->free_list;
+    slab->free_list = data;
+    --slab->n_used;
+    slab__unlock(slab);
+}
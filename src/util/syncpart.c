@@ -6,14 +6,55 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <util/fz.h>
 #include <util/logger.h>
 #include <util/syncpart.h>
 
+/*
+ * Pack the data as a single compressed block, see util/fz.h. The raw data is
+ * packed instead if compression does not reduce the size.
+ */
+static int syncpart__pack_z(
+        msgpack_packer * pk,
+        unsigned char * buff,
+        size_t sz,
+        int level,
+        _Bool * is_compressed)
+{
+    int rc;
+    size_t zn;
+    unsigned char * zbuf = malloc(fz_block_bound(sz));
+    if (!zbuf)
+    {
+        log_critical(EX_MEMORY_S);
+        return -1;
+    }
+
+    zn = fz_block_compress(zbuf, buff, sz, level);
+
+    *is_compressed = zn && zn < sz;
+    rc = *is_compressed
+            ? mp_pack_bin(pk, zbuf, zn)
+            : mp_pack_bin(pk, buff, sz);
+
+    free(zbuf);
+    return rc;
+}
+
 /*
  * Returns 0 if the file is complete, 1 if more data is available and -1 on
  * error.
+ *
+ * When `level` is not 0, the data might be packed as a compressed block in
+ * which case `is_compressed` is set to `true`. The offset for the next part
+ * is always based on the uncompressed size.
  */
-int syncpart_to_pk(msgpack_packer * pk, const char * fn, off_t offset)
+int syncpart_to_pk(
+        msgpack_packer * pk,
+        const char * fn,
+        off_t offset,
+        int level,
+        _Bool * is_compressed)
 {
     int more;
     size_t sz;
@@ -67,7 +108,11 @@ int syncpart_to_pk(msgpack_packer * pk, const char * fn, off_t offset)
         goto fail2;
     }
 
-    more = mp_pack_bin(pk, buff, sz) ? -1 : (size_t) restsz != sz;
+    *is_compressed = false;
+
+    more = (level && sz
+        ? syncpart__pack_z(pk, buff, sz, level, is_compressed)
+        : mp_pack_bin(pk, buff, sz)) ? -1 : (size_t) restsz != sz;
     free(buff);
     return more;
 
@@ -145,3 +190,39 @@ done:
     return e->nr;
 }
 
+
+/*
+ * Returns the decompressed data for a part which is packed by
+ * syncpart_to_pk() as a compressed block. The `size` is updated to the
+ * decompressed size and the returned data must be freed by the caller.
+ */
+unsigned char * syncpart_decompress(
+        const unsigned char * data,
+        size_t * size,
+        ex_t * e)
+{
+    size_t n = fz_block_size(data, *size);
+    unsigned char * raw = n ? malloc(n) : NULL;
+
+    if (!n)
+    {
+        ex_set(e, EX_BAD_DATA, "invalid compressed part");
+        return NULL;
+    }
+
+    if (!raw)
+    {
+        ex_set_mem(e);
+        return NULL;
+    }
+
+    if (fz_block_decompress(raw, data, *size))
+    {
+        ex_set(e, EX_BAD_DATA, "corrupt compressed part");
+        free(raw);
+        return NULL;
+    }
+
+    *size = n;
+    return raw;
+}
@@ -367,6 +367,84 @@ void vec_sort_r(vec_t * vec, vec_sort_r_cb compare, void * arg)
     vec__sort_cb = NULL;
 }
 
+static void vec__sift_down(void ** heap, uint32_t i, uint32_t n)
+{
+    while (1)
+    {
+        uint32_t c = 2 * i + 1;
+        void * tmp;
+
+        if (c >= n)
+            return;
+
+        if (c + 1 < n && vec__sort_cb(heap[c], heap[c+1], vec__sort_arg) < 0)
+            ++c;
+
+        if (vec__sort_cb(heap[i], heap[c], vec__sort_arg) >= 0)
+            return;
+
+        tmp = heap[i];
+        heap[i] = heap[c];
+        heap[c] = tmp;
+        i = c;
+    }
+}
+
+/*
+ * Sort only the first `k` items of the vector; the order of the remaining
+ * items is undefined. This uses a heap of `k` items and is therefore cheaper
+ * than a full sort when `k` is small compared to the size of the vector.
+ *
+ * careful: this function is NOT thread safe
+ */
+void vec_partial_sort_r(
+        vec_t * vec,
+        uint32_t k,
+        vec_sort_r_cb compare,
+        void * arg)
+{
+    void ** data = vec->data;
+    uint32_t i;
+
+    if (k >= vec->n)
+    {
+        vec_sort_r(vec, compare, arg);
+        return;
+    }
+
+    if (!k)
+        return;
+
+    vec__sort_arg = arg;
+    vec__sort_cb = compare;
+
+    /* max-heap with the `k` smallest items seen so far */
+    for (i = k / 2; i--;)
+        vec__sift_down(data, i, k);
+
+    for (i = k; i < vec->n; ++i)
+    {
+        if (compare(data[i], data[0], arg) < 0)
+        {
+            void * tmp = data[0];
+            data[0] = data[i];
+            data[i] = tmp;
+            vec__sift_down(data, 0, k);
+        }
+    }
+
+    /* heap sort the first `k` items */
+    for (i = k; --i;)
+    {
+        void * tmp = data[0];
+        data[0] = data[i];
+        data[i] = tmp;
+        vec__sift_down(data, 0, i);
+    }
+
+    vec__sort_cb = NULL;
+}
+
 _Bool vec_is_sorting(void)
 {
     return !!vec__sort_cb;
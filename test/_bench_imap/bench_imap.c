@@ -0,0 +1,99 @@
+/*
+ * Memory and latency benchmark for the id map.
+ *
+ * Not part of the regular tests; build and run from the `test` directory:
+ *
+ *   gcc -I../inc -O2 -std=gnu99 _bench_imap/bench_imap.c \
+ *       $(cat _bench_imap/sources) -luv -o bench_imap.out
+ *   ./bench_imap.out [number of ids, default 10M] [step, default 1]
+ *
+ * A step larger than one creates a sparse map.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <malloc.h>
+#include <time.h>
+#include <util/imap.h>
+
+static struct timespec start;
+
+static void bench_start(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &start);
+}
+
+static double bench_end(void)
+{
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start.tv_sec) * 1e3 +
+           (end.tv_nsec - start.tv_nsec) / 1e6;
+}
+
+static size_t bench_mem(void)
+{
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+}
+
+static int bench_walk_cb(void * data, void * arg)
+{
+    *((uintptr_t *) arg) += (uintptr_t) data;
+    return 0;
+}
+
+/* xorshift, the lookups must be random but the same for each run */
+static uint64_t bench_rand(uint64_t * x)
+{
+    *x ^= *x << 13;
+    *x ^= *x >> 7;
+    *x ^= *x << 17;
+    return *x;
+}
+
+int main(int argc, char * argv[])
+{
+    uint64_t n = argc > 1 ? strtoull(argv[1], NULL, 10) : 10000000;
+    uint64_t step = argc > 2 ? strtoull(argv[2], NULL, 10) : 1;
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    uintptr_t sum = 0;
+    size_t mem = bench_mem();
+    double ms;
+    imap_t * imap = imap_create();
+
+    if (!imap || !n || !step)
+        return 1;
+
+    printf("ids: %lu, step: %lu\n", n, step);
+
+    bench_start();
+    for (uint64_t i = 0; i < n; ++i)
+        if (imap_add(imap, i * step, (void *) (uintptr_t) (i + 1)))
+            return 1;
+    ms = bench_end();
+    printf("add:    %9.1f ms  %6.1f ns/id\n", ms, ms * 1e6 / n);
+    printf("memory: %9.1f MiB %6.1f bytes/id\n",
+            (bench_mem() - mem) / 1048576.0,
+            (double) (bench_mem() - mem) / n);
+
+    bench_start();
+    for (uint64_t i = 0; i < n; ++i)
+        sum += (uintptr_t) imap_get(imap, (bench_rand(&seed) % n) * step);
+    ms = bench_end();
+    printf("get:    %9.1f ms  %6.1f ns/id\n", ms, ms * 1e6 / n);
+
+    bench_start();
+    (void) imap_walk(imap, bench_walk_cb, &sum);
+    ms = bench_end();
+    printf("walk:   %9.1f ms  %6.1f ns/id\n", ms, ms * 1e6 / n);
+
+    bench_start();
+    for (uint64_t i = 0; i < n; i += 2)
+        (void) imap_pop(imap, i * step);
+    ms = bench_end();
+    printf("pop:    %9.1f ms  %6.1f ns/id\n", ms, ms * 2e6 / n);
+
+    imap_destroy(imap, NULL);
+    return sum == 0;
+}
@@ -0,0 +1,81 @@
+#include "../test.h"
+#include <util/argsort.h>
+
+
+static int is_sorted(
+        int64_t * values,
+        uint64_t * keys,
+        uint32_t * idx,
+        size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (keys[i] != argsort_key_i64(values[idx[i]]))
+            return 0;
+        if (i && (
+                values[idx[i-1]] > values[idx[i]] ||
+                (values[idx[i-1]] == values[idx[i]] && idx[i-1] > idx[i])))
+            return 0;
+    }
+    return 1;
+}
+
+
+int main()
+{
+    test_start("argsort");
+
+    /* test keys */
+    {
+        _assert (argsort_key_i64(-1) < argsort_key_i64(0));
+        _assert (argsort_key_i64(INT64_MIN) < argsort_key_i64(-1));
+        _assert (argsort_key_i64(1) < argsort_key_i64(INT64_MAX));
+        _assert (argsort_key_f64(-1.5) < argsort_key_f64(-0.5));
+        _assert (argsort_key_f64(-0.5) < argsort_key_f64(0.0));
+        _assert (argsort_key_f64(-0.0) == argsort_key_f64(0.0));
+        _assert (argsort_key_f64(0.25) < argsort_key_f64(1e300));
+    }
+
+    /* test small and large inputs, with duplicates for stability */
+    {
+        size_t sizes[] = {0, 1, 5, 63, 64, 1000, 100000};
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(size_t); ++s)
+        {
+            size_t n = sizes[s];
+            int64_t * values = malloc(n * sizeof(int64_t) + 1);
+            uint64_t * keys = malloc(n * sizeof(uint64_t) + 1);
+            uint32_t * idx = malloc(n * sizeof(uint32_t) + 1);
+
+            _assert (values && keys && idx);
+
+            srand(s);
+            for (size_t i = 0; i < n; ++i)
+            {
+                values[i] = (int64_t) (rand() % 2000) - 1000;
+                if (i % 7 == 0)
+                    values[i] *= 1000000000LL;
+                keys[i] = argsort_key_i64(values[i]);
+            }
+
+            _assert (argsort_u64(keys, idx, n) == 0);
+            _assert (is_sorted(values, keys, idx, n));
+
+            free(values);
+            free(keys);
+            free(idx);
+        }
+    }
+
+    /* test equal keys */
+    {
+        uint64_t keys[100];
+        uint32_t idx[100];
+        for (size_t i = 0; i < 100; ++i)
+            keys[i] = 42;
+        _assert (argsort_u64(keys, idx, 100) == 0);
+        for (size_t i = 0; i < 100; ++i)
+            _assert (idx[i] == i);
+    }
+
+    return test_end();
+}
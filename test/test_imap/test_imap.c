@@ -1,9 +1,32 @@
 #include "../test.h"
+#include <tiinc.h>
 #include <util/imap.h>
 
 static const unsigned int num_batches = 5;
 static const unsigned int num_entries = 8;
 
+static int test__count_cb(void * data, size_t * n)
+{
+    (void) data;
+    return ++(*n) == 100;
+}
+
+/* items for maps using different heights, each with enough references */
+static ti_ref_t refs[4] = {{10}, {10}, {10}, {10}};
+
+static imap_t * test__imap(size_t n, const uint64_t * ids)
+{
+    imap_t * imap = imap_create();
+    for (size_t i = 0; i < n; ++i)
+        (void) imap_add(imap, ids[i], &refs[i % 4]);
+    return imap;
+}
+
+static void test__ref_drop(void * data)
+{
+    ti_decref((ti_ref_t *) data);
+}
+
 
 int main()
 {
@@ -36,7 +59,96 @@ int main()
 
     _assert (imap->n == 0x1000);
 
+    /* test walking from an id */
+    {
+        size_t n = 0;
+        _assert (imap_walk_from(imap, 0xf00, (imap_cb) test__count_cb, &n));
+        _assert (n == 100);
+
+        n = 0;
+        _assert (!imap_walk_from(imap, 0xfc0, (imap_cb) test__count_cb, &n));
+        _assert (n == 0x40);
+
+        n = 0;
+        _assert (!imap_walk_from(imap, 0x1000, (imap_cb) test__count_cb, &n));
+        _assert (n == 0);
+    }
+
     imap_destroy(imap, NULL);
 
+    /* test comparing maps with a different height */
+    {
+        imap_t * a = test__imap(1, (uint64_t[]) {5});
+        imap_t * b = test__imap(1, (uint64_t[]) {100000});
+        imap_t * c = test__imap(2, (uint64_t[]) {5, 100000});
+        imap_t * d = test__imap(1, (uint64_t[]) {5});
+        imap_t * e = test__imap(2, (uint64_t[]) {5, 100000});
+
+        /* `d` keeps the height but only contains a low id */
+        _assert (imap_add(d, 1ULL << 40, &refs[0]) == IMAP_SUCCESS);
+        _assert (imap_pop(d, 1ULL << 40) == &refs[0]);
+
+        _assert (!imap_eq(a, b));
+        _assert (!imap_eq(b, a));
+        _assert (imap_eq(a, d));
+        _assert (imap_eq(d, a));
+        _assert (imap_eq(c, e));
+        _assert (!imap_eq(c, d));
+
+        _assert (imap_le(a, c));
+        _assert (imap_le(b, c));
+        _assert (imap_le(d, c));
+        _assert (imap_le(a, d));
+        _assert (imap_le(d, a));
+        _assert (!imap_le(c, a));
+        _assert (!imap_le(b, a));
+        _assert (!imap_le(a, b));
+        _assert (!imap_le(b, d));
+
+        _assert (imap_lt(a, c));
+        _assert (imap_lt(d, c));
+        _assert (imap_lt(b, c));
+        _assert (!imap_lt(a, d));
+        _assert (!imap_lt(c, e));
+        _assert (!imap_lt(c, a));
+
+        imap_destroy(a, NULL);
+        imap_destroy(b, NULL);
+        imap_destroy(c, NULL);
+        imap_destroy(d, NULL);
+        imap_destroy(e, NULL);
+    }
+
+    /* test in-place set operations on maps with a different height */
+    {
+        imap_t * a = test__imap(3, (uint64_t[]) {1, 2, 70});
+        imap_t * b = test__imap(3, (uint64_t[]) {2, 100000, 1ULL << 40});
+        imap_t * c = test__imap(2, (uint64_t[]) {2, 100000});
+
+        _assert (imap_union_move(a, b) == 0);
+        _assert (a->n == 5 && b->n == 0);
+        _assert (imap_get(a, 1) && imap_get(a, 2) && imap_get(a, 70));
+        _assert (imap_get(a, 100000) && imap_get(a, 1ULL << 40));
+
+        _assert (imap_difference_inplace(a, c) == 0);
+        _assert (a->n == 3);
+        _assert (!imap_get(a, 2) && !imap_get(a, 100000));
+
+        _assert (imap_symmdiff_move(a, c, test__ref_drop) == 0);
+        _assert (a->n == 5 && c->n == 0);
+        _assert (imap_get(a, 2) && imap_get(a, 100000));
+
+        imap_destroy(c, NULL);
+        c = test__imap(3, (uint64_t[]) {1, 70, 100000});
+        _assert (imap_intersection_inplace(a, c, test__ref_drop) == 0);
+        _assert (a->n == 3);
+        _assert (imap_get(a, 1) && imap_get(a, 70) && imap_get(a, 100000));
+        _assert (imap_le(a, c) && imap_le(c, a));
+
+        imap_destroy(a, NULL);
+        imap_destroy(b, NULL);
+        imap_destroy(c, NULL);
+    }
+
     return test_end();
 }
@@ -0,0 +1,171 @@
+#include "../test.h"
+#include <ti/tzinfo.h>
+#include <util/logger.h>
+
+/*
+ * Expected values are taken from a first call to mktime() of the GNU C
+ * library, with the `TZ` environment set to the zone name.
+ */
+typedef struct
+{
+    const char * zone;
+    int year, mon, mday, hour, min, sec, isdst;
+    int64_t ts;
+    long gmtoff;
+    int tm_isdst;
+    const char * abbr;
+} tzinfo__case_t;
+
+static tzinfo__case_t tzinfo__cases[] = {
+    /* negative daylight saving time, POSIX footer after 2037 */
+    {"Europe/Dublin", 2077, 10, 31, 1, 30, 10, -1, 3402869410,
+        0, 1, "GMT"},
+    {"Europe/Dublin", 2077, 10, 31, 1, 30, 10, 0, 3402865810,
+        3600, 0, "IST"},
+    {"Europe/Dublin", 2077, 10, 31, 1, 30, 10, 1, 3402869410,
+        0, 1, "GMT"},
+    {"Europe/Dublin", 2077, 3, 28, 1, 30, 0, -1, 3384117000,
+        0, 1, "GMT"},
+    {"Europe/Dublin", 2077, 7, 1, 12, 0, 0, -1, 3392362800,
+        3600, 0, "IST"},
+    {"Europe/Dublin", 2077, 1, 1, 12, 0, 0, -1, 3376728000,
+        0, 1, "GMT"},
+    /* negative daylight saving time, explicit transitions */
+    {"Africa/Casablanca", 2024, 3, 10, 2, 16, 11, -1, 1710036971,
+        0, 1, "+00"},
+    {"Africa/Casablanca", 2024, 3, 10, 2, 16, 11, 0, 1710033371,
+        3600, 0, "+01"},
+    {"Africa/Casablanca", 2024, 4, 14, 2, 30, 0, -1, 1713058200,
+        0, 1, "+00"},
+    {"Africa/Casablanca", 2024, 6, 1, 12, 0, 0, -1, 1717239600,
+        3600, 0, "+01"},
+    /* east of Greenwich, before and after the last transition */
+    {"Europe/Amsterdam", 2024, 10, 27, 2, 30, 0, -1, 1729992600,
+        3600, 0, "CET"},
+    {"Europe/Amsterdam", 2024, 10, 27, 2, 30, 0, 1, 1729989000,
+        7200, 1, "CEST"},
+    {"Europe/Amsterdam", 2024, 3, 31, 2, 30, 0, -1, 1711848600,
+        7200, 1, "CEST"},
+    {"Europe/Amsterdam", 2090, 10, 29, 2, 30, 0, -1, 3812923800,
+        3600, 0, "CET"},
+    {"Europe/Amsterdam", 2090, 10, 29, 2, 30, 0, 1, 3812920200,
+        7200, 1, "CEST"},
+    {"Europe/Amsterdam", 2090, 3, 26, 2, 30, 0, -1, 3794175000,
+        7200, 1, "CEST"},
+    /* west of Greenwich, before and after the last transition */
+    {"America/New_York", 2024, 11, 3, 1, 30, 0, -1, 1730611800,
+        -14400, 1, "EDT"},
+    {"America/New_York", 2024, 11, 3, 1, 30, 0, 0, 1730615400,
+        -18000, 0, "EST"},
+    {"America/New_York", 2024, 3, 10, 2, 30, 0, -1, 1710055800,
+        -14400, 1, "EDT"},
+    {"America/New_York", 2100, 11, 7, 1, 30, 0, -1, 4129248600,
+        -14400, 1, "EDT"},
+    {"America/New_York", 2100, 11, 7, 1, 30, 0, 0, 4129252200,
+        -18000, 0, "EST"},
+    {"America/New_York", 2100, 3, 14, 2, 30, 0, -1, 4108692600,
+        -14400, 1, "EDT"},
+    {"America/New_York", 2100, 7, 4, 12, 0, 0, 0, 4118403600,
+        -14400, 1, "EDT"},
+    /* southern hemisphere, daylight saving time of 30 minutes */
+    {"Australia/Sydney", 2080, 4, 7, 2, 30, 0, -1, 3479646600,
+        36000, 0, "AEST"},
+    {"Australia/Sydney", 2080, 4, 7, 2, 30, 0, 0, 3479646600,
+        36000, 0, "AEST"},
+    {"Australia/Sydney", 2080, 10, 6, 2, 30, 0, -1, 3495371400,
+        39600, 1, "AEDT"},
+    {"Australia/Lord_Howe", 2080, 4, 7, 1, 45, 0, -1, 3479642100,
+        37800, 0, "+1030"},
+    {"Australia/Lord_Howe", 2080, 4, 7, 1, 45, 0, 1, 3479640300,
+        39600, 1, "+11"},
+    /* without daylight saving time */
+    {"Asia/Tokyo", 2080, 1, 1, 0, 0, 0, -1, 3471260400,
+        32400, 0, "JST"},
+    {"Asia/Tokyo", 2080, 1, 1, 0, 0, 0, 1, 3471256800,
+        32400, 0, "JST"},
+    {"UTC", 2024, 2, 29, 23, 59, 59, -1, 1709251199,
+        0, 0, "UTC"},
+};
+
+static int tzinfo__check(tzinfo__case_t * c)
+{
+    int64_t ts;
+    struct tm tm = {
+            .tm_year = c->year - 1900,
+            .tm_mon = c->mon - 1,
+            .tm_mday = c->mday,
+            .tm_hour = c->hour,
+            .tm_min = c->min,
+            .tm_sec = c->sec,
+            .tm_isdst = c->isdst,
+    };
+    ti_tzinfo_t * info = ti_tzinfo_load(c->zone);
+    int ok = (
+        info &&
+        ti_tzinfo_mktime(info, &tm, &ts) == 0 &&
+        ts == c->ts &&
+        tm.tm_gmtoff == c->gmtoff &&
+        tm.tm_isdst == c->tm_isdst &&
+        strcmp(tm.tm_zone, c->abbr) == 0 &&
+        ti_tzinfo_localtime(info, c->ts, &tm) == 0 &&
+        tm.tm_gmtoff == c->gmtoff &&
+        tm.tm_isdst == c->tm_isdst
+    );
+
+    if (!ok)
+        printf("\n%s %04d-%02d-%02d %02d:%02d:%02d isdst=%d\n",
+                c->zone, c->year, c->mon, c->mday,
+                c->hour, c->min, c->sec, c->isdst);
+
+    ti_tzinfo_destroy(info);
+    return ok;
+}
+
+static int test_tzinfo_mktime(void)
+{
+    test_start("tzinfo (mktime)");
+
+    size_t n = sizeof(tzinfo__cases) / sizeof(tzinfo__case_t);
+    for (size_t i = 0; i < n; ++i)
+        _assert (tzinfo__check(&tzinfo__cases[i]));
+
+    return test_end();
+}
+
+static int test_tzinfo_transitions(void)
+{
+    test_start("tzinfo (transitions)");
+
+    struct tm tm;
+    ti_tzinfo_t * info = ti_tzinfo_load("Europe/Amsterdam");
+    _assert (info);
+
+    /* 2024-03-31 01:00:00 UTC, an explicit transition */
+    _assert (ti_tzinfo_localtime(info, 1711846799, &tm) == 0);
+    _assert (tm.tm_hour == 1 && tm.tm_isdst == 0);
+    _assert (ti_tzinfo_localtime(info, 1711846800, &tm) == 0);
+    _assert (tm.tm_hour == 3 && tm.tm_isdst == 1);
+
+    /* 2090-03-26 01:00:00 UTC, calculated using the POSIX footer */
+    _assert (ti_tzinfo_localtime(info, 3794173199, &tm) == 0);
+    _assert (tm.tm_hour == 1 && tm.tm_isdst == 0);
+    _assert (ti_tzinfo_localtime(info, 3794173200, &tm) == 0);
+    _assert (tm.tm_hour == 3 && tm.tm_isdst == 1);
+    _assert (strcmp(tm.tm_zone, "CEST") == 0);
+
+    ti_tzinfo_destroy(info);
+
+    _assert (ti_tzinfo_load("No/Such_Zone") == NULL);
+
+    return test_end();
+}
+
+int main()
+{
+    logger_init(stderr, LOGGER_CRITICAL);
+    return (
+        test_tzinfo_mktime() ||
+        test_tzinfo_transitions() ||
+        0
+    );
+}